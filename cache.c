@@ -0,0 +1,291 @@
+// 编译缓存
+//
+// 以预处理后的终结符流，和影响代码生成的选项作为键，
+// 将生成的.s或.o文件存放在-fcache-dir=指定的目录中。
+// 再次编译相同内容时，直接复制缓存中的文件，跳过解析、代码生成和汇编。
+//
+// 缓存目录内容：
+//   <键>.s / <键>.o  缓存的输出文件
+//   stats            命中数 未命中数 缓存总大小，读写时加文件锁
+
+#include "rvcc.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <utime.h>
+
+// 缓存目录
+char *OptFCacheDir;
+// 缓存的最大字节数，超过时淘汰最久未使用的文件
+long OptFCacheMaxSize = 1L << 30;
+
+// 缓存的统计数据
+typedef struct {
+  long Hits;   // 命中数
+  long Misses; // 未命中数
+  long Size;   // 缓存文件的总大小
+} CacheStats;
+
+// 缓存中的文件，用于淘汰
+typedef struct {
+  char *Path;  // 路径
+  time_t Time; // 最近使用时间
+  long Size;   // 大小
+} CacheEntry;
+
+// 键的哈希值，两路FNV-1a，共128位
+static uint64_t Hash1, Hash2;
+
+static void hashBytes(char *S, int Len) {
+  for (int I = 0; I < Len; I++) {
+    Hash1 = (Hash1 ^ (unsigned char)S[I]) * 0x100000001b3;
+    Hash2 = (Hash2 ^ (unsigned char)S[I]) * 0x100000001b3;
+    Hash2 += 0x9e3779b97f4a7c15;
+  }
+}
+
+static void hashStr(char *S) {
+  // 包含结尾的'\0'，以区分相邻的字符串
+  hashBytes(S, strlen(S) + 1);
+}
+
+static void hashInt(int64_t Val) { hashBytes((char *)&Val, sizeof(Val)); }
+
+// 判断选项是否会影响输出的内容
+// 输出路径、线程数和缓存自身的选项不影响，-I和-D已体现在预处理的结果中
+static bool isOutputOption(char *Arg) {
+  return !strncmp(Arg, "-o", 2) || !strncmp(Arg, "-cc1", 4) ||
+         !strncmp(Arg, "-fcache-", 8) || !strncmp(Arg, "-I", 2) ||
+         !strncmp(Arg, "-D", 2) || !strncmp(Arg, "-U", 2) ||
+         !strncmp(Arg, "-M", 2) || !strncmp(Arg, "-fcodegen-threads=", 18);
+}
+
+// 计算缓存的键
+// 包括：预处理后的终结符及其位置，输入文件名，编译选项，目标平台
+char *cacheKey(Token *Tok, int Argc, char **Argv) {
+  Hash1 = 0xcbf29ce484222325;
+  Hash2 = 0x84222325cbf29ce4;
+
+  // 缓存格式的版本和目标平台
+  hashStr("rvcc-cache-1");
+  hashStr("riscv64-lp64d");
+  hashInt(OptFPIC);
+  hashInt(OptFCommon);
+
+  // 其余会影响代码生成的选项
+  for (int I = 1; I < Argc; I++) {
+    if (isOutputOption(Argv[I])) {
+      // 跳过选项的参数
+      if (!strcmp(Argv[I], "-o") || !strcmp(Argv[I], "-I") ||
+          !strcmp(Argv[I], "-D") || !strcmp(Argv[I], "-U") ||
+          !strcmp(Argv[I], "-MF") || !strcmp(Argv[I], "-MT") ||
+          !strcmp(Argv[I], "-MQ") || !strcmp(Argv[I], "-cc1-input") ||
+          !strcmp(Argv[I], "-cc1-output") ||
+          !strcmp(Argv[I], "-cc1-cache-key"))
+        I++;
+      continue;
+    }
+    if (Argv[I][0] == '-')
+      hashStr(Argv[I]);
+  }
+
+  // 文件名会输出到.file指示中
+  File **Files = getInputFiles();
+  for (int I = 0; Files[I]; I++) {
+    hashInt(Files[I]->FileNo);
+    hashStr(Files[I]->Name);
+  }
+
+  // 终结符的内容和位置，位置会输出到.loc指示中
+  for (; Tok->Kind != TK_EOF; Tok = Tok->Next) {
+    hashBytes(Tok->Loc, Tok->Len);
+    hashInt(((int64_t)Tok->File->FileNo << 32) | (uint32_t)Tok->LineNo);
+    hashInt(Tok->AtBOL * 2 + Tok->HasSpace);
+  }
+
+  return format("%016lx%016lx", Hash1, Hash2);
+}
+
+// 缓存中文件的路径
+static char *cachePath(char *Key, char *Extn) {
+  return format("%s/%s%s", OptFCacheDir, Key, Extn);
+}
+
+// 复制文件，返回是否成功
+static bool copyFile(char *Src, char *Dst) {
+  FILE *In = fopen(Src, "r");
+  if (!In)
+    return false;
+  FILE *Out = fopen(Dst, "w");
+  if (!Out) {
+    fclose(In);
+    return false;
+  }
+
+  char Buf[8192];
+  bool Ok = true;
+  int N;
+  while ((N = fread(Buf, 1, sizeof(Buf), In)) > 0)
+    if (fwrite(Buf, 1, N, Out) != N)
+      Ok = false;
+
+  fclose(In);
+  if (fclose(Out))
+    Ok = false;
+  return Ok;
+}
+
+// 打开并锁住统计文件，读取其中的数据
+static int lockStats(CacheStats *Stats) {
+  mkdir(OptFCacheDir, 0755);
+  int FD = open(format("%s/stats", OptFCacheDir), O_RDWR | O_CREAT, 0644);
+  if (FD < 0)
+    return -1;
+
+  struct flock Lock = {};
+  Lock.l_type = F_WRLCK;
+  Lock.l_whence = SEEK_SET;
+  fcntl(FD, F_SETLKW, &Lock);
+
+  char Buf[128] = {};
+  *Stats = (CacheStats){};
+  if (read(FD, Buf, sizeof(Buf) - 1) > 0)
+    sscanf(Buf, "%ld %ld %ld", &Stats->Hits, &Stats->Misses, &Stats->Size);
+  return FD;
+}
+
+// 写回统计数据，并解锁
+static void unlockStats(int FD, CacheStats *Stats) {
+  char *Buf = format("%ld %ld %ld\n", Stats->Hits, Stats->Misses, Stats->Size);
+  ftruncate(FD, 0);
+  pwrite(FD, Buf, strlen(Buf), 0);
+  // 关闭文件时，释放锁
+  close(FD);
+}
+
+static int compareEntry(const void *A, const void *B) {
+  time_t X = ((CacheEntry *)A)->Time;
+  time_t Y = ((CacheEntry *)B)->Time;
+  return X < Y ? -1 : X > Y;
+}
+
+// 淘汰最久未使用的文件，直到总大小降到上限的90%以下
+static void evict(CacheStats *Stats) {
+  DIR *Dir = opendir(OptFCacheDir);
+  if (!Dir)
+    return;
+
+  // 收集所有缓存文件
+  CacheEntry *Entries = NULL;
+  int Len = 0, Cap = 0;
+  long Size = 0;
+  for (struct dirent *DE; (DE = readdir(Dir));) {
+    char *Name = DE->d_name;
+    int NameLen = strlen(Name);
+    if (NameLen < 2 || Name[NameLen - 2] != '.' ||
+        (Name[NameLen - 1] != 's' && Name[NameLen - 1] != 'o'))
+      continue;
+
+    char *Path = format("%s/%s", OptFCacheDir, Name);
+    struct stat St;
+    if (stat(Path, &St))
+      continue;
+
+    if (Len == Cap) {
+      Cap = Cap ? Cap * 2 : 64;
+      Entries = realloc(Entries, sizeof(CacheEntry) * Cap);
+    }
+    Entries[Len++] = (CacheEntry){Path, St.st_mtime, St.st_size};
+    Size += St.st_size;
+  }
+  closedir(Dir);
+
+  // 从最旧的文件开始删除
+  qsort(Entries, Len, sizeof(CacheEntry), compareEntry);
+  for (int I = 0; I < Len && Size > OptFCacheMaxSize / 10 * 9; I++)
+    if (!unlink(Entries[I].Path))
+      Size -= Entries[I].Size;
+
+  Stats->Size = Size;
+  free(Entries);
+}
+
+// 在缓存中查找键对应的文件
+bool cacheHas(char *Key, char *Extn) {
+  return fileExists(cachePath(Key, Extn));
+}
+
+// 从缓存中取出文件，写入到Dst，返回是否命中
+bool cacheFetch(char *Key, char *Extn, char *Dst) {
+  char *Path = cachePath(Key, Extn);
+  if (!copyFile(Path, Dst))
+    return false;
+
+  // 更新使用时间，用于淘汰
+  utime(Path, NULL);
+
+  CacheStats Stats;
+  int FD = lockStats(&Stats);
+  if (FD >= 0) {
+    Stats.Hits++;
+    unlockStats(FD, &Stats);
+  }
+  return true;
+}
+
+// 将编译得到的文件Src存入缓存
+void cacheStore(char *Key, char *Extn, char *Src) {
+  mkdir(OptFCacheDir, 0755);
+
+  // 先写入临时文件，再重命名，避免并发编译时读到不完整的文件
+  char *Path = cachePath(Key, Extn);
+  char *Tmp = format("%s.XXXXXX", Path);
+  int TmpFD = mkstemp(Tmp);
+  if (TmpFD < 0)
+    return;
+  // mkstemp创建的文件仅自身可读写，缓存可能被多个用户共享
+  fchmod(TmpFD, 0644);
+  close(TmpFD);
+  if (!copyFile(Src, Tmp)) {
+    unlink(Tmp);
+    return;
+  }
+
+  // 持有统计数据的锁时重命名，并发编译可能已经存入了相同的键，
+  // 此时重命名会替换旧文件，只计入大小的差值
+  CacheStats Stats;
+  int FD = lockStats(&Stats);
+  struct stat St;
+  long OldSize = stat(Path, &St) ? 0 : St.st_size;
+  if (rename(Tmp, Path) || stat(Path, &St)) {
+    unlink(Tmp);
+    if (FD >= 0)
+      close(FD);
+    return;
+  }
+  if (FD < 0)
+    return;
+
+  Stats.Misses++;
+  Stats.Size += St.st_size - OldSize;
+  if (Stats.Size > OptFCacheMaxSize)
+    evict(&Stats);
+  unlockStats(FD, &Stats);
+}
+
+// 输出缓存的统计数据
+void cachePrintStats(void) {
+  CacheStats Stats;
+  int FD = lockStats(&Stats);
+  if (FD < 0)
+    error("cannot open cache directory: %s: %s", OptFCacheDir,
+          strerror(errno));
+  close(FD);
+
+  long Total = Stats.Hits + Stats.Misses;
+  printf("cache directory  %s\n", OptFCacheDir);
+  printf("cache hits       %ld\n", Stats.Hits);
+  printf("cache misses     %ld\n", Stats.Misses);
+  printf("hit rate         %.2f %%\n", Total ? Stats.Hits * 100.0 / Total : 0);
+  printf("cache size       %.1f / %.1f MB\n", Stats.Size / 1048576.0,
+         OptFCacheMaxSize / 1048576.0);
+}
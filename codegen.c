@@ -1,23 +1,41 @@
 #include "rvcc.h"
+#include <pthread.h>
 
 #define GP_MAX 8
 #define FP_MAX 8
 
+// 代码生成的线程数，为0时使用所有的处理器
+int OptCodegenThreads;
+
+// 各函数的代码在不同的线程中生成，以下状态每个线程各有一份
+
 // 输出文件
-static FILE *OutputFile;
+static _Thread_local FILE *OutputFile;
 // 记录栈深度
-static int Depth;
+static _Thread_local int Depth;
 // 记录大结构体的深度
-static int BSDepth;
+static _Thread_local int BSDepth;
 // 当前的函数
-static Obj *CurrentFn;
+static _Thread_local Obj *CurrentFn;
+// 当前函数内的标签计数
+static _Thread_local int LabelCnt;
+// 当前函数中不太可能执行的代码，放在函数的末尾
+static _Thread_local FILE *ColdFile;
+static _Thread_local char *ColdBuf;
+static _Thread_local size_t ColdLen;
 
 // 我们将fs0～fs11两两组对形成6个寄存器对
 // 用于long double类型的存储，每次+2
-static int LDSP;
+static _Thread_local int LDSP;
+
+// 本文件中定义的全局变量和函数，生成代码时只读
+static HashMap Definitions;
 
 static void genExpr(Node *Nd);
 static void genStmt(Node *Nd);
+static void storeGeneral(int Reg, int Offset, int Size);
+static void genVecOp(Node *Nd);
+static bool genLoopVal(Node *Nd);
 
 __attribute__((format(printf, 1, 2)))
 // 输出字符串到目标文件并换行
@@ -33,10 +51,8 @@ printLn(char *Fmt, ...) {
 }
 
 // 代码段计数
-static int count(void) {
-  static int I = 1;
-  return I++;
-}
+// 每个函数单独计数，标签中带有函数名，从而与生成代码的顺序无关
+static int count(void) { return ++LabelCnt; }
 
 // 压栈，将结果临时压入栈中备用
 // sp为栈指针，栈反向向下增长，64位下，8个字节为一个单位，所以sp-8
@@ -93,12 +109,247 @@ static void popLD(int Reg) {
   printLn("  fmv.x.d a%d, fs%d", Reg, LDSP);
 }
 
+// 判断是否为12位有符号立即数
+static bool isImm12(int64_t Val) { return -2048 <= Val && Val <= 2047; }
+
+// 当前函数能否相对sp访问栈内的变量
+// 开启RVC时，sp相对的访存可以压缩为c.ldsp/c.sdsp等指令，
+// 使用alloca时sp会动态变化，只能相对fp访问
+static bool useSPRelative(void) {
+  return OptMRVC && !CurrentFn->UsesAlloca;
+}
+
+// 栈内fp+Offset处相对于sp的偏移量
+static int spOffset(int Offset) {
+  return CurrentFn->StackSize + Offset + Depth * 8;
+}
+
+// 获取栈内fp+Offset处，Size字节的访存操作数
+// 偏移量超出12位时，通过t0计算地址
+static char *stackSlot(int Offset, int Size) {
+  if (useSPRelative() && (Size == 4 || Size == 8)) {
+    // c.lwsp/c.ldsp的偏移量为6位无符号数，以Size为单位
+    int SPOff = spOffset(Offset);
+    if (SPOff >= 0 && SPOff % Size == 0 && SPOff < 64 * Size)
+      return format("%d(sp)", SPOff);
+  }
+  if (isImm12(Offset))
+    return format("%d(fp)", Offset);
+  printLn("  li t0, %d", Offset);
+  printLn("  add t0, fp, t0");
+  return "0(t0)";
+}
+
+// 将栈内fp+Offset的地址存入寄存器Reg
+static void genStackAddr(char *Reg, int Offset) {
+  if (useSPRelative() && isImm12(spOffset(Offset))) {
+    printLn("  addi %s, sp, %d", Reg, spOffset(Offset));
+    return;
+  }
+  if (isImm12(Offset)) {
+    printLn("  addi %s, fp, %d", Reg, Offset);
+    return;
+  }
+  printLn("  li t0, %d", Offset);
+  printLn("  add %s, fp, t0", Reg);
+}
+
+// 寄存器Reg加上常量Val
+static void genAddImm(char *Reg, int64_t Val) {
+  if (isImm12(Val)) {
+    printLn("  addi %s, %s, %ld", Reg, Reg, Val);
+    return;
+  }
+  printLn("  li t0, %ld", Val);
+  printLn("  add %s, %s, t0", Reg, Reg);
+}
+
 // 对齐到Align的整数倍
 int alignTo(int N, int Align) {
   // (0,Align]返回Align
   return (N + Align - 1) / Align * Align;
 }
 
+// 判断是否为非默认的可见性
+static bool isHidden(char *Visibility) {
+  return Visibility && strcmp(Visibility, "default");
+}
+
+// 判断全局变量或函数是否可能被其他模块中的同名符号抢占
+// 可能被抢占的符号需要通过GOT访问，否则可以直接使用PC相对寻址
+static bool isPreemptible(Obj *Var) {
+  // 使用本文件中的定义，其可见性包含了之前各个声明的可见性
+  Obj *Def = hashmap_get(&Definitions, Var->Name);
+  if (!Def)
+    Def = Var;
+
+  // 文件域内的符号，包括字符串字面量
+  if (Var->IsStatic || Def->IsStatic)
+    return false;
+
+  // 隐藏的符号只在本模块内可见
+  // protected的数据在可执行文件中可能被复制重定位，仍然通过GOT访问
+  char *Vis = Def->Visibility;
+  if (isHidden(Vis) && (strcmp(Vis, "protected") || Var->IsFunction))
+    return false;
+
+  // 非位置无关代码用于可执行文件，其中定义的符号不会被抢占
+  return OptFPIC || !Def->IsDefinition;
+}
+
+// 获取全局变量或函数的地址
+static void genSymAddr(Obj *Var) {
+  printLn("  # 获取%s%s的地址", Var->IsFunction ? "函数" : "全局变量",
+          Var->Name);
+  if (isPreemptible(Var))
+    printLn("  la a0, %s", Var->Name);
+  else
+    printLn("  lla a0, %s", Var->Name);
+}
+
+// 判断全局变量是否放入小数据段
+// 小数据段靠近gp，链接器可以将PC相对寻址松弛为一条相对gp的指令
+// 位置无关代码中不使用小数据段
+static bool isSmallData(Obj *Var) {
+  return !OptFPIC && !Var->IsFunction && !Var->IsLocal && !Var->IsTLS &&
+         Var->Ty->Size > 0 && Var->Ty->Size <= OptMSmallDataLimit;
+}
+
+// 判断全局变量是否只读，包括字符串字面量和const限定的变量
+static bool isReadOnly(Obj *Var) {
+  if (Var->IsLiteral)
+    return true;
+
+  // 数组的const限定在元素类型上
+  Type *Ty = Var->Ty;
+  while (Ty->Kind == TY_ARRAY && !Ty->IsConst)
+    Ty = Ty->Base;
+  return Ty->IsConst;
+}
+
+// 判断是否为可以合并的字符串字面量
+// 链接器按'\0'切分并合并相同的字符串，因此中间不能有'\0'
+static bool isMergeableString(Obj *Var) {
+  if (!Var->IsLiteral || Var->Ty->Base->Size != 1)
+    return false;
+  return strlen(Var->InitData) == Var->Ty->Size - 1;
+}
+
+// 判断能否通过符号直接读写变量，而不必先计算地址
+// 只用于小数据段中的整型和指针，链接器松弛后只需一条指令
+static bool isDirectAccess(Node *Nd) {
+  if (Nd->Kind != ND_VAR || !isSmallData(Nd->Var) || isPreemptible(Nd->Var) ||
+      Nd->Ty->IsAtomic)
+    return false;
+  return isInteger(Nd->Ty) || Nd->Ty->Kind == TY_PTR;
+}
+
+// 通过符号直接读取小数据段中的变量
+static void loadSym(Node *Nd) {
+  char *Suffix = Nd->Ty->IsUnsigned ? "u" : "";
+  char *Name = Nd->Var->Name;
+
+  printLn("  # 读取全局变量%s的值，存入a0", Name);
+  if (Nd->Ty->Size == 1)
+    printLn("  lb%s a0, %s", Suffix, Name);
+  else if (Nd->Ty->Size == 2)
+    printLn("  lh%s a0, %s", Suffix, Name);
+  else if (Nd->Ty->Size == 4)
+    printLn("  lw%s a0, %s", Suffix, Name);
+  else
+    printLn("  ld a0, %s", Name);
+}
+
+// 通过符号直接将a0写入小数据段中的变量
+static void storeSym(Node *Nd) {
+  char *Name = Nd->Var->Name;
+
+  printLn("  # 将a0的值，写入到全局变量%s中", Name);
+  if (Nd->Ty->Size == 1)
+    printLn("  sb a0, %s, t0", Name);
+  else if (Nd->Ty->Size == 2)
+    printLn("  sh a0, %s, t0", Name);
+  else if (Nd->Ty->Size == 4)
+    printLn("  sw a0, %s, t0", Name);
+  else
+    printLn("  sd a0, %s, t0", Name);
+}
+
+// 输出符号的可见性
+static void emitVisibility(Obj *Var) {
+  if (!Var->IsStatic && isHidden(Var->Visibility))
+    printLn("  .%s %s", Var->Visibility, Var->Name);
+}
+
+// 选择线程局部变量的访问模型
+// 默认根据是否位置无关、是否可能被抢占来选择，
+// -ftls-model=和tls_model属性只能选择更高效的模型
+static TLSModel tlsModel(Obj *Var) {
+  TLSModel Model;
+  if (isPreemptible(Var))
+    // 可执行文件中，外部的变量位于静态TLS块中，偏移量在加载时确定
+    Model = OptFPIC ? TLS_GLOBAL_DYNAMIC : TLS_INITIAL_EXEC;
+  else
+    Model = OptFPIC ? TLS_LOCAL_DYNAMIC : TLS_LOCAL_EXEC;
+
+  Obj *Def = hashmap_get(&Definitions, Var->Name);
+  Model = MAX(Model, OptFTLSModel);
+  Model = MAX(Model, Var->TLSModel);
+  if (Def)
+    Model = MAX(Model, Def->TLSModel);
+  return Model;
+}
+
+// 通过__tls_get_addr获取线程局部变量的地址
+static void genTLSGetAddr(Obj *Var) {
+  int C = count();
+  printLn(".Lpcrel_hi.%s.%d:", CurrentFn->Name, C);
+  printLn("  auipc a0, %%tls_gd_pcrel_hi(%s)", Var->Name);
+  printLn("  addi a0, a0, %%pcrel_lo(.Lpcrel_hi.%s.%d)", CurrentFn->Name, C);
+  printLn("  call __tls_get_addr@plt");
+}
+
+// 计算线程局部变量的地址
+static void genTLSAddr(Node *Nd) {
+  Obj *Var = Nd->Var;
+  switch (tlsModel(Var)) {
+  case TLS_LOCAL_EXEC:
+    printLn("  # 获取线程局部变量%s的地址，local-exec", Var->Name);
+    printLn("  lui a0,%%tprel_hi(%s)", Var->Name);
+    printLn("  add a0,a0,tp,%%tprel_add(%s)", Var->Name);
+    printLn("  addi a0,a0,%%tprel_lo(%s)", Var->Name);
+    return;
+  case TLS_INITIAL_EXEC: {
+    printLn("  # 获取线程局部变量%s的地址，initial-exec", Var->Name);
+    int C = count();
+    printLn(".Lpcrel_hi.%s.%d:", CurrentFn->Name, C);
+    printLn("  auipc a0, %%tls_ie_pcrel_hi(%s)", Var->Name);
+    printLn("  ld a0, %%pcrel_lo(.Lpcrel_hi.%s.%d)(a0)", CurrentFn->Name, C);
+    printLn("  add a0, a0, tp");
+    return;
+  }
+  case TLS_LOCAL_DYNAMIC:
+    // RISC-V没有local-dynamic的重定位，
+    // 因此多次访问时，缓存第一次执行到的__tls_get_addr的结果
+    if (Nd->TLSSlot) {
+      int C = count();
+      printLn("  # 获取线程局部变量%s的地址，local-dynamic", Var->Name);
+      printLn("  ld a0, %s", stackSlot(Nd->TLSSlot->Offset, 8));
+      printLn("  bnez a0, .L.tls.%d", C);
+      genTLSGetAddr(Var);
+      printLn("  sd a0, %s", stackSlot(Nd->TLSSlot->Offset, 8));
+      printLn(".L.tls.%d:", C);
+      return;
+    }
+    break;
+  default:
+    break;
+  }
+
+  printLn("  # 获取线程局部变量%s的地址，global-dynamic", Var->Name);
+  genTLSGetAddr(Var);
+}
+
 // 计算给定节点的绝对地址
 // 如果报错，说明节点不在内存中
 static void genAddr(Node *Nd) {
@@ -108,49 +359,29 @@ static void genAddr(Node *Nd) {
     // Variable-length array, which is always local.
     if (Nd->Var->Ty->Kind == TY_VLA) {
       // printLn("  mov %d(%%rbp), %%rax", Nd->Var->Offset);
-      printLn("  li t0, %d", Nd->Var->Offset);
-      printLn("  add t0, t0, fp");
-      printLn("  ld a0, 0(t0)");
+      printLn("  ld a0, %s", stackSlot(Nd->Var->Offset, 8));
       return;
     }
 
-    if (OptFPIC) {
-      int C = count();
-      printLn(".Lpcrel_hi%d:", C);
-      // Thread-local variable
-      if (Nd->Var->IsTLS) {
-        printLn("  auipc a0, %%tls_gd_pcrel_hi(%s)", Nd->Var->Name);
-        printLn("  addi a0, a0, %%pcrel_lo(.Lpcrel_hi%d)", C);
-        printLn("  call __tls_get_addr@plt");
-        return;
-      }
+    // 放入寄存器的变量没有地址
+    if (Nd->Var->Reg)
+      unreachable();
 
-      // 函数或者全局变量
-      printLn("  # 获取%s%s的地址",
-              Nd->Ty->Kind == TY_FUNC ? "函数" : "全局变量", Nd->Var->Name);
-      printLn("  la a0, %s", Nd->Var->Name);
+    if (Nd->Var->IsLocal) { // 偏移量是相对于fp的
+      printLn("  # 获取局部变量%s的栈内地址为%d(fp)", Nd->Var->Name,
+              Nd->Var->Offset);
+      genStackAddr("a0", Nd->Var->Offset);
       return;
     }
 
     // Thread-local variable
     if (Nd->Var->IsTLS) {
-      printLn("  lui a0,%%tprel_hi(%s)", Nd->Var->Name);
-      printLn("  add a0,a0,tp,%%tprel_add(%s)", Nd->Var->Name);
-      printLn("  addi a0,a0,%%tprel_lo(%s)", Nd->Var->Name);
+      genTLSAddr(Nd);
       return;
     }
 
-    if (Nd->Var->IsLocal) { // 偏移量是相对于fp的
-      printLn("  # 获取局部变量%s的栈内地址为%d(fp)", Nd->Var->Name,
-              Nd->Var->Offset);
-      printLn("  li t0, %d", Nd->Var->Offset);
-      printLn("  add a0, fp, t0");
-    } else {
-      // 函数或者全局变量
-      printLn("  # 获取%s%s的地址",
-              Nd->Ty->Kind == TY_FUNC ? "函数" : "全局变量", Nd->Var->Name);
-      printLn("  la a0, %s", Nd->Var->Name);
-    }
+    // 函数或者全局变量
+    genSymAddr(Nd->Var);
     return;
   // 解引用*
   case ND_DEREF:
@@ -165,8 +396,7 @@ static void genAddr(Node *Nd) {
   case ND_MEMBER:
     genAddr(Nd->LHS);
     printLn("  # 计算成员变量的地址偏移量");
-    printLn("  li t0, %d", Nd->Mem->Offset);
-    printLn("  add a0, a0, t0");
+    genAddImm("a0", Nd->Mem->Offset);
     return;
   // 函数调用
   case ND_FUNCALL:
@@ -178,22 +408,61 @@ static void genAddr(Node *Nd) {
     break;
   case ND_VLA_PTR:
     // printLn("  lea %d(%%rbp), %%rax", Nd->Var->Offset);
-    printLn("  li t0, %d", Nd->Var->Offset);
-    printLn("  add a0, t0, fp");
+    genStackAddr("a0", Nd->Var->Offset);
     return;
   default:
     break;
   }
 
+  // 向量运算的结果存放在临时变量中，a0即为其地址
+  if (Nd->Ty && Nd->Ty->Kind == TY_VECTOR) {
+    genExpr(Nd);
+    return;
+  }
+
   errorTok(Nd->Tok, "not an lvalue");
 }
 
+// 原子读取前的内存屏障，顺序一致时需与之前的写入保持顺序
+static void fenceBeforeLoad(MemoryOrder Order) {
+  if (Order == MO_SEQ_CST)
+    printLn("  fence rw, rw");
+}
+
+// 原子读取后的内存屏障，获取语义
+static void fenceAfterLoad(MemoryOrder Order) {
+  if (Order != MO_RELAXED && Order != MO_RELEASE)
+    printLn("  fence r, rw");
+}
+
+// 原子写入前的内存屏障，释放语义
+static void fenceBeforeStore(MemoryOrder Order) {
+  if (Order == MO_RELEASE || Order == MO_ACQ_REL || Order == MO_SEQ_CST)
+    printLn("  fence rw, w");
+}
+
+// 判断是否为需要加内存屏障读写的_Atomic对象
+static bool isAtomicScalar(Type *Ty) {
+  return Ty->IsAtomic && (isNumeric(Ty) || Ty->Kind == TY_PTR);
+}
+
 // 加载a0指向的值
 static void load(Type *Ty) {
+  // _Atomic对象的读取为顺序一致的
+  if (isAtomicScalar(Ty)) {
+    Type Plain = *Ty;
+    Plain.IsAtomic = false;
+    fenceBeforeLoad(MO_SEQ_CST);
+    load(&Plain);
+    fenceAfterLoad(MO_SEQ_CST);
+    return;
+  }
+
   switch (Ty->Kind) {
   case TY_ARRAY:
   case TY_STRUCT:
   case TY_UNION:
+  case TY_VECTOR:
   case TY_FUNC:
   case TY_VLA:
     return;
@@ -229,23 +498,84 @@ static void load(Type *Ty) {
     printLn("  ld a0, 0(a0)");
 }
 
+// 对象地址的对齐值，包括__builtin_assume_aligned假定的对齐值
+static int addrAlign(Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_VAR:
+    return MAX(Nd->Ty->Align, Nd->Var->Align);
+  case ND_DEREF: {
+    Node *Ptr = Nd->LHS;
+    while (Ptr->Kind == ND_CAST)
+      Ptr = Ptr->LHS;
+    if (Ptr->Kind == ND_ALIGNED)
+      return MAX(Nd->Ty->Align, Ptr->Val);
+    return Nd->Ty->Align;
+  }
+  case ND_MEMBER: {
+    // 成员的偏移量可能降低对齐值
+    int Align = addrAlign(Nd->LHS);
+    int Offset = Nd->Mem->Offset;
+    if (Offset)
+      Align = MIN(Align, Offset & -Offset);
+    return MAX(Align, Nd->Ty->Align);
+  }
+  default:
+    return Nd->Ty->Align;
+  }
+}
+
+// 将Src指向的内存复制到Dst指向的地址，使用t0、t1
+// 每次复制的字节数不超过两侧地址共同的对齐值
+static void copyMem(char *Dst, char *Src, int Size, int Align) {
+  for (int I = 0; I < Size;) {
+    int Sz = MIN(Align, 8);
+    while (Sz > Size - I)
+      Sz /= 2;
+    char *S = Sz == 8 ? "d" : Sz == 4 ? "w" : Sz == 2 ? "h" : "b";
+
+    if (isImm12(I)) {
+      printLn("  l%s t1, %d(%s)", S, I, Src);
+      printLn("  s%s t1, %d(%s)", S, I, Dst);
+    } else {
+      printLn("  li t0, %d", I);
+      printLn("  add t0, %s, t0", Src);
+      printLn("  l%s t1, 0(t0)", S);
+
+      printLn("  li t0, %d", I);
+      printLn("  add t0, %s, t0", Dst);
+      printLn("  s%s t1, 0(t0)", S);
+    }
+    I += Sz;
+  }
+}
+
+// 将a0指向的结构体复制到a1指向的地址
+static void copyStruct(int Size, int Align) {
+  copyMem("a1", "a0", Size, Align);
+}
+
 // 将栈顶值(为一个地址)存入a0
 static void store(Type *Ty) {
+  // _Atomic对象的写入为顺序一致的
+  if (isAtomicScalar(Ty)) {
+    Type Plain = *Ty;
+    Plain.IsAtomic = false;
+    fenceBeforeStore(MO_SEQ_CST);
+    store(&Plain);
+    return;
+  }
+
   pop(1);
 
   switch (Ty->Kind) {
   case TY_STRUCT:
   case TY_UNION:
     printLn("  # 对%s进行赋值", Ty->Kind == TY_STRUCT ? "结构体" : "联合体");
-    for (int I = 0; I < Ty->Size; ++I) {
-      printLn("  li t0, %d", I);
-      printLn("  add t0, a0, t0");
-      printLn("  lb t1, 0(t0)");
-
-      printLn("  li t0, %d", I);
-      printLn("  add t0, a1, t0");
-      printLn("  sb t1, 0(t0)");
-    }
+    copyStruct(Ty->Size, Ty->Align);
+    return;
+  case TY_VECTOR:
+    printLn("  # 对向量进行赋值");
+    copyStruct(Ty->Size, Ty->Align);
     return;
   case TY_FLOAT:
     printLn("  # 将fa0的值，写入到a1中存放的地址");
@@ -525,6 +855,24 @@ static void cast(Type *From, Type *To) {
   // 获取类型的枚举值
   int T1 = getTypeId(From);
   int T2 = getTypeId(To);
+
+  // 支持位操作扩展时，使用单条指令进行零扩展和符号扩展
+  char *Ext = castTable[T1][T2];
+  char *Insn = NULL;
+  if (OptZba && Ext == i64u32)
+    Insn = "zext.w";
+  else if (OptZbb && Ext == i64i8)
+    Insn = "sext.b";
+  else if (OptZbb && Ext == i64i16)
+    Insn = "sext.h";
+  else if (OptZbb && Ext == i64u16)
+    Insn = "zext.h";
+  if (Insn) {
+    printLn("  # 使用%s进行类型转换", Insn);
+    printLn("  %s a0, a0", Insn);
+    return;
+  }
+
   if (castTable[T1][T2]) {
     printLn("  # 转换函数");
     if (T1 == F128)
@@ -535,6 +883,32 @@ static void cast(Type *From, Type *To) {
   }
 }
 
+// 按大小选择访存指令的后缀
+static char sizeSuffix(int Size) {
+  return Size == 1 ? 'b' : Size == 2 ? 'h' : Size == 4 ? 'w' : 'd';
+}
+
+// 向量与同样大小的向量、整数之间的转换，按位重新解释
+static void genVecCast(Node *Nd) {
+  Type *From = Nd->LHS->Ty, *To = Nd->Ty;
+  // 向量之间只改变类型，a0仍为地址
+  if (From->Kind == TY_VECTOR && To->Kind == TY_VECTOR)
+    return;
+  if (To->Kind == TY_VOID)
+    return;
+  // 向量转换为整数，读取a0指向的值
+  if (From->Kind == TY_VECTOR) {
+    load(To);
+    return;
+  }
+
+  // 标量写入临时变量，a0为其地址
+  printLn("  # 将整数按位写入临时的向量");
+  genStackAddr("t1", Nd->VecTmp->Offset);
+  printLn("  s%c a0, 0(t1)", sizeSuffix(From->Size));
+  printLn("  mv a0, t1");
+}
+
 // 获取浮点结构体的成员类型
 void getFloStMemsTy(Type *Ty, Type **RegsTy, int *Idx) {
   switch (Ty->Kind) {
@@ -552,7 +926,8 @@ void getFloStMemsTy(Type *Ty, Type **RegsTy, int *Idx) {
       *Idx += 2;
     return;
   case TY_LDOUBLE:
-    // long double不是浮点结构体
+  case TY_VECTOR:
+    // long double和向量不是浮点结构体
     *Idx += 2;
     return;
   case TY_ARRAY:
@@ -570,8 +945,10 @@ void getFloStMemsTy(Type *Ty, Type **RegsTy, int *Idx) {
 }
 
 // 是否为一或两个含浮点成员变量的结构体
+// 结果写入类型的副本中，不修改各函数共享的类型
 void setFloStMemsTy(Type **Ty, int GP, int FP) {
-  Type *T = *Ty;
+  Type *T = copyType(*Ty);
+  *Ty = T;
   T->FSReg1Ty = TyVoid;
   T->FSReg2Ty = TyVoid;
 
@@ -602,13 +979,20 @@ void setFloStMemsTy(Type **Ty, int GP, int FP) {
   }
 }
 
+// 被调用的函数为函数名时，返回该函数，否则为函数指针，返回NULL
+static Obj *directCallee(Node *Nd) {
+  if (Nd->Kind == ND_VAR && Nd->Var->IsFunction)
+    return Nd->Var;
+  return NULL;
+}
+
 // 为大结构体开辟空间
 static int createBSSpace(Node *Args) {
   int BSStack = 0;
   for (Node *Arg = Args; Arg; Arg = Arg->Next) {
     Type *Ty = Arg->Ty;
-    // 大于16字节的结构体
-    if (Ty->Size > 16 && Ty->Kind == TY_STRUCT) {
+    // 大于16字节的结构体或向量
+    if (Ty->Size > 16 && (Ty->Kind == TY_STRUCT || Ty->Kind == TY_VECTOR)) {
       printLn("\n  # 大于16字节的结构体，先开辟相应的栈空间\n");
       int Sz = alignTo(Ty->Size, 8);
       printLn("  addi sp, sp, -%d", Sz);
@@ -637,14 +1021,13 @@ static void pushStruct(Type *Ty) {
     int BSOffset = (Depth + BSDepth) * 8;
     BSDepth += Sz / 8;
 
-    printLn("  # 复制%d字节的，结构体到%d(sp)的位置", Sz, BSOffset);
-    for (int I = 0; I < Sz; I++) {
-      printLn("  lb t0, %d(a0)", I);
-      printLn("  sb t0, %d(sp)", I + BSOffset);
-    }
+    printLn("  # 复制%d字节的结构体到%d(sp)的位置", Ty->Size, BSOffset);
+    printLn("  mv a1, sp");
+    genAddImm("a1", BSOffset);
+    copyStruct(Ty->Size, Ty->Align);
 
     printLn("  # 大于16字节的结构体，对结构体地址压栈");
-    printLn("  addi a0, sp, %d", BSOffset);
+    printLn("  mv a0, a1");
     push();
     return;
   }
@@ -675,13 +1058,62 @@ static void pushStruct(Type *Ty) {
   Depth += Sz / 8;
 
   printLn("  # 开辟%d字节的空间，复制%s的内存", Sz, Str);
-  for (int I = 0; I < Ty->Size; I++) {
-    printLn("  lb t0, %d(a0)", I);
-    printLn("  sb t0, %d(sp)", I);
-  }
+  printLn("  mv a1, sp");
+  copyStruct(Ty->Size, Ty->Align);
   return;
 }
 
+static bool isSimpleAddr(Node *Nd);
+
+// 判断表达式能否不调用函数，只写入a0、fa0和t0计算出来
+static bool isSimpleExpr(Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_NUM:
+    return true;
+  case ND_VAR:
+  case ND_MEMBER:
+    return isSimpleAddr(Nd);
+  case ND_DEREF:
+    return isSimpleExpr(Nd->LHS);
+  case ND_ADDR:
+    return isSimpleAddr(Nd->LHS);
+  case ND_CAST: {
+    // 只允许整数、指针之间，或float、double之间的转换
+    Type *From = Nd->LHS->Ty, *To = Nd->Ty;
+    bool IntFrom = isInteger(From) || From->Kind == TY_PTR;
+    bool IntTo = isInteger(To) || To->Kind == TY_PTR;
+    if (!(IntFrom && IntTo) && !(isFloatOrDouble(From) && isFloatOrDouble(To)))
+      return false;
+    return isSimpleExpr(Nd->LHS);
+  }
+  default:
+    return false;
+  }
+}
+
+// 判断左值的地址能否如此计算
+static bool isSimpleAddr(Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_VAR:
+    return !Nd->Var->IsTLS;
+  case ND_DEREF:
+    return isSimpleExpr(Nd->LHS);
+  case ND_MEMBER:
+    return !Nd->Mem->IsBitfield && isSimpleAddr(Nd->LHS);
+  default:
+    return false;
+  }
+}
+
+// 判断寄存器传递的实参能否在其他实参弹栈后，直接计算到传参的寄存器中
+static bool isSimpleArg(Node *Arg) {
+  Type *Ty = Arg->Ty;
+  if (!isInteger(Ty) && !isFloatOrDouble(Ty) && Ty->Kind != TY_PTR &&
+      Ty->Kind != TY_ARRAY && Ty->Kind != TY_FUNC)
+    return false;
+  return isSimpleExpr(Arg);
+}
+
 // 将函数实参计算后压入栈中
 static void pushArgs2(Node *Args, bool FirstPass) {
   // 参数为空直接返回
@@ -697,6 +1129,10 @@ static void pushArgs2(Node *Args, bool FirstPass) {
       (!FirstPass && Args->PassByStack))
     return;
 
+  // 直接计算到寄存器中的实参无需压栈
+  if (Args->IsDirect)
+    return;
+
   printLn("\n  # ↓对表达式进行计算，然后压栈↓");
   // 计算出表达式
   genExpr(Args);
@@ -704,6 +1140,7 @@ static void pushArgs2(Node *Args, bool FirstPass) {
   switch (Args->Ty->Kind) {
   case TY_STRUCT:
   case TY_UNION:
+  case TY_VECTOR:
     pushStruct(Args->Ty);
     break;
   case TY_FLOAT:
@@ -732,14 +1169,25 @@ static int pushArgs(Node *Nd) {
   if (Nd->RetBuffer && Nd->Ty->Size > 16)
     GP++;
 
+  // 简单的实参直接计算到寄存器中，不经过栈
+  // fa0不是这样的实参时，计算浮点实参会覆盖它，浮点实参仍需经过栈
+  // 可变参数中的long double会调整寄存器的编号，之后的实参仍需经过栈
+  bool FA0Direct = true;
+  bool VarLD = false;
+
   // 遍历所有参数，优先使用寄存器传递，然后是栈传递
   Type *CurArg = Nd->FuncType->Params;
   for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next) {
+    Arg->IsDirect = false;
+
     // 如果是可变参数的参数，只使用整型寄存器和栈传递
     if (Nd->FuncType->IsVariadic && CurArg == NULL) {
       int64_t Val = Arg->Val ? Arg->Val : Arg->FVal;
+      if (Arg->Ty->Kind == TY_LDOUBLE)
+        VarLD = true;
       if (GP < GP_MAX) {
         printLn("  # 可变参数%ld值通过a%d传递", Val, GP);
+        Arg->IsDirect = !VarLD && !isFloNum(Arg->Ty) && isSimpleArg(Arg);
         GP++;
       } else {
         printLn("  # 可变参数%ld值通过栈传递", Val);
@@ -757,11 +1205,15 @@ static int pushArgs(Node *Nd) {
 
     switch (Ty->Kind) {
     case TY_STRUCT:
-    case TY_UNION: {
-      // 判断结构体的类型
+    case TY_UNION:
+    case TY_VECTOR: {
+      // 判断结构体的类型，压栈时使用实参上记录的寄存器类型
       setFloStMemsTy(&Ty, GP, FP);
+      Arg->Ty = Ty;
       // 处理一或两个浮点成员变量的结构体
       if (isFloNum(Ty->FSReg1Ty) || isFloNum(Ty->FSReg2Ty)) {
+        if (FP == 0)
+          FA0Direct = false;
         Type *Regs[2] = {Ty->FSReg1Ty, Ty->FSReg2Ty};
         for (int I = 0; I < 2; ++I) {
           if (isFloNum(Regs[I]))
@@ -789,6 +1241,9 @@ static int pushArgs(Node *Nd) {
       // 浮点优先使用FP，而后是GP，最后是栈传递
       if (FP < FP_MAX) {
         printLn("  # 浮点%Lf值通过fa%d传递", Arg->FVal, FP);
+        Arg->IsDirect = isSimpleArg(Arg);
+        if (FP == 0 && !Arg->IsDirect)
+          FA0Direct = false;
         FP++;
       } else if (GP < GP_MAX) {
         printLn("  # 浮点%Lf值通过a%d传递", Arg->FVal, GP);
@@ -814,6 +1269,7 @@ static int pushArgs(Node *Nd) {
       // 整型优先使用GP，最后是栈传递
       if (GP < GP_MAX) {
         printLn("  # 整型%ld值通过a%d传递", Arg->Val, GP);
+        Arg->IsDirect = isSimpleArg(Arg);
         GP++;
       } else {
         printLn("  # 整型%ld值通过栈传递", Arg->Val);
@@ -824,6 +1280,11 @@ static int pushArgs(Node *Nd) {
     }
   }
 
+  if (!FA0Direct)
+    for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next)
+      if (isFloNum(Arg->Ty))
+        Arg->IsDirect = false;
+
   // 对齐栈边界
   if ((Depth + Stack) % 2 == 1) {
     printLn("  # 对齐栈边界到16字节");
@@ -843,14 +1304,26 @@ static int pushArgs(Node *Nd) {
 
   if (Nd->RetBuffer && Nd->Ty->Size > 16) {
     printLn("  # 返回类型是大于16字节的结构体，指向其的指针，压入栈顶");
-    printLn("  li t0, %d", Nd->RetBuffer->Offset);
-    printLn("  add a0, fp, t0");
+    genStackAddr("a0", Nd->RetBuffer->Offset);
     push();
   }
 
   return Stack + BSStack;
 }
 
+// 弹栈到传参的寄存器a%d
+// 之后还要直接计算实参时，a0会被覆盖，先暂存在t2中
+static void popArg(int Reg, bool HasDirect) {
+  if (Reg != 0 || !HasDirect) {
+    pop(Reg);
+    return;
+  }
+  printLn("  # 弹栈，将栈顶的值暂存入t2");
+  printLn("  ld t2, 0(sp)");
+  printLn("  addi sp, sp, 8");
+  Depth--;
+}
+
 // 复制结构体返回值到缓冲区中
 static void copyRetBuffer(Obj *Var) {
   Type *Ty = Var->Ty;
@@ -860,8 +1333,7 @@ static void copyRetBuffer(Obj *Var) {
 
   printLn("  # 拷贝到返回缓冲区");
   printLn("  # 加载struct地址到t0");
-  printLn("  li t0, %d", Var->Offset);
-  printLn("  add t1, fp, t0");
+  genStackAddr("t1", Var->Offset);
 
   // 处理浮点结构体的情况
   if (isFloNum(Ty->FSReg1Ty) || isFloNum(Ty->FSReg2Ty)) {
@@ -971,9 +1443,7 @@ static void copyStructMem(void) {
 
   printLn("  # 复制大于16字节结构体内存");
   printLn("  # 将栈内struct地址存入t1，调用者的结构体的地址");
-  printLn("  li t0, %d", Var->Offset);
-  printLn("  add t0, fp, t0");
-  printLn("  ld t1, 0(t0)");
+  printLn("  ld t1, %s", stackSlot(Var->Offset, 8));
 
   printLn("  # 遍历结构体并从a0位置复制所有字节到t1");
   for (int I = 0; I < Ty->Size; I++) {
@@ -997,9 +1467,7 @@ static void builtinAlloca(void) {
   // rcx->t2
   // printLn("  mov %d(%%rbp), %%rcx", current_fn->alloca_bottom->offset);
   // 加载老sp到t2中
-  printLn("  li t0, %d", CurrentFn->AllocaBottom->Offset);
-  printLn("  add t0, fp, t0");
-  printLn("  ld t2, 0(t0)");
+  printLn("  ld t2, %s", stackSlot(CurrentFn->AllocaBottom->Offset, 8));
   // 老sp-新sp
   // printLn("  sub %%rsp, %%rcx");
   printLn("  sub t2, t2, sp");
@@ -1016,11 +1484,11 @@ static void builtinAlloca(void) {
   printLn("  mv t3, sp");
 
   int C = count();
-  printLn(".L.alloca1.%d:", C);
+  printLn(".L.alloca1.%s.%d:", CurrentFn->Name, C);
   // printLn("  cmp $0, %%rcx");
   // printLn("  je 2f");
   // t1为0跳转到标签2
-  printLn("beqz t2, .L.alloca2.%d", C);
+  printLn("beqz t2, .L.alloca2.%s.%d", CurrentFn->Name, C);
   // r8b->t0
   // printLn("  mov (%%rax), %%r8b");
   // printLn("  mov %%r8b, (%%rdx)");
@@ -1034,707 +1502,4359 @@ static void builtinAlloca(void) {
   // printLn("  dec %%rcx");
   printLn("  addi t2, t2, -1");
   // printLn("  jmp 1b");
-  printLn("  j .L.alloca1.%d", C);
-  printLn(".L.alloca2.%d:", C);
+  printLn("  j .L.alloca1.%s.%d", CurrentFn->Name, C);
+  printLn(".L.alloca2.%s.%d:", CurrentFn->Name, C);
 
   // Move alloca_bottom pointer.
   // printLn("  mov %d(%%rbp), %%rax", current_fn->alloca_bottom->offset);
-  printLn("  li t0, %d", CurrentFn->AllocaBottom->Offset);
-  printLn("  add t0, fp, t0");
-  printLn("  ld a0, 0(t0)");
+  char *Slot = stackSlot(CurrentFn->AllocaBottom->Offset, 8);
+  printLn("  ld a0, %s", Slot);
   // printLn("  sub %%rdi, %%rax");
   printLn("  sub a0, a0, t1");
   // printLn("  mov %%rax, %d(%%rbp)", current_fn->alloca_bottom->offset);
-  printLn("sd a0, 0(t0)");
+  printLn("  sd a0, %s", Slot);
 }
 
-// 生成表达式
-static void genExpr(Node *Nd) {
-  // .loc 文件编号 行号
-  printLn("  .loc %d %d", Nd->Tok->File->FileNo, Nd->Tok->LineNo);
+// 判断节点是否为整型常量，并获取转换为节点类型后的值
+static bool isConstInt(Node *Nd, int64_t *Val) {
+  if (!isInteger(Nd->Ty))
+    return false;
 
-  // 生成各个根节点
-  switch (Nd->Kind) {
-  // 空表达式
-  case ND_NULL_EXPR:
+  if (Nd->Kind == ND_NUM) {
+    *Val = Nd->Val;
+    return true;
+  }
+
+  if (Nd->Kind != ND_CAST || !isInteger(Nd->LHS->Ty) ||
+      !isConstInt(Nd->LHS, Val))
+    return false;
+
+  // 截断到转换后的类型
+  bool U = Nd->Ty->IsUnsigned;
+  switch (Nd->Ty->Size) {
+  case 1:
+    *Val = U ? (uint8_t)*Val : (int8_t)*Val;
+    break;
+  case 2:
+    *Val = U ? (uint16_t)*Val : (int16_t)*Val;
+    break;
+  case 4:
+    // 分开赋值，避免条件表达式将int32_t转换为uint32_t
+    if (U)
+      *Val = (uint32_t)*Val;
+    else
+      *Val = (int32_t)*Val;
+    break;
+  }
+  return true;
+}
+
+// 向下取整的以2为底的对数，N不能为0
+static int log2Floor(uint64_t N) {
+  int K = 0;
+  while (N >>= 1)
+    K++;
+  return K;
+}
+
+// 判断是否为2的幂，是则返回其指数，否则返回-1
+static int log2Exact(uint64_t N) {
+  if (!N || (N & (N - 1)))
+    return -1;
+  return log2Floor(N);
+}
+
+// 乘以常量时，判断能否用不超过三条的移位和加减指令代替乘法
+static bool isCheapMul(int64_t C) {
+  // 取绝对值，避免最小负数溢出
+  uint64_t U = C < 0 ? -(uint64_t)C : C;
+  if (U <= 1 || log2Exact(U) >= 0 || log2Exact(U + 1) >= 0)
+    return true;
+  if (C < 0)
+    return false;
+  // 2^k+1，或两个2的幂之和
+  return log2Exact(U - 1) >= 0 || log2Exact(U & (U - 1)) >= 0;
+}
+
+// a0乘以常量C，W为"w"时按32位计算
+static void genMulConst(int64_t C, char *W) {
+  uint64_t U = C < 0 ? -(uint64_t)C : C;
+  printLn("  # a0×%ld，使用移位和加减代替乘法", C);
+
+  if (U == 0) {
+    printLn("  li a0, 0");
     return;
-  // 加载数字到a0
+  }
 
-  // float和uint32、double和uint64 共用一份内存空间
-  case ND_NUM: {
-    switch (Nd->Ty->Kind) {
-    case TY_FLOAT: {
-      union {
-        float F32;
-        uint32_t U32;
-      } U;
-      U.F32 = Nd->FVal;
-      printLn("  # 将a0转换到float类型值为%Lf的fa0中", Nd->FVal);
-      printLn("  li a0, %u  # float %Lf", U.U32, Nd->FVal);
-      printLn("  fmv.w.x fa0, a0");
-      return;
+  // ±2^k
+  int K = log2Exact(U);
+  if (K >= 0) {
+    if (K > 0)
+      printLn("  slli%s a0, a0, %d", W, K);
+    else if (*W)
+      printLn("  sext.w a0, a0");
+    if (C < 0)
+      printLn("  neg%s a0, a0", W);
+    return;
+  }
+
+  // ±(2^k-1)
+  K = log2Exact(U + 1);
+  if (K >= 0) {
+    printLn("  slli%s t0, a0, %d", W, K);
+    if (C < 0)
+      printLn("  sub%s a0, a0, t0", W);
+    else
+      printLn("  sub%s a0, t0, a0", W);
+    return;
+  }
+
+  // 2^k+1
+  K = log2Exact(U - 1);
+  if (K >= 0) {
+    printLn("  slli%s t0, a0, %d", W, K);
+    printLn("  add%s a0, a0, t0", W);
+    return;
+  }
+
+  // 2^a+2^b
+  printLn("  slli%s t0, a0, %d", W, log2Exact(U & (U - 1)));
+  printLn("  slli%s a0, a0, %d", W, log2Exact(U & -U));
+  printLn("  add%s a0, a0, t0", W);
+}
+
+// 计算有符号除法的魔数M和移位量S，使得x/D=(x*M)>>(Bits+S)，再修正舍入
+// 算法见Hacker's Delight第10章，D不能为0和±1
+static void signedMagic(int64_t D, int Bits, int64_t *M, int *S) {
+  uint64_t Mask = Bits == 64 ? ~0UL : (1UL << Bits) - 1;
+  uint64_t Two = 1UL << (Bits - 1);
+  uint64_t AD = (D < 0 ? -(uint64_t)D : D) & Mask;
+  uint64_t T = Two + (D < 0);
+  uint64_t ANC = T - 1 - T % AD;
+  uint64_t Q1 = Two / ANC, R1 = Two - Q1 * ANC;
+  uint64_t Q2 = Two / AD, R2 = Two - Q2 * AD;
+  uint64_t Delta;
+  int P = Bits - 1;
+
+  do {
+    P++;
+    Q1 = (Q1 * 2) & Mask;
+    R1 = R1 * 2;
+    if (R1 >= ANC) {
+      Q1 = (Q1 + 1) & Mask;
+      R1 -= ANC;
     }
-    case TY_DOUBLE: {
-      union {
-        double F64;
-        uint64_t U64;
-      } U;
-      printLn("  # 将a0转换到double类型值为%Lf的fa0中", Nd->FVal);
-      U.F64 = Nd->FVal;
-      printLn("  li a0, %lu  # double %Lf", U.U64, Nd->FVal);
-      printLn("  fmv.d.x fa0, a0");
-      return;
+    Q2 = (Q2 * 2) & Mask;
+    R2 = R2 * 2;
+    if (R2 >= AD) {
+      Q2 = (Q2 + 1) & Mask;
+      R2 -= AD;
     }
-    case TY_LDOUBLE: {
-#ifdef __riscv
-      union {
-        long double F128;
-        uint64_t U64[2];
-      } U;
-      memset(&U, 0, sizeof(U));
-      U.F128 = Nd->FVal;
-      printLn("  # 将long double类型的%Lf值，压入LD栈中", Nd->FVal);
-      printLn("  li a0, 0x%016lx  # long double %Lf", U.U64[0], Nd->FVal);
-      printLn("  fmv.d.x fs%d, a0", LDSP);
+    Delta = AD - R2;
+  } while (Q1 < Delta || (Q1 == Delta && R1 == 0));
+
+  uint64_t Mag = (Q2 + 1) & Mask;
+  if (D < 0)
+    Mag = -Mag & Mask;
+  *M = Bits == 64 ? (int64_t)Mag : (int32_t)Mag;
+  *S = P - Bits;
+}
 
-      printLn("  li a0, 0x%016lx", U.U64[1]);
-      printLn("  fmv.d.x fs%d, a0", LDSP + 1);
-      LDSP += 2;
-      return;
-#endif // __riscv
-#ifdef __x86_64
-      // 【注意】交叉环境当中，x86_64的long double是f80而非f128
-      // 因而此处的支持仅供交叉测试，存在f80->f64的精度的丢失！
-      union {
-        double F64;
-        uint64_t U64;
-      } U = {Nd->FVal};
-      printLn("  # 【注意】此处存在f80->f64的精度丢失！！！");
-      printLn("  # 将long double类型的%Lf值，压入LD栈中", Nd->FVal);
-      printLn("  li a0, %lu  # double %Lf", U.U64, Nd->FVal);
-      printLn("  fmv.d.x fa0, a0");
-      printLn("  call __extenddftf2@plt");
-      pushLD();
-      return;
-#endif // __x86_64
-    }
-    default:
-      printLn("  # 将%ld加载到a0中", Nd->Val);
-      printLn("  li a0, %ld", Nd->Val);
-      return;
+// 计算64位无符号除法的魔数M和移位量S
+// Add为真时，M实际需要65位，由调用者补上最高位
+static void unsignedMagic(uint64_t D, uint64_t *M, int *S, bool *Add) {
+  uint64_t Max = ~0UL >> 1;
+  uint64_t Q = Max / D, R = Max - Q * D;
+  uint64_t P64 = 0, Delta;
+  int P = 63;
+  *Add = false;
+
+  do {
+    P++;
+    P64 = P == 64 ? 1 : P64 * 2;
+    if (R + 1 >= D - R) {
+      if (Q >= Max)
+        *Add = true;
+      Q = Q * 2 + 1;
+      R = R * 2 + 1 - D;
+    } else {
+      if (Q >= Max + 1)
+        *Add = true;
+      Q = Q * 2;
+      R = R * 2 + 1;
     }
+    Delta = D - 1 - R;
+  } while (P < 128 && P64 < Delta);
+
+  *M = Q + 1;
+  *S = P - 64;
+}
+
+// 计算a0除以常量D的商，存入Rd，不修改a0
+// 使用乘法和移位代替除法，Is32为真时按32位计算
+static void genDivConst(int64_t D, bool IsUnsigned, bool Is32, char *Rd) {
+  char *W = Is32 ? "w" : "";
+  int Bits = Is32 ? 32 : 64;
+  printLn("  # a0÷%ld，使用乘法和移位代替除法", D);
+
+  if (D == 1) {
+    printLn("  %s %s, a0", Is32 ? "sext.w" : "mv", Rd);
+    return;
   }
-  // 对寄存器取反
-  case ND_NEG:
-    // 计算左部的表达式
-    genExpr(Nd->LHS);
 
-    switch (Nd->Ty->Kind) {
-    case TY_FLOAT:
-      printLn("  # 对float类型的fa0值进行取反");
-      printLn("  fneg.s fa0, fa0");
-      return;
-    case TY_DOUBLE:
-      printLn("  # 对double类型的fa0值进行取反");
-      printLn("  fneg.d fa0, fa0");
+  if (IsUnsigned) {
+    uint64_t UD = Is32 ? (uint32_t)D : (uint64_t)D;
+
+    // 2^k
+    int K = log2Exact(UD);
+    if (K >= 0) {
+      printLn("  srli%s %s, a0, %d", W, Rd, K);
       return;
-    case TY_LDOUBLE:
-      printLn("  # 对long double类型的LD栈顶值进行取反");
-      printLn("  li t0, -1");
-      printLn("  slli t0, t0, 63");
-      printLn("  xor a%d, a%d, t0", LDSP + 1, LDSP + 1);
+    }
+
+    // 被除数为32位无符号数，需要零扩展
+    char *X = "a0";
+    if (Is32) {
+      printLn("  slli t2, a0, 32");
+      printLn("  srli t2, t2, 32");
+      X = "t2";
+    }
+
+    // 除数最高位为1时，商只能是0或1
+    if (UD >> (Bits - 1)) {
+      printLn("  li t1, %lu", UD);
+      printLn("  sltu t0, %s, t1", X);
+      printLn("  xori %s, t0, 1", Rd);
       return;
-    default:
-      // neg a0, a0是sub a0, x0, a0的别名, 即a0=0-a0
-      printLn("  # 对a0值进行取反");
-      printLn("  neg a0, a0");
+    }
+
+    // 32位时，33位的魔数左移后可以直接用mulhu得到商
+    if (Is32) {
+      int L = log2Floor(UD) + 1;
+      uint64_t M = (1UL << (32 + L)) / UD + 1;
+      printLn("  li t1, %lu", M << (32 - L));
+      printLn("  mulhu %s, t2, t1", Rd);
       return;
     }
-  // 变量
-  case ND_VAR:
-    // 计算出变量的地址，然后存入a0
-    genAddr(Nd);
-    load(Nd->Ty);
-    return;
-  // 成员变量
-  case ND_MEMBER: {
-    // 计算出成员变量的地址，然后存入a0
-    genAddr(Nd);
-    load(Nd->Ty);
 
-    Member *Mem = Nd->Mem;
-    if (Mem->IsBitfield) {
-      printLn("  # 清除位域的成员变量（%d字节）未用到的位", Mem->BitWidth);
-      // 清除位域成员变量未用到的高位
-      printLn("  slli a0, a0, %d", 64 - Mem->BitWidth - Mem->BitOffset);
-      // 清除位域成员变量未用到的低位
-      if (Mem->Ty->IsUnsigned)
-        printLn("  srli a0, a0, %d", 64 - Mem->BitWidth);
-      else
-        printLn("  srai a0, a0, %d", 64 - Mem->BitWidth);
+    uint64_t M;
+    int S;
+    bool Add;
+    unsignedMagic(UD, &M, &S, &Add);
+    printLn("  li t1, %lu", M);
+    printLn("  mulhu t0, a0, t1");
+    if (!Add) {
+      printLn("  srli %s, t0, %d", Rd, S);
+      return;
     }
+    // 魔数的第65位：q=(((x-t)>>1)+t)>>(S-1)
+    printLn("  sub t1, a0, t0");
+    printLn("  srli t1, t1, 1");
+    printLn("  add t0, t1, t0");
+    printLn("  srli %s, t0, %d", Rd, S - 1);
     return;
   }
-  // 解引用
-  case ND_DEREF:
-    genExpr(Nd->LHS);
-    load(Nd->Ty);
-    return;
-  // 取地址
-  case ND_ADDR:
-    genAddr(Nd->LHS);
+
+  if (D == -1) {
+    printLn("  neg%s %s, a0", W, Rd);
     return;
-  // 赋值
-  case ND_ASSIGN:
-    // 左部是左值，保存值到的地址
-    genAddr(Nd->LHS);
-    push();
-    // 右部是右值，为表达式的值
-    genExpr(Nd->RHS);
+  }
 
-    // 如果是位域成员变量，需要先从内存中读取当前值，然后合并到新值中
-    if (Nd->LHS->Kind == ND_MEMBER && Nd->LHS->Mem->IsBitfield) {
-      printLn("\n  # 位域成员变量进行赋值↓");
-      printLn("  # 备份需要赋的a0值");
-      printLn("  mv t2, a0");
+  // ±2^k，负数需要先加上2^k-1，使商向零取整
+  int K = log2Exact(D < 0 ? -(uint64_t)D : D);
+  if (K >= 0) {
+    printLn("  srai%s t0, a0, %d", W, Bits - 1);
+    printLn("  srli%s t0, t0, %d", W, Bits - K);
+    printLn("  add%s t0, a0, t0", W);
+    if (D > 0) {
+      printLn("  srai%s %s, t0, %d", W, Rd, K);
+      return;
+    }
+    printLn("  srai%s t0, t0, %d", W, K);
+    printLn("  neg%s %s, t0", W, Rd);
+    return;
+  }
 
-      printLn("  # 计算位域成员变量的新值：");
-      Member *Mem = Nd->LHS->Mem;
-      // 将需要赋的值a0存入t1
-      printLn("  mv t1, a0");
-      // 构造一个和位域成员长度相同，全为1的二进制数
-      printLn("  li t0, %ld", (1L << Mem->BitWidth) - 1);
-      // 取交之后，位域长度的低位，存储了我们需要的值，其他位都为0
-      printLn("  and t1, t1, t0");
-      // 然后将该值左移，相应的位偏移量中
-      // 此时我们所需要的位域数值已经处于正确的位置，且其他位置都为0
-      printLn("  slli t1, t1, %d", Mem->BitOffset);
+  int64_t M;
+  int S;
+  signedMagic(D, Bits, &M, &S);
+
+  if (Is32) {
+    // 32位的被除数和魔数的乘积不超过64位，将加减被除数的修正合并到魔数中
+    if (D > 0 && M < 0)
+      M += 1L << 32;
+    if (D < 0 && M > 0)
+      M -= 1L << 32;
+    printLn("  sext.w t2, a0");
+    printLn("  li t1, %ld", M);
+    printLn("  mul t0, t2, t1");
+    printLn("  srai t0, t0, %d", 32 + S);
+  } else {
+    printLn("  li t1, %ld", M);
+    printLn("  mulh t0, a0, t1");
+    if (D > 0 && M < 0)
+      printLn("  add t0, t0, a0");
+    if (D < 0 && M > 0)
+      printLn("  sub t0, t0, a0");
+    printLn("  srai t0, t0, %d", S);
+  }
 
-      printLn("  # 读取位域当前值：");
-      // 将位域值保存的地址加载进来
-      printLn("  ld a0, 0(sp)");
-      // 读取该地址的值
-      load(Mem->Ty);
+  // 商为负数时加1，使商向零取整
+  printLn("  srli t1, t0, 63");
+  printLn("  add%s %s, t0, t1", W, Rd);
+}
 
-      printLn("  # 写入成员变量新值到位域当前值中：");
-      // 位域值对应的掩码，即t1需要写入的位置
-      // 掩码位都为1，其余位为0
-      long Mask = ((1L << Mem->BitWidth) - 1) << Mem->BitOffset;
-      // 对掩码取反，此时，其余位都为1，掩码位都为0
-      printLn("  li t0, %ld", ~Mask);
-      // 取交，保留除掩码位外所有的位
-      printLn("  and a0, a0, t0");
-      // 取或，将成员变量的新值写入到掩码位
-      printLn("  or a0, a0, t1");
+// 乘、除、取余的右部为常量时，使用移位、加减和乘法代替
+// 返回是否已经生成了代码
+static bool genMulDivConst(Node *Nd) {
+  int64_t C;
+  if (!isInteger(Nd->Ty) || !isConstInt(Nd->RHS, &C))
+    return false;
 
-      store(Nd->Ty);
-      printLn("  # 恢复需要赋的a0值作为返回值");
-      printLn("  mv a0, t2");
-      printLn("  # 完成位域成员变量的赋值↑\n");
-      return;
-    }
+  bool Is32 = !(Nd->LHS->Ty->Kind == TY_LONG || Nd->LHS->Ty->Base);
+  if (Is32 && Nd->Ty->IsUnsigned)
+    C = (uint32_t)C;
+  else if (Is32)
+    C = (int32_t)C;
 
-    store(Nd->Ty);
-    return;
-  // 语句表达式
-  case ND_STMT_EXPR:
-    for (Node *N = Nd->Body; N; N = N->Next)
-      genStmt(N);
-    return;
-  // 逗号
-  case ND_COMMA:
+  switch (Nd->Kind) {
+  case ND_MUL:
+    // 32位乘积的低32位与符号无关，按有符号数处理，如0xffffffff视为-1
+    if (Is32)
+      C = (int32_t)C;
+    if (!isCheapMul(C))
+      return false;
     genExpr(Nd->LHS);
-    genExpr(Nd->RHS);
-    return;
-  // 类型转换
-  case ND_CAST:
+    genMulConst(C, Is32 ? "w" : "");
+    return true;
+  case ND_DIV:
+    if (C == 0)
+      return false;
     genExpr(Nd->LHS);
-    cast(Nd->LHS->Ty, Nd->Ty);
-    return;
-  // 内存清零
-  case ND_MEMZERO: {
-    printLn("  # 对%s的内存%d(fp)清零%d位", Nd->Var->Name, Nd->Var->Offset,
-            Nd->Var->Ty->Size);
-    // 对栈内变量所占用的每个字节都进行清零
-    for (int I = 0; I < Nd->Var->Ty->Size; I++) {
-      printLn("  li t0, %d", Nd->Var->Offset + I);
-      printLn("  add t0, fp, t0");
-      printLn("  sb zero, 0(t0)");
+    genDivConst(C, Nd->Ty->IsUnsigned, Is32, "a0");
+    return true;
+  case ND_MOD: {
+    if (C == 0)
+      return false;
+    genExpr(Nd->LHS);
+
+    // 无符号数对2^k取余，只保留低位
+    uint64_t Mask = Is32 ? (uint32_t)C - 1 : (uint64_t)C - 1;
+    if (Nd->Ty->IsUnsigned && log2Exact(Mask + 1) >= 0) {
+      printLn("  # a0%%%lu，只保留低位", Mask + 1);
+      if (Mask < 2048) {
+        printLn("  andi a0, a0, %lu", Mask);
+      } else {
+        printLn("  li t1, %lu", Mask);
+        printLn("  and a0, a0, t1");
+      }
+      if (Is32)
+        printLn("  sext.w a0, a0");
+      return true;
     }
-    return;
+
+    // a0-(a0÷C)×C
+    char *W = Is32 ? "w" : "";
+    genDivConst(C, Nd->Ty->IsUnsigned, Is32, "t0");
+    printLn("  # a0%%%ld=a0-(a0÷%ld)×%ld", C, C, C);
+    printLn("  li t1, %ld", C);
+    printLn("  mul%s t0, t0, t1", W);
+    printLn("  sub%s a0, a0, t0", W);
+    return true;
   }
-  // 条件运算符
-  case ND_COND: {
-    int C = count();
-    printLn("\n# =====条件运算符%d===========", C);
-    genExpr(Nd->Cond);
-    notZero(Nd->Cond->Ty);
-    printLn("  # 条件判断，为0则跳转");
-    printLn("  beqz a0, .L.else.%d", C);
-    genExpr(Nd->Then);
-    printLn("  # 跳转到条件运算符结尾部分");
-    printLn("  j .L.end.%d", C);
-    printLn(".L.else.%d:", C);
-    genExpr(Nd->Els);
-    printLn(".L.end.%d:", C);
-    return;
+  default:
+    return false;
   }
-  // 非运算
-  case ND_NOT:
-    genExpr(Nd->LHS);
-    notZero(Nd->LHS->Ty);
-    printLn("  # 非运算");
-    // a0=0则置1，否则为0
-    printLn("  seqz a0, a0");
-    return;
-  // 逻辑与
-  case ND_LOGAND: {
-    int C = count();
-    printLn("\n# =====逻辑与%d===============", C);
-    genExpr(Nd->LHS);
-    // 判断是否为短路操作
-    notZero(Nd->LHS->Ty);
-    printLn("  # 左部短路操作判断，为0则跳转");
-    printLn("  beqz a0, .L.false.%d", C);
-    genExpr(Nd->RHS);
-    notZero(Nd->RHS->Ty);
-    printLn("  # 右部判断，为0则跳转");
-    printLn("  beqz a0, .L.false.%d", C);
-    printLn("  li a0, 1");
-    printLn("  j .L.end.%d", C);
-    printLn(".L.false.%d:", C);
-    printLn("  li a0, 0");
-    printLn(".L.end.%d:", C);
-    return;
+}
+
+// 判断是否为不改变值的类型转换
+// 常规算术转换会为同类型的操作数也加上转换，指针加法会将偏移量转换为指针
+static bool isNopCast(Node *Nd) {
+  if (Nd->Kind != ND_CAST)
+    return false;
+  Type *From = Nd->LHS->Ty, *To = Nd->Ty;
+  if (!(isInteger(From) || From->Kind == TY_PTR) ||
+      !(isInteger(To) || To->Kind == TY_PTR))
+    return false;
+  if (From->Kind == TY_BOOL || To->Kind == TY_BOOL)
+    return From->Kind == To->Kind;
+  // 64位时不区分符号，更窄的类型需要符号相同
+  return From->Size == To->Size &&
+         (From->Size == 8 || From->IsUnsigned == To->IsUnsigned);
+}
+
+// 跳过不改变值的类型转换
+static Node *skipNopCast(Node *Nd) {
+  while (isNopCast(Nd))
+    Nd = Nd->LHS;
+  return Nd;
+}
+
+// 判断是否为同一个整型变量，读取变量没有副作用，可以交换计算的次序
+static bool isSameVar(Node *A, Node *B) {
+  A = skipNopCast(A);
+  B = skipNopCast(B);
+  return A->Kind == ND_VAR && B->Kind == ND_VAR && A->Var == B->Var &&
+         isInteger(A->Ty);
+}
+
+// 获取乘以2^k或左移k位（k≤3）的被乘数，返回k；否则返回0
+static int scaleShift(Node *Nd, Node **Idx) {
+  int64_t C;
+  Nd = skipNopCast(Nd);
+  *Idx = Nd;
+  if (Nd->Kind == ND_MUL && isConstInt(Nd->RHS, &C) && C > 0 && C <= 8 &&
+      log2Exact(C) >= 0) {
+    *Idx = Nd->LHS;
+    return log2Exact(C);
   }
-  // 逻辑或
-  case ND_LOGOR: {
-    int C = count();
-    printLn("\n# =====逻辑或%d===============", C);
-    genExpr(Nd->LHS);
-    notZero(Nd->LHS->Ty);
-    // 判断是否为短路操作
-    printLn("  # 左部短路操作判断，不为0则跳转");
-    printLn("  bnez a0, .L.true.%d", C);
-    genExpr(Nd->RHS);
-    notZero(Nd->RHS->Ty);
-    printLn("  # 右部判断，不为0则跳转");
-    printLn("  bnez a0, .L.true.%d", C);
-    printLn("  li a0, 0");
-    printLn("  j .L.end.%d", C);
-    printLn(".L.true.%d:", C);
-    printLn("  li a0, 1");
-    printLn(".L.end.%d:", C);
-    return;
+  if (Nd->Kind == ND_SHL && isConstInt(Nd->RHS, &C) && C > 0 && C <= 3) {
+    *Idx = Nd->LHS;
+    return C;
   }
-  // 按位取非运算
-  case ND_BITNOT:
-    genExpr(Nd->LHS);
-    printLn("  # 按位取反");
-    // 这里的 not a0, a0 为 xori a0, a0, -1 的伪码
-    printLn("  not a0, a0");
-    return;
-  // 函数调用
-  case ND_FUNCALL: {
-    if (Nd->LHS->Kind == ND_VAR && !strcmp(Nd->LHS->Var->Name, "alloca")) {
-      genExpr(Nd->Args);
-      // printLn("  mov %%rax, %%rdi");
-      printLn("  mv t1, a0");
-      builtinAlloca();
-      return;
-    }
+  return 0;
+}
 
-    // 计算所有参数的值，正向压栈
-    // 此处获取到栈传递参数的数量
-    int StackArgs = pushArgs(Nd);
-    genExpr(Nd->LHS);
-    // 将a0的值存入t0
-    printLn("  mv t0, a0");
+// 64位加法的一侧乘以2、4、8时，使用Zba扩展的sh1add、sh2add、sh3add
+// 该侧由无符号32位整数扩展而来时，使用.uw的版本，省去零扩展
+static bool genShiftAdd(Node *Nd) {
+  if (!(Nd->LHS->Ty->Kind == TY_LONG || Nd->LHS->Ty->Base))
+    return false;
+
+  for (int I = 0; I < 2; I++) {
+    Node *Base = I ? Nd->RHS : Nd->LHS;
+    Node *Idx;
+    int K = scaleShift(I ? Nd->LHS : Nd->RHS, &Idx);
+    bool UW = Idx->Kind == ND_CAST && Idx->Ty->Size == 8 &&
+              isInteger(Idx->LHS->Ty) && Idx->LHS->Ty->Size == 4 &&
+              Idx->LHS->Ty->IsUnsigned;
+    if (UW)
+      Idx = Idx->LHS;
+    else if (K == 0)
+      continue;
 
-    // 反向弹栈，a0->参数1，a1->参数2……
-    int GP = 0, FP = 0;
+    genExpr(Idx);
+    push();
+    genExpr(Base);
+    pop(1);
+    printLn("  # a1左移%d位后加上a0，结果写入a0", K);
+    if (K)
+      printLn("  sh%dadd%s a0, a1, a0", K, UW ? ".uw" : "");
+    else
+      printLn("  add.uw a0, a1, a0");
+    return true;
+  }
+  return false;
+}
 
-    if (Nd->RetBuffer && Nd->Ty->Size > 16) {
-      printLn("  # 返回结构体大于16字节，那么第一个参数指向返回缓冲区");
-      pop(GP++);
-    }
+// 循环移位：(x<<n)|(x>>(W-n))，使用Zbb扩展的rol、ror
+static bool genRotate(Node *Nd) {
+  if (Nd->Kind != ND_BITOR || !Nd->Ty->IsUnsigned ||
+      (Nd->Ty->Size != 4 && Nd->Ty->Size != 8))
+    return false;
+
+  Node *Shl = skipNopCast(Nd->LHS), *Shr = skipNopCast(Nd->RHS);
+  if (Shl->Kind == ND_SHR) {
+    Node *Tmp = Shl;
+    Shl = Shr;
+    Shr = Tmp;
+  }
+  if (Shl->Kind != ND_SHL || Shr->Kind != ND_SHR ||
+      !isSameVar(Shl->LHS, Shr->LHS) || Shl->LHS->Ty->Size != Nd->Ty->Size)
+    return false;
+
+  int Bits = Nd->Ty->Size * 8;
+  char *W = Bits == 32 ? "w" : "";
+  int64_t A, B;
+
+  // 常量的移位量
+  if (isConstInt(Shl->RHS, &A) && isConstInt(Shr->RHS, &B)) {
+    if (A <= 0 || B <= 0 || A + B != Bits)
+      return false;
+    genExpr(Shl->LHS);
+    printLn("  # a0循环右移%ld位", B);
+    printLn("  rori%s a0, a0, %ld", W, B);
+    return true;
+  }
 
-    // 读取函数形参中的参数类型
-    Type *CurArg = Nd->FuncType->Params;
-    for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next) {
-      // 如果是可变参数函数
-      // 匹配到空参数（最后一个）的时候，将剩余的整型寄存器弹栈
-      if (Nd->FuncType->IsVariadic && CurArg == NULL) {
-        if (GP < GP_MAX) {
-          if (Arg->Ty->Kind == TY_LDOUBLE) {
-            // 在可变参数函数的调用中
-            // LD的第一个寄存器必须是偶数下标，即a0,a2,a4,a6
-            if (GP % 2 == 1)
-              GP++;
-            printLn("  # long double通过a%d,a%d传递可变实参", GP, GP + 1);
-            pop(GP++);
-            if (GP < GP_MAX)
-              pop(GP++);
-          } else {
-            printLn("  # a%d传递可变实参", GP);
-            pop(GP++);
-          }
-        }
-        continue;
-      }
+  // 变量的移位量，另一侧为W-n
+  char *Op;
+  Node *Amt;
+  Node *L = skipNopCast(Shl->RHS), *R = skipNopCast(Shr->RHS);
+  if (R->Kind == ND_SUB && isConstInt(R->LHS, &A) && A == Bits &&
+      isSameVar(R->RHS, L)) {
+    Op = "rol";
+    Amt = Shl->RHS;
+  } else if (L->Kind == ND_SUB && isConstInt(L->LHS, &A) && A == Bits &&
+             isSameVar(L->RHS, R)) {
+    Op = "ror";
+    Amt = Shr->RHS;
+  } else {
+    return false;
+  }
 
-      CurArg = CurArg->Next;
-      // 实参的类型
-      Type *Ty = Arg->Ty;
+  genExpr(Amt);
+  push();
+  genExpr(Shl->LHS);
+  pop(1);
+  printLn("  # a0循环%s移a1位", Op[2] == 'l' ? "左" : "右");
+  printLn("  %s%s a0, a0, a1", Op, W);
+  return true;
+}
 
-      switch (Ty->Kind) {
-      case TY_STRUCT:
-      case TY_UNION: {
-        // 判断结构体的类型
-        // 结构体的大小
-        int Sz = Ty->Size;
+// 一侧按位取反的与、或、异或，使用Zbb扩展的andn、orn、xnor
+static bool genLogicNot(Node *Nd) {
+  char *Op = Nd->Kind == ND_BITAND  ? "andn"
+             : Nd->Kind == ND_BITOR ? "orn"
+                                    : "xnor";
+  for (int I = 0; I < 2; I++) {
+    Node *X = I ? Nd->RHS : Nd->LHS;
+    Node *Not = skipNopCast(I ? Nd->LHS : Nd->RHS);
+    if (Not->Kind != ND_BITNOT)
+      continue;
 
-        // 处理一或两个浮点成员变量的结构体
-        if (isFloatOrDouble(Ty->FSReg1Ty) || isFloatOrDouble(Ty->FSReg2Ty)) {
-          Type *Regs[2] = {Ty->FSReg1Ty, Ty->FSReg2Ty};
-          for (int I = 0; I < 2; ++I) {
-            if (Regs[I]->Kind == TY_FLOAT) {
-              printLn("  # %d字节float结构体%d通过fa%d传递", Sz, I, FP);
-              printLn("  # 弹栈，将栈顶的值存入fa%d", FP);
-              printLn("  flw fa%d, 0(sp)", FP++);
-              printLn("  addi sp, sp, 8");
-              Depth--;
-            }
-            if (Regs[I]->Kind == TY_DOUBLE) {
-              printLn("  # %d字节double结构体%d通过fa%d传递", Sz, I, FP);
-              popF(FP++);
-            }
-            if (isInteger(Regs[I])) {
-              printLn("  # %d字节浮点结构体%d通过a%d传递", Sz, I, GP);
-              pop(GP++);
-            }
-          }
-          break;
-        }
+    genExpr(Not->LHS);
+    push();
+    genExpr(X);
+    pop(1);
+    printLn("  # a0与取反的a1进行%s运算", Op);
+    printLn("  %s a0, a0, a1", Op);
+    return true;
+  }
+  return false;
+}
 
-        // 其他整型结构体或多字节结构体
-        // 9~16字节整型结构体用两个寄存器，其他字节结构体用一个结构体
-        int Regs = (8 < Sz && Sz <= 16) ? 2 : 1;
-        for (int I = 1; I <= Regs; ++I) {
-          if (GP < GP_MAX) {
-            printLn("  # %d字节的整型结构体%d通过a%d传递", Sz, I, GP);
-            pop(GP++);
-          }
-        }
-        break;
-      }
-      case TY_FLOAT:
-      case TY_DOUBLE:
-        if (FP < FP_MAX) {
-          printLn("  # fa%d传递浮点参数", FP);
-          popF(FP++);
-        } else if (GP < GP_MAX) {
-          printLn("  # a%d传递浮点参数", GP);
-          pop(GP++);
-        }
-        break;
-      case TY_LDOUBLE:
-        if (GP == GP_MAX - 1) {
-          printLn("  # a%d传递LD一半参数", GP);
-          pop(GP++);
-        }
-        if (GP< GP_MAX-1) {
-          printLn("  # a%d传递long double第%d部分参数", GP, 1);
-          pop(GP++);
-          pop(GP++);
-        }
-        break;
-      default:
-        if (GP < GP_MAX) {
-          printLn("  # a%d传递整型参数", GP);
-          pop(GP++);
-        }
-        break;
+// 判断是否为1<<n，n为变量
+static bool isBitOfVar(Node *Nd) {
+  int64_t C;
+  Nd = skipNopCast(Nd);
+  return Nd->Kind == ND_SHL && Nd->Ty->Size == 8 && isConstInt(Nd->LHS, &C) &&
+         C == 1 && !isConstInt(Nd->RHS, &C);
+}
+
+// 单个位的置位、清零、取反和提取，使用Zbs扩展的bset、bclr、binv、bext
+static bool genSingleBit(Node *Nd) {
+  for (int I = 0; I < 2; I++) {
+    Node *X = skipNopCast(I ? Nd->RHS : Nd->LHS);
+    Node *Y = skipNopCast(I ? Nd->LHS : Nd->RHS);
+    int64_t C;
+
+    // x&~(1<<n)、x|(1<<n)、x^(1<<n)，只处理64位，32位需要保持符号扩展
+    Node *Bit = Nd->Kind == ND_BITAND && Y->Kind == ND_BITNOT ? Y->LHS : Y;
+    if ((Nd->Kind != ND_BITAND || Bit != Y) && Nd->Ty->Size == 8 &&
+        isBitOfVar(Bit)) {
+      Bit = skipNopCast(Bit);
+      char *Op = Nd->Kind == ND_BITAND  ? "bclr"
+                 : Nd->Kind == ND_BITOR ? "bset"
+                                        : "binv";
+      genExpr(Bit->RHS);
+      push();
+      genExpr(X);
+      pop(1);
+      printLn("  # 对a0的第a1位进行%s运算", Op);
+      printLn("  %s a0, a0, a1", Op);
+      return true;
+    }
+
+    // (x>>n)&1
+    if (Nd->Kind == ND_BITAND && X->Kind == ND_SHR && isConstInt(Y, &C) &&
+        C == 1) {
+      if (isConstInt(X->RHS, &C)) {
+        genExpr(X->LHS);
+        printLn("  # 提取a0的第%ld位", C);
+        printLn("  bexti a0, a0, %ld", C);
+        return true;
       }
+      genExpr(X->RHS);
+      push();
+      genExpr(X->LHS);
+      pop(1);
+      printLn("  # 提取a0的第a1位");
+      printLn("  bext a0, a0, a1");
+      return true;
     }
 
-    // 调用函数
-    printLn("  # 调用函数");
-    printLn("  jalr t0");
+    // 常量只有一位不同、超出12位立即数时，使用bseti、bclri、binvi
+    // 32位时不能修改第31位，以保持符号扩展
+    if (!isConstInt(Y, &C))
+      continue;
+    int K = log2Exact(Nd->Kind == ND_BITAND ? ~(uint64_t)C : (uint64_t)C);
+    if (K < 11 || (Nd->Ty->Size == 4 && K >= 31))
+      continue;
+    char *Op = Nd->Kind == ND_BITAND  ? "bclri"
+               : Nd->Kind == ND_BITOR ? "bseti"
+                                      : "binvi";
+    genExpr(X);
+    printLn("  # 对a0的第%d位进行%s运算", K, Op);
+    printLn("  %s a0, a0, %d", Op, K);
+    return true;
+  }
+  return false;
+}
 
-    if (Nd->Ty->Kind == TY_LDOUBLE) {
-      printLn("  # 保存Long double类型函数的返回值");
-      pushLD();
-    }
+// 使用位操作扩展的指令，返回是否已经生成了代码
+static bool genBitmanip(Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_ADD:
+    return OptZba && genShiftAdd(Nd);
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+    return (OptZbs && genSingleBit(Nd)) ||
+           (OptZbb && (genRotate(Nd) || genLogicNot(Nd)));
+  default:
+    return false;
+  }
+}
 
-    // 回收为栈传递的变量开辟的栈空间
-    if (StackArgs) {
-      // 栈的深度减去栈传递参数的字节数
-      Depth -= StackArgs;
-      printLn("  # 回收栈传递参数的%d个字节", StackArgs * 8);
-      printLn("  addi sp, sp, %d", StackArgs * 8);
-      // 清除记录的大结构体的数量
-      BSDepth = 0;
+// 最小值和最大值：a<b?a:b、a<b?b:a，使用Zbb扩展的min、max
+static bool genMinMax(Node *Nd) {
+  Node *Cond = Nd->Cond;
+  if (Cond->Kind != ND_LT && Cond->Kind != ND_LE)
+    return false;
+
+  char *Op;
+  if (isSameVar(Nd->Then, Cond->LHS) && isSameVar(Nd->Els, Cond->RHS))
+    Op = "min";
+  else if (isSameVar(Nd->Then, Cond->RHS) && isSameVar(Nd->Els, Cond->LHS))
+    Op = "max";
+  else
+    return false;
+
+  genExpr(Cond->RHS);
+  push();
+  genExpr(Cond->LHS);
+  pop(1);
+  char *U = Cond->LHS->Ty->IsUnsigned ? "u" : "";
+  printLn("  # a0和a1的%s值", Op[1] == 'i' ? "最小" : "最大");
+  printLn("  %s%s a0, a0, a1", Op, U);
+  return true;
+}
+
+// 计算a0中前导零、末尾零或为1的位数，Is32时只计算低32位
+// 支持Zbb扩展时使用clz、ctz、cpop指令，否则循环计算
+static void genBitCount(NodeKind Kind, bool Is32) {
+  char *W = Is32 ? "w" : "";
+  if (OptZbb) {
+    char *Op = Kind == ND_CLZ ? "clz" : Kind == ND_CTZ ? "ctz" : "cpop";
+    printLn("  # 计算位数");
+    printLn("  %s%s a0, a0", Op, W);
+    return;
+  }
+
+  int C = count();
+  if (Is32) {
+    printLn("  # 零扩展到64位");
+    printLn("  slli a0, a0, 32");
+    printLn("  srli a0, a0, 32");
+  }
+
+  if (Kind == ND_CLZ) {
+    // 每次右移一位，直到a0为0
+    printLn("  # 循环计算前导零的个数");
+    printLn("  li t0, %d", Is32 ? 32 : 64);
+    printLn(".L.bitcount.%s.%d:", CurrentFn->Name, C);
+    printLn("  beqz a0, .L.bitcount_end.%s.%d", CurrentFn->Name, C);
+    printLn("  srli a0, a0, 1");
+    printLn("  addi t0, t0, -1");
+  } else {
+    // 末尾零的个数，等于(a0&-a0)-1中1的个数
+    if (Kind == ND_CTZ) {
+      printLn("  # 末尾零的个数，等于(a0&-a0)-1中1的个数");
+      printLn("  neg t0, a0");
+      printLn("  and a0, a0, t0");
+      printLn("  addi a0, a0, -1");
     }
+    // 每次清除最低位的1，直到a0为0
+    printLn("  # 循环计算1的个数");
+    printLn("  li t0, 0");
+    printLn(".L.bitcount.%s.%d:", CurrentFn->Name, C);
+    printLn("  beqz a0, .L.bitcount_end.%s.%d", CurrentFn->Name, C);
+    printLn("  addi t1, a0, -1");
+    printLn("  and a0, a0, t1");
+    printLn("  addi t0, t0, 1");
+  }
+  printLn("  j .L.bitcount.%s.%d", CurrentFn->Name, C);
+  printLn(".L.bitcount_end.%s.%d:", CurrentFn->Name, C);
+  printLn("  mv a0, t0");
+}
 
-    // 清除寄存器中高位无关的数据
+// 完整的内存屏障
+static void genFence(MemoryOrder Order) {
+  switch (Order) {
+  case MO_RELAXED:
+    return;
+  case MO_CONSUME:
+  case MO_ACQUIRE:
+    printLn("  fence r, rw");
+    return;
+  case MO_RELEASE:
+    printLn("  fence rw, w");
+    return;
+  case MO_ACQ_REL:
+    printLn("  fence.tso");
+    return;
+  case MO_SEQ_CST:
+    printLn("  fence rw, rw");
+    return;
+  }
+}
+
+// amo指令的aq、rl后缀
+static char *amoSuffix(MemoryOrder Order) {
+  switch (Order) {
+  case MO_RELAXED:
+    return "";
+  case MO_CONSUME:
+  case MO_ACQUIRE:
+    return ".aq";
+  case MO_RELEASE:
+    return ".rl";
+  default:
+    return ".aqrl";
+  }
+}
+
+// lr指令的后缀，顺序一致时需要同时带有aq和rl
+static char *lrSuffix(MemoryOrder Order) {
+  if (Order == MO_SEQ_CST)
+    return ".aqrl";
+  if (Order == MO_CONSUME || Order == MO_ACQUIRE || Order == MO_ACQ_REL)
+    return ".aq";
+  return "";
+}
+
+// sc指令的后缀
+static char *scSuffix(MemoryOrder Order) {
+  if (Order == MO_RELEASE || Order == MO_ACQ_REL || Order == MO_SEQ_CST)
+    return ".rl";
+  return "";
+}
+
+// 计算原子读改写的新值：Rd = Old op Val
+// Is32时使用w后缀的指令，保持32位值的符号扩展
+static void genAtomicOp(NodeKind Op, char *Rd, char *Old, char *Val,
+                        bool Is32) {
+  char *W = Is32 ? "w" : "";
+  switch (Op) {
+  case ND_ASSIGN:
+    printLn("  mv %s, %s", Rd, Val);
+    return;
+  // 减法的操作数已取负
+  case ND_ADD:
+  case ND_SUB:
+    printLn("  add%s %s, %s, %s", W, Rd, Old, Val);
+    return;
+  case ND_BITAND:
+    printLn("  and %s, %s, %s", Rd, Old, Val);
+    break;
+  case ND_BITOR:
+    printLn("  or %s, %s, %s", Rd, Old, Val);
+    break;
+  case ND_BITXOR:
+    printLn("  xor %s, %s, %s", Rd, Old, Val);
+    break;
+  case ND_BITNOT:
+    printLn("  and %s, %s, %s", Rd, Old, Val);
+    printLn("  not %s, %s", Rd, Rd);
+    break;
+  default:
+    unreachable();
+  }
+  if (Is32)
+    printLn("  sext.w %s, %s", Rd, Rd);
+}
+
+// 计算1、2字节对象在对齐的4字节中的位置
+// a0对齐到4字节，t3为字段的位偏移，t4为字段的掩码
+static void genSubWordAddr(int Size) {
+  printLn("  # 地址对齐到4字节，计算字段的位偏移和掩码");
+  printLn("  andi t3, a0, 3");
+  printLn("  slli t3, t3, 3");
+  printLn("  andi a0, a0, -4");
+  printLn("  li t4, %d", Size == 1 ? 0xff : 0xffff);
+  printLn("  sll t4, t4, t3");
+}
+
+// 原子读改写，a0为地址，a1为操作数，结果存入a0
+// 4、8字节使用amo指令，与非运算和1、2字节使用lr/sc循环
+static void genAtomicRW(Node *Nd) {
+  NodeKind Op = Nd->AtomicOp;
+  MemoryOrder Order = Nd->Order;
+  int Size = Nd->Ty->Size;
+  char *W = Size == 8 ? "d" : "w";
+  int C = count();
+
+  // 减法转换为加上操作数的负值
+  if (Op == ND_SUB)
+    printLn("  neg a1, a1");
+
+  if (Size >= 4 && Op != ND_BITNOT) {
+    char *Amo = Op == ND_ASSIGN   ? "amoswap"
+                : Op == ND_BITAND ? "amoand"
+                : Op == ND_BITOR  ? "amoor"
+                : Op == ND_BITXOR ? "amoxor"
+                                  : "amoadd";
+    printLn("  # 原子读改写，a0为原值");
+    printLn("  %s.%s%s a0, a1, (a0)", Amo, W, amoSuffix(Order));
+    if (!Nd->AtomicFetch)
+      genAtomicOp(Op, "a0", "a0", "a1", Size == 4);
+    // 32位的结果是符号扩展的，无符号类型需要零扩展
+    if (Size == 4 && Nd->Ty->IsUnsigned)
+      cast(TyLong, Nd->Ty);
+    return;
+  }
+
+  if (Size >= 4) {
+    printLn("  # 使用lr/sc循环进行原子读改写");
+    printLn(".L.atomic.%s.%d:", CurrentFn->Name, C);
+    printLn("  lr.%s%s t0, (a0)", W, lrSuffix(Order));
+    genAtomicOp(Op, "t1", "t0", "a1", Size == 4);
+    printLn("  sc.%s%s t2, t1, (a0)", W, scSuffix(Order));
+    printLn("  bnez t2, .L.atomic.%s.%d", CurrentFn->Name, C);
+    printLn("  mv a0, %s", Nd->AtomicFetch ? "t0" : "t1");
+    if (Size == 4 && Nd->Ty->IsUnsigned)
+      cast(TyLong, Nd->Ty);
+    return;
+  }
+
+  // 1、2字节的对象，对所在的4字节进行lr/sc，只修改其中的字段
+  genSubWordAddr(Size);
+  printLn("  sll a1, a1, t3");
+  printLn("  # 使用lr/sc循环进行原子读改写");
+  printLn(".L.atomic.%s.%d:", CurrentFn->Name, C);
+  printLn("  lr.w%s t0, (a0)", lrSuffix(Order));
+  genAtomicOp(Op, "t1", "t0", "a1", false);
+  printLn("  # 将新值中的字段合并到原值中");
+  printLn("  xor t1, t1, t0");
+  printLn("  and t1, t1, t4");
+  printLn("  xor t1, t1, t0");
+  printLn("  sc.w%s t2, t1, (a0)", scSuffix(Order));
+  printLn("  bnez t2, .L.atomic.%s.%d", CurrentFn->Name, C);
+  printLn("  # 取出字段的值");
+  printLn("  and a0, %s, t4", Nd->AtomicFetch ? "t0" : "t1");
+  printLn("  srl a0, a0, t3");
+  cast(TyLong, Nd->Ty);
+}
+
+// 比较并交换，a0为地址，a1为新值，a2指向期望值
+// 成功时a0置1，失败时将当前值写入a2指向的地址，a0置0
+static void genCas(Type *Ty, MemoryOrder Order) {
+  int Size = Ty->Size;
+  char *W = Size == 8 ? "d" : "w";
+  char *Fn = CurrentFn->Name;
+  int C = count();
+
+  if (Size >= 4) {
+    printLn("  # 读取期望值");
+    printLn("  l%s a3, 0(a2)", W);
+    printLn(".L.cas.%s.%d:", Fn, C);
+    printLn("  lr.%s%s t0, (a0)", W, lrSuffix(Order));
+    printLn("  bne t0, a3, .L.cas_fail.%s.%d", Fn, C);
+    printLn("  sc.%s%s t1, a1, (a0)", W, scSuffix(Order));
+    printLn("  bnez t1, .L.cas.%s.%d", Fn, C);
+    printLn("  li a0, 1");
+    printLn("  j .L.cas_end.%s.%d", Fn, C);
+    printLn(".L.cas_fail.%s.%d:", Fn, C);
+    printLn("  # 失败时将当前值写回期望值");
+    printLn("  s%s t0, 0(a2)", W);
+    printLn("  li a0, 0");
+    printLn(".L.cas_end.%s.%d:", Fn, C);
+    return;
+  }
+
+  // 1、2字节的对象，比较所在的4字节中的字段
+  char *S = Size == 1 ? "b" : "h";
+  genSubWordAddr(Size);
+  printLn("  # 读取期望值，并移动到字段的位置");
+  printLn("  l%su a3, 0(a2)", S);
+  printLn("  sll a3, a3, t3");
+  printLn("  sll a1, a1, t3");
+  printLn("  and a1, a1, t4");
+  printLn(".L.cas.%s.%d:", Fn, C);
+  printLn("  lr.w%s t0, (a0)", lrSuffix(Order));
+  printLn("  and t1, t0, t4");
+  printLn("  bne t1, a3, .L.cas_fail.%s.%d", Fn, C);
+  printLn("  # 将新值合并到原值中");
+  printLn("  xor t2, t0, t1");
+  printLn("  or t2, t2, a1");
+  printLn("  sc.w%s t1, t2, (a0)", scSuffix(Order));
+  printLn("  bnez t1, .L.cas.%s.%d", Fn, C);
+  printLn("  li a0, 1");
+  printLn("  j .L.cas_end.%s.%d", Fn, C);
+  printLn(".L.cas_fail.%s.%d:", Fn, C);
+  printLn("  # 失败时将当前值写回期望值");
+  printLn("  srl t1, t1, t3");
+  printLn("  s%s t1, 0(a2)", S);
+  printLn("  li a0, 0");
+  printLn(".L.cas_end.%s.%d:", Fn, C);
+}
+
+// 判断语句是否只有__builtin_unreachable
+static bool isUnreachable(Node *Nd) {
+  if (Nd->Kind == ND_BLOCK)
+    return Nd->Body && !Nd->Body->Next && isUnreachable(Nd->Body);
+  if (Nd->Kind != ND_EXPR_STMT)
+    return false;
+  Node *Expr = Nd->LHS;
+  while (Expr->Kind == ND_CAST)
+    Expr = Expr->LHS;
+  return Expr->Kind == ND_UNREACH;
+}
+
+// 根据__builtin_expect，预测条件的值：1为真，0为假，-1为未知
+static int branchHint(Node *Nd) {
+  while (Nd->Kind == ND_CAST)
+    Nd = Nd->LHS;
+
+  switch (Nd->Kind) {
+  case ND_EXPECT:
+    return Nd->Val != 0;
+  case ND_NOT: {
+    int Hint = branchHint(Nd->LHS);
+    return Hint < 0 ? Hint : !Hint;
+  }
+  case ND_LOGAND: {
+    int L = branchHint(Nd->LHS), R = branchHint(Nd->RHS);
+    if (L == 0 || R == 0)
+      return 0;
+    return L == 1 && R == 1 ? 1 : -1;
+  }
+  case ND_LOGOR: {
+    int L = branchHint(Nd->LHS), R = branchHint(Nd->RHS);
+    if (L == 1 || R == 1)
+      return 1;
+    return L == 0 && R == 0 ? 0 : -1;
+  }
+  default:
+    return -1;
+  }
+}
+
+//
+// 放入寄存器的局部变量
+//
+// -O1时，地址未被获取的整型和指针局部变量在整个函数中存放于s寄存器，
+// 寄存器中的值与从栈中读取时相同，已按类型进行符号扩展或零扩展。
+//
+
+// 复合赋值中指向寄存器变量的临时变量TMP，及其指向的变量
+static _Thread_local Obj *RegTmp;
+static _Thread_local Obj *RegTmpVar;
+
+// 判断是否为复合赋值中的 TMP = &LV
+static bool isTmpAddr(Node *Nd) {
+  return Nd->Kind == ND_ASSIGN && Nd->LHS->Kind == ND_VAR &&
+         !*Nd->LHS->Var->Name && skipNopCast(Nd->RHS)->Kind == ND_ADDR;
+}
+
+// 左值为放入寄存器的变量，或者指向它的TMP解引用时，返回该变量
+static Obj *regVar(Node *LV) {
+  if (LV->Kind == ND_VAR && LV->Var->Reg)
+    return LV->Var;
+  if (RegTmp && LV->Kind == ND_DEREF && LV->LHS->Kind == ND_VAR &&
+      LV->LHS->Var == RegTmp)
+    return RegTmpVar;
+  return NULL;
+}
+
+// 从栈中读取局部变量的值，存入寄存器Reg
+static void loadVarSlot(char *Reg, Obj *Var) {
+  int Size = Var->Ty->Size;
+  char *Op = Size == 1 ? "lb" : Size == 2 ? "lh" : Size == 4 ? "lw" : "ld";
+  char *Suffix = Size < 8 && Var->Ty->IsUnsigned ? "u" : "";
+  printLn("  %s%s %s, %s", Op, Suffix, Reg, stackSlot(Var->Offset, Size));
+}
+
+// 读取局部变量的值，存入a0
+static void loadVar(Obj *Var) {
+  if (Var->Reg) {
+    printLn("  # 读取s%d中的局部变量%s", Var->Reg, Var->Name);
+    printLn("  mv a0, s%d", Var->Reg);
+    return;
+  }
+  loadVarSlot("a0", Var);
+}
+
+// 判断表达式的值是否已按类型Ty扩展，与从栈中读取时相同
+static bool isExtended(Node *Nd, Type *Ty) {
+  if (Ty->Size == 8)
+    return true;
+  Type *T = Nd->Ty;
+  bool Same = isInteger(T) && T->Size == Ty->Size &&
+              T->IsUnsigned == Ty->IsUnsigned &&
+              (T->Kind == TY_BOOL) == (Ty->Kind == TY_BOOL);
+
+  switch (Nd->Kind) {
+  case ND_NUM: {
+    int Bits = Ty->Size * 8;
+    int64_t V = Ty->IsUnsigned ? (int64_t)((uint64_t)Nd->Val << (64 - Bits) >>
+                                           (64 - Bits))
+                               : Nd->Val << (64 - Bits) >> (64 - Bits);
+    if (Ty->Kind == TY_BOOL)
+      return Nd->Val == 0 || Nd->Val == 1;
+    return V == Nd->Val;
+  }
+  // 结果为0或1
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+  case ND_NOT:
+  case ND_LOGAND:
+  case ND_LOGOR:
+    return true;
+  // 读取时已扩展
+  case ND_VAR:
+  case ND_DEREF:
+    return Same;
+  case ND_MEMBER:
+    return Same && !Nd->Mem->IsBitfield;
+  // 整数之间的转换或者进行了扩展，或者不改变a0
+  case ND_CAST: {
+    Type *From = Nd->LHS->Ty;
+    if (!Same || !(isInteger(From) || From->Kind == TY_PTR))
+      return false;
+    if (T->Kind == TY_BOOL || castTable[getTypeId(From)][getTypeId(T)])
+      return true;
+    return isExtended(Nd->LHS, Ty);
+  }
+  // 32位的运算使用w后缀的指令，结果是符号扩展的
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+  case ND_DIV:
+  case ND_MOD:
+  case ND_SHL:
+  case ND_SHR:
+    return Same && T->Size == 4 && !T->IsUnsigned;
+  default:
+    return false;
+  }
+}
+
+// 将a0写入局部变量，Ext为a0已按变量的类型扩展
+static void storeVar(Obj *Var, bool Ext) {
+  if (!Var->Reg) {
+    storeGeneral(0, Var->Offset, Var->Ty->Size);
+    return;
+  }
+  // 截断并扩展为从栈中读取时的值
+  if (!Ext && Var->Ty->Size == 4 && !Var->Ty->IsUnsigned)
+    printLn("  sext.w a0, a0");
+  else if (!Ext && Var->Ty->Size < 8)
+    cast(TyLong, Var->Ty);
+  printLn("  # 将a0写入s%d中的局部变量%s", Var->Reg, Var->Name);
+  printLn("  mv s%d, a0", Var->Reg);
+}
+
+// 生成表达式
+static void genExpr(Node *Nd) {
+  // .loc 文件编号 行号
+  printLn("  .loc %d %d", Nd->Tok->File->FileNo, Nd->Tok->LineNo);
+
+  // 循环优化中放入寄存器的值
+  if (genLoopVal(Nd))
+    return;
+
+  // 向量的运算
+  if (Nd->VecTmp && Nd->Kind != ND_CAST) {
+    genVecOp(Nd);
+    return;
+  }
+
+  // 生成各个根节点
+  switch (Nd->Kind) {
+  // 空表达式
+  case ND_NULL_EXPR:
+    return;
+  // 加载数字到a0
+
+  // float和uint32、double和uint64 共用一份内存空间
+  case ND_NUM: {
     switch (Nd->Ty->Kind) {
-    case TY_BOOL:
-      printLn("  # 清除bool类型的高位");
-      printLn("  slli a0, a0, 63");
-      printLn("  srli a0, a0, 63");
-      return;
-    case TY_CHAR:
-      printLn("  # 清除char类型的高位");
-      if (Nd->Ty->IsUnsigned) {
-        printLn("  slli a0, a0, 56");
-        printLn("  srli a0, a0, 56");
-      } else {
+    case TY_FLOAT: {
+      union {
+        float F32;
+        uint32_t U32;
+      } U;
+      U.F32 = Nd->FVal;
+      printLn("  # 将a0转换到float类型值为%Lf的fa0中", Nd->FVal);
+      printLn("  li a0, %u  # float %Lf", U.U32, Nd->FVal);
+      printLn("  fmv.w.x fa0, a0");
+      return;
+    }
+    case TY_DOUBLE: {
+      union {
+        double F64;
+        uint64_t U64;
+      } U;
+      printLn("  # 将a0转换到double类型值为%Lf的fa0中", Nd->FVal);
+      U.F64 = Nd->FVal;
+      printLn("  li a0, %lu  # double %Lf", U.U64, Nd->FVal);
+      printLn("  fmv.d.x fa0, a0");
+      return;
+    }
+    case TY_LDOUBLE: {
+#ifdef __riscv
+      union {
+        long double F128;
+        uint64_t U64[2];
+      } U;
+      memset(&U, 0, sizeof(U));
+      U.F128 = Nd->FVal;
+      printLn("  # 将long double类型的%Lf值，压入LD栈中", Nd->FVal);
+      printLn("  li a0, 0x%016lx  # long double %Lf", U.U64[0], Nd->FVal);
+      printLn("  fmv.d.x fs%d, a0", LDSP);
+
+      printLn("  li a0, 0x%016lx", U.U64[1]);
+      printLn("  fmv.d.x fs%d, a0", LDSP + 1);
+      LDSP += 2;
+      return;
+#endif // __riscv
+#ifdef __x86_64
+      // 【注意】交叉环境当中，x86_64的long double是f80而非f128
+      // 因而此处的支持仅供交叉测试，存在f80->f64的精度的丢失！
+      union {
+        double F64;
+        uint64_t U64;
+      } U = {Nd->FVal};
+      printLn("  # 【注意】此处存在f80->f64的精度丢失！！！");
+      printLn("  # 将long double类型的%Lf值，压入LD栈中", Nd->FVal);
+      printLn("  li a0, %lu  # double %Lf", U.U64, Nd->FVal);
+      printLn("  fmv.d.x fa0, a0");
+      printLn("  call __extenddftf2@plt");
+      pushLD();
+      return;
+#endif // __x86_64
+    }
+    default:
+      printLn("  # 将%ld加载到a0中", Nd->Val);
+      printLn("  li a0, %ld", Nd->Val);
+      return;
+    }
+  }
+  // 对寄存器取反
+  case ND_NEG:
+    // 计算左部的表达式
+    genExpr(Nd->LHS);
+
+    switch (Nd->Ty->Kind) {
+    case TY_FLOAT:
+      printLn("  # 对float类型的fa0值进行取反");
+      printLn("  fneg.s fa0, fa0");
+      return;
+    case TY_DOUBLE:
+      printLn("  # 对double类型的fa0值进行取反");
+      printLn("  fneg.d fa0, fa0");
+      return;
+    case TY_LDOUBLE:
+      printLn("  # 对long double类型的LD栈顶值进行取反");
+      printLn("  li t0, -1");
+      printLn("  slli t0, t0, 63");
+      printLn("  xor a%d, a%d, t0", LDSP + 1, LDSP + 1);
+      return;
+    default:
+      // neg a0, a0是sub a0, x0, a0的别名, 即a0=0-a0
+      printLn("  # 对a0值进行取反");
+      printLn("  neg a0, a0");
+      return;
+    }
+  // 变量
+  case ND_VAR:
+    // 放入寄存器的局部变量
+    if (Nd->Var->Reg) {
+      loadVar(Nd->Var);
+      return;
+    }
+    // 小数据段中的变量，直接读取
+    if (isDirectAccess(Nd)) {
+      loadSym(Nd);
+      return;
+    }
+    // 计算出变量的地址，然后存入a0
+    genAddr(Nd);
+    load(Nd->Ty);
+    return;
+  // 成员变量
+  case ND_MEMBER: {
+    // 计算出成员变量的地址，然后存入a0
+    genAddr(Nd);
+    load(Nd->Ty);
+
+    Member *Mem = Nd->Mem;
+    if (Mem->IsBitfield) {
+      printLn("  # 清除位域的成员变量（%d字节）未用到的位", Mem->BitWidth);
+      // 清除位域成员变量未用到的高位
+      printLn("  slli a0, a0, %d", 64 - Mem->BitWidth - Mem->BitOffset);
+      // 清除位域成员变量未用到的低位
+      if (Mem->Ty->IsUnsigned)
+        printLn("  srli a0, a0, %d", 64 - Mem->BitWidth);
+      else
+        printLn("  srai a0, a0, %d", 64 - Mem->BitWidth);
+    }
+    return;
+  }
+  // 解引用
+  case ND_DEREF:
+    if (regVar(Nd)) {
+      loadVar(regVar(Nd));
+      return;
+    }
+    genExpr(Nd->LHS);
+    load(Nd->Ty);
+    return;
+  // 取地址
+  case ND_ADDR:
+    genAddr(Nd->LHS);
+    return;
+  // 赋值
+  case ND_ASSIGN:
+    // 放入寄存器的局部变量
+    if (regVar(Nd->LHS)) {
+      genExpr(Nd->RHS);
+      storeVar(regVar(Nd->LHS), isExtended(Nd->RHS, Nd->LHS->Ty));
+      return;
+    }
+    // 小数据段中的变量，直接写入
+    if (isDirectAccess(Nd->LHS)) {
+      genExpr(Nd->RHS);
+      storeSym(Nd->LHS);
+      return;
+    }
+
+    // 左部是左值，保存值到的地址
+    genAddr(Nd->LHS);
+    push();
+    // 右部是右值，为表达式的值
+    genExpr(Nd->RHS);
+
+    // 如果是位域成员变量，需要先从内存中读取当前值，然后合并到新值中
+    if (Nd->LHS->Kind == ND_MEMBER && Nd->LHS->Mem->IsBitfield) {
+      printLn("\n  # 位域成员变量进行赋值↓");
+      printLn("  # 备份需要赋的a0值");
+      printLn("  mv t2, a0");
+
+      printLn("  # 计算位域成员变量的新值：");
+      Member *Mem = Nd->LHS->Mem;
+      // 将需要赋的值a0存入t1
+      printLn("  mv t1, a0");
+      // 构造一个和位域成员长度相同，全为1的二进制数
+      printLn("  li t0, %ld", (1L << Mem->BitWidth) - 1);
+      // 取交之后，位域长度的低位，存储了我们需要的值，其他位都为0
+      printLn("  and t1, t1, t0");
+      // 然后将该值左移，相应的位偏移量中
+      // 此时我们所需要的位域数值已经处于正确的位置，且其他位置都为0
+      printLn("  slli t1, t1, %d", Mem->BitOffset);
+
+      printLn("  # 读取位域当前值：");
+      // 将位域值保存的地址加载进来
+      printLn("  ld a0, 0(sp)");
+      // 读取该地址的值
+      load(Mem->Ty);
+
+      printLn("  # 写入成员变量新值到位域当前值中：");
+      // 位域值对应的掩码，即t1需要写入的位置
+      // 掩码位都为1，其余位为0
+      long Mask = ((1L << Mem->BitWidth) - 1) << Mem->BitOffset;
+      // 对掩码取反，此时，其余位都为1，掩码位都为0
+      printLn("  li t0, %ld", ~Mask);
+      // 取交，保留除掩码位外所有的位
+      printLn("  and a0, a0, t0");
+      // 取或，将成员变量的新值写入到掩码位
+      printLn("  or a0, a0, t1");
+
+      store(Nd->Ty);
+      printLn("  # 恢复需要赋的a0值作为返回值");
+      printLn("  mv a0, t2");
+      printLn("  # 完成位域成员变量的赋值↑\n");
+      return;
+    }
+
+    // 结构体和向量按两侧地址已知的对齐值进行复制
+    if (Nd->Ty->Kind == TY_STRUCT || Nd->Ty->Kind == TY_UNION ||
+        Nd->Ty->Kind == TY_VECTOR) {
+      pop(1);
+      printLn("  # 对%s进行赋值", Nd->Ty->Kind == TY_STRUCT  ? "结构体"
+                                  : Nd->Ty->Kind == TY_UNION ? "联合体"
+                                                             : "向量");
+      copyStruct(Nd->Ty->Size, MIN(addrAlign(Nd->LHS), addrAlign(Nd->RHS)));
+      return;
+    }
+
+    store(Nd->Ty);
+    return;
+  // 语句表达式
+  case ND_STMT_EXPR:
+    for (Node *N = Nd->Body; N; N = N->Next)
+      genStmt(N);
+    return;
+  // 逗号
+  case ND_COMMA: {
+    // 复合赋值 TMP = &Var, *TMP = *TMP op B 中，Var放入了寄存器，
+    // 不计算TMP，用Var代替*TMP
+    Obj *Var = isTmpAddr(Nd->LHS) ? regVar(skipNopCast(Nd->LHS->RHS)->LHS)
+                                  : NULL;
+    if (Var) {
+      Obj *Tmp = RegTmp, *TmpVar = RegTmpVar;
+      RegTmp = Nd->LHS->LHS->Var;
+      RegTmpVar = Var;
+      genExpr(Nd->RHS);
+      RegTmp = Tmp;
+      RegTmpVar = TmpVar;
+      return;
+    }
+    // 有初始值的寄存器变量，无需先清零
+    bool Init = Nd->LHS->Kind == ND_MEMZERO && Nd->LHS->Var->Reg &&
+                Nd->RHS->Kind == ND_ASSIGN &&
+                regVar(Nd->RHS->LHS) == Nd->LHS->Var;
+    if (!Init)
+      genExpr(Nd->LHS);
+    genExpr(Nd->RHS);
+    return;
+  }
+  // 类型转换
+  case ND_CAST:
+    genExpr(Nd->LHS);
+    if (Nd->Ty->Kind == TY_VECTOR || Nd->LHS->Ty->Kind == TY_VECTOR) {
+      genVecCast(Nd);
+      return;
+    }
+    cast(Nd->LHS->Ty, Nd->Ty);
+    return;
+  // 内存清零
+  case ND_MEMZERO: {
+    if (Nd->Var->Reg) {
+      printLn("  # 将s%d中的局部变量%s清零", Nd->Var->Reg, Nd->Var->Name);
+      printLn("  li s%d, 0", Nd->Var->Reg);
+      return;
+    }
+    printLn("  # 对%s的内存%d(fp)清零%d位", Nd->Var->Name, Nd->Var->Offset,
+            Nd->Var->Ty->Size);
+    // 对栈内变量所占用的内存进行清零，对齐时每次清零8或4个字节
+    int Size = Nd->Var->Ty->Size;
+    for (int I = 0; I < Size;) {
+      int Off = Nd->Var->Offset + I;
+      int Sz = 1;
+      if (Off % 8 == 0 && Size - I >= 8)
+        Sz = 8;
+      else if (Off % 4 == 0 && Size - I >= 4)
+        Sz = 4;
+      char *Op = Sz == 8 ? "sd" : Sz == 4 ? "sw" : "sb";
+      printLn("  %s zero, %s", Op, stackSlot(Off, Sz));
+      I += Sz;
+    }
+    return;
+  }
+  // 条件运算符
+  case ND_COND: {
+    if (OptZbb && genMinMax(Nd))
+      return;
+    int C = count();
+    printLn("\n# =====条件运算符%d===========", C);
+    genExpr(Nd->Cond);
+    notZero(Nd->Cond->Ty);
+    printLn("  # 条件判断，为0则跳转");
+    printLn("  beqz a0, .L.else.%s.%d", CurrentFn->Name, C);
+    genExpr(Nd->Then);
+    printLn("  # 跳转到条件运算符结尾部分");
+    printLn("  j .L.end.%s.%d", CurrentFn->Name, C);
+    printLn(".L.else.%s.%d:", CurrentFn->Name, C);
+    genExpr(Nd->Els);
+    printLn(".L.end.%s.%d:", CurrentFn->Name, C);
+    return;
+  }
+  // 非运算
+  case ND_NOT:
+    genExpr(Nd->LHS);
+    notZero(Nd->LHS->Ty);
+    printLn("  # 非运算");
+    // a0=0则置1，否则为0
+    printLn("  seqz a0, a0");
+    return;
+  // 逻辑与
+  case ND_LOGAND: {
+    int C = count();
+    printLn("\n# =====逻辑与%d===============", C);
+    genExpr(Nd->LHS);
+    // 判断是否为短路操作
+    notZero(Nd->LHS->Ty);
+    printLn("  # 左部短路操作判断，为0则跳转");
+    printLn("  beqz a0, .L.false.%s.%d", CurrentFn->Name, C);
+    genExpr(Nd->RHS);
+    notZero(Nd->RHS->Ty);
+    printLn("  # 右部判断，为0则跳转");
+    printLn("  beqz a0, .L.false.%s.%d", CurrentFn->Name, C);
+    printLn("  li a0, 1");
+    printLn("  j .L.end.%s.%d", CurrentFn->Name, C);
+    printLn(".L.false.%s.%d:", CurrentFn->Name, C);
+    printLn("  li a0, 0");
+    printLn(".L.end.%s.%d:", CurrentFn->Name, C);
+    return;
+  }
+  // 逻辑或
+  case ND_LOGOR: {
+    int C = count();
+    printLn("\n# =====逻辑或%d===============", C);
+    genExpr(Nd->LHS);
+    notZero(Nd->LHS->Ty);
+    // 判断是否为短路操作
+    printLn("  # 左部短路操作判断，不为0则跳转");
+    printLn("  bnez a0, .L.true.%s.%d", CurrentFn->Name, C);
+    genExpr(Nd->RHS);
+    notZero(Nd->RHS->Ty);
+    printLn("  # 右部判断，不为0则跳转");
+    printLn("  bnez a0, .L.true.%s.%d", CurrentFn->Name, C);
+    printLn("  li a0, 0");
+    printLn("  j .L.end.%s.%d", CurrentFn->Name, C);
+    printLn(".L.true.%s.%d:", CurrentFn->Name, C);
+    printLn("  li a0, 1");
+    printLn(".L.end.%s.%d:", CurrentFn->Name, C);
+    return;
+  }
+  // 位操作的内建函数
+  case ND_CLZ:
+  case ND_CTZ:
+  case ND_POPCOUNT:
+    genExpr(Nd->LHS);
+    genBitCount(Nd->Kind, Nd->LHS->Ty->Size == 4);
+    return;
+  // 原子读改写
+  case ND_ATOMIC_RW:
+    genExpr(Nd->RHS);
+    push();
+    genExpr(Nd->LHS);
+    pop(1);
+    genAtomicRW(Nd);
+    return;
+  // 比较并交换
+  case ND_CAS:
+    genExpr(Nd->CasOld);
+    push();
+    genExpr(Nd->CasNew);
+    // 浮点数按位进行比较和交换
+    if (isFloNum(Nd->CasNew->Ty))
+      printLn("  fmv.x.%s a0, fa0", Nd->CasNew->Ty->Size == 4 ? "w" : "d");
+    push();
+    genExpr(Nd->CasAddr);
+    pop(1);
+    pop(2);
+    genCas(Nd->CasAddr->Ty->Base, Nd->Order);
+    return;
+  // 原子读取，按内存顺序加上屏障
+  case ND_ATOMIC_LD: {
+    Type Plain = *Nd->Ty;
+    Plain.IsAtomic = false;
+    genExpr(Nd->LHS);
+    fenceBeforeLoad(Nd->Order);
+    load(&Plain);
+    fenceAfterLoad(Nd->Order);
+    return;
+  }
+  // 原子写入
+  case ND_ATOMIC_ST: {
+    Type Plain = *Nd->LHS->Ty->Base;
+    Plain.IsAtomic = false;
+    genExpr(Nd->LHS);
+    push();
+    genExpr(Nd->RHS);
+    fenceBeforeStore(Nd->Order);
+    store(&Plain);
+    return;
+  }
+  // 内存屏障
+  case ND_FENCE:
+    genFence(Nd->Order);
+    return;
+  // 优化提示的内建函数，值为其参数
+  case ND_EXPECT:
+  case ND_ALIGNED:
+    genExpr(Nd->LHS);
+    return;
+  // 预取，支持Zicbop扩展时生成prefetch指令，否则不生成
+  case ND_PREFETCH:
+    genExpr(Nd->LHS);
+    if (OptZicbop) {
+      printLn("  # 预取a0指向的数据");
+      printLn("  prefetch.%s 0(a0)", Nd->Val ? "w" : "r");
+    }
+    return;
+  // 不可到达，不生成代码
+  case ND_UNREACH:
+    return;
+  // 按位取非运算
+  case ND_BITNOT:
+    genExpr(Nd->LHS);
+    printLn("  # 按位取反");
+    // 这里的 not a0, a0 为 xori a0, a0, -1 的伪码
+    printLn("  not a0, a0");
+    return;
+  // 函数调用
+  case ND_FUNCALL: {
+    if (Nd->LHS->Kind == ND_VAR && !strcmp(Nd->LHS->Var->Name, "alloca")) {
+      genExpr(Nd->Args);
+      // printLn("  mov %%rax, %%rdi");
+      printLn("  mv t1, a0");
+      builtinAlloca();
+      return;
+    }
+
+    // 计算所有参数的值，正向压栈
+    // 此处获取到栈传递参数的数量
+    int StackArgs = pushArgs(Nd);
+
+    // 直接调用函数时，无需计算函数的地址
+    Obj *Callee = directCallee(Nd->LHS);
+    // 函数指针在s寄存器中时，直接通过该寄存器调用
+    Obj *FnReg = Callee ? NULL : regVar(Nd->LHS);
+    if (!Callee && !FnReg) {
+      genExpr(Nd->LHS);
+      // 将a0的值存入t1，直接计算的实参会用到t0
+      printLn("  mv t1, a0");
+    }
+
+    // 直接计算的实参，等其他实参弹栈后再计算
+    Node *Direct[GP_MAX + FP_MAX];
+    int DirectReg[GP_MAX + FP_MAX];
+    int NDirect = 0;
+    bool HasDirect = false;
+    for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next)
+      HasDirect |= Arg->IsDirect;
+
+    // 反向弹栈，a0->参数1，a1->参数2……
+    int GP = 0, FP = 0;
+
+    if (Nd->RetBuffer && Nd->Ty->Size > 16) {
+      printLn("  # 返回结构体大于16字节，那么第一个参数指向返回缓冲区");
+      popArg(GP++, HasDirect);
+    }
+
+    // 读取函数形参中的参数类型
+    Type *CurArg = Nd->FuncType->Params;
+    for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next) {
+      // 如果是可变参数函数
+      // 匹配到空参数（最后一个）的时候，将剩余的整型寄存器弹栈
+      if (Nd->FuncType->IsVariadic && CurArg == NULL) {
+        if (GP < GP_MAX) {
+          if (Arg->Ty->Kind == TY_LDOUBLE) {
+            // 在可变参数函数的调用中
+            // LD的第一个寄存器必须是偶数下标，即a0,a2,a4,a6
+            if (GP % 2 == 1)
+              GP++;
+            printLn("  # long double通过a%d,a%d传递可变实参", GP, GP + 1);
+            popArg(GP++, HasDirect);
+            if (GP < GP_MAX)
+              popArg(GP++, HasDirect);
+          } else if (Arg->IsDirect) {
+            Direct[NDirect] = Arg;
+            DirectReg[NDirect++] = GP++;
+          } else {
+            printLn("  # a%d传递可变实参", GP);
+            popArg(GP++, HasDirect);
+          }
+        }
+        continue;
+      }
+
+      CurArg = CurArg->Next;
+      // 实参的类型
+      Type *Ty = Arg->Ty;
+
+      switch (Ty->Kind) {
+      case TY_STRUCT:
+      case TY_UNION:
+      case TY_VECTOR: {
+        // 判断结构体的类型
+        // 结构体的大小
+        int Sz = Ty->Size;
+
+        // 处理一或两个浮点成员变量的结构体
+        if (isFloatOrDouble(Ty->FSReg1Ty) || isFloatOrDouble(Ty->FSReg2Ty)) {
+          Type *Regs[2] = {Ty->FSReg1Ty, Ty->FSReg2Ty};
+          for (int I = 0; I < 2; ++I) {
+            if (Regs[I]->Kind == TY_FLOAT) {
+              printLn("  # %d字节float结构体%d通过fa%d传递", Sz, I, FP);
+              printLn("  # 弹栈，将栈顶的值存入fa%d", FP);
+              printLn("  flw fa%d, 0(sp)", FP++);
+              printLn("  addi sp, sp, 8");
+              Depth--;
+            }
+            if (Regs[I]->Kind == TY_DOUBLE) {
+              printLn("  # %d字节double结构体%d通过fa%d传递", Sz, I, FP);
+              popF(FP++);
+            }
+            if (isInteger(Regs[I])) {
+              printLn("  # %d字节浮点结构体%d通过a%d传递", Sz, I, GP);
+              popArg(GP++, HasDirect);
+            }
+          }
+          break;
+        }
+
+        // 其他整型结构体或多字节结构体
+        // 9~16字节整型结构体用两个寄存器，其他字节结构体用一个结构体
+        int Regs = (8 < Sz && Sz <= 16) ? 2 : 1;
+        for (int I = 1; I <= Regs; ++I) {
+          if (GP < GP_MAX) {
+            printLn("  # %d字节的整型结构体%d通过a%d传递", Sz, I, GP);
+            popArg(GP++, HasDirect);
+          }
+        }
+        break;
+      }
+      case TY_FLOAT:
+      case TY_DOUBLE:
+        if (FP < FP_MAX && Arg->IsDirect) {
+          Direct[NDirect] = Arg;
+          DirectReg[NDirect++] = FP++;
+        } else if (FP < FP_MAX) {
+          printLn("  # fa%d传递浮点参数", FP);
+          popF(FP++);
+        } else if (GP < GP_MAX) {
+          printLn("  # a%d传递浮点参数", GP);
+          popArg(GP++, HasDirect);
+        }
+        break;
+      case TY_LDOUBLE:
+        if (GP == GP_MAX - 1) {
+          printLn("  # a%d传递LD一半参数", GP);
+          popArg(GP++, HasDirect);
+        }
+        if (GP< GP_MAX-1) {
+          printLn("  # a%d传递long double第%d部分参数", GP, 1);
+          popArg(GP++, HasDirect);
+          popArg(GP++, HasDirect);
+        }
+        break;
+      default:
+        if (GP < GP_MAX && Arg->IsDirect) {
+          Direct[NDirect] = Arg;
+          DirectReg[NDirect++] = GP++;
+        } else if (GP < GP_MAX) {
+          printLn("  # a%d传递整型参数", GP);
+          popArg(GP++, HasDirect);
+        }
+        break;
+      }
+    }
+
+    // 计算直接传递的实参，计算时会写入a0、fa0
+    // 因此先计算浮点的实参，再计算整型的实参，各自最后计算a0、fa0
+    bool A0Direct = false;
+    for (int Pass = 0; Pass < 4; Pass++) {
+      for (int I = 0; I < NDirect; I++) {
+        Node *Arg = Direct[I];
+        int Reg = DirectReg[I];
+        bool Flo = isFloNum(Arg->Ty);
+        if (Flo != (Pass < 2) || (Reg == 0) != (Pass % 2 == 1))
+          continue;
+
+        printLn("\n  # 直接计算传入%sa%d的实参", Flo ? "f" : "", Reg);
+        genExpr(Arg);
+        if (Reg == 0) {
+          A0Direct |= !Flo;
+          continue;
+        }
+        if (Flo)
+          printLn("  fmv.%s fa%d, fa0", Arg->Ty->Kind == TY_FLOAT ? "s" : "d",
+                  Reg);
+        else
+          printLn("  mv a%d, a0", Reg);
+      }
+    }
+    if (HasDirect && !A0Direct && GP > 0) {
+      printLn("  # 恢复暂存在t2中的a0");
+      printLn("  mv a0, t2");
+    }
+
+    // 调用函数
+    if (Callee) {
+      printLn("  # 直接调用%s函数", Callee->Name);
+      // 位置无关代码中，可能被抢占的函数需要通过PLT调用
+      if (OptFPIC && isPreemptible(Callee))
+        printLn("  call %s@plt", Callee->Name);
+      else
+        printLn("  call %s", Callee->Name);
+    } else {
+      printLn("  # 调用函数指针");
+      if (FnReg)
+        printLn("  jalr s%d", FnReg->Reg);
+      else
+        printLn("  jalr t1");
+    }
+
+    if (Nd->Ty->Kind == TY_LDOUBLE) {
+      printLn("  # 保存Long double类型函数的返回值");
+      pushLD();
+    }
+
+    // 回收为栈传递的变量开辟的栈空间
+    if (StackArgs) {
+      // 栈的深度减去栈传递参数的字节数
+      Depth -= StackArgs;
+      printLn("  # 回收栈传递参数的%d个字节", StackArgs * 8);
+      printLn("  addi sp, sp, %d", StackArgs * 8);
+      // 清除记录的大结构体的数量
+      BSDepth = 0;
+    }
+
+    // 清除寄存器中高位无关的数据
+    switch (Nd->Ty->Kind) {
+    case TY_BOOL:
+      printLn("  # 清除bool类型的高位");
+      printLn("  slli a0, a0, 63");
+      printLn("  srli a0, a0, 63");
+      return;
+    case TY_CHAR:
+      printLn("  # 清除char类型的高位");
+      if (Nd->Ty->IsUnsigned) {
+        printLn("  slli a0, a0, 56");
+        printLn("  srli a0, a0, 56");
+      } else {
         printLn("  slli a0, a0, 56");
         printLn("  srai a0, a0, 56");
       }
       return;
-    case TY_SHORT:
-      printLn("  # 清除short类型的高位");
-      if (Nd->Ty->IsUnsigned) {
-        printLn("  slli a0, a0, 48");
-        printLn("  srli a0, a0, 48");
-      } else {
-        printLn("  slli a0, a0, 48");
-        printLn("  srai a0, a0, 48");
+    case TY_SHORT:
+      printLn("  # 清除short类型的高位");
+      if (Nd->Ty->IsUnsigned) {
+        printLn("  slli a0, a0, 48");
+        printLn("  srli a0, a0, 48");
+      } else {
+        printLn("  slli a0, a0, 48");
+        printLn("  srai a0, a0, 48");
+      }
+      return;
+    default:
+      break;
+    }
+
+    // 如果返回的结构体小于16字节，直接使用寄存器返回
+    if (Nd->RetBuffer && Nd->Ty->Size <= 16) {
+      copyRetBuffer(Nd->RetBuffer);
+      genStackAddr("a0", Nd->RetBuffer->Offset);
+    }
+
+    return;
+  }
+  case ND_LABEL_VAL:
+    // printLn("  lea %s(%%rip), %%rax", Nd->UniqueLabel);
+    printLn("  la a0, %s", Nd->UniqueLabel);
+    return;
+  default:
+    break;
+  }
+
+  // 处理浮点类型
+  switch (Nd->LHS->Ty->Kind) {
+  case TY_FLOAT:
+  case TY_DOUBLE: {
+    // 递归到最右节点
+    genExpr(Nd->RHS);
+    // 将结果压入栈
+    pushF();
+    // 递归到左节点
+    genExpr(Nd->LHS);
+    // 将结果弹栈到fa1
+    popF(1);
+
+    // 生成各个二叉树节点
+    // float对应s(single)后缀，double对应d(double)后缀
+    char *Suffix = (Nd->LHS->Ty->Kind == TY_FLOAT) ? "s" : "d";
+
+    switch (Nd->Kind) {
+    case ND_ADD:
+      printLn("  # fa0+fa1，结果写入fa0");
+      printLn("  fadd.%s fa0, fa0, fa1", Suffix);
+      return;
+    case ND_SUB:
+      printLn("  # fa0-fa1，结果写入fa0");
+      printLn("  fsub.%s fa0, fa0, fa1", Suffix);
+      return;
+    case ND_MUL:
+      printLn("  # fa0×fa1，结果写入fa0");
+      printLn("  fmul.%s fa0, fa0, fa1", Suffix);
+      return;
+    case ND_DIV:
+      printLn("  # fa0÷fa1，结果写入fa0");
+      printLn("  fdiv.%s fa0, fa0, fa1", Suffix);
+      return;
+    case ND_EQ:
+      printLn("  # 判断是否fa0=fa1");
+      printLn("  feq.%s a0, fa0, fa1", Suffix);
+      return;
+    case ND_NE:
+      printLn("  # 判断是否fa0≠fa1");
+      printLn("  feq.%s a0, fa0, fa1", Suffix);
+      printLn("  seqz a0, a0");
+      return;
+    case ND_LT:
+      printLn("  # 判断是否fa0<fa1");
+      printLn("  flt.%s a0, fa0, fa1", Suffix);
+      return;
+    case ND_LE:
+      printLn("  # 判断是否fa0≤fa1");
+      printLn("  fle.%s a0, fa0, fa1", Suffix);
+      return;
+    default:
+      errorTok(Nd->Tok, "invalid expression");
+    }
+  }
+  case TY_LDOUBLE: {
+    genExpr(Nd->LHS);
+    genExpr(Nd->RHS);
+
+    popLD(2);
+    popLD(0);
+    switch (Nd->Kind) {
+    case ND_ADD:
+      printLn("  # long double加法，从栈顶读取32个字节");
+      printLn("  call __addtf3@plt");
+      pushLD();
+      return;
+    case ND_SUB:
+      printLn("  # long double减法，从栈顶读取32个字节");
+      printLn("  call __subtf3@plt");
+      pushLD();
+      return;
+    case ND_MUL:
+      printLn("  # long double乘法，从栈顶读取32个字节");
+      printLn("  call __multf3@plt");
+      pushLD();
+      return;
+    case ND_DIV:
+      printLn("  # long double除法，从栈顶读取32个字节");
+      printLn("  call __divtf3@plt");
+      pushLD();
+      return;
+    case ND_EQ:
+      printLn("  # long double相等，从栈顶读取32个字节");
+      printLn("  call __eqtf2@plt");
+      printLn("  seqz a0, a0");
+      return;
+    case ND_NE:
+      printLn("  # long double不等，从栈顶读取32个字节");
+      printLn("  call __netf2@plt");
+      printLn("  snez a0, a0");
+      return;
+    case ND_LT:
+      printLn("  # long double小于，从栈顶读取32个字节");
+      printLn("  call __lttf2@plt");
+      printLn("  slti a0, a0, 0");
+      return;
+    case ND_LE:
+      printLn("  # long double小于等于，从栈顶读取32个字节");
+      printLn("  call __letf2@plt");
+      printLn("  slti a0, a0, 1");
+      return;
+    default:
+      errorTok(Nd->Tok, "invalid expression");
+    }
+  }
+  default:
+    break;
+  }
+
+  // 使用位操作扩展的指令
+  if (genBitmanip(Nd))
+    return;
+
+  // 乘以或除以常量
+  if ((Nd->Kind == ND_MUL || Nd->Kind == ND_DIV || Nd->Kind == ND_MOD) &&
+      genMulDivConst(Nd))
+    return;
+
+  // 递归到最右节点
+  genExpr(Nd->RHS);
+  // 将结果压入栈
+  push();
+  // 递归到左节点
+  genExpr(Nd->LHS);
+  // 将结果弹栈到a1
+  pop(1);
+
+  // 生成各个二叉树节点
+  char *Suffix = Nd->LHS->Ty->Kind == TY_LONG || Nd->LHS->Ty->Base ? "" : "w";
+  switch (Nd->Kind) {
+  case ND_ADD: // + a0=a0+a1
+    printLn("  # a0+a1，结果写入a0");
+    printLn("  add%s a0, a0, a1", Suffix);
+    return;
+  case ND_SUB: // - a0=a0-a1
+    printLn("  # a0-a1，结果写入a0");
+    printLn("  sub%s a0, a0, a1", Suffix);
+    return;
+  case ND_MUL: // * a0=a0*a1
+    printLn("  # a0×a1，结果写入a0");
+    printLn("  mul%s a0, a0, a1", Suffix);
+    return;
+  case ND_DIV: // / a0=a0/a1
+    printLn("  # a0÷a1，结果写入a0");
+    if (Nd->Ty->IsUnsigned)
+      printLn("  divu%s a0, a0, a1", Suffix);
+    else
+      printLn("  div%s a0, a0, a1", Suffix);
+    return;
+  case ND_MOD: // % a0=a0%a1
+    printLn("  # a0%%a1，结果写入a0");
+    if (Nd->Ty->IsUnsigned)
+      printLn("  remu%s a0, a0, a1", Suffix);
+    else
+      printLn("  rem%s a0, a0, a1", Suffix);
+    return;
+  case ND_BITAND: // & a0=a0&a1
+    printLn("  # a0&a1，结果写入a0");
+    printLn("  and a0, a0, a1");
+    return;
+  case ND_BITOR: // | a0=a0|a1
+    printLn("  # a0|a1，结果写入a0");
+    printLn("  or a0, a0, a1");
+    return;
+  case ND_BITXOR: // ^ a0=a0^a1
+    printLn("  # a0^a1，结果写入a0");
+    printLn("  xor a0, a0, a1");
+    return;
+  case ND_EQ:
+  case ND_NE:
+    // a0=a0^a1，异或指令
+    printLn("  # 判断是否a0%sa1", Nd->Kind == ND_EQ ? "=" : "≠");
+    printLn("  xor a0, a0, a1");
+
+    if (Nd->Kind == ND_EQ)
+      // a0==a1
+      // a0=a0^a1, sltiu a0, a0, 1
+      // 等于0则置1
+      printLn("  seqz a0, a0");
+    else
+      // a0!=a1
+      // a0=a0^a1, sltu a0, x0, a0
+      // 不等于0则置1
+      printLn("  snez a0, a0");
+    return;
+  case ND_LT:
+    printLn("  # 判断a0<a1");
+    if (Nd->LHS->Ty->IsUnsigned)
+      printLn("  sltu a0, a0, a1");
+    else
+      printLn("  slt a0, a0, a1");
+    return;
+  case ND_LE:
+    // a0<=a1等价于
+    // a0=a1<a0, a0=a0^1
+    printLn("  # 判断是否a0≤a1");
+    if (Nd->LHS->Ty->IsUnsigned)
+      printLn("  sltu a0, a1, a0");
+    else
+      printLn("  slt a0, a1, a0");
+    printLn("  xori a0, a0, 1");
+    return;
+  case ND_SHL:
+    printLn("  # a0逻辑左移a1位");
+    printLn("  sll%s a0, a0, a1", Suffix);
+    return;
+  case ND_SHR:
+    printLn("  # a0算术右移a1位");
+    if (Nd->Ty->IsUnsigned)
+      printLn("  srl%s a0, a0, a1", Suffix);
+    else
+      printLn("  sra%s a0, a0, a1", Suffix);
+    return;
+  default:
+    break;
+  }
+
+  errorTok(Nd->Tok, "invalid expression");
+}
+
+//
+// 循环的自动向量化
+//
+// 开启V扩展时，将形如 for (...; I < N; I++) 的计数循环，
+// 按vsetvli分段（strip-mining）生成向量循环，循环体中可以有：
+//   A[I] = E;  A[I] op= E;   逐元素地计算，写入数组
+//   S op= E;  S = S op E;     整数的加、减、与、或、异或归约
+//   if (E1 cmp E2) 语句;      查找第一个满足条件的元素
+// E由下标为I的数组元素、循环不变量和逐元素的运算组成。
+// 向量循环结束或找到元素后写回I，再进入原来的标量循环，
+// 由标量循环判断条件、执行剩余的部分。因此迭代次数不为正、
+// 指针指向的数组相互重叠时，跳过向量循环即可。
+//
+// 向量循环中的寄存器：
+//   a0为当前的下标，a1为剩余的迭代次数，a2～a7为各数组当前元素的地址，
+//   t0为本段处理的元素数，v0为比较的掩码，
+//   v1起依次为循环不变量、归约的累加值和临时值
+//
+
+// 向量循环中数组、循环不变量和语句的最大个数
+#define VEC_ARRAYS 6
+#define VEC_SCALARS 8
+#define VEC_STMTS 8
+
+// 向量循环访问的数组
+typedef struct {
+  Node *Base;    // 数组或指针变量
+  Type *Ty;      // 元素的类型
+  bool IsStored; // 是否写入
+} VecArray;
+
+// 向量循环中的语句
+typedef struct {
+  Node *Dst;   // 写入的数组元素，为NULL时是归约
+  Node *Src;   // 逐元素计算的表达式
+  Obj *Tmp;    // 复合赋值中指向左值的临时变量
+  Node *TmpLV; // 临时变量指向的左值
+} VecStmt;
+
+// 可以向量化的循环
+typedef struct {
+  Obj *IV;          // 归纳变量，即数组的下标
+  int SEW;          // 向量中元素的位数
+  bool Checking;    // 第二遍分析，检查各运算的位数
+  bool StoreViaPtr; // 是否通过指针写入数组
+  VecArray Arrays[VEC_ARRAYS];
+  int NumArrays;
+  Node *Scalars[VEC_SCALARS]; // 循环不变量
+  int NumScalars;
+  VecStmt Stmts[VEC_STMTS];
+  int NumStmts;
+  Node *RedVar;   // 归约的变量
+  NodeKind RedOp; // 归约的运算
+  Node *Search;   // 查找的条件
+  VecStmt *Cur;   // 当前的语句
+  int Temps;      // 当前语句需要的临时向量寄存器数
+  int MaxTemps;   // 各语句需要的临时向量寄存器数的最大值
+  int NextReg;    // 下一个空闲的向量寄存器
+} VecLoop;
+
+// 标记地址被获取的局部变量，它们可能被间接地读写
+// 复合赋值中的 TMP = &Var ，TMP只在该表达式中使用，不算在内
+static void markAddrTaken(Node *Nd) {
+  for (; Nd; Nd = Nd->Next) {
+    if (Nd->Kind == ND_ADDR) {
+      // 复合字面量为 (初始化, 变量)
+      Node *X = Nd->LHS;
+      while (X->Kind == ND_MEMBER || X->Kind == ND_COMMA)
+        X = X->Kind == ND_COMMA ? X->RHS : X->LHS;
+      if (X->Kind == ND_VAR && X->Var->IsLocal)
+        X->Var->IsAddrTaken = true;
+    }
+    if (Nd->Kind == ND_ASSIGN && Nd->LHS->Kind == ND_VAR &&
+        !*Nd->LHS->Var->Name && skipNopCast(Nd->RHS)->Kind == ND_ADDR &&
+        skipNopCast(Nd->RHS)->LHS->Kind == ND_VAR)
+      continue;
+    markAddrTaken(Nd->LHS);
+    markAddrTaken(Nd->RHS);
+    markAddrTaken(Nd->Cond);
+    markAddrTaken(Nd->Then);
+    markAddrTaken(Nd->Els);
+    markAddrTaken(Nd->Init);
+    markAddrTaken(Nd->Inc);
+    markAddrTaken(Nd->Body);
+    markAddrTaken(Nd->Args);
+    markAddrTaken(Nd->CasAddr);
+    markAddrTaken(Nd->CasOld);
+    markAddrTaken(Nd->CasNew);
+    markAddrTaken(Nd->Mask);
+  }
+}
+
+// 判断是否为只能被直接读写的局部变量
+static bool isPrivateVar(Obj *Var) {
+  return Var->IsLocal && !Var->IsAddrTaken;
+}
+
+//
+// 别名分析
+//
+// 判断两个左值是否可能访问重叠的内存，供移动读取的优化查询：
+//   不同的变量互不重叠，同一变量按成员的偏移量和大小判断；
+//   地址未被获取的标量局部变量，不能通过指针访问；
+//   restrict限定的形参，与其他变量和restrict形参指向的对象不重叠；
+//   开启-fstrict-aliasing时，不同类型的左值不会访问同一对象，
+//   字符类型、结构体等聚合类型以及经过联合体的访问除外。
+//
+
+// 左值访问的内存
+typedef struct {
+  Obj *Var;    // 访问的变量，或其值为所访问地址的指针变量，NULL时未知
+  bool Deref;  // 通过指针变量Var的值访问
+  bool Known;  // 偏移量已知
+  bool Union;  // 经过联合体的成员访问
+  int64_t Off; // 相对于变量或指针值的偏移量
+  Type *Ty;    // 访问的类型
+} MemRef;
+
+static void addrRef(Node *Addr, MemRef *R);
+
+// 分析左值访问的内存
+static void memRef(Node *LV, MemRef *R) {
+  switch (LV->Kind) {
+  case ND_VAR:
+    *R = (MemRef){LV->Var, false, true, false, 0, LV->Ty};
+    return;
+  case ND_MEMBER:
+    memRef(LV->LHS, R);
+    R->Off += LV->Mem->Offset;
+    R->Union |= LV->LHS->Ty->Kind == TY_UNION;
+    R->Ty = LV->Ty;
+    return;
+  case ND_DEREF:
+    addrRef(LV->LHS, R);
+    R->Ty = LV->Ty;
+    return;
+  default:
+    *R = (MemRef){NULL, false, false, false, 0, LV->Ty};
+    return;
+  }
+}
+
+// 获取指针加减的常量字节数，即 K * 元素大小
+static bool constBytes(Node *Nd, int64_t *Val) {
+  Nd = skipNopCast(Nd);
+  int64_t K, Size;
+  if (Nd->Kind == ND_MUL && isConstInt(Nd->LHS, &K) &&
+      isConstInt(Nd->RHS, &Size)) {
+    *Val = K * Size;
+    return true;
+  }
+  return isConstInt(Nd, Val);
+}
+
+// 分析地址表达式指向的内存
+static void addrRef(Node *Addr, MemRef *R) {
+  // 跳过指针之间的转换，以及数组到指针的转换
+  while (isNopCast(Addr) ||
+         (Addr->Kind == ND_CAST && Addr->LHS->Ty->Kind == TY_ARRAY))
+    Addr = Addr->LHS;
+  // 数组的值为其地址
+  if (Addr->Ty->Kind == TY_ARRAY) {
+    memRef(Addr, R);
+    return;
+  }
+
+  int64_t Val;
+  switch (Addr->Kind) {
+  case ND_ADDR:
+    memRef(Addr->LHS, R);
+    return;
+  case ND_VAR:
+    *R = (MemRef){Addr->Var, true, true, false, 0, Addr->Ty};
+    return;
+  case ND_ADD:
+  case ND_SUB:
+    if (Addr->Ty->Kind == TY_PTR) {
+      addrRef(Addr->LHS, R);
+      if (R->Known && constBytes(Addr->RHS, &Val))
+        R->Off += Addr->Kind == ND_ADD ? Val : -Val;
+      else
+        R->Known = false;
+      return;
+    }
+    break;
+  default:
+    break;
+  }
+  *R = (MemRef){NULL, false, false, false, 0, Addr->Ty};
+}
+
+// 基于类型的别名规则中的类别，-1表示可能与任何类型重叠
+static int aliasClass(Type *Ty) {
+  switch (Ty->Kind) {
+  case TY_CHAR:
+  case TY_ARRAY:
+  case TY_VLA:
+  case TY_STRUCT:
+  case TY_UNION:
+  case TY_VECTOR:
+    return -1;
+  case TY_ENUM:
+    // 枚举与其底层的整数类型兼容
+    return TY_INT;
+  default:
+    // 整数不区分符号，指针之间不区分指向的类型
+    return Ty->Kind;
+  }
+}
+
+// 判断是否为可以视为指向独立对象的restrict形参
+static bool isRestrictParam(Obj *Var) {
+  if (!Var->Ty->IsRestrict || !isPrivateVar(Var))
+    return false;
+  for (Obj *P = CurrentFn->Params; P; P = P->Next)
+    if (P == Var)
+      return true;
+  return false;
+}
+
+// 判断两次内存访问是否可能重叠
+static bool refMayAlias(MemRef *A, MemRef *B) {
+  if (OptFStrictAliasing && !A->Union && !B->Union) {
+    int CA = aliasClass(A->Ty), CB = aliasClass(B->Ty);
+    if (CA >= 0 && CB >= 0 && CA != CB)
+      return false;
+  }
+  if (!A->Var || !B->Var)
+    return true;
+
+  // 直接访问的变量
+  if (!A->Deref && !B->Deref) {
+    if (A->Var != B->Var)
+      return false;
+    return !A->Known || !B->Known ||
+           (A->Off < B->Off + B->Ty->Size && B->Off < A->Off + A->Ty->Size);
+  }
+
+  // 变量与通过指针的访问
+  if (!A->Deref || !B->Deref) {
+    MemRef *X = A->Deref ? B : A, *P = A->Deref ? A : B;
+    // 数组和结构体中的数组会隐式地转换为地址
+    if (isPrivateVar(X->Var) && X->Var->Ty->Kind != TY_ARRAY &&
+        X->Var->Ty->Kind != TY_STRUCT && X->Var->Ty->Kind != TY_UNION &&
+        X->Var->Ty->Kind != TY_VECTOR)
+      return false;
+    return !isRestrictParam(P->Var);
+  }
+
+  // 都通过指针访问，同一指针的值可能在两次访问之间改变
+  return A->Var == B->Var || !isRestrictParam(A->Var) ||
+         !isRestrictParam(B->Var);
+}
+
+// 判断两个左值是否可能访问重叠的内存
+static bool mayAlias(Node *A, Node *B) {
+  MemRef RA, RB;
+  memRef(A, &RA);
+  memRef(B, &RB);
+  return refMayAlias(&RA, &RB);
+}
+
+// 判断是否为可以放入向量的类型
+static bool isVecType(Type *Ty) {
+  if (Ty->IsAtomic)
+    return false;
+  switch (Ty->Kind) {
+  case TY_CHAR:
+  case TY_SHORT:
+  case TY_INT:
+  case TY_LONG:
+  case TY_ENUM:
+  case TY_FLOAT:
+  case TY_DOUBLE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// 跳过不改变值的整数类型转换
+static Node *skipWidenCast(Node *Nd) {
+  while (Nd->Kind == ND_CAST && isVecType(Nd->Ty) && isVecType(Nd->LHS->Ty) &&
+         isInteger(Nd->Ty) && isInteger(Nd->LHS->Ty)) {
+    Type *From = Nd->LHS->Ty, *To = Nd->Ty;
+    // 有符号数不能转换为无符号数，扩展时不能转换为更窄的类型
+    if (From->Size > To->Size || (!From->IsUnsigned && To->IsUnsigned) ||
+        (From->Size == To->Size && From->IsUnsigned != To->IsUnsigned))
+      break;
+    Nd = Nd->LHS;
+  }
+  return Nd;
+}
+
+// 判断是否为循环变量Var
+static bool isVarOf(Node *Nd, Obj *Var) {
+  Nd = skipWidenCast(Nd);
+  return Nd->Kind == ND_VAR && Nd->Var == Var;
+}
+
+// 匹配递增语句 Var++ 、 Var-- 、 Var += C 、 Var -= C 和 Var = Var + C ，
+// 返回变量Var，Step为每次的增量
+static Obj *incVar(Node *Nd, int64_t *Step) {
+  int64_t Val;
+  Nd = skipNopCast(Nd);
+  // Var++ 为 (Var += 1) - 1
+  if (Nd->Kind == ND_ADD && isConstInt(Nd->RHS, &Val))
+    Nd = skipNopCast(Nd->LHS);
+
+  // Var += 1 为 TMP = &Var, *TMP = *TMP + 1
+  Node *Ref = NULL, *Var = NULL;
+  if (Nd->Kind == ND_COMMA && Nd->LHS->Kind == ND_ASSIGN &&
+      skipNopCast(Nd->LHS->RHS)->Kind == ND_ADDR) {
+    Ref = Nd->LHS->LHS;
+    Var = skipWidenCast(skipNopCast(Nd->LHS->RHS)->LHS);
+    Nd = Nd->RHS;
+  }
+  if (Nd->Kind != ND_ASSIGN)
+    return NULL;
+  Node *Add = skipNopCast(Nd->RHS);
+  if ((Add->Kind != ND_ADD && Add->Kind != ND_SUB) ||
+      !isConstInt(Add->RHS, &Val) || Val == 0)
+    return NULL;
+  *Step = Add->Kind == ND_ADD ? Val : -Val;
+
+  Node *LHS = Nd->LHS, *Old = skipNopCast(Add->LHS);
+  if (Ref) {
+    if (Var->Kind == ND_VAR && Ref->Kind == ND_VAR && LHS->Kind == ND_DEREF &&
+        LHS->LHS->Kind == ND_VAR && LHS->LHS->Var == Ref->Var &&
+        Old->Kind == ND_DEREF && Old->LHS->Kind == ND_VAR &&
+        Old->LHS->Var == Ref->Var)
+      return Var->Var;
+    return NULL;
+  }
+  if (LHS->Kind == ND_VAR && Old->Kind == ND_VAR && Old->Var == LHS->Var)
+    return LHS->Var;
+  return NULL;
+}
+
+// 判断是否为加1
+static bool isIncrement(Node *Nd, Obj *Var) {
+  int64_t Step;
+  return incVar(Nd, &Step) == Var && Step == 1;
+}
+
+// 判断变量在循环中是否不变
+static bool isInvariantVar(VecLoop *L, Obj *Var) {
+  if (Var == L->IV || (L->RedVar && Var == L->RedVar->Var))
+    return false;
+  // 全局变量可能被通过指针写入的数组元素修改，
+  // 线程局部变量的地址可能需要调用__tls_get_addr获取，会破坏向量寄存器
+  if (!Var->IsLocal)
+    return !L->StoreViaPtr && !Var->IsTLS;
+  return isPrivateVar(Var);
+}
+
+// 判断是否为循环不变量，循环不变量在循环前计算一次
+static bool isInvariant(VecLoop *L, Node *Nd) {
+  if (!isVecType(Nd->Ty))
+    return false;
+
+  switch (Nd->Kind) {
+  case ND_NUM:
+    return true;
+  case ND_VAR:
+    return isInvariantVar(L, Nd->Var);
+  case ND_CAST:
+  case ND_NEG:
+  case ND_BITNOT:
+  case ND_NOT:
+    return isInvariant(L, Nd->LHS);
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+  case ND_DIV:
+  case ND_MOD:
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+  case ND_SHL:
+  case ND_SHR:
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+    return isInvariant(L, Nd->LHS) && isInvariant(L, Nd->RHS);
+  default:
+    return false;
+  }
+}
+
+// 检查类型的位数，Exact时需要等于元素的位数，否则需要不小于元素的位数
+// 整数运算的结果只有低位是正确的，除法、右移和比较等需要完整的值
+// 第一遍分析时，只记录需要的元素位数
+static bool vecWidth(VecLoop *L, Type *Ty, bool Exact) {
+  int Bits = Ty->Size * 8;
+  if (!L->Checking) {
+    if (Exact)
+      L->SEW = MAX(L->SEW, Bits);
+    return true;
+  }
+  return Exact ? Bits == L->SEW : Bits >= L->SEW;
+}
+
+// 复合赋值中的*TMP，替换为TMP指向的左值
+static Node *vecResolve(VecLoop *L, Node *Nd) {
+  Nd = skipNopCast(Nd);
+  if (L->Cur && L->Cur->Tmp && Nd->Kind == ND_DEREF &&
+      Nd->LHS->Kind == ND_VAR && Nd->LHS->Var == L->Cur->Tmp)
+    return L->Cur->TmpLV;
+  return Nd;
+}
+
+// 匹配下标为I的数组元素 Base[I] ，即 *(Base + I * Size)
+// 返回对应的数组，第一次访问时记录该数组
+static VecArray *vecArray(VecLoop *L, Node *Nd) {
+  Nd = vecResolve(L, Nd);
+  if (Nd->Kind != ND_DEREF || Nd->LHS->Kind != ND_ADD || !isVecType(Nd->Ty))
+    return NULL;
+
+  Node *Base = skipNopCast(Nd->LHS->LHS), *Off = skipNopCast(Nd->LHS->RHS);
+  int64_t Size;
+  // 数组转换为指向首元素的指针
+  if (Base->Kind == ND_CAST && Base->LHS->Ty->Kind == TY_ARRAY)
+    Base = Base->LHS;
+  if (Base->Kind != ND_VAR || Off->Kind != ND_MUL ||
+      !isConstInt(Off->RHS, &Size) || Size != Nd->Ty->Size ||
+      !isVarOf(Off->LHS, L->IV))
+    return NULL;
+
+  for (int I = 0; I < L->NumArrays; I++)
+    if (L->Arrays[I].Base->Var == Base->Var)
+      return &L->Arrays[I];
+
+  // 数组的地址不变，指针需要是循环中不变的局部变量
+  Obj *Var = Base->Var;
+  if (Var->Ty->Kind == TY_PTR) {
+    if (!isPrivateVar(Var) || Var == L->IV)
+      return NULL;
+  } else if (Var->Ty->Kind != TY_ARRAY) {
+    return NULL;
+  }
+
+  if (L->NumArrays == VEC_ARRAYS)
+    return NULL;
+  VecArray *A = &L->Arrays[L->NumArrays++];
+  *A = (VecArray){Base, Nd->Ty};
+  return A;
+}
+
+// 记录循环不变量，在循环前广播到向量寄存器中
+static bool addScalar(VecLoop *L, Node *Nd) {
+  if (L->Checking)
+    return true;
+  if (L->NumScalars == VEC_SCALARS)
+    return false;
+  L->Scalars[L->NumScalars++] = Nd;
+  return true;
+}
+
+static bool vecExpr(VecLoop *L, Node *Nd);
+
+// 分析移位的位数，可以是不受元素位数限制的循环不变量
+static bool vecShiftAmount(VecLoop *L, Node *Nd) {
+  if (isInvariant(L, Nd) && isInteger(Nd->Ty))
+    return addScalar(L, Nd);
+  return vecExpr(L, Nd);
+}
+
+// 分析逐元素计算的表达式，并统计需要的临时向量寄存器
+static bool vecExpr(VecLoop *L, Node *Nd) {
+  if (isInvariant(L, Nd))
+    return vecWidth(L, Nd->Ty, isFloNum(Nd->Ty)) && addScalar(L, Nd);
+  if (!isVecType(Nd->Ty))
+    return false;
+
+  bool Flo = isFloNum(Nd->Ty);
+  int64_t Sh;
+  switch (Nd->Kind) {
+  case ND_DEREF: {
+    VecArray *A = vecArray(L, Nd);
+    if (!A)
+      return false;
+    // 比元素窄的整数，加载后需要扩展
+    L->Temps += 2;
+    if (!L->Checking)
+      L->SEW = MAX(L->SEW, A->Ty->Size * 8);
+    return !Flo || vecWidth(L, Nd->Ty, true);
+  }
+  case ND_CAST:
+    // 整数与浮点数间、float与double间的转换，需要改变元素的位数
+    if (Flo || isFloNum(Nd->LHS->Ty))
+      return Nd->Ty->Kind == Nd->LHS->Ty->Kind && vecExpr(L, Nd->LHS);
+    return vecWidth(L, Nd->Ty, false) && vecExpr(L, Nd->LHS);
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+    L->Temps++;
+    return vecWidth(L, Nd->Ty, Flo) && vecExpr(L, Nd->LHS) &&
+           vecExpr(L, Nd->RHS);
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+    L->Temps++;
+    return !Flo && vecWidth(L, Nd->Ty, false) && vecExpr(L, Nd->LHS) &&
+           vecExpr(L, Nd->RHS);
+  case ND_DIV:
+  case ND_MOD:
+    L->Temps++;
+    return (!Flo || Nd->Kind == ND_DIV) && vecWidth(L, Nd->Ty, true) &&
+           vecExpr(L, Nd->LHS) && vecExpr(L, Nd->RHS);
+  case ND_SHL: {
+    // 左移的位数小于元素的位数时，结果的低位与移出的高位无关
+    L->Temps++;
+    int Max = L->Checking ? L->SEW : Nd->Ty->Size * 8;
+    bool Exact = !isConstInt(Nd->RHS, &Sh) || Sh < 0 || Sh >= Max;
+    return !Flo && vecWidth(L, Nd->Ty, Exact) && vecExpr(L, Nd->LHS) &&
+           vecShiftAmount(L, Nd->RHS);
+  }
+  case ND_SHR:
+    L->Temps++;
+    return !Flo && vecWidth(L, Nd->Ty, true) && vecExpr(L, Nd->LHS) &&
+           vecShiftAmount(L, Nd->RHS);
+  case ND_NEG:
+    L->Temps++;
+    return vecWidth(L, Nd->Ty, Flo) && vecExpr(L, Nd->LHS);
+  case ND_BITNOT:
+    L->Temps++;
+    return !Flo && vecWidth(L, Nd->Ty, false) && vecExpr(L, Nd->LHS);
+  default:
+    return false;
+  }
+}
+
+// 分析查找的条件，比较的结果存入v0
+static bool vecCond(VecLoop *L, Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+    return isVecType(Nd->LHS->Ty) && vecWidth(L, Nd->LHS->Ty, true) &&
+           vecExpr(L, Nd->LHS) && vecExpr(L, Nd->RHS);
+  case ND_NOT:
+    Nd = Nd->LHS;
+    break;
+  default:
+    break;
+  }
+  // 与0比较
+  return isInteger(Nd->Ty) && isVecType(Nd->Ty) &&
+         vecWidth(L, Nd->Ty, true) && vecExpr(L, Nd);
+}
+
+// 判断语句是否会离开循环，即return、break或goto
+static bool isLoopExit(Node *Nd, Node *Loop) {
+  if (Nd->Kind == ND_BLOCK) {
+    Node *Last = Nd->Body;
+    if (!Last)
+      return false;
+    while (Last->Next)
+      Last = Last->Next;
+    return isLoopExit(Last, Loop);
+  }
+  return Nd->Kind == ND_RETURN ||
+         (Nd->Kind == ND_GOTO && Nd->UniqueLabel != Loop->ContLabel);
+}
+
+// 分析循环体中的表达式语句，匹配写入数组元素或归约的赋值
+static bool vecStmt(VecLoop *L, Node *Nd) {
+  if (L->NumStmts == VEC_STMTS)
+    return false;
+  VecStmt *S = &L->Stmts[L->NumStmts++];
+  *S = (VecStmt){};
+  L->Cur = S;
+
+  // 复合赋值 TMP = &LV, *TMP = *TMP op E
+  if (Nd->Kind == ND_COMMA && Nd->LHS->Kind == ND_ASSIGN &&
+      Nd->LHS->LHS->Kind == ND_VAR && !*Nd->LHS->LHS->Var->Name &&
+      skipNopCast(Nd->LHS->RHS)->Kind == ND_ADDR) {
+    S->Tmp = Nd->LHS->LHS->Var;
+    S->TmpLV = skipNopCast(Nd->LHS->RHS)->LHS;
+    Nd = Nd->RHS;
+  }
+  if (Nd->Kind != ND_ASSIGN)
+    return false;
+  Node *Dst = vecResolve(L, Nd->LHS);
+  if (S->Tmp && Dst == Nd->LHS)
+    return false;
+
+  // 写入数组元素
+  if (Dst->Kind != ND_VAR) {
+    VecArray *A = vecArray(L, Dst);
+    if (!A)
+      return false;
+    A->IsStored = true;
+    if (A->Base->Var->Ty->Kind == TY_PTR)
+      L->StoreViaPtr = true;
+    S->Dst = Dst;
+    S->Src = Nd->RHS;
+    return true;
+  }
+
+  // 归约 S = S op E ，只能有一个
+  Node *Op = skipNopCast(Nd->RHS);
+  if (L->RedVar || !isPrivateVar(Dst->Var) || !isInteger(Dst->Ty) ||
+      !isVecType(Dst->Ty) || Dst->Var == L->IV || Op->Ty->Size != Dst->Ty->Size)
+    return false;
+  switch (Op->Kind) {
+  case ND_ADD:
+  case ND_SUB:
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+    break;
+  default:
+    return false;
+  }
+
+  Node *LHS = vecResolve(L, Op->LHS), *RHS = vecResolve(L, Op->RHS);
+  if (LHS->Kind == ND_VAR && LHS->Var == Dst->Var)
+    S->Src = Op->RHS;
+  else if (RHS->Kind == ND_VAR && RHS->Var == Dst->Var && Op->Kind != ND_SUB)
+    S->Src = Op->LHS;
+  else
+    return false;
+  L->RedVar = Dst;
+  L->RedOp = Op->Kind;
+  return true;
+}
+
+// 分析循环是否可以向量化
+static bool vecAnalyze(VecLoop *L, Node *Nd) {
+  if (!Nd->Cond || !Nd->Inc || !Nd->Then)
+    return false;
+
+  // 条件为 I < N 、 I <= N 或 I != N ，I为int或long类型的局部变量
+  Node *Cond = Nd->Cond;
+  if (Cond->Kind != ND_LT && Cond->Kind != ND_LE && Cond->Kind != ND_NE)
+    return false;
+  Node *IV = skipWidenCast(Cond->LHS);
+  if (IV->Kind != ND_VAR || !isInteger(IV->Ty) || !isVecType(IV->Ty) ||
+      IV->Ty->Size < 4 || !isPrivateVar(IV->Var) ||
+      !isIncrement(Nd->Inc, IV->Var))
+    return false;
+  L->IV = IV->Var;
+
+  // 循环体
+  Node *Body = Nd->Then;
+  if (Body->Kind == ND_BLOCK && Body->Body && !Body->Body->Next &&
+      Body->Body->Kind == ND_IF)
+    Body = Body->Body;
+  if (Body->Kind == ND_IF) {
+    // 查找满足条件的元素
+    if (Body->Els || !isLoopExit(Body->Then, Nd))
+      return false;
+    L->Search = Body->Cond;
+  } else if (Body->Kind == ND_BLOCK) {
+    for (Node *S = Body->Body; S; S = S->Next)
+      if (S->Kind != ND_EXPR_STMT || !vecStmt(L, S->LHS))
+        return false;
+  } else if (Body->Kind != ND_EXPR_STMT || !vecStmt(L, Body->LHS)) {
+    return false;
+  }
+  if (!L->Search && !L->NumStmts)
+    return false;
+
+  if (!isInvariant(L, Cond->RHS))
+    return false;
+
+  // 第一遍确定元素的位数，第二遍检查各运算的位数
+  for (int Pass = 0; Pass < 2; Pass++) {
+    L->Checking = Pass;
+    L->MaxTemps = 0;
+    if (L->Search) {
+      L->Cur = NULL;
+      L->Temps = 0;
+      if (!vecCond(L, L->Search))
+        return false;
+      L->MaxTemps = L->Temps;
+    }
+    for (int I = 0; I < L->NumStmts; I++) {
+      VecStmt *S = &L->Stmts[I];
+      L->Cur = S;
+      L->Temps = 0;
+      // 写入的元素和归约的变量不能比向量中的元素窄
+      Type *Ty = S->Dst ? S->Dst->Ty : L->RedVar->Ty;
+      if (!vecWidth(L, Ty, true) || !vecExpr(L, S->Src))
+        return false;
+      L->MaxTemps = MAX(L->MaxTemps, L->Temps);
+    }
+  }
+
+  // 数组的元素为1、2、4、8字节，可以通过移位计算地址
+  if (!L->NumArrays)
+    return false;
+  // v0为掩码，归约需要累加值和一个临时寄存器
+  int Regs = 1 + L->NumScalars + L->MaxTemps + (L->RedVar ? 2 : 0);
+  return Regs <= 32;
+}
+
+// 逐元素运算的向量指令
+static char *vecInsn(NodeKind Kind, Type *Ty) {
+  bool Flo = isFloNum(Ty), U = Ty->IsUnsigned;
+  switch (Kind) {
+  case ND_ADD:
+    return Flo ? "vfadd" : "vadd";
+  case ND_SUB:
+    return Flo ? "vfsub" : "vsub";
+  case ND_MUL:
+    return Flo ? "vfmul" : "vmul";
+  case ND_DIV:
+    return Flo ? "vfdiv" : U ? "vdivu" : "vdiv";
+  case ND_MOD:
+    return U ? "vremu" : "vrem";
+  case ND_BITAND:
+    return "vand";
+  case ND_BITOR:
+    return "vor";
+  case ND_BITXOR:
+    return "vxor";
+  case ND_SHL:
+    return "vsll";
+  case ND_SHR:
+    return U ? "vsrl" : "vsra";
+  default:
+    unreachable();
+  }
+}
+
+// 数组当前元素的地址所在的寄存器
+static int vecArrayReg(VecLoop *L, VecArray *A) { return 2 + (A - L->Arrays); }
+
+// 生成逐元素计算的代码，返回存放结果的向量寄存器
+static int genVecExpr(VecLoop *L, Node *Nd) {
+  for (int I = 0; I < L->NumScalars; I++)
+    if (L->Scalars[I] == Nd)
+      return 1 + I;
+
+  int D;
+  switch (Nd->Kind) {
+  case ND_DEREF: {
+    VecArray *A = vecArray(L, Nd);
+    int Bits = A->Ty->Size * 8;
+    int R = L->NextReg++;
+    // 查找时，后面的元素可能越过数组的末尾，只有首个元素的访存可以出错
+    printLn("  vle%d%s.v v%d, (a%d)", Bits, L->Search ? "ff" : "", R,
+            vecArrayReg(L, A));
+    if (Bits == L->SEW)
+      return R;
+    D = L->NextReg++;
+    printLn("  v%sext.vf%d v%d, v%d", A->Ty->IsUnsigned ? "z" : "s",
+            L->SEW / Bits, D, R);
+    return D;
+  }
+  case ND_CAST:
+    // 低位不变，更窄的整数已经扩展到元素的位数
+    return genVecExpr(L, Nd->LHS);
+  case ND_NEG: {
+    int R = genVecExpr(L, Nd->LHS);
+    D = L->NextReg++;
+    printLn("  %s v%d, v%d", isFloNum(Nd->Ty) ? "vfneg.v" : "vneg.v", D, R);
+    return D;
+  }
+  case ND_BITNOT: {
+    int R = genVecExpr(L, Nd->LHS);
+    D = L->NextReg++;
+    printLn("  vnot.v v%d, v%d", D, R);
+    return D;
+  }
+  default: {
+    int R1 = genVecExpr(L, Nd->LHS);
+    int R2 = genVecExpr(L, Nd->RHS);
+    D = L->NextReg++;
+    printLn("  %s.vv v%d, v%d, v%d", vecInsn(Nd->Kind, Nd->Ty), D, R1, R2);
+    return D;
+  }
+  }
+}
+
+// 生成查找的条件，结果存入掩码寄存器v0
+static void genVecCond(VecLoop *L, Node *Nd) {
+  char *Cmp;
+  switch (Nd->Kind) {
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE: {
+    Type *Ty = Nd->LHS->Ty;
+    int R1 = genVecExpr(L, Nd->LHS);
+    int R2 = genVecExpr(L, Nd->RHS);
+    char *Name = Nd->Kind == ND_EQ   ? "eq"
+                 : Nd->Kind == ND_NE ? "ne"
+                 : Nd->Kind == ND_LT ? "lt"
+                                     : "le";
+    if (isFloNum(Ty))
+      printLn("  vmf%s.vv v0, v%d, v%d", Name, R1, R2);
+    else
+      printLn("  vms%s%s.vv v0, v%d, v%d", Name,
+              Ty->IsUnsigned && Nd->Kind != ND_EQ && Nd->Kind != ND_NE ? "u"
+                                                                      : "",
+              R1, R2);
+    return;
+  }
+  case ND_NOT:
+    Cmp = "vmseq";
+    Nd = Nd->LHS;
+    break;
+  default:
+    Cmp = "vmsne";
+    break;
+  }
+  printLn("  %s.vi v0, v%d, 0", Cmp, genVecExpr(L, Nd));
+}
+
+// 生成数组的地址移动Reg个元素的代码
+static void vecAdvance(VecLoop *L, char *Reg) {
+  for (int I = 0; I < L->NumArrays; I++) {
+    int Sh = log2Exact(L->Arrays[I].Ty->Size);
+    if (Sh) {
+      printLn("  slli t1, %s, %d", Reg, Sh);
+      printLn("  add a%d, a%d, t1", 2 + I, 2 + I);
+    } else {
+      printLn("  add a%d, a%d, %s", 2 + I, 2 + I, Reg);
+    }
+  }
+}
+
+// 检查两个数组是否重叠，重叠时执行标量循环
+// 起始地址相同、元素大小相同时，同一下标只会被同一次迭代访问，不算重叠
+static void genVecAliasCheck(VecLoop *L, int I, int J, char *Scalar) {
+  VecArray *A = &L->Arrays[I], *B = &L->Arrays[J];
+  int C = count();
+  char *Ok = format(".L.vec.noalias.%s.%d", CurrentFn->Name, C);
+  printLn("  # 检查数组%s与%s是否重叠", A->Base->Var->Name, B->Base->Var->Name);
+  if (A->Ty->Size == B->Ty->Size)
+    printLn("  beq a%d, a%d, %s", 2 + I, 2 + J, Ok);
+  printLn("  slli t0, a1, %d", log2Exact(A->Ty->Size));
+  printLn("  add t0, t0, a%d", 2 + I);
+  printLn("  bleu t0, a%d, %s", 2 + J, Ok);
+  printLn("  slli t0, a1, %d", log2Exact(B->Ty->Size));
+  printLn("  add t0, t0, a%d", 2 + J);
+  printLn("  bleu t0, a%d, %s", 2 + I, Ok);
+  printLn("  j %s", Scalar);
+  printLn("%s:", Ok);
+}
+
+// 判断向量循环访问的两个数组是否可能重叠，需要在运行时检查
+static bool vecMayAlias(VecArray *A, VecArray *B) {
+  Obj *VA = A->Base->Var, *VB = B->Base->Var;
+  if (VA->Ty->Kind != TY_PTR && VB->Ty->Kind != TY_PTR)
+    return false;
+  MemRef RA = {VA, VA->Ty->Kind == TY_PTR, false, false, 0, A->Ty};
+  MemRef RB = {VB, VB->Ty->Kind == TY_PTR, false, false, 0, B->Ty};
+  return refMayAlias(&RA, &RB);
+}
+
+// 生成循环的向量版本，之后进入原来的标量循环
+static void genVecLoop(Node *Nd, int C) {
+  VecLoop L = {};
+  if (!vecAnalyze(&L, Nd))
+    return;
+
+  char *Fn = CurrentFn->Name;
+  char *Scalar = format(".L.scalar.%s.%d", Fn, C);
+  Node *Cond = Nd->Cond;
+  Type *Ty = Cond->LHS->Ty;
+  int SEW = L.SEW;
+  int Acc = 1 + L.NumScalars;
+  printLn("\n# 循环%d的向量版本，元素为%d位", C, SEW);
+
+  // 迭代次数为N-I，不为正时执行标量循环
+  printLn("  # 计算迭代次数，存入a1");
+  genExpr(Cond->RHS);
+  push();
+  genExpr(Cond->LHS);
+  pop(1);
+  if (Ty->Size == 4 && Ty->IsUnsigned) {
+    printLn("  slli a0, a0, 32");
+    printLn("  srli a0, a0, 32");
+    printLn("  slli a1, a1, 32");
+    printLn("  srli a1, a1, 32");
+  }
+  char *U = Ty->IsUnsigned ? "u" : "";
+  if (Cond->Kind == ND_LE) {
+    printLn("  blt%s a1, a0, %s", U, Scalar);
+    printLn("  sub a1, a1, a0");
+    printLn("  addi a1, a1, 1");
+    printLn("  beqz a1, %s", Scalar);
+  } else {
+    printLn("  bge%s a0, a1, %s", U, Scalar);
+    printLn("  sub a1, a1, a0");
+  }
+  push();
+  printLn("  mv a0, a1");
+  push();
+
+  // 数组的起始地址
+  for (int I = 0; I < L.NumArrays; I++) {
+    genExpr(L.Arrays[I].Base);
+    push();
+  }
+
+  // 循环不变量广播到向量寄存器中
+  if (L.NumScalars || L.RedVar)
+    printLn("  vsetvli t0, zero, e%d, m1, ta, ma", SEW);
+  for (int I = 0; I < L.NumScalars; I++) {
+    Node *S = L.Scalars[I];
+    genExpr(S);
+    if (isFloNum(S->Ty))
+      printLn("  vfmv.v.f v%d, fa0", 1 + I);
+    else
+      printLn("  vmv.v.x v%d, a0", 1 + I);
+  }
+  if (L.RedVar)
+    printLn("  vmv.v.i v%d, %d", Acc, L.RedOp == ND_BITAND ? -1 : 0);
+
+  for (int I = L.NumArrays - 1; I >= 0; I--)
+    pop(2 + I);
+  pop(1);
+  pop(0);
+  vecAdvance(&L, "a0");
+
+  // 写入的数组与其他数组重叠时，执行标量循环
+  for (int I = 0; I < L.NumArrays; I++)
+    for (int J = I + 1; J < L.NumArrays; J++)
+      if ((L.Arrays[I].IsStored || L.Arrays[J].IsStored) &&
+          vecMayAlias(&L.Arrays[I], &L.Arrays[J]))
+        genVecAliasCheck(&L, I, J, Scalar);
+
+  // 每段处理vl个元素，归约时保留累加值中超出vl的部分
+  printLn(".L.vec.%s.%d:", Fn, C);
+  printLn("  vsetvli t0, a1, e%d, m1, %s, ma", SEW, L.RedVar ? "tu" : "ta");
+  for (int I = 0; I < L.NumStmts; I++) {
+    VecStmt *S = &L.Stmts[I];
+    L.Cur = S;
+    L.NextReg = Acc + (L.RedVar ? 1 : 0);
+    int R = genVecExpr(&L, S->Src);
+    if (S->Dst)
+      printLn("  vse%d.v v%d, (a%d)", SEW, R,
+              vecArrayReg(&L, vecArray(&L, S->Dst)));
+    else
+      printLn("  %s.vv v%d, v%d, v%d", vecInsn(L.RedOp, L.RedVar->Ty), Acc,
+              Acc, R);
+  }
+  if (L.Search) {
+    L.Cur = NULL;
+    L.NextReg = Acc;
+    genVecCond(&L, L.Search);
+    // 首元素之后的访存出错时，vl会减小
+    printLn("  csrr t0, vl");
+    printLn("  vfirst.m t1, v0");
+    printLn("  bgez t1, .L.vec.found.%s.%d", Fn, C);
+  }
+  printLn("  sub a1, a1, t0");
+  printLn("  add a0, a0, t0");
+  vecAdvance(&L, "t0");
+  printLn("  bnez a1, .L.vec.%s.%d", Fn, C);
+
+  // 写回I，标量循环的条件不再成立
+  storeVar(L.IV, false);
+
+  // 累加值的各元素归约到一起，再加上原来的值
+  if (L.RedVar) {
+    int R = Acc + 1;
+    char *Red = L.RedOp == ND_BITAND  ? "and"
+                : L.RedOp == ND_BITOR  ? "or"
+                : L.RedOp == ND_BITXOR ? "xor"
+                                       : "sum";
+    printLn("  # 归约到变量%s中", L.RedVar->Var->Name);
+    printLn("  vsetvli t0, zero, e%d, m1, ta, ma", SEW);
+    genExpr(L.RedVar);
+    printLn("  vmv.s.x v%d, a0", R);
+    printLn("  vred%s.vs v%d, v%d, v%d", Red, R, Acc, R);
+    printLn("  vmv.x.s a0, v%d", R);
+    storeVar(L.RedVar->Var, false);
+  }
+
+  // 找到的元素，由标量循环再次判断条件，执行循环体
+  if (L.Search) {
+    printLn("  j %s", Scalar);
+    printLn(".L.vec.found.%s.%d:", Fn, C);
+    printLn("  add a0, a0, t1");
+    storeVar(L.IV, false);
+  }
+
+  // 标量循环之前可能还要计算放入寄存器的循环不变量
+  printLn("%s:", Scalar);
+}
+
+//
+// 循环优化
+//
+// -O1及以上时，生成for和do while循环前先分析循环：
+//   循环中不变的变量读取、地址和运算（循环不变量），在循环前计算一次，
+//   存入s1～s11寄存器，循环中直接使用寄存器；
+//   for循环的递增语句为 I += C 时，下标为 I + K 的数组元素的地址，
+//   在循环前计算，每次迭代加上 C * 元素大小，代替下标的乘法和加法，
+//   I的递增也直接读写栈中的变量，不再经过指向它的临时变量；
+//   -funroll-loops时，迭代次数为不超过8的常量的for循环完全展开，
+//   循环体中的I替换为各次迭代的常量。
+// s1～s11为被调用者保存的寄存器，函数调用不会改变，用到的在序言中保存。
+// 循环中有函数调用、原子操作，或通过指针、对全局变量的写入时，
+// 只有地址和不会被间接写入的局部变量的读取是不变的。
+// 通过指针的读取可能访问无效的地址，只在第一次判断for的条件时一定计算的，
+// 才能提前到循环前。
+// 循环中有内联汇编、标签、外层switch的case，或调用setjmp时不进行优化。
+//
+
+// 循环优化可用的s寄存器数
+#define LOOP_REGS 11
+// 一个循环中放入寄存器的表达式、记录的写入的局部变量和左值的最大个数
+#define LOOP_VALS 64
+#define LOOP_MODS 32
+#define LOOP_STORES 16
+// 完全展开的最大迭代次数，以及循环体的最大节点数
+#define UNROLL_TRIPS 8
+#define UNROLL_NODES 40
+
+// 放入寄存器的表达式
+typedef struct {
+  Node *Nd;    // 循环中的表达式
+  int Reg;     // 对应的s寄存器
+  int64_t Off; // 表达式的值为寄存器加上Off
+} LoopVal;
+
+// 循环中使用的s寄存器
+typedef struct {
+  Node *Init;   // 在循环前计算初值的表达式
+  Node *Base;   // 数组的基址，为NULL时是循环不变量
+  int64_t Size; // 数组元素的大小
+  int64_t Disp; // 初值中下标相对于I的偏移
+} LoopReg;
+
+// 循环的分析结果
+typedef struct {
+  bool Bad;             // 不能优化
+  bool Clobber;         // 可能写入任意的内存
+  bool Jumps;           // 有跳转、嵌套的循环或switch，不能展开
+  bool Exits;           // 有break、continue、goto或return，循环体可能只执行一部分
+  bool InBody;          // 正在收集for的循环体
+  bool Guard;           // 外提了循环体中的读取，需先判断一次条件
+  int Nodes;            // 循环体的节点数
+  Obj *Mods[LOOP_MODS]; // 循环中写入的局部变量
+  int NumMods;          // 超过LOOP_MODS时，视为写入了所有的局部变量
+  // 循环中写入的其他左值，由别名分析判断影响哪些读取
+  Node *Stores[LOOP_STORES];
+  int NumStores;
+  Obj *Tmp;             // 复合赋值中指向左值的临时变量
+  Obj *IV;              // 归纳变量
+  int64_t Step;         // 归纳变量每次迭代的增量
+  bool Reduce;          // 对数组元素的地址进行强度削减
+  LoopReg Regs[LOOP_REGS];
+  int NumRegs;
+  int FirstReg; // 使用s(FirstReg+1)起的寄存器
+  LoopVal Vals[LOOP_VALS];
+  int NumVals;
+  bool Unroll;         // 完全展开
+  int Trips;           // 展开的迭代次数
+  int64_t Start, Last; // 归纳变量的初值和循环结束时的值
+} LoopInfo;
+
+// 外层循环中放入寄存器的表达式
+static _Thread_local LoopVal LoopVals[256];
+static _Thread_local int NumLoopVals;
+// 外层循环使用的s寄存器数
+static _Thread_local int NumLoopRegs;
+// 完全展开的循环中，替换为常量的归纳变量
+static _Thread_local Obj *UnrollVar;
+static _Thread_local int64_t UnrollVal;
+// 当前函数保存的s寄存器数，及保存的位置
+static _Thread_local int NumSavedRegs;
+static _Thread_local int SavedRegsOffset;
+
+// 记录循环中写入的变量，其他变量可能通过指针被写入时视为写入任意内存
+static void loopMod(LoopInfo *L, Obj *Var) {
+  if (!Var->IsLocal || !isPrivateVar(Var))
+    L->Clobber = true;
+  for (int I = 0; I < L->NumMods && I < LOOP_MODS; I++)
+    if (L->Mods[I] == Var)
+      return;
+  if (L->NumMods < LOOP_MODS)
+    L->Mods[L->NumMods] = Var;
+  L->NumMods++;
+}
+
+// 判断变量是否在循环中被写入
+static bool isLoopMod(LoopInfo *L, Obj *Var) {
+  if (L->NumMods > LOOP_MODS)
+    return true;
+  for (int I = 0; I < L->NumMods; I++)
+    if (L->Mods[I] == Var)
+      return true;
+  return false;
+}
+
+// 写入左值
+static void loopStore(LoopInfo *L, Node *LV) {
+  if (LV->Kind == ND_VAR && isPrivateVar(LV->Var)) {
+    loopMod(L, LV->Var);
+    return;
+  }
+  if (L->NumStores == LOOP_STORES) {
+    L->Clobber = true;
+    return;
+  }
+  L->Stores[L->NumStores++] = LV;
+}
+
+// 判断循环中的写入是否可能改变左值LV
+static bool loopStored(LoopInfo *L, Node *LV) {
+  if (L->Clobber)
+    return true;
+  for (int I = 0; I < L->NumStores; I++)
+    if (mayAlias(L->Stores[I], LV))
+      return true;
+  return false;
+}
+
+// 扫描循环中的语句和表达式，记录写入的变量和影响优化的语句
+static void loopScan(LoopInfo *L, Node *Nd, int Switches) {
+  for (; Nd; Nd = Nd->Next) {
+    L->Nodes++;
+    switch (Nd->Kind) {
+    case ND_ASM:
+    case ND_LABEL:
+      L->Bad = true;
+      break;
+    case ND_CASE:
+      // 跳转到循环中的case
+      if (!Switches)
+        L->Bad = true;
+      break;
+    case ND_GOTO:
+    case ND_GOTO_EXPR:
+      L->Exits = true;
+      L->Jumps = true;
+      break;
+    case ND_RETURN:
+      L->Exits = true;
+      break;
+    case ND_FOR:
+    case ND_DO:
+      L->Jumps = true;
+      break;
+    case ND_SWITCH:
+      L->Jumps = true;
+      loopScan(L, Nd->Cond, Switches);
+      loopScan(L, Nd->Then, Switches + 1);
+      continue;
+    case ND_FUNCALL: {
+      L->Clobber = true;
+      // setjmp返回两次，longjmp后寄存器会恢复为setjmp时的值
+      Obj *Fn = directCallee(Nd->LHS);
+      if (Fn && (strstr(Fn->Name, "setjmp") || !strcmp(Fn->Name, "vfork")))
+        L->Bad = true;
+      if (Nd->RetBuffer)
+        loopMod(L, Nd->RetBuffer);
+      break;
+    }
+    case ND_CAS:
+    case ND_ATOMIC_RW:
+    case ND_ATOMIC_ST:
+    case ND_FENCE:
+      L->Clobber = true;
+      break;
+    case ND_MEMZERO:
+    case ND_VLA_PTR:
+      loopMod(L, Nd->Var);
+      break;
+    case ND_ADDR: {
+      Node *X = Nd->LHS;
+      while (X->Kind == ND_MEMBER)
+        X = X->LHS;
+      if (X->Kind == ND_VAR)
+        loopMod(L, X->Var);
+      break;
+    }
+    case ND_ASSIGN:
+      // TMP = &LV ，之后的 *TMP = E 写入LV
+      if (isTmpAddr(Nd)) {
+        Node *LV = skipNopCast(Nd->RHS)->LHS;
+        loopScan(L, LV->LHS, Switches);
+        loopScan(L, LV->RHS, Switches);
+        loopStore(L, LV);
+        loopMod(L, Nd->LHS->Var);
+        L->Tmp = Nd->LHS->Var;
+        continue;
+      }
+      if (!(L->Tmp && Nd->LHS->Kind == ND_DEREF &&
+            Nd->LHS->LHS->Kind == ND_VAR && Nd->LHS->LHS->Var == L->Tmp))
+        loopStore(L, Nd->LHS);
+      break;
+    default:
+      break;
+    }
+    if (Nd->VecTmp)
+      loopMod(L, Nd->VecTmp);
+
+    loopScan(L, Nd->LHS, Switches);
+    loopScan(L, Nd->RHS, Switches);
+    loopScan(L, Nd->Cond, Switches);
+    loopScan(L, Nd->Then, Switches);
+    loopScan(L, Nd->Els, Switches);
+    loopScan(L, Nd->Init, Switches);
+    loopScan(L, Nd->Inc, Switches);
+    loopScan(L, Nd->Body, Switches);
+    loopScan(L, Nd->Args, Switches);
+    loopScan(L, Nd->CasAddr, Switches);
+    loopScan(L, Nd->CasOld, Switches);
+    loopScan(L, Nd->CasNew, Switches);
+    loopScan(L, Nd->Mask, Switches);
+  }
+}
+
+// 可以放入寄存器的值：整数、指针，以及数组的地址
+static bool isLoopScalar(Type *Ty) {
+  if (Ty->IsVolatile || Ty->IsAtomic)
+    return false;
+  return isInteger(Ty) || Ty->Kind == TY_PTR || Ty->Kind == TY_ARRAY;
+}
+
+static bool loopInvariant(LoopInfo *L, Node *Nd, bool *Load);
+
+// 判断左值的地址在循环中是否不变，经过指针时记录Load
+static bool loopInvariantAddr(LoopInfo *L, Node *Nd, bool *Load) {
+  switch (Nd->Kind) {
+  case ND_VAR:
+    return !Nd->Var->IsTLS && Nd->Var->Ty->Kind != TY_VLA;
+  case ND_DEREF:
+    *Load = true;
+    return loopInvariant(L, Nd->LHS, Load);
+  case ND_MEMBER:
+    return !Nd->Mem->IsBitfield && loopInvariantAddr(L, Nd->LHS, Load);
+  default:
+    return false;
+  }
+}
+
+// 判断表达式的值在循环中是否不变，通过指针读取时记录Load
+static bool loopInvariant(LoopInfo *L, Node *Nd, bool *Load) {
+  if (!isLoopScalar(Nd->Ty) || Nd->VecTmp)
+    return false;
+  // 数组的值为其地址，不需要读取内存
+  bool IsAddr = Nd->Ty->Kind == TY_ARRAY;
+
+  switch (Nd->Kind) {
+  case ND_NUM:
+    return true;
+  case ND_VAR: {
+    Obj *Var = Nd->Var;
+    if (Var->IsTLS || Var->Ty->Kind == TY_VLA)
+      return false;
+    if (IsAddr)
+      return true;
+    if (isPrivateVar(Var))
+      return !isLoopMod(L, Var);
+    return !isLoopMod(L, Var) && !loopStored(L, Nd);
+  }
+  case ND_MEMBER: {
+    if (Nd->Mem->IsBitfield)
+      return false;
+    if (!IsAddr) {
+      // 读取结构体变量的成员，或通过指针读取
+      Node *Root = Nd->LHS;
+      while (Root->Kind == ND_MEMBER)
+        Root = Root->LHS;
+      if ((Root->Kind == ND_VAR && isLoopMod(L, Root->Var)) ||
+          loopStored(L, Nd))
+        return false;
+    }
+    return loopInvariantAddr(L, Nd->LHS, Load);
+  }
+  case ND_DEREF:
+    if (!IsAddr) {
+      if (loopStored(L, Nd))
+        return false;
+      *Load = true;
+    }
+    return loopInvariant(L, Nd->LHS, Load);
+  case ND_ADDR:
+    return loopInvariantAddr(L, Nd->LHS, Load);
+  case ND_CAST:
+  case ND_NEG:
+  case ND_BITNOT:
+  case ND_NOT:
+    return loopInvariant(L, Nd->LHS, Load);
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+  case ND_DIV:
+  case ND_MOD:
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+  case ND_SHL:
+  case ND_SHR:
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+    return loopInvariant(L, Nd->LHS, Load) && loopInvariant(L, Nd->RHS, Load);
+  default:
+    return false;
+  }
+}
+
+// 计算代价很低，不必放入寄存器的值：常量、局部数组和局部变量的地址，
+// 以及已在寄存器中的变量
+static bool isCheapValue(Node *Nd) {
+  while (Nd->Kind == ND_CAST)
+    Nd = Nd->LHS;
+  switch (Nd->Kind) {
+  case ND_NUM:
+    return true;
+  case ND_VAR:
+    return (Nd->Var->IsLocal && Nd->Ty->Kind == TY_ARRAY) || Nd->Var->Reg;
+  case ND_ADDR:
+    return Nd->LHS->Kind == ND_VAR && Nd->LHS->Var->IsLocal;
+  default:
+    return false;
+  }
+}
+
+// 判断两个表达式是否相同，相同的表达式共用寄存器
+static bool sameExpr(Node *A, Node *B) {
+  if (A->Kind != B->Kind || A->Ty->Kind != B->Ty->Kind ||
+      A->Ty->Size != B->Ty->Size || A->Ty->IsUnsigned != B->Ty->IsUnsigned)
+    return false;
+
+  switch (A->Kind) {
+  case ND_NUM:
+    return A->Val == B->Val;
+  case ND_VAR:
+    return A->Var == B->Var;
+  case ND_MEMBER:
+    return A->Mem == B->Mem && sameExpr(A->LHS, B->LHS);
+  case ND_DEREF:
+  case ND_ADDR:
+  case ND_CAST:
+  case ND_NEG:
+  case ND_BITNOT:
+  case ND_NOT:
+    return sameExpr(A->LHS, B->LHS);
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+  case ND_DIV:
+  case ND_MOD:
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+  case ND_SHL:
+  case ND_SHR:
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+    return sameExpr(A->LHS, B->LHS) && sameExpr(A->RHS, B->RHS);
+  default:
+    return false;
+  }
+}
+
+// 查找外层循环中放入寄存器的表达式
+static LoopVal *findLoopVal(Node *Nd) {
+  for (int I = NumLoopVals - 1; I >= 0; I--)
+    if (LoopVals[I].Nd == Nd)
+      return &LoopVals[I];
+  return NULL;
+}
+
+// 记录放入第I个寄存器的表达式
+static bool addLoopVal(LoopInfo *L, Node *Nd, int I, int64_t Off) {
+  if (L->NumVals == LOOP_VALS)
+    return false;
+  L->Vals[L->NumVals++] = (LoopVal){Nd, L->FirstReg + I + 1, Off};
+  return true;
+}
+
+// 分配一个寄存器，没有空闲的寄存器时返回-1
+static int addLoopReg(LoopInfo *L, LoopReg R) {
+  if (L->NumVals == LOOP_VALS || L->FirstReg + L->NumRegs == LOOP_REGS)
+    return -1;
+  L->Regs[L->NumRegs] = R;
+  return L->NumRegs++;
+}
+
+// 循环不变量放入寄存器，Uncond为第一次迭代时一定计算的表达式
+static bool hoistInvariant(LoopInfo *L, Node *Nd, bool Uncond) {
+  bool Load = false;
+  if (!OptFMoveLoopInvariants || isCheapValue(Nd) ||
+      !loopInvariant(L, Nd, &Load))
+    return false;
+
+  for (int I = 0; I < L->NumRegs; I++)
+    if (!L->Regs[I].Base && sameExpr(L->Regs[I].Init, Nd))
+      return addLoopVal(L, Nd, I, 0);
+
+  // 读取内存的表达式提前计算，须保证原来的循环也会读取
+  if (Load && !Uncond)
+    return false;
+  int I = addLoopReg(L, (LoopReg){Nd});
+  if (I < 0 || !addLoopVal(L, Nd, I, 0))
+    return false;
+  if (Load && L->InBody)
+    L->Guard = true;
+  return true;
+}
+
+// 匹配下标 I 、 I + K 和 I - K ，I为归纳变量
+static bool ivIndex(LoopInfo *L, Node *Nd, int64_t *K) {
+  *K = 0;
+  Nd = skipWidenCast(Nd);
+  if ((Nd->Kind == ND_ADD || Nd->Kind == ND_SUB) && isConstInt(Nd->RHS, K)) {
+    if (Nd->Kind == ND_SUB)
+      *K = -*K;
+    Nd = skipWidenCast(Nd->LHS);
+  }
+  return Nd->Kind == ND_VAR && Nd->Var == L->IV;
+}
+
+// 数组元素的地址 Base + (I + K) * Size ，基址相同的元素共用寄存器
+static bool reduceIV(LoopInfo *L, Node *Nd) {
+  if (!L->Reduce || Nd->Kind != ND_ADD || Nd->Ty->Kind != TY_PTR)
+    return false;
+
+  Node *Base = Nd->LHS, *Mul = skipNopCast(Nd->RHS);
+  int64_t Size, K;
+  bool Load = false;
+  if (Mul->Kind != ND_MUL || !isConstInt(Mul->RHS, &Size) ||
+      !ivIndex(L, Mul->LHS, &K) || !loopInvariant(L, Base, &Load) || Load)
+    return false;
+
+  for (int I = 0; I < L->NumRegs; I++) {
+    LoopReg *R = &L->Regs[I];
+    if (R->Base && R->Size == Size && sameExpr(R->Base, Base))
+      return addLoopVal(L, Nd, I, (K - R->Disp) * Size);
+  }
+  int I = addLoopReg(L, (LoopReg){Nd, Base, Size, K});
+  return I >= 0 && addLoopVal(L, Nd, I, 0);
+}
+
+static void collectExpr(LoopInfo *L, Node *Nd, bool Uncond);
+static void collectStmt(LoopInfo *L, Node *Nd, bool Uncond);
+
+// 收集计算左值的地址时使用的值
+static void collectAddr(LoopInfo *L, Node *Nd) {
+  switch (Nd->Kind) {
+  case ND_DEREF:
+    collectExpr(L, Nd->LHS, false);
+    return;
+  case ND_MEMBER:
+    collectAddr(L, Nd->LHS);
+    return;
+  case ND_COMMA:
+    collectExpr(L, Nd->LHS, false);
+    collectAddr(L, Nd->RHS);
+    return;
+  default:
+    return;
+  }
+}
+
+// 按照生成代码时的方式遍历表达式，收集可以放入寄存器的值
+static void collectExpr(LoopInfo *L, Node *Nd, bool Uncond) {
+  // 空表达式、栈中变量清零等没有类型
+  if (!Nd->Ty || findLoopVal(Nd) || reduceIV(L, Nd) ||
+      hoistInvariant(L, Nd, Uncond) || Nd->VecTmp)
+    return;
+
+  switch (Nd->Kind) {
+  case ND_ASSIGN:
+    collectAddr(L, Nd->LHS);
+    collectExpr(L, Nd->RHS, Uncond);
+    return;
+  case ND_ADDR:
+  case ND_MEMBER:
+    collectAddr(L, Nd->LHS);
+    return;
+  case ND_COND:
+    collectExpr(L, Nd->Cond, Uncond);
+    collectExpr(L, Nd->Then, false);
+    collectExpr(L, Nd->Els, false);
+    return;
+  case ND_LOGAND:
+  case ND_LOGOR:
+    collectExpr(L, Nd->LHS, Uncond);
+    collectExpr(L, Nd->RHS, false);
+    return;
+  case ND_FUNCALL:
+    if (!directCallee(Nd->LHS))
+      collectExpr(L, Nd->LHS, false);
+    for (Node *Arg = Nd->Args; Arg; Arg = Arg->Next)
+      collectExpr(L, Arg, false);
+    return;
+  case ND_STMT_EXPR:
+    for (Node *N = Nd->Body; N; N = N->Next)
+      collectStmt(L, N, false);
+    return;
+  case ND_CAS:
+  case ND_ATOMIC_RW:
+  case ND_ATOMIC_LD:
+  case ND_ATOMIC_ST:
+  case ND_SHUFFLE:
+    return;
+  default:
+    if (Nd->LHS)
+      collectExpr(L, Nd->LHS, Uncond);
+    if (Nd->RHS)
+      collectExpr(L, Nd->RHS, Uncond);
+    return;
+  }
+}
+
+// 遍历语句，收集可以放入寄存器的值
+// Uncond为每次迭代都会执行的语句
+static void collectStmt(LoopInfo *L, Node *Nd, bool Uncond) {
+  switch (Nd->Kind) {
+  case ND_EXPR_STMT:
+    collectExpr(L, Nd->LHS, Uncond);
+    return;
+  case ND_RETURN:
+    if (Nd->LHS)
+      collectExpr(L, Nd->LHS, false);
+    return;
+  case ND_BLOCK:
+    for (Node *N = Nd->Body; N; N = N->Next)
+      collectStmt(L, N, Uncond);
+    return;
+  case ND_IF:
+    collectExpr(L, Nd->Cond, Uncond);
+    collectStmt(L, Nd->Then, false);
+    if (Nd->Els)
+      collectStmt(L, Nd->Els, false);
+    return;
+  case ND_FOR:
+    if (Nd->Init)
+      collectStmt(L, Nd->Init, Uncond);
+    if (Nd->Cond)
+      collectExpr(L, Nd->Cond, Uncond);
+    if (Nd->Inc)
+      collectExpr(L, Nd->Inc, false);
+    collectStmt(L, Nd->Then, false);
+    return;
+  case ND_DO:
+    collectStmt(L, Nd->Then, false);
+    collectExpr(L, Nd->Cond, false);
+    return;
+  case ND_SWITCH:
+    collectExpr(L, Nd->Cond, Uncond);
+    collectStmt(L, Nd->Then, false);
+    return;
+  case ND_CASE:
+    collectStmt(L, Nd->LHS, false);
+    return;
+  default:
+    return;
+  }
+}
+
+// 判断语句或表达式是否写入变量Var
+static bool writesVar(Node *Nd, Obj *Var) {
+  if (!Nd)
+    return false;
+  if ((Nd->Kind == ND_ASSIGN || Nd->Kind == ND_ADDR) &&
+      Nd->LHS->Kind == ND_VAR && Nd->LHS->Var == Var)
+    return true;
+  if (Nd->Kind == ND_MEMZERO && Nd->Var == Var)
+    return true;
+  for (Node *N = Nd->Body; N; N = N->Next)
+    if (writesVar(N, Var))
+      return true;
+  for (Node *N = Nd->Args; N; N = N->Next)
+    if (writesVar(N, Var))
+      return true;
+  return writesVar(Nd->LHS, Var) || writesVar(Nd->RHS, Var) ||
+         writesVar(Nd->Cond, Var) || writesVar(Nd->Then, Var) ||
+         writesVar(Nd->Els, Var) || writesVar(Nd->Init, Var) ||
+         writesVar(Nd->Inc, Var);
+}
+
+// 获取初始化语句最后赋给Var的常量
+static bool loopStart(Node *Nd, Obj *Var, int64_t *Val, bool *Found) {
+  for (; Nd; Nd = Nd->Next) {
+    switch (Nd->Kind) {
+    case ND_BLOCK:
+      if (!loopStart(Nd->Body, Var, Val, Found))
+        return false;
+      continue;
+    case ND_EXPR_STMT:
+      if (!loopStart(Nd->LHS, Var, Val, Found))
+        return false;
+      continue;
+    case ND_COMMA:
+      if (!loopStart(Nd->LHS, Var, Val, Found) ||
+          !loopStart(Nd->RHS, Var, Val, Found))
+        return false;
+      continue;
+    case ND_MEMZERO:
+      if (Nd->Var == Var) {
+        *Val = 0;
+        *Found = true;
+      }
+      continue;
+    case ND_ASSIGN:
+      if (Nd->LHS->Kind == ND_VAR && Nd->LHS->Var == Var) {
+        if (writesVar(Nd->RHS, Var) || !isConstInt(Nd->RHS, Val))
+          return false;
+        *Found = true;
+        continue;
       }
+      break;
+    default:
+      break;
+    }
+    if (writesVar(Nd, Var))
+      return false;
+  }
+  return true;
+}
+
+// 截断为归纳变量类型的值
+static int64_t ivWrap(Type *Ty, int64_t Val) {
+  if (Ty->Size == 4)
+    return Ty->IsUnsigned ? (int64_t)(uint32_t)Val : (int64_t)(int32_t)Val;
+  return Val;
+}
+
+// 计算条件 A op B
+static bool unrollCond(NodeKind Kind, bool Unsigned, int64_t A, int64_t B) {
+  switch (Kind) {
+  case ND_LT:
+    return Unsigned ? (uint64_t)A < (uint64_t)B : A < B;
+  case ND_LE:
+    return Unsigned ? (uint64_t)A <= (uint64_t)B : A <= B;
+  default:
+    return A != B;
+  }
+}
+
+// 完全展开：I的初值和条件中比较的值为常量，迭代次数不超过UNROLL_TRIPS
+static bool loopUnroll(LoopInfo *L, Node *Nd, Obj *IV, int64_t Step) {
+  Node *Cond = Nd->Cond;
+  if (L->Jumps || L->Nodes > UNROLL_NODES || !Nd->Init || !Cond ||
+      (Cond->Kind != ND_LT && Cond->Kind != ND_LE && Cond->Kind != ND_NE))
+    return false;
+
+  bool Found = false;
+  int64_t Limit;
+  if (!loopStart(Nd->Init, IV, &L->Start, &Found) || !Found)
+    return false;
+  bool IVLeft = isVarOf(Cond->LHS, IV) && isConstInt(Cond->RHS, &Limit);
+  if (!IVLeft && !(isVarOf(Cond->RHS, IV) && isConstInt(Cond->LHS, &Limit)))
+    return false;
+
+  int64_t Val = ivWrap(IV->Ty, L->Start);
+  bool U = Cond->LHS->Ty->IsUnsigned;
+  for (L->Trips = 0; IVLeft ? unrollCond(Cond->Kind, U, Val, Limit)
+                            : unrollCond(Cond->Kind, U, Limit, Val);
+       L->Trips++) {
+    if (L->Trips == UNROLL_TRIPS)
+      return false;
+    Val = ivWrap(IV->Ty, Val + Step);
+  }
+  L->Start = ivWrap(IV->Ty, L->Start);
+  L->Last = Val;
+  L->IV = IV;
+  L->Step = Step;
+  return true;
+}
+
+// 分析循环，返回是否进行优化
+static bool loopAnalyze(LoopInfo *L, Node *Nd) {
+  L->Bad = L->Clobber = L->Jumps = L->Reduce = L->Unroll = false;
+  L->Exits = L->InBody = L->Guard = false;
+  L->Nodes = L->NumMods = L->NumStores = L->NumRegs = L->NumVals = 0;
+  L->Tmp = L->IV = NULL;
+  L->FirstReg = NumLoopRegs;
+  if (!OptOLevel ||
+      !(OptFMoveLoopInvariants || OptFIVOpts || OptFUnrollLoops))
+    return false;
+
+  loopScan(L, Nd->Then, 0);
+  int Nodes = L->Nodes;
+  loopScan(L, Nd->Cond, 0);
+  if (L->Bad)
+    return false;
+
+  // 归纳变量是只在递增语句中写入的int或long类型的局部变量
+  Obj *IV = NULL;
+  int64_t Step;
+  if (Nd->Kind == ND_FOR && Nd->Inc) {
+    IV = incVar(Nd->Inc, &Step);
+    if (IV && (!isInteger(IV->Ty) || IV->Ty->IsAtomic || IV->Ty->IsVolatile ||
+               (IV->Ty->Size != 4 && IV->Ty->Size != 8) ||
+               isLoopMod(L, IV) || !isPrivateVar(IV)))
+      IV = NULL;
+    loopScan(L, Nd->Inc, 0);
+    if (L->Bad)
+      return false;
+  }
+
+  L->Nodes = Nodes;
+  if (IV && OptFUnrollLoops && loopUnroll(L, Nd, IV, Step)) {
+    L->Unroll = true;
+    return true;
+  }
+
+  if (IV && OptFIVOpts) {
+    L->IV = IV;
+    L->Step = Step;
+    // 32位的无符号数回绕时，地址不能随之回绕
+    L->Reduce = IV->Ty->Size == 8 || !IV->Ty->IsUnsigned;
+  }
+
+  // 第一次判断for的条件时，其中的表达式一定会计算
+  if (Nd->Cond)
+    collectExpr(L, Nd->Cond, Nd->Kind == ND_FOR);
+  // 循环体中没有提前结束迭代的语句时，每次迭代都会执行整个循环体。
+  // for的循环体可能不执行，外提其中的读取时要先判断一次条件
+  L->InBody = Nd->Kind == ND_FOR && Nd->Cond;
+  collectStmt(L, Nd->Then, !L->Exits);
+  L->InBody = false;
+  if (Nd->Inc && !L->IV)
+    collectExpr(L, Nd->Inc, false);
+  return L->NumRegs > 0 || L->IV;
+}
+
+// 登记循环中放入寄存器的表达式
+static void loopActivate(LoopInfo *L) {
+  NumLoopRegs += L->NumRegs;
+  for (int I = 0; I < L->NumVals; I++)
+    if (NumLoopVals < (int)(sizeof(LoopVals) / sizeof(*LoopVals)))
+      LoopVals[NumLoopVals++] = L->Vals[I];
+}
+
+// 离开循环，恢复为外层循环登记的表达式
+static void loopLeave(LoopInfo *L, int Vals) {
+  NumLoopRegs -= L->NumRegs;
+  NumLoopVals = Vals;
+}
+
+// 在循环前计算各寄存器的初值
+static void loopEnter(LoopInfo *L, int C) {
+  for (int I = 0; I < L->NumRegs; I++) {
+    int Reg = L->FirstReg + I + 1;
+    if (L->Regs[I].Base)
+      printLn("\n# 循环%d中数组元素的地址，每次迭代递增，存入s%d", C, Reg);
+    else
+      printLn("\n# 循环%d的不变量，存入s%d", C, Reg);
+    genExpr(L->Regs[I].Init);
+    printLn("  mv s%d, a0", Reg);
+  }
+  loopActivate(L);
+}
+
+// 递增语句：数组元素的地址加上增量，直接读写归纳变量
+static void loopInc(LoopInfo *L, Node *Inc) {
+  if (!L->IV) {
+    genExpr(Inc);
+    return;
+  }
+
+  for (int I = 0; I < L->NumRegs; I++) {
+    LoopReg *R = &L->Regs[I];
+    if (!R->Base)
+      continue;
+    printLn("  # 数组元素的地址s%d加上%ld", L->FirstReg + I + 1,
+            L->Step * R->Size);
+    genAddImm(format("s%d", L->FirstReg + I + 1), L->Step * R->Size);
+  }
+
+  Obj *IV = L->IV;
+  printLn("  # 归纳变量%s加上%ld", IV->Name, L->Step);
+  // 寄存器中的有符号数直接相加，32位时保持符号扩展
+  if (IV->Reg && isImm12(L->Step) &&
+      (IV->Ty->Size == 8 || !IV->Ty->IsUnsigned)) {
+    printLn("  addi%s s%d, s%d, %ld", IV->Ty->Size == 4 ? "w" : "", IV->Reg,
+            IV->Reg, L->Step);
+    return;
+  }
+  loadVar(IV);
+  genAddImm("a0", L->Step);
+  storeVar(IV, false);
+}
+
+// 完全展开的循环，循环体中的归纳变量依次替换为各次迭代的值
+static void genUnroll(LoopInfo *L, Node *Nd, int C) {
+  printLn("\n# 循环%d完全展开为%d次迭代", C, L->Trips);
+  int64_t Val = L->Start;
+  for (int I = 0; I < L->Trips; I++) {
+    printLn("\n# 循环%d的第%d次迭代，%s为%ld", C, I + 1, L->IV->Name, Val);
+    UnrollVar = L->IV;
+    UnrollVal = Val;
+    genStmt(Nd->Then);
+    Val = ivWrap(L->IV->Ty, Val + L->Step);
+  }
+  UnrollVar = NULL;
+
+  printLn("  # 循环结束时%s为%ld", L->IV->Name, L->Last);
+  printLn("  li a0, %ld", L->Last);
+  storeVar(L->IV, false);
+}
+
+// 循环优化中放入寄存器的表达式，以及完全展开时的归纳变量
+static bool genLoopVal(Node *Nd) {
+  if (UnrollVar && Nd->Kind == ND_VAR && Nd->Var == UnrollVar) {
+    printLn("  li a0, %ld", UnrollVal);
+    return true;
+  }
+
+  LoopVal *V = findLoopVal(Nd);
+  if (!V)
+    return false;
+  printLn("  mv a0, s%d", V->Reg);
+  if (V->Off)
+    genAddImm("a0", V->Off);
+  return true;
+}
+
+// 统计函数中的循环需要的s寄存器数，与生成代码时的分析相同
+static void loopRegsNeeded(Node *Nd, int *Max) {
+  if (!Nd)
+    return;
+
+  loopRegsNeeded(Nd->Init, Max);
+  if (Nd->Kind == ND_FOR || Nd->Kind == ND_DO) {
+    LoopInfo L;
+    if (loopAnalyze(&L, Nd)) {
+      // 展开的循环中没有嵌套的循环
+      if (L.Unroll)
+        return;
+      int Vals = NumLoopVals;
+      loopActivate(&L);
+      *Max = MAX(*Max, NumLoopRegs);
+      loopRegsNeeded(Nd->Cond, Max);
+      loopRegsNeeded(Nd->Then, Max);
+      loopRegsNeeded(Nd->Inc, Max);
+      loopLeave(&L, Vals);
       return;
+    }
+  }
+
+  for (Node *N = Nd->Body; N; N = N->Next)
+    loopRegsNeeded(N, Max);
+  for (Node *N = Nd->Args; N; N = N->Next)
+    loopRegsNeeded(N, Max);
+  loopRegsNeeded(Nd->LHS, Max);
+  loopRegsNeeded(Nd->RHS, Max);
+  loopRegsNeeded(Nd->Cond, Max);
+  loopRegsNeeded(Nd->Then, Max);
+  loopRegsNeeded(Nd->Els, Max);
+  loopRegsNeeded(Nd->Inc, Max);
+}
+
+// 为循环优化保留的s寄存器的最大个数
+#define LOOP_REGS_RESERVED 4
+// 放入寄存器的变量的最少加权使用次数，更少时保存和恢复寄存器的代价更高
+#define REG_MIN_USES 3
+
+// 统计局部变量按循环嵌套加权的使用次数，W为当前的权重
+// 有内联汇编或返回两次的函数时，不能将变量放入寄存器，返回false
+static bool countRegUses(Node *Nd, int64_t W) {
+  for (; Nd; Nd = Nd->Next) {
+    switch (Nd->Kind) {
+    case ND_ASM:
+      return false;
+    case ND_FUNCALL: {
+      Obj *Fn = directCallee(Nd->LHS);
+      if (Fn && (strstr(Fn->Name, "setjmp") || !strcmp(Fn->Name, "vfork")))
+        return false;
+      break;
+    }
+    case ND_VAR:
+      if (Nd->Var->IsLocal && Nd->Var->RegUses >= 0)
+        Nd->Var->RegUses += W;
+      break;
+    case ND_ASSIGN: {
+      // 复合赋值 TMP = &Var ，TMP随Var一起放入寄存器，不单独分配
+      Node *X = skipNopCast(Nd->RHS)->LHS;
+      if (isTmpAddr(Nd) && X->Kind == ND_VAR) {
+        Nd->LHS->Var->RegUses = -1;
+        if (X->Var->RegUses >= 0)
+          X->Var->RegUses += W * 2;
+        continue;
+      }
+      // 对复合字面量 (初始化, 变量) 赋值时，需要变量的地址
+      for (X = Nd->LHS; X->Kind == ND_COMMA;)
+        X = X->RHS;
+      if (X != Nd->LHS && X->Kind == ND_VAR)
+        X->Var->RegUses = -1;
+      break;
+    }
+    case ND_FOR:
+    case ND_DO: {
+      int64_t W2 = W < (1 << 20) ? W * 8 : W;
+      if (!countRegUses(Nd->Init, W) || !countRegUses(Nd->Cond, W2) ||
+          !countRegUses(Nd->Then, W2) || !countRegUses(Nd->Inc, W2))
+        return false;
+      continue;
+    }
     default:
       break;
     }
 
-    // 如果返回的结构体小于16字节，直接使用寄存器返回
-    if (Nd->RetBuffer && Nd->Ty->Size <= 16) {
-      copyRetBuffer(Nd->RetBuffer);
-      printLn("  li t0, %d", Nd->RetBuffer->Offset);
-      printLn("  add a0, fp, t0");
-    }
+    if (!countRegUses(Nd->LHS, W) || !countRegUses(Nd->RHS, W) ||
+        !countRegUses(Nd->Cond, W) || !countRegUses(Nd->Then, W) ||
+        !countRegUses(Nd->Els, W) || !countRegUses(Nd->Init, W) ||
+        !countRegUses(Nd->Inc, W) || !countRegUses(Nd->Body, W) ||
+        !countRegUses(Nd->Args, W) || !countRegUses(Nd->CasAddr, W) ||
+        !countRegUses(Nd->CasOld, W) || !countRegUses(Nd->CasNew, W))
+      return false;
+  }
+  return true;
+}
 
-    return;
+// 判断局部变量能否放入寄存器：地址未被获取的非volatile整型和指针
+static bool isRegCandidate(Obj *Fn, Obj *Var) {
+  Type *Ty = Var->Ty;
+  if (Var->RegUses < REG_MIN_USES || !isPrivateVar(Var) || Ty->IsVolatile ||
+      Ty->IsAtomic || Var->TLSVar || Var == Fn->AllocaBottom)
+    return false;
+  return isInteger(Ty) || Ty->Kind == TY_PTR;
+}
+
+// 判断是否为放入寄存器的、通过寄存器传递的64位或有符号32位整型形参
+static bool isRegParam(Obj *Var) {
+  Type *Ty = Var->Ty;
+  return Var->Reg && Var->Offset < 0 &&
+         (Ty->Size == 8 || (Ty->Size == 4 && !Ty->IsUnsigned));
+}
+
+// 选择放入s寄存器的局部变量，返回使用的寄存器数
+static int assignRegVars(Obj *Fn) {
+  for (Obj *Var = Fn->Locals; Var; Var = Var->Next) {
+    Var->Reg = 0;
+    Var->RegUses = 0;
   }
-  case ND_LABEL_VAL:
-    // printLn("  lea %s(%%rip), %%rax", Nd->UniqueLabel);
-    printLn("  la a0, %s", Nd->UniqueLabel);
-    return;
+  if (!OptOLevel || !countRegUses(Fn->Body, 1))
+    return 0;
+
+  // 循环优化的不变量和数组元素的地址也使用s寄存器，为其保留一部分
+  int Need = 0;
+  loopRegsNeeded(Fn->Body, &Need);
+  int Max = LOOP_REGS - MIN(Need, LOOP_REGS_RESERVED);
+
+  // 按使用次数从多到少依次分配
+  int N = 0;
+  while (N < Max) {
+    Obj *Best = NULL;
+    for (Obj *Var = Fn->Locals; Var; Var = Var->Next)
+      if (!Var->Reg && isRegCandidate(Fn, Var) &&
+          (!Best || Var->RegUses > Best->RegUses))
+        Best = Var;
+    if (!Best)
+      break;
+    Best->Reg = ++N;
+  }
+  return N;
+}
+
+//
+// 向量类型的运算
+//
+// vector_size属性声明的向量与结构体一样，以地址表示。
+// 运算的结果写入节点上的临时变量VecTmp，a0为其地址。
+// 开启V扩展时使用RVV指令；否则位运算，以及8、16位元素的加减，
+// 在通用寄存器中每次处理8个字节（SWAR），其余运算逐个元素计算。
+//
+// 运算时的寄存器：
+//   a0、a1为左右操作数，向量为地址，标量为值（浮点在fa0、fa1中），
+//   a2为结果的地址，a3为__builtin_shuffle下标向量的地址，
+//   t3为循环的计数，fa2、fa3存放浮点元素（ft0～ft11保存着fs0～fs11），
+//   v0为比较的掩码，v8、v12、v16、v20为各操作数和结果
+//
+
+static bool isVector(Type *Ty) { return Ty->Kind == TY_VECTOR; }
+
+// 参与运算的向量的类型
+static Type *vecOpType(Node *Nd) {
+  if (isVector(Nd->LHS->Ty))
+    return Nd->LHS->Ty;
+  return Nd->RHS->Ty;
+}
+
+// 计算各操作数，存入a0、a1、a3（浮点标量存入fa0、fa1）
+static void genVecOperands(Node *Nd) {
+  Node *Ops[] = {Nd->LHS, Nd->RHS, Nd->Mask};
+  int Regs[] = {0, 1, 3};
+  int Last = Nd->Mask ? 2 : Nd->RHS ? 1 : 0;
+
+  for (int I = 0; I <= Last; I++) {
+    if (!Ops[I])
+      continue;
+    genExpr(Ops[I]);
+    if (I == Last)
+      break;
+    if (isFloNum(Ops[I]->Ty))
+      pushF();
+    else
+      push();
+  }
+
+  if (Regs[Last] != 0) {
+    if (isFloNum(Ops[Last]->Ty))
+      printLn("  fmv.d fa%d, fa0", Regs[Last]);
+    else
+      printLn("  mv a%d, a0", Regs[Last]);
+  }
+  for (int I = Last - 1; I >= 0; I--) {
+    if (!Ops[I])
+      continue;
+    if (isFloNum(Ops[I]->Ty))
+      popF(Regs[I]);
+    else
+      pop(Regs[I]);
+  }
+
+  printLn("  # 运算结果的地址存入a2");
+  genStackAddr("a2", Nd->VecTmp->Offset);
+}
+
+// 使用RVV指令计算
+static void genVecRVV(Node *Nd) {
+  Type *Ty = Nd->Kind == ND_SHUFFLE ? Nd->Ty : vecOpType(Nd);
+  Type *Elem = Ty->Base;
+  int N = Ty->ArrayLen;
+  int SEW = Elem->Size * 8;
+  int LMUL = MAX(1, Ty->Size / 16);
+  bool Flo = isFloNum(Elem);
+  // 两个输入的__builtin_shuffle，第二次vrgather不能改写未选中的元素
+  char *MA = Nd->Kind == ND_SHUFFLE && Nd->RHS ? "mu" : "ma";
+
+  if (N < 32) {
+    printLn("  vsetivli zero, %d, e%d, m%d, ta, %s", N, SEW, LMUL, MA);
+  } else {
+    printLn("  li t0, %d", N);
+    printLn("  vsetvli zero, t0, e%d, m%d, ta, %s", SEW, LMUL, MA);
+  }
+
+  // 读取操作数，标量广播到整个向量
+  Node *Ops[] = {Nd->LHS, Nd->RHS, Nd->Mask};
+  char *Addrs[] = {"a0", "a1", "a3"};
+  for (int I = 0; I < 3; I++) {
+    if (!Ops[I])
+      continue;
+    int V = 8 + 4 * I;
+    if (isVector(Ops[I]->Ty))
+      printLn("  vle%d.v v%d, (%s)", SEW, V, Addrs[I]);
+    else if (isFloNum(Ops[I]->Ty))
+      printLn("  vfmv.v.f v%d, fa%d", V, I);
+    else
+      printLn("  vmv.v.x v%d, a%d", V, I);
+  }
+
+  int D = 8;
+  switch (Nd->Kind) {
+  case ND_NEG:
+    printLn("  %s v8, v8", Flo ? "vfneg.v" : "vneg.v");
+    break;
+  case ND_BITNOT:
+    printLn("  vnot.v v8, v8");
+    break;
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE: {
+    char *Name = Nd->Kind == ND_EQ   ? "eq"
+                 : Nd->Kind == ND_NE ? "ne"
+                 : Nd->Kind == ND_LT ? "lt"
+                                     : "le";
+    bool U = Elem->IsUnsigned && (Nd->Kind == ND_LT || Nd->Kind == ND_LE);
+    printLn("  vm%s%s%s.vv v0, v8, v12", Flo ? "f" : "s", Name, U ? "u" : "");
+    // 比较结果为真的元素全为1，否则为0
+    printLn("  vmv.v.i v8, 0");
+    printLn("  vmerge.vim v8, v8, -1, v0");
+    break;
+  }
+  case ND_SHUFFLE:
+    // 下标对输入的元素总数取模，两个输入时大于N-1的选取第二个输入
+    printLn("  li t1, %d", (Nd->RHS ? 2 * N : N) - 1);
+    printLn("  vand.vx v16, v16, t1");
+    if (Nd->RHS) {
+      printLn("  li t1, %d", N - 1);
+      printLn("  vmsgtu.vx v0, v16, t1");
+      printLn("  vand.vx v16, v16, t1");
+    }
+    printLn("  vrgather.vv v20, v8, v16");
+    if (Nd->RHS)
+      printLn("  vrgather.vv v20, v12, v16, v0.t");
+    D = 20;
+    break;
   default:
+    printLn("  %s.vv v8, v8, v12", vecInsn(Nd->Kind, Elem));
     break;
   }
 
-  // 处理浮点类型
-  switch (Nd->LHS->Ty->Kind) {
-  case TY_FLOAT:
-  case TY_DOUBLE: {
-    // 递归到最右节点
-    genExpr(Nd->RHS);
-    // 将结果压入栈
-    pushF();
-    // 递归到左节点
-    genExpr(Nd->LHS);
-    // 将结果弹栈到fa1
-    popF(1);
+  printLn("  vse%d.v v%d, (a2)", SEW, D);
+}
 
-    // 生成各个二叉树节点
-    // float对应s(single)后缀，double对应d(double)后缀
-    char *Suffix = (Nd->LHS->Ty->Kind == TY_FLOAT) ? "s" : "d";
+// SWAR中每个元素最高位的掩码
+static uint64_t laneHighBits(int Size) {
+  return Size == 1 ? 0x8080808080808080UL : 0x8000800080008000UL;
+}
 
-    switch (Nd->Kind) {
-    case ND_ADD:
-      printLn("  # fa0+fa1，结果写入fa0");
-      printLn("  fadd.%s fa0, fa0, fa1", Suffix);
-      return;
-    case ND_SUB:
-      printLn("  # fa0-fa1，结果写入fa0");
-      printLn("  fsub.%s fa0, fa0, fa1", Suffix);
-      return;
-    case ND_MUL:
-      printLn("  # fa0×fa1，结果写入fa0");
-      printLn("  fmul.%s fa0, fa0, fa1", Suffix);
-      return;
-    case ND_DIV:
-      printLn("  # fa0÷fa1，结果写入fa0");
-      printLn("  fdiv.%s fa0, fa0, fa1", Suffix);
-      return;
-    case ND_EQ:
-      printLn("  # 判断是否fa0=fa1");
-      printLn("  feq.%s a0, fa0, fa1", Suffix);
-      return;
-    case ND_NE:
-      printLn("  # 判断是否fa0≠fa1");
-      printLn("  feq.%s a0, fa0, fa1", Suffix);
-      printLn("  seqz a0, a0");
-      return;
-    case ND_LT:
-      printLn("  # 判断是否fa0<fa1");
-      printLn("  flt.%s a0, fa0, fa1", Suffix);
-      return;
-    case ND_LE:
-      printLn("  # 判断是否fa0≤fa1");
-      printLn("  fle.%s a0, fa0, fa1", Suffix);
-      return;
-    default:
-      errorTok(Nd->Tok, "invalid expression");
+// 判断能否在通用寄存器中每次处理8个字节
+static bool isSWAROp(Node *Nd) {
+  if (Nd->Kind == ND_SHUFFLE)
+    return false;
+  Type *Ty = vecOpType(Nd);
+  if (isFloNum(Ty->Base) || Ty->Size < 8 ||
+      (Nd->RHS && !isVector(Nd->RHS->Ty)) || !isVector(Nd->LHS->Ty))
+    return false;
+
+  switch (Nd->Kind) {
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+  case ND_BITNOT:
+    return true;
+  case ND_ADD:
+  case ND_SUB:
+  case ND_NEG:
+    return Ty->Base->Size <= 2;
+  default:
+    return false;
+  }
+}
+
+// SWAR计算Off处的8个字节，t4、t5为元素最高位的掩码及其取反
+static void genVecSWAR(Node *Nd, int Off) {
+  printLn("  ld t1, %d(a0)", Off);
+  if (Nd->RHS)
+    printLn("  ld t2, %d(a1)", Off);
+
+  switch (Nd->Kind) {
+  case ND_BITAND:
+    printLn("  and t1, t1, t2");
+    break;
+  case ND_BITOR:
+    printLn("  or t1, t1, t2");
+    break;
+  case ND_BITXOR:
+    printLn("  xor t1, t1, t2");
+    break;
+  case ND_BITNOT:
+    printLn("  not t1, t1");
+    break;
+  case ND_ADD:
+    // ((x&~H)+(y&~H)) ^ ((x^y)&H)，最高位不向相邻的元素进位
+    printLn("  xor t6, t1, t2");
+    printLn("  and t6, t6, t4");
+    printLn("  and t1, t1, t5");
+    printLn("  and t2, t2, t5");
+    printLn("  add t1, t1, t2");
+    printLn("  xor t1, t1, t6");
+    break;
+  case ND_SUB:
+    // ((x|H)-(y&~H)) ^ ((x^~y)&H)，最高位不向相邻的元素借位
+    printLn("  xor t6, t1, t2");
+    printLn("  not t6, t6");
+    printLn("  and t6, t6, t4");
+    printLn("  or t1, t1, t4");
+    printLn("  and t2, t2, t5");
+    printLn("  sub t1, t1, t2");
+    printLn("  xor t1, t1, t6");
+    break;
+  case ND_NEG:
+    // 即 0 - x
+    printLn("  not t6, t1");
+    printLn("  and t6, t6, t4");
+    printLn("  and t1, t1, t5");
+    printLn("  sub t1, t4, t1");
+    printLn("  xor t1, t1, t6");
+    break;
+  default:
+    unreachable();
+  }
+
+  printLn("  sd t1, %d(a2)", Off);
+}
+
+// 读取Off处的元素，向量读取到Reg中，标量直接使用寄存器中的值
+static char *vecElement(Node *Nd, int Idx, int Off, char *Reg) {
+  Type *Ty = Nd->Ty;
+  if (!isVector(Ty)) {
+    if (isFloNum(Ty))
+      return format("fa%d", Idx);
+    return format("a%d", Idx);
+  }
+
+  Type *Elem = Ty->Base;
+  if (isFloNum(Elem))
+    printLn("  fl%c %s, %d(a%d)", sizeSuffix(Elem->Size), Reg, Off, Idx);
+  else
+    printLn("  l%c%s %s, %d(a%d)", sizeSuffix(Elem->Size),
+            Elem->IsUnsigned && Elem->Size < 8 ? "u" : "", Reg, Off, Idx);
+  return Reg;
+}
+
+// 逐个元素计算Off处的元素
+static void genVecScalar(Node *Nd, int Off) {
+  if (Nd->Kind == ND_SHUFFLE) {
+    Type *Ty = Nd->Ty;
+    int Size = Ty->Base->Size;
+    int N = Ty->ArrayLen;
+    int Shift = __builtin_ctz(Size);
+
+    // 下标对输入的元素总数取模
+    printLn("  l%c t1, %d(a3)", sizeSuffix(Size), Off);
+    printLn("  li t2, %d", (Nd->RHS ? 2 * N : N) - 1);
+    printLn("  and t1, t1, t2");
+    if (Nd->RHS) {
+      // 大于N-1时选取第二个输入：t2 = a0 + ((a1-a0) & -(i/N))
+      printLn("  srli t2, t1, %d", __builtin_ctz(N));
+      printLn("  neg t2, t2");
+      printLn("  sub t4, a1, a0");
+      printLn("  and t4, t4, t2");
+      printLn("  add t4, t4, a0");
+      printLn("  li t2, %d", N - 1);
+      printLn("  and t1, t1, t2");
     }
+    if (Shift)
+      printLn("  slli t1, t1, %d", Shift);
+    printLn("  add t1, t1, %s", Nd->RHS ? "t4" : "a0");
+    printLn("  l%c t1, 0(t1)", sizeSuffix(Size));
+    printLn("  s%c t1, %d(a2)", sizeSuffix(Size), Off);
+    return;
   }
-  case TY_LDOUBLE: {
-    genExpr(Nd->LHS);
-    genExpr(Nd->RHS);
 
-    popLD(2);
-    popLD(0);
+  Type *Elem = vecOpType(Nd)->Base;
+  bool Flo = isFloNum(Elem);
+  char *L = vecElement(Nd->LHS, 0, Off, Flo ? "fa2" : "t1");
+  char *R = Nd->RHS ? vecElement(Nd->RHS, 1, Off, Flo ? "fa3" : "t2") : "";
+
+  if (Flo) {
+    char *Sf = Elem->Kind == TY_FLOAT ? "s" : "d";
     switch (Nd->Kind) {
     case ND_ADD:
-      printLn("  # long double加法，从栈顶读取32个字节");
-      printLn("  call __addtf3@plt");
-      pushLD();
-      return;
+      printLn("  fadd.%s fa2, %s, %s", Sf, L, R);
+      break;
     case ND_SUB:
-      printLn("  # long double减法，从栈顶读取32个字节");
-      printLn("  call __subtf3@plt");
-      pushLD();
-      return;
+      printLn("  fsub.%s fa2, %s, %s", Sf, L, R);
+      break;
     case ND_MUL:
-      printLn("  # long double乘法，从栈顶读取32个字节");
-      printLn("  call __multf3@plt");
-      pushLD();
-      return;
+      printLn("  fmul.%s fa2, %s, %s", Sf, L, R);
+      break;
     case ND_DIV:
-      printLn("  # long double除法，从栈顶读取32个字节");
-      printLn("  call __divtf3@plt");
-      pushLD();
-      return;
+      printLn("  fdiv.%s fa2, %s, %s", Sf, L, R);
+      break;
+    case ND_NEG:
+      printLn("  fneg.%s fa2, %s", Sf, L);
+      break;
     case ND_EQ:
-      printLn("  # long double相等，从栈顶读取32个字节");
-      printLn("  call __eqtf2@plt");
-      printLn("  seqz a0, a0");
-      return;
     case ND_NE:
-      printLn("  # long double不等，从栈顶读取32个字节");
-      printLn("  call __netf2@plt");
-      printLn("  snez a0, a0");
-      return;
+      printLn("  feq.%s t1, %s, %s", Sf, L, R);
+      if (Nd->Kind == ND_NE)
+        printLn("  xori t1, t1, 1");
+      break;
     case ND_LT:
-      printLn("  # long double小于，从栈顶读取32个字节");
-      printLn("  call __lttf2@plt");
-      printLn("  slti a0, a0, 0");
-      return;
+      printLn("  flt.%s t1, %s, %s", Sf, L, R);
+      break;
     case ND_LE:
-      printLn("  # long double小于等于，从栈顶读取32个字节");
-      printLn("  call __letf2@plt");
-      printLn("  slti a0, a0, 1");
-      return;
+      printLn("  fle.%s t1, %s, %s", Sf, L, R);
+      break;
     default:
-      errorTok(Nd->Tok, "invalid expression");
+      unreachable();
     }
-  }
-  default:
-    break;
-  }
-
-  // 递归到最右节点
-  genExpr(Nd->RHS);
-  // 将结果压入栈
-  push();
-  // 递归到左节点
-  genExpr(Nd->LHS);
-  // 将结果弹栈到a1
-  pop(1);
-
-  // 生成各个二叉树节点
-  char *Suffix = Nd->LHS->Ty->Kind == TY_LONG || Nd->LHS->Ty->Base ? "" : "w";
-  switch (Nd->Kind) {
-  case ND_ADD: // + a0=a0+a1
-    printLn("  # a0+a1，结果写入a0");
-    printLn("  add%s a0, a0, a1", Suffix);
-    return;
-  case ND_SUB: // - a0=a0-a1
-    printLn("  # a0-a1，结果写入a0");
-    printLn("  sub%s a0, a0, a1", Suffix);
-    return;
-  case ND_MUL: // * a0=a0*a1
-    printLn("  # a0×a1，结果写入a0");
-    printLn("  mul%s a0, a0, a1", Suffix);
-    return;
-  case ND_DIV: // / a0=a0/a1
-    printLn("  # a0÷a1，结果写入a0");
-    if (Nd->Ty->IsUnsigned)
-      printLn("  divu%s a0, a0, a1", Suffix);
-    else
-      printLn("  div%s a0, a0, a1", Suffix);
-    return;
-  case ND_MOD: // % a0=a0%a1
-    printLn("  # a0%%a1，结果写入a0");
-    if (Nd->Ty->IsUnsigned)
-      printLn("  remu%s a0, a0, a1", Suffix);
-    else
-      printLn("  rem%s a0, a0, a1", Suffix);
-    return;
-  case ND_BITAND: // & a0=a0&a1
-    printLn("  # a0&a1，结果写入a0");
-    printLn("  and a0, a0, a1");
-    return;
-  case ND_BITOR: // | a0=a0|a1
-    printLn("  # a0|a1，结果写入a0");
-    printLn("  or a0, a0, a1");
-    return;
-  case ND_BITXOR: // ^ a0=a0^a1
-    printLn("  # a0^a1，结果写入a0");
-    printLn("  xor a0, a0, a1");
+
+    if (Nd->Kind == ND_EQ || Nd->Kind == ND_NE || Nd->Kind == ND_LT ||
+        Nd->Kind == ND_LE) {
+      // 比较结果为真的元素全为1，否则为0
+      printLn("  neg t1, t1");
+      printLn("  s%c t1, %d(a2)", sizeSuffix(Elem->Size), Off);
+      return;
+    }
+    printLn("  fs%c fa2, %d(a2)", sizeSuffix(Elem->Size), Off);
     return;
+  }
+
+  // 不足8字节的元素使用32位的运算，写入时截断
+  char *W = Elem->Size < 8 ? "w" : "";
+  char *U = Elem->IsUnsigned ? "u" : "";
+  switch (Nd->Kind) {
+  case ND_ADD:
+    printLn("  add%s t1, %s, %s", W, L, R);
+    break;
+  case ND_SUB:
+    printLn("  sub%s t1, %s, %s", W, L, R);
+    break;
+  case ND_MUL:
+    printLn("  mul%s t1, %s, %s", W, L, R);
+    break;
+  case ND_DIV:
+    printLn("  div%s%s t1, %s, %s", U, W, L, R);
+    break;
+  case ND_MOD:
+    printLn("  rem%s%s t1, %s, %s", U, W, L, R);
+    break;
+  case ND_BITAND:
+    printLn("  and t1, %s, %s", L, R);
+    break;
+  case ND_BITOR:
+    printLn("  or t1, %s, %s", L, R);
+    break;
+  case ND_BITXOR:
+    printLn("  xor t1, %s, %s", L, R);
+    break;
+  case ND_SHL:
+    printLn("  sll%s t1, %s, %s", W, L, R);
+    break;
+  case ND_SHR:
+    printLn("  sr%s%s t1, %s, %s", Elem->IsUnsigned ? "l" : "a", W, L, R);
+    break;
+  case ND_NEG:
+    printLn("  sub%s t1, zero, %s", W, L);
+    break;
+  case ND_BITNOT:
+    printLn("  not t1, %s", L);
+    break;
   case ND_EQ:
   case ND_NE:
-    // a0=a0^a1，异或指令
-    printLn("  # 判断是否a0%sa1", Nd->Kind == ND_EQ ? "=" : "≠");
-    printLn("  xor a0, a0, a1");
-
-    if (Nd->Kind == ND_EQ)
-      // a0==a1
-      // a0=a0^a1, sltiu a0, a0, 1
-      // 等于0则置1
-      printLn("  seqz a0, a0");
-    else
-      // a0!=a1
-      // a0=a0^a1, sltu a0, x0, a0
-      // 不等于0则置1
-      printLn("  snez a0, a0");
-    return;
+    printLn("  xor t1, %s, %s", L, R);
+    printLn("  %s t1, t1", Nd->Kind == ND_EQ ? "seqz" : "snez");
+    printLn("  neg t1, t1");
+    break;
   case ND_LT:
-    printLn("  # 判断a0<a1");
-    if (Nd->LHS->Ty->IsUnsigned)
-      printLn("  sltu a0, a0, a1");
-    else
-      printLn("  slt a0, a0, a1");
-    return;
+    printLn("  slt%s t1, %s, %s", U, L, R);
+    printLn("  neg t1, t1");
+    break;
   case ND_LE:
-    // a0<=a1等价于
-    // a0=a1<a0, a0=a0^1
-    printLn("  # 判断是否a0≤a1");
-    if (Nd->LHS->Ty->IsUnsigned)
-      printLn("  sltu a0, a1, a0");
-    else
-      printLn("  slt a0, a1, a0");
-    printLn("  xori a0, a0, 1");
-    return;
-  case ND_SHL:
-    printLn("  # a0逻辑左移a1位");
-    printLn("  sll%s a0, a0, a1", Suffix);
-    return;
-  case ND_SHR:
-    printLn("  # a0算术右移a1位");
-    if (Nd->Ty->IsUnsigned)
-      printLn("  srl%s a0, a0, a1", Suffix);
-    else
-      printLn("  sra%s a0, a0, a1", Suffix);
-    return;
-  default:
+    printLn("  slt%s t1, %s, %s", U, R, L);
+    printLn("  addi t1, t1, -1");
     break;
+  default:
+    unreachable();
   }
+  printLn("  s%c t1, %d(a2)", sizeSuffix(Elem->Size), Off);
+}
 
-  errorTok(Nd->Tok, "invalid expression");
+// 每次计算Step字节，次数较少时展开，否则生成循环
+static void genVecSegments(Node *Nd, int Step,
+                           void (*Body)(Node *Nd, int Off)) {
+  int Cnt = Nd->Ty->Size / Step;
+  if (Cnt <= 8) {
+    for (int I = 0; I < Cnt; I++)
+      Body(Nd, I * Step);
+    return;
+  }
+
+  int C = count();
+  printLn("  li t3, %d", Cnt);
+  printLn(".L.vec_op.%s.%d:", CurrentFn->Name, C);
+  Body(Nd, 0);
+  // __builtin_shuffle按下标读取输入，只移动下标向量
+  if (Nd->Kind == ND_SHUFFLE) {
+    printLn("  addi a3, a3, %d", Step);
+  } else {
+    if (isVector(Nd->LHS->Ty))
+      printLn("  addi a0, a0, %d", Step);
+    if (Nd->RHS && isVector(Nd->RHS->Ty))
+      printLn("  addi a1, a1, %d", Step);
+  }
+  printLn("  addi a2, a2, %d", Step);
+  printLn("  addi t3, t3, -1");
+  printLn("  bnez t3, .L.vec_op.%s.%d", CurrentFn->Name, C);
+}
+
+// 生成向量运算的代码，a0为结果的地址
+static void genVecOp(Node *Nd) {
+  printLn("\n  # =====向量运算=====");
+  genVecOperands(Nd);
+
+  if (OptRVV && Nd->Ty->Size <= 64) {
+    genVecRVV(Nd);
+  } else if (isSWAROp(Nd)) {
+    uint64_t H = laneHighBits(vecOpType(Nd)->Base->Size);
+    if (Nd->Kind == ND_ADD || Nd->Kind == ND_SUB || Nd->Kind == ND_NEG) {
+      printLn("  li t4, 0x%lx", H);
+      printLn("  not t5, t4");
+    }
+    genVecSegments(Nd, 8, genVecSWAR);
+  } else {
+    Type *Ty = Nd->Kind == ND_SHUFFLE ? Nd->Ty : vecOpType(Nd);
+    genVecSegments(Nd, Ty->Base->Size, genVecScalar);
+  }
+
+  genStackAddr("a0", Nd->VecTmp->Offset);
 }
 
 // 生成语句
@@ -1751,26 +5871,60 @@ static void genStmt(Node *Nd) {
     // 生成条件内语句
     printLn("\n# Cond表达式%d", C);
     genExpr(Nd->Cond);
+
+    // 一侧分支不可到达时，只生成另一侧的语句
+    if (isUnreachable(Nd->Then) || (Nd->Els && isUnreachable(Nd->Els))) {
+      printLn("  # 分支%d的一侧不可到达", C);
+      Node *Live = isUnreachable(Nd->Then) ? Nd->Els : Nd->Then;
+      if (Live)
+        genStmt(Live);
+      return;
+    }
+
     notZero(Nd->Cond->Ty);
+
+    // 根据__builtin_expect的提示，将不太可能执行的分支放到函数末尾
+    // 冷代码中不再拆分，以免嵌套
+    int Hint = OutputFile == ColdFile ? -1 : branchHint(Nd->Cond);
+    if (Hint == 0 || (Hint == 1 && Nd->Els)) {
+      char *Fn = CurrentFn->Name;
+      Node *Hot = Hint ? Nd->Then : Nd->Els;
+      printLn("  # 分支%d中不太可能执行的一侧位于.L.cold.%s.%d段", C, Fn, C);
+      printLn("  %s a0, .L.cold.%s.%d", Hint ? "beqz" : "bnez", Fn, C);
+      if (Hot)
+        genStmt(Hot);
+      printLn(".L.end.%s.%d:", Fn, C);
+
+      FILE *Out = OutputFile;
+      if (!ColdFile)
+        ColdFile = open_memstream(&ColdBuf, &ColdLen);
+      OutputFile = ColdFile;
+      printLn(".L.cold.%s.%d:", Fn, C);
+      genStmt(Hint ? Nd->Els : Nd->Then);
+      printLn("  j .L.end.%s.%d", Fn, C);
+      OutputFile = Out;
+      return;
+    }
     // 判断结果是否为0，为0则跳转到else标签
-    printLn("  # 若a0为0，则跳转到分支%d的.L.else.%d段", C, C);
-    printLn("  beqz a0, .L.else.%d", C);
+    printLn("  # 若a0为0，则跳转到分支%d的.L.else.%s.%d段", C,
+            CurrentFn->Name, C);
+    printLn("  beqz a0, .L.else.%s.%d", CurrentFn->Name, C);
     // 生成符合条件后的语句
     printLn("\n# Then语句%d", C);
     genStmt(Nd->Then);
     // 执行完后跳转到if语句后面的语句
-    printLn("  # 跳转到分支%d的.L.end.%d段", C, C);
-    printLn("  j .L.end.%d", C);
+    printLn("  # 跳转到分支%d的.L.end.%s.%d段", C, CurrentFn->Name, C);
+    printLn("  j .L.end.%s.%d", CurrentFn->Name, C);
     // else代码块，else可能为空，故输出标签
     printLn("\n# Else语句%d", C);
-    printLn("# 分支%d的.L.else.%d段标签", C, C);
-    printLn(".L.else.%d:", C);
+    printLn("# 分支%d的.L.else.%s.%d段标签", C, CurrentFn->Name, C);
+    printLn(".L.else.%s.%d:", CurrentFn->Name, C);
     // 生成不符合条件后的语句
     if (Nd->Els)
       genStmt(Nd->Els);
     // 结束if语句，继续执行后面的语句
-    printLn("\n# 分支%d的.L.end.%d段标签", C, C);
-    printLn(".L.end.%d:", C);
+    printLn("\n# 分支%d的.L.end.%s.%d段标签", C, CurrentFn->Name, C);
+    printLn(".L.end.%s.%d:", CurrentFn->Name, C);
     return;
   }
   // 生成for或while循环语句
@@ -1783,9 +5937,32 @@ static void genStmt(Node *Nd) {
       printLn("\n# Init语句%d", C);
       genStmt(Nd->Init);
     }
+    // 完全展开循环
+    LoopInfo L;
+    bool Opt = loopAnalyze(&L, Nd);
+    if (Opt && L.Unroll) {
+      genUnroll(&L, Nd, C);
+      return;
+    }
+    // 开启V扩展时，先尝试执行循环的向量版本
+    if (OptRVV && OptFVectorize)
+      genVecLoop(Nd, C);
+    // 外提了循环体中的读取时，先判断一次条件，至少执行一次迭代才计算初值
+    if (Opt && L.Guard) {
+      printLn("\n# 循环%d的第一次判断条件", C);
+      genExpr(Nd->Cond);
+      notZero(Nd->Cond->Ty);
+      printLn("  beqz a0, %s", Nd->BrkLabel);
+    }
+    // 循环不变量和数组元素的地址放入寄存器
+    int Vals = NumLoopVals;
+    if (Opt)
+      loopEnter(&L, C);
+    if (Opt && L.Guard)
+      printLn("  j .L.body.%s.%d", CurrentFn->Name, C);
     // 输出循环头部标签
-    printLn("\n# 循环%d的.L.begin.%d段标签", C, C);
-    printLn(".L.begin.%d:", C);
+    printLn("\n# 循环%d的.L.begin.%s.%d段标签", C, CurrentFn->Name, C);
+    printLn(".L.begin.%s.%d:", CurrentFn->Name, C);
     // 处理循环条件语句
     printLn("# Cond表达式%d", C);
     if (Nd->Cond) {
@@ -1798,6 +5975,8 @@ static void genStmt(Node *Nd) {
     }
     // 生成循环体语句
     printLn("\n# Then语句%d", C);
+    if (Opt && L.Guard)
+      printLn(".L.body.%s.%d:", CurrentFn->Name, C);
     genStmt(Nd->Then);
     // continue标签语句
     printLn("%s:", Nd->ContLabel);
@@ -1805,22 +5984,34 @@ static void genStmt(Node *Nd) {
     if (Nd->Inc) {
       printLn("\n# Inc语句%d", C);
       // 生成循环递增语句
-      genExpr(Nd->Inc);
+      if (Opt)
+        loopInc(&L, Nd->Inc);
+      else
+        genExpr(Nd->Inc);
     }
     // 跳转到循环头部
-    printLn("  # 跳转到循环%d的.L.begin.%d段", C, C);
-    printLn("  j .L.begin.%d", C);
+    printLn("  # 跳转到循环%d的.L.begin.%s.%d段", C, CurrentFn->Name,
+            C);
+    printLn("  j .L.begin.%s.%d", CurrentFn->Name, C);
     // 输出循环尾部标签
     printLn("\n# 循环%d的%s段标签", C, Nd->BrkLabel);
     printLn("%s:", Nd->BrkLabel);
+    if (Opt)
+      loopLeave(&L, Vals);
     return;
   }
   // 生成do while语句
   case ND_DO: {
     int C = count();
     printLn("\n# =====do while语句%d============", C);
+    // 循环不变量放入寄存器
+    LoopInfo L;
+    bool Opt = loopAnalyze(&L, Nd);
+    int Vals = NumLoopVals;
+    if (Opt)
+      loopEnter(&L, C);
     printLn("\n# begin语句%d", C);
-    printLn(".L.begin.%d:", C);
+    printLn(".L.begin.%s.%d:", CurrentFn->Name, C);
 
     printLn("\n# Then语句%d", C);
     genStmt(Nd->Then);
@@ -1830,11 +6021,14 @@ static void genStmt(Node *Nd) {
     genExpr(Nd->Cond);
 
     notZero(Nd->Cond->Ty);
-    printLn("  # 跳转到循环%d的.L.begin.%d段", C, C);
-    printLn("  bnez a0, .L.begin.%d", C);
+    printLn("  # 跳转到循环%d的.L.begin.%s.%d段", C, CurrentFn->Name,
+            C);
+    printLn("  bnez a0, .L.begin.%s.%d", CurrentFn->Name, C);
 
     printLn("\n# 循环%d的%s段标签", C, Nd->BrkLabel);
     printLn("%s:", Nd->BrkLabel);
+    if (Opt)
+      loopLeave(&L, Vals);
     return;
   }
   case ND_SWITCH:
@@ -1881,8 +6075,14 @@ static void genStmt(Node *Nd) {
     return;
   // 生成代码块，遍历代码块的语句链表
   case ND_BLOCK:
-    for (Node *N = Nd->Body; N; N = N->Next)
+    for (Node *N = Nd->Body; N; N = N->Next) {
       genStmt(N);
+      // 不可到达之后的语句不会执行，跳过其中不含标签的语句
+      if (isUnreachable(N))
+        while (N->Next && (N->Next->Kind == ND_EXPR_STMT ||
+                           N->Next->Kind == ND_RETURN))
+          N = N->Next;
+    }
     return;
   // goto语句
   case ND_GOTO:
@@ -1891,7 +6091,7 @@ static void genStmt(Node *Nd) {
   case ND_GOTO_EXPR:
     genExpr(Nd->LHS);
     // println("  jmp *%%rax");
-    printLn("  jalr a0");
+    printLn("  jr a0");
     return;
   // 标签语句
   case ND_LABEL:
@@ -1906,8 +6106,9 @@ static void genStmt(Node *Nd) {
       genExpr(Nd->LHS);
 
       Type *Ty = Nd->LHS->Ty;
-      // 处理结构体作为返回值的情况
-      if (Ty->Kind == TY_STRUCT || Ty->Kind == TY_UNION) {
+      // 处理结构体或向量作为返回值的情况
+      if (Ty->Kind == TY_STRUCT || Ty->Kind == TY_UNION ||
+          Ty->Kind == TY_VECTOR) {
         if (Ty->Size <= 16)
           // 小于16字节拷贝寄存器
           copyStructReg();
@@ -1967,7 +6168,10 @@ static void assignLVarOffsets(Obj *Prog) {
       switch (Ty->Kind) {
       case TY_STRUCT:
       case TY_UNION:
+      case TY_VECTOR:
         setFloStMemsTy(&Ty, GP, FP);
+        // 形参的寄存器类型在生成函数代码时使用
+        Var->Ty = Ty;
 
         // 计算浮点结构体所使用的寄存器
         // 这里一定寄存器可用，所以不判定是否超过寄存器最大值
@@ -2088,6 +6292,119 @@ static int simpleLog2(int Num) {
   return E;
 }
 
+// 连续的零或可打印字符达到该长度时，使用.zero或.ascii输出
+#define MIN_RUN 8
+
+// 从Pos开始，连续为零的字节数
+static int zeroRun(char *Buf, int Pos, int End) {
+  int I = Pos;
+  while (I < End && !Buf[I])
+    I++;
+  return I - Pos;
+}
+
+// 判断是否为可以放入.ascii的字符
+static bool isTextChar(char C) {
+  return isprint((unsigned char)C) || C == '\n' || C == '\t';
+}
+
+// 从Pos开始，连续的可打印字符数
+static int textRun(char *Buf, int Pos, int End) {
+  int I = Pos;
+  while (I < End && isTextChar(Buf[I]))
+    I++;
+  return I - Pos;
+}
+
+// 使用.ascii或.string输出字符串，每行最多64个字符
+// Terminated为真时，最后一行使用.string，以补上结尾的'\0'
+static void emitString(char *Buf, int Len, bool Terminated) {
+  for (int I = 0; I < Len || (I == 0 && Terminated);) {
+    char Line[64 * 4 + 1];
+    int N = 0;
+    int J = I;
+    for (; J < Len && J < I + 64; J++) {
+      char C = Buf[J];
+      if (C == '"' || C == '\\')
+        N += sprintf(Line + N, "\\%c", C);
+      else if (C == '\n')
+        N += sprintf(Line + N, "\\n");
+      else if (C == '\t')
+        N += sprintf(Line + N, "\\t");
+      else if (isprint((unsigned char)C))
+        Line[N++] = C;
+      else
+        N += sprintf(Line + N, "\\%03o", (unsigned char)C);
+    }
+    Line[N] = '\0';
+
+    bool Last = J == Len;
+    printLn("  %s \"%s\"", Last && Terminated ? ".string" : ".ascii", Line);
+    if (Last)
+      return;
+    I = J;
+  }
+}
+
+// 使用.byte/.half/.word/.quad输出数值，对齐的位置使用尽量大的宽度
+// 相同宽度的数值每行最多输出8个，遇到较长的零或字符时返回
+static int emitScalars(char *Buf, int Pos, int End) {
+  char Line[8 * 24 + 1];
+  int N = 0, Cnt = 0, LineSz = 0;
+  static char *Dirs[] = {[1] = ".byte", [2] = ".half", [4] = ".word",
+                         [8] = ".quad"};
+
+  while (Pos < End && zeroRun(Buf, Pos, End) < MIN_RUN &&
+         textRun(Buf, Pos, End) < MIN_RUN) {
+    int Sz = 8;
+    while (Sz > 1 && (Pos % Sz || Pos + Sz > End))
+      Sz /= 2;
+
+    // 宽度变化或一行已满时，输出当前行
+    if (Cnt && (Sz != LineSz || Cnt == 8)) {
+      printLn("  %s %s", Dirs[LineSz], Line);
+      N = Cnt = 0;
+    }
+
+    // 小端序
+    uint64_t Val = 0;
+    for (int I = Sz - 1; I >= 0; I--)
+      Val = (Val << 8) | (unsigned char)Buf[Pos + I];
+    N += sprintf(Line + N, "%s%lu", Cnt ? ", " : "", Val);
+    Cnt++;
+    LineSz = Sz;
+    Pos += Sz;
+  }
+
+  if (Cnt)
+    printLn("  %s %s", Dirs[LineSz], Line);
+  return Pos;
+}
+
+// 输出全局变量[Pos, End)范围内的初始值
+static void emitBytes(char *Buf, int Pos, int End) {
+  while (Pos < End) {
+    // 连续的零
+    int Z = zeroRun(Buf, Pos, End);
+    if (Z >= MIN_RUN) {
+      printLn("  .zero %d", Z);
+      Pos += Z;
+      continue;
+    }
+
+    // 连续的可打印字符，以'\0'结尾时使用.string
+    int T = textRun(Buf, Pos, End);
+    if (T >= MIN_RUN) {
+      bool Terminated = Pos + T < End && !Buf[Pos + T];
+      emitString(Buf + Pos, T, Terminated);
+      Pos += T + Terminated;
+      continue;
+    }
+
+    Pos = emitScalars(Buf, Pos, End);
+  }
+}
+
 static void emitData(Obj *Prog) {
   for (Obj *Var = Prog; Var; Var = Var->Next) {
     // 跳过是函数或者无定义的变量
@@ -2100,6 +6417,7 @@ static void emitData(Obj *Prog) {
     } else {
       printLn("\n  # 全局变量%s", Var->Name);
       printLn("  .globl %s", Var->Name);
+      emitVisibility(Var);
     }
 
     printLn("  # 对齐全局变量");
@@ -2123,13 +6441,33 @@ static void emitData(Obj *Prog) {
       printLn("\n  # 数据段标签");
       if (Var->IsTLS)
         printLn("  .section .tdata,\"awT\",@progbits");
+      else if (isMergeableString(Var))
+        printLn("  .section .rodata.str1.1,\"aMS\",@progbits,1");
+      else if (isReadOnly(Var) && Var->Rel && OptFPIC)
+        // 位置无关代码中，需要重定位的数据在重定位后才是只读的
+        printLn("  .section .data.rel.ro,\"aw\"");
+      else if (isReadOnly(Var) && isSmallData(Var))
+        printLn("  .section .srodata,\"a\"");
+      else if (isReadOnly(Var))
+        printLn("  .section .rodata");
+      else if (isSmallData(Var))
+        printLn("  .section .sdata,\"aw\"");
       else
         printLn("  .data");
 
       printLn("  .type %s, @object", Var->Name);
       printLn("  .size %s, %d", Var->Name, Var->Ty->Size);
-      printLn("  .align %d", Align);
+      // 可合并的字符串逐字节排列，不能有额外的对齐
+      printLn("  .balign %d", isMergeableString(Var) ? 1 : Align);
       printLn("%s:", Var->Name);
+
+      // 字符串字面量
+      if (isMergeableString(Var)) {
+        printLn("  # 字符串字面量");
+        emitString(Var->InitData, Var->Ty->Size - 1, true);
+        continue;
+      }
+
       Relocation *Rel = Var->Rel;
       int Pos = 0;
       while (Pos < Var->Ty->Size) {
@@ -2139,15 +6477,13 @@ static void emitData(Obj *Prog) {
           printLn("  .quad %s%+ld", *Rel->Label, Rel->Addend);
           Rel = Rel->Next;
           Pos += 8;
-        } else {
-          // 打印出字符串的内容，包括转义字符
-          printLn("  # 字符串字面量");
-          char C = Var->InitData[Pos++];
-          if (isprint(C))
-            printLn("  .byte %d\t# %c", C, C);
-          else
-            printLn("  .byte %d", C);
+          continue;
         }
+
+        // 输出到下一个重定位之前的数据
+        int End = Rel ? Rel->Offset : Var->Ty->Size;
+        emitBytes(Var->InitData, Pos, End);
+        Pos = End;
       }
       continue;
     }
@@ -2157,10 +6493,12 @@ static void emitData(Obj *Prog) {
     // .bss or .tbss
     if (Var->IsTLS)
       printLn("  .section .tbss,\"awT\",@nobits");
+    else if (isSmallData(Var))
+      printLn("  .section .sbss,\"aw\",@nobits");
     else
       printLn("  .bss");
 
-    printLn("  .align %d", Align);
+    printLn("  .balign %d", Align);
     printLn("%s:", Var->Name);
     printLn("  # 全局变量零填充%d位", Var->Ty->Size);
     printLn("  .zero %d", Var->Ty->Size);
@@ -2170,15 +6508,13 @@ static void emitData(Obj *Prog) {
 // 将浮点寄存器的值存入栈中
 static void storeFloat(int Reg, int Offset, int Sz) {
   printLn("  # 将fa%d寄存器的值存入%d(fp)的栈地址", Reg, Offset);
-  printLn("  li t0, %d", Offset);
-  printLn("  add t0, fp, t0");
 
   switch (Sz) {
   case 4:
-    printLn("  fsw fa%d, 0(t0)", Reg);
+    printLn("  fsw fa%d, %s", Reg, stackSlot(Offset, 4));
     return;
   case 8:
-    printLn("  fsd fa%d, 0(t0)", Reg);
+    printLn("  fsd fa%d, %s", Reg, stackSlot(Offset, 8));
     return;
   default:
     unreachable();
@@ -2188,286 +6524,417 @@ static void storeFloat(int Reg, int Offset, int Sz) {
 // 将整形寄存器的值存入栈中
 static void storeGeneral(int Reg, int Offset, int Size) {
   printLn("  # 将a%d寄存器的值存入%d(fp)的栈地址", Reg, Offset);
-  printLn("  li t0, %d", Offset);
-  printLn("  add t0, fp, t0");
   switch (Size) {
   case 1:
-    printLn("  sb a%d, 0(t0)", Reg);
+    printLn("  sb a%d, %s", Reg, stackSlot(Offset, 1));
     return;
   case 2:
-    printLn("  sh a%d, 0(t0)", Reg);
+    printLn("  sh a%d, %s", Reg, stackSlot(Offset, 2));
     return;
   case 4:
-    printLn("  sw a%d, 0(t0)", Reg);
+    printLn("  sw a%d, %s", Reg, stackSlot(Offset, 4));
     return;
   case 8:
-    printLn("  sd a%d, 0(t0)", Reg);
+    printLn("  sd a%d, %s", Reg, stackSlot(Offset, 8));
     return;
   }
   unreachable();
 }
 
 // 存储结构体到栈内开辟的空间
-static void storeStruct(int Reg, int Offset, int Size) {
-  // t0是结构体的地址，复制t0指向的结构体到栈相应的位置中
-  for (int I = 0; I < Size; I++) {
-    printLn("  lb t0, %d(a%d)", I, Reg);
-
-    printLn("  li t1, %d", Offset + I);
-    printLn("  add t1, fp, t1");
-    printLn("  sb t0, 0(t1)");
-  }
-  return;
+static void storeStruct(int Reg, int Offset, Type *Ty) {
+  // a%d是结构体的地址，复制其指向的结构体到栈相应的位置中
+  genStackAddr("t2", Offset);
+  copyMem("t2", format("a%d", Reg), Ty->Size, Ty->Align);
 }
 
 // 代码生成入口函数，包含代码块的基础信息
-void emitText(Obj *Prog) {
-  // 为每个函数单独生成代码
-  for (Obj *Fn = Prog; Fn; Fn = Fn->Next) {
-    if (!Fn->IsFunction || !Fn->IsDefinition)
-      continue;
-
-    // No code is emitted for "static inline" functions
-    // if no one is referencing them.
-    if (!Fn->IsLive)
-      continue;
-
-    if (Fn->IsStatic) {
-      printLn("\n  # 定义局部%s函数", Fn->Name);
-      printLn("  .local %s", Fn->Name);
-    } else {
-      printLn("\n  # 定义全局%s函数", Fn->Name);
-      printLn("  .globl %s", Fn->Name);
-    }
-
-    printLn("  # 代码段标签");
-    printLn("  .text");
-    printLn("# =====%s段开始===============", Fn->Name);
-    printLn("# %s段标签", Fn->Name);
-    printLn("  .type %s, @function", Fn->Name);
-    printLn("%s:", Fn->Name);
-    CurrentFn = Fn;
-
-    // 栈布局
-    // ------------------------------//
-    //        上一级函数的栈传递参数
-    // ==============================// sp（本级函数）
-    //         VaArea(寄存器可用时)
-    // ------------------------------// sp = sp（本级函数）-VaArea
-    //              ra
-    //-------------------------------// ra = sp-8
-    //              fp
-    //-------------------------------// fp = sp-16
-    //             变量
-    //-------------------------------// sp = sp-16-StackSize
-    //           表达式计算
-    //-------------------------------//
-
-    // Prologue, 前言
-
-    // 为剩余的整型寄存器开辟空间，用于存储可变参数
-    int VaSize = 0;
-    if (Fn->VaArea) {
-      // 遍历正常参数所使用的浮点、整型寄存器
-      int GPs = 0, FPs = 0;
-
-      // 可变参数函数，非可变的参数使用寄存器
-      for (Obj *Var = Fn->Params; Var; Var = Var->Next) {
-        if (isFloNum(Var->Ty) && FPs < FP_MAX)
-          // 可变参数函数中的浮点参数
-          FPs++;
-        else if (GPs < GP_MAX)
-          // 可变参数函数中的整型参数
-          GPs++;
-      }
+// 生成函数的代码
+static void emitFunction(Obj *Fn) {
+  if (Fn->IsStatic) {
+    printLn("\n  # 定义局部%s函数", Fn->Name);
+    printLn("  .local %s", Fn->Name);
+  } else {
+    printLn("\n  # 定义全局%s函数", Fn->Name);
+    printLn("  .globl %s", Fn->Name);
+    emitVisibility(Fn);
+  }
 
-      VaSize = (8 - GPs) * 8;
-      printLn("  # VaArea的区域，大小为%d", VaSize);
-      printLn("  addi sp, sp, -%d", VaSize);
+  printLn("  # 代码段标签");
+  printLn("  .text");
+  printLn("# =====%s段开始===============", Fn->Name);
+  printLn("# %s段标签", Fn->Name);
+  printLn("  .type %s, @function", Fn->Name);
+  printLn("%s:", Fn->Name);
+  CurrentFn = Fn;
+
+  // 向量化和循环优化需要知道哪些局部变量可能被间接地读写
+  markAddrTaken(Fn->Body);
+
+  // 局部变量和循环优化使用的s寄存器，保存在栈的底部
+  // 放入寄存器的变量使用s1起的寄存器，循环优化使用之后的寄存器
+  // 选择变量时按没有寄存器变量统计循环需要的寄存器
+  NumLoopRegs = 0;
+  NumLoopRegs = assignRegVars(Fn);
+  NumSavedRegs = NumLoopRegs;
+  loopRegsNeeded(Fn->Body, &NumSavedRegs);
+  SavedRegsOffset = -Fn->StackSize;
+  if (NumSavedRegs)
+    Fn->StackSize = alignTo(Fn->StackSize + NumSavedRegs * 8, 16);
+
+  // 栈布局
+  // ------------------------------//
+  //        上一级函数的栈传递参数
+  // ==============================// sp（本级函数）
+  //         VaArea(寄存器可用时)
+  // ------------------------------// sp = sp（本级函数）-VaArea
+  //              ra
+  //-------------------------------// ra = sp-8
+  //              fp
+  //-------------------------------// fp = sp-16
+  //             变量
+  //-------------------------------// sp = sp-16-StackSize
+  //           表达式计算
+  //-------------------------------//
+
+  // Prologue, 前言
+
+  // 为剩余的整型寄存器开辟空间，用于存储可变参数
+  int VaSize = 0;
+  if (Fn->VaArea) {
+    // 遍历正常参数所使用的浮点、整型寄存器
+    int GPs = 0, FPs = 0;
+
+    // 可变参数函数，非可变的参数使用寄存器
+    for (Obj *Var = Fn->Params; Var; Var = Var->Next) {
+      if (isFloNum(Var->Ty) && FPs < FP_MAX)
+        // 可变参数函数中的浮点参数
+        FPs++;
+      else if (GPs < GP_MAX)
+        // 可变参数函数中的整型参数
+        GPs++;
     }
 
-    // 将ra寄存器压栈,保存ra的值
-    printLn("  # 将ra寄存器压栈,保存ra的值");
-    printLn("  addi sp, sp, -16");
-    printLn("  sd ra, 8(sp)");
-    // 将fp压入栈中，保存fp的值
-    printLn("  # 将fp压栈，fp属于“被调用者保存”的寄存器，需要恢复原值");
-    printLn("  sd fp, 0(sp)");
-    // 将sp写入fp
-    printLn("  # 将sp的值写入fp");
-    printLn("  mv fp, sp");
-
-    printLn("  # 保存所有的fs0~fs11寄存器");
-    for (int I = 0; I <= 11; ++I)
-      printLn("  fsgnj.d ft%d, fs%d, fs%d", I, I, I);
-
-    // 偏移量为实际变量所用的栈大小
-    printLn("  # sp腾出StackSize大小的栈空间");
-    printLn("  li t0, -%d", Fn->StackSize);
-    printLn("  add sp, sp, t0");
-    // Alloca区域
-    // printLn("  mov %%rsp, %d(%%rbp)", fn->alloca_bottom->offset);
-    printLn("  # Alloca区域");
-    printLn("  li t0, %d", Fn->AllocaBottom->Offset);
-    printLn("  add t0, t0, fp");
-    printLn("  sd sp, 0(t0)");
+    VaSize = (8 - GPs) * 8;
+    printLn("  # VaArea的区域，大小为%d", VaSize);
+    printLn("  addi sp, sp, -%d", VaSize);
+  }
 
-    // 正常传递的形参
-    // 记录整型寄存器，浮点寄存器使用的数量
-    int GP = 0, FP = 0;
-    for (Obj *Var = Fn->Params; Var; Var = Var->Next) {
-      // 不处理栈传递的形参，栈传递一半的结构体除外
-      if (Var->Offset > 0 && !Var->IsHalfByStack)
-        continue;
+  // 将ra寄存器压栈,保存ra的值
+  printLn("  # 将ra寄存器压栈,保存ra的值");
+  printLn("  addi sp, sp, -16");
+  printLn("  sd ra, 8(sp)");
+  // 将fp压入栈中，保存fp的值
+  printLn("  # 将fp压栈，fp属于“被调用者保存”的寄存器，需要恢复原值");
+  printLn("  sd fp, 0(sp)");
+  // 将sp写入fp
+  printLn("  # 将sp的值写入fp");
+  printLn("  mv fp, sp");
+
+  printLn("  # 保存所有的fs0~fs11寄存器");
+  for (int I = 0; I <= 11; ++I)
+    printLn("  fsgnj.d ft%d, fs%d, fs%d", I, I, I);
+
+  // 偏移量为实际变量所用的栈大小
+  printLn("  # sp腾出StackSize大小的栈空间");
+  genAddImm("sp", -Fn->StackSize);
+  // Alloca区域
+  // printLn("  mov %%rsp, %d(%%rbp)", fn->alloca_bottom->offset);
+  printLn("  # Alloca区域");
+  printLn("  sd sp, %s", stackSlot(Fn->AllocaBottom->Offset, 8));
+
+  for (int I = 1; I <= NumSavedRegs; I++) {
+    printLn("  # 保存s%d寄存器", I);
+    printLn("  sd s%d, %s", I, stackSlot(SavedRegsOffset - I * 8, 8));
+  }
 
-      Type *Ty = Var->Ty;
+  // 正常传递的形参
+  // 记录整型寄存器，浮点寄存器使用的数量
+  int GP = 0, FP = 0;
+  for (Obj *Var = Fn->Params; Var; Var = Var->Next) {
+    // 不处理栈传递的形参，栈传递一半的结构体除外
+    if (Var->Offset > 0 && !Var->IsHalfByStack)
+      continue;
 
-      // 正常传递的形参
-      switch (Ty->Kind) {
-      case TY_STRUCT:
-      case TY_UNION:
-        // 对寄存器传递的参数进行压栈
-        if (isFloNum(Ty->FSReg1Ty) || isFloNum(Ty->FSReg2Ty)) {
-          // 浮点寄存器的第一部分
-          if (Ty->FSReg1Ty->Kind == TY_FLOAT)
-            storeFloat(FP++, Var->Offset, 4);
-          if (Ty->FSReg1Ty->Kind == TY_DOUBLE)
-            storeFloat(FP++, Var->Offset, 8);
-          if (isInteger(Ty->FSReg1Ty))
-            storeGeneral(GP++, Var->Offset, MIN(8, Ty->Size));
-
-          // 浮点寄存器的第二部分
-          if (Ty->FSReg2Ty->Kind != TY_VOID) {
-            int Off2 = Ty->FSReg2Ty->Size;
-
-            if (Ty->FSReg2Ty->Kind == TY_FLOAT)
-              storeFloat(FP++, Var->Offset + Off2, Off2);
-            if (Ty->FSReg2Ty->Kind == TY_DOUBLE)
-              storeFloat(FP++, Var->Offset + Off2, Off2);
-            if (isInteger(Ty->FSReg2Ty))
-              storeGeneral(GP++, Var->Offset + Off2, Off2);
-          }
-          break;
-        }
+    Type *Ty = Var->Ty;
 
-        // 大于16字节的结构体参数，通过访问它的地址，
-        // 将原来位置的结构体复制到栈中
-        if (Ty->Size > 16) {
-          storeStruct(GP++, Var->Offset, Ty->Size);
-          break;
-        }
+    // 正常传递的形参
+    switch (Ty->Kind) {
+    case TY_STRUCT:
+    case TY_UNION:
+    case TY_VECTOR:
+      // 对寄存器传递的参数进行压栈
+      if (isFloNum(Ty->FSReg1Ty) || isFloNum(Ty->FSReg2Ty)) {
+        // 浮点寄存器的第一部分
+        if (Ty->FSReg1Ty->Kind == TY_FLOAT)
+          storeFloat(FP++, Var->Offset, 4);
+        if (Ty->FSReg1Ty->Kind == TY_DOUBLE)
+          storeFloat(FP++, Var->Offset, 8);
+        if (isInteger(Ty->FSReg1Ty))
+          storeGeneral(GP++, Var->Offset, MIN(8, Ty->Size));
 
-        // 一半寄存器，一半栈传递的结构体
-        if (Var->IsHalfByStack) {
-          storeGeneral(GP++, Var->Offset, 8);
-          // 拷贝栈传递的一半结构体到当前栈中
-          for (int I = 0; I != Var->Ty->Size - 8; ++I) {
-            printLn("  lb t0, %d(fp)", 16 + I);
+        // 浮点寄存器的第二部分
+        if (Ty->FSReg2Ty->Kind != TY_VOID) {
+          int Off2 = Ty->FSReg2Ty->Size;
 
-            printLn("  li t1, %d", Var->Offset + 8 + I);
-            printLn("  add t1, fp, t1");
-            printLn("  sb t0, 0(t1)");
-          }
-          break;
+          if (Ty->FSReg2Ty->Kind == TY_FLOAT)
+            storeFloat(FP++, Var->Offset + Off2, Off2);
+          if (Ty->FSReg2Ty->Kind == TY_DOUBLE)
+            storeFloat(FP++, Var->Offset + Off2, Off2);
+          if (isInteger(Ty->FSReg2Ty))
+            storeGeneral(GP++, Var->Offset + Off2, Off2);
         }
-
-        // 处理小于16字节的结构体
-        if (Ty->Size <= 16)
-          storeGeneral(GP++, Var->Offset, MIN(8, Ty->Size));
-        if (Ty->Size > 8)
-          storeGeneral(GP++, Var->Offset + 8, Ty->Size - 8);
         break;
-      case TY_FLOAT:
-      case TY_DOUBLE:
-        // 正常传递的浮点形参
-        if (FP < FP_MAX) {
-          printLn("  # 将浮点形参%s的寄存器fa%d的值压栈", Var->Name, FP);
-          storeFloat(FP++, Var->Offset, Var->Ty->Size);
-        } else {
-          printLn("  # 将浮点形参%s的寄存器a%d的值压栈", Var->Name, GP);
-          storeGeneral(GP++, Var->Offset, Var->Ty->Size);
-        }
+      }
+
+      // 大于16字节的结构体参数，通过访问它的地址，
+      // 将原来位置的结构体复制到栈中
+      if (Ty->Size > 16) {
+        storeStruct(GP++, Var->Offset, Ty);
         break;
-      case TY_LDOUBLE:
-        if (Var->IsHalfByStack) {
-          printLn("  # 将LD形参%s的第一部分a%d的值压栈", Var->Name, GP);
-          printLn("  ld t0, 16(fp)");
-          printLn("  sd t0, %d(fp)", Var->Offset + 8);
-          break;
-        }
-        if (GP < GP_MAX - 1) {
-          printLn("  # 将LD形参%s的第一部分a%d的值压栈", Var->Name, GP);
-          storeGeneral(GP++, Var->Offset, 8);
-          printLn("  # 将LD形参%s的第二部分a%d的值压栈", Var->Name, GP);
-          storeGeneral(GP++, Var->Offset + 8, 8);
+      }
+
+      // 一半寄存器，一半栈传递的结构体
+      if (Var->IsHalfByStack) {
+        storeGeneral(GP++, Var->Offset, 8);
+        // 拷贝栈传递的一半结构体到当前栈中
+        for (int I = 0; I != Var->Ty->Size - 8; ++I) {
+          printLn("  lb t0, %d(fp)", 16 + I);
+
+          printLn("  li t1, %d", Var->Offset + 8 + I);
+          printLn("  add t1, fp, t1");
+          printLn("  sb t0, 0(t1)");
         }
         break;
-      default:
-        // 正常传递的整型形参
-        printLn("  # 将整型形参%s的寄存器a%d的值压栈", Var->Name, GP);
+      }
+
+      // 处理小于16字节的结构体
+      if (Ty->Size <= 16)
+        storeGeneral(GP++, Var->Offset, MIN(8, Ty->Size));
+      if (Ty->Size > 8)
+        storeGeneral(GP++, Var->Offset + 8, Ty->Size - 8);
+      break;
+    case TY_FLOAT:
+    case TY_DOUBLE:
+      // 正常传递的浮点形参
+      if (FP < FP_MAX) {
+        printLn("  # 将浮点形参%s的寄存器fa%d的值压栈", Var->Name, FP);
+        storeFloat(FP++, Var->Offset, Var->Ty->Size);
+      } else {
+        printLn("  # 将浮点形参%s的寄存器a%d的值压栈", Var->Name, GP);
         storeGeneral(GP++, Var->Offset, Var->Ty->Size);
+      }
+      break;
+    case TY_LDOUBLE:
+      if (Var->IsHalfByStack) {
+        printLn("  # 将LD形参%s的第一部分a%d的值压栈", Var->Name, GP);
+        printLn("  ld t0, 16(fp)");
+        printLn("  sd t0, %d(fp)", Var->Offset + 8);
         break;
       }
+      if (GP < GP_MAX - 1) {
+        printLn("  # 将LD形参%s的第一部分a%d的值压栈", Var->Name, GP);
+        storeGeneral(GP++, Var->Offset, 8);
+        printLn("  # 将LD形参%s的第二部分a%d的值压栈", Var->Name, GP);
+        storeGeneral(GP++, Var->Offset + 8, 8);
+      }
+      break;
+    default:
+      // 放入寄存器的形参，已符号扩展的值直接存入s寄存器
+      if (isRegParam(Var)) {
+        printLn("  # 将整型形参%s的寄存器a%d的值存入s%d", Var->Name, GP,
+                Var->Reg);
+        printLn("  %s s%d, a%d", Var->Ty->Size == 8 ? "mv" : "sext.w",
+                Var->Reg, GP++);
+        break;
+      }
+      // 正常传递的整型形参
+      printLn("  # 将整型形参%s的寄存器a%d的值压栈", Var->Name, GP);
+      storeGeneral(GP++, Var->Offset, Var->Ty->Size);
+      break;
     }
+  }
 
-    // 可变参数
-    if (Fn->VaArea) {
-      // 可变参数位置位于本函数的最上方，即sp的位置，也就是fp+16
-
-      // 可变参数存入__va_area__，注意最多为7个
-      int Offset = Fn->VaArea->Offset;
-      printLn("  # 可变参数VaArea的偏移量为%d", Fn->VaArea->Offset);
-      while (GP < GP_MAX) {
-        printLn("  # 可变参数，相对%s的偏移量为%d", Fn->VaArea->Name,
-                Offset - Fn->VaArea->Offset);
-        storeGeneral(GP++, Offset, 8);
-        Offset += 8;
-      }
+  // 放入寄存器的其他形参，从栈中读取到s寄存器中，按类型进行扩展
+  for (Obj *Var = Fn->Params; Var; Var = Var->Next) {
+    if (!Var->Reg || isRegParam(Var))
+      continue;
+    printLn("  # 将形参%s读取到s%d中", Var->Name, Var->Reg);
+    loadVarSlot(format("s%d", Var->Reg), Var);
+  }
+
+  // 可变参数
+  if (Fn->VaArea) {
+    // 可变参数位置位于本函数的最上方，即sp的位置，也就是fp+16
+
+    // 可变参数存入__va_area__，注意最多为7个
+    int Offset = Fn->VaArea->Offset;
+    printLn("  # 可变参数VaArea的偏移量为%d", Fn->VaArea->Offset);
+    while (GP < GP_MAX) {
+      printLn("  # 可变参数，相对%s的偏移量为%d", Fn->VaArea->Name,
+              Offset - Fn->VaArea->Offset);
+      storeGeneral(GP++, Offset, 8);
+      Offset += 8;
     }
+  }
 
-    // 生成语句链表的代码
-    printLn("# =====%s段主体===============", Fn->Name);
-    genStmt(Fn->Body);
-    assert(Depth == 0);
-
-    // [https://www.sigbus.info/n1570#5.1.2.2.3p1] The C spec defines
-    // a special rule for the main function. Reaching the end of the
-    // main function is equivalent to returning 0, even though the
-    // behavior is undefined for the other functions.
-    if (strcmp(Fn->Name, "main") == 0)
-        printLn("  li a0, 0");
-
-    // Epilogue，后语
-    // 输出return段标签
-    printLn("# =====%s段结束===============", Fn->Name);
-    printLn("# return段标签");
-    printLn(".L.return.%s:", Fn->Name);
-
-    printLn("  # 恢复所有的fs0~fs11寄存器");
-    for (int I = 0; I <= 11; ++I)
-        printLn("  fsgnj.d fs%d, ft%d, ft%d", I, I, I);
-
-    // 将fp的值改写回sp
-    printLn("  # 将fp的值写回sp");
-    printLn("  mv sp, fp");
-    // 将最早fp保存的值弹栈，恢复fp。
-    printLn("  # 将最早fp保存的值弹栈，恢复fp和sp");
-    printLn("  ld fp, 0(sp)");
-    // 将ra寄存器弹栈,恢复ra的值
-    printLn("  # 将ra寄存器弹栈,恢复ra的值");
-    printLn("  ld ra, 8(sp)");
-    printLn("  addi sp, sp, 16");
-
-    // 归还可变参数寄存器压栈的那一部分
-    if (Fn->VaArea) {
-      printLn("  # 归还VaArea的区域，大小为%d", VaSize);
-      printLn("  addi sp, sp, %d", VaSize);
+  // 函数内多次访问的线程局部变量，地址在第一次访问时获取，入口处先清空缓存
+  for (Obj *Var = Fn->Locals; Var; Var = Var->Next) {
+    if (!Var->TLSVar || tlsModel(Var->TLSVar) != TLS_LOCAL_DYNAMIC)
+      continue;
+    printLn("  # 清空线程局部变量%s的地址缓存", Var->TLSVar->Name);
+    printLn("  sd zero, %s", stackSlot(Var->Offset, 8));
+  }
+
+  // 生成语句链表的代码
+  printLn("# =====%s段主体===============", Fn->Name);
+  genStmt(Fn->Body);
+  assert(Depth == 0);
+
+  // [https://www.sigbus.info/n1570#5.1.2.2.3p1] The C spec defines
+  // a special rule for the main function. Reaching the end of the
+  // main function is equivalent to returning 0, even though the
+  // behavior is undefined for the other functions.
+  if (strcmp(Fn->Name, "main") == 0)
+      printLn("  li a0, 0");
+
+  // Epilogue，后语
+  // 输出return段标签
+  printLn("# =====%s段结束===============", Fn->Name);
+  printLn("# return段标签");
+  printLn(".L.return.%s:", Fn->Name);
+
+  // 返回时的栈深度可能不为0，相对fp恢复s寄存器
+  for (int I = 1; I <= NumSavedRegs; I++) {
+    int Off = SavedRegsOffset - I * 8;
+    printLn("  # 恢复s%d寄存器", I);
+    if (isImm12(Off)) {
+      printLn("  ld s%d, %d(fp)", I, Off);
+    } else {
+      printLn("  li t0, %d", Off);
+      printLn("  add t0, fp, t0");
+      printLn("  ld s%d, 0(t0)", I);
+    }
+  }
+
+  printLn("  # 恢复所有的fs0~fs11寄存器");
+  for (int I = 0; I <= 11; ++I)
+      printLn("  fsgnj.d fs%d, ft%d, ft%d", I, I, I);
+
+  // 将fp的值改写回sp
+  printLn("  # 将fp的值写回sp");
+  printLn("  mv sp, fp");
+  // 将最早fp保存的值弹栈，恢复fp。
+  printLn("  # 将最早fp保存的值弹栈，恢复fp和sp");
+  printLn("  ld fp, 0(sp)");
+  // 将ra寄存器弹栈,恢复ra的值
+  printLn("  # 将ra寄存器弹栈,恢复ra的值");
+  printLn("  ld ra, 8(sp)");
+  printLn("  addi sp, sp, 16");
+
+  // 归还可变参数寄存器压栈的那一部分
+  if (Fn->VaArea) {
+    printLn("  # 归还VaArea的区域，大小为%d", VaSize);
+    printLn("  addi sp, sp, %d", VaSize);
+  }
+
+  // 返回
+  printLn("  # 返回a0值给系统调用");
+  printLn("  ret");
+
+  // 不太可能执行的代码
+  if (ColdFile) {
+    fclose(ColdFile);
+    ColdFile = NULL;
+    printLn("# =====%s段冷代码===============", Fn->Name);
+    fwrite(ColdBuf, 1, ColdLen, OutputFile);
+    free(ColdBuf);
+  }
+}
+
+// 代码生成的任务队列
+typedef struct {
+  Obj **Fns;    // 需要生成代码的函数
+  char **Bufs;  // 各函数生成的代码
+  size_t *Lens; // 各函数代码的长度
+  int Len;      // 函数的数量
+  int Next;     // 下一个待生成的函数
+  pthread_mutex_t Lock;
+} FnQueue;
+
+// 工作线程，从队列中依次取出函数，将代码生成到各自的缓冲区中
+static void *codegenWorker(void *Arg) {
+  FnQueue *Q = Arg;
+  while (true) {
+    pthread_mutex_lock(&Q->Lock);
+    int I = Q->Next++;
+    pthread_mutex_unlock(&Q->Lock);
+    if (I >= Q->Len)
+      return NULL;
+
+    OutputFile = open_memstream(&Q->Bufs[I], &Q->Lens[I]);
+    LabelCnt = 0;
+    emitFunction(Q->Fns[I]);
+    fclose(OutputFile);
+    if (OptOLevel > 0)
+      peephole(&Q->Bufs[I], &Q->Lens[I]);
+  }
+}
+
+void emitText(Obj *Prog) {
+  FnQueue Q = {};
+  int Cap = 0;
+  for (Obj *Fn = Prog; Fn; Fn = Fn->Next) {
+    if (!Fn->IsFunction || !Fn->IsDefinition)
+      continue;
+
+    // No code is emitted for "static inline" functions
+    // if no one is referencing them.
+    if (!Fn->IsLive)
+      continue;
+
+    if (Q.Len == Cap) {
+      Cap = Cap ? Cap * 2 : 16;
+      Q.Fns = realloc(Q.Fns, sizeof(Obj *) * Cap);
     }
+    Q.Fns[Q.Len++] = Fn;
+  }
+  if (Q.Len == 0)
+    return;
+
+  Q.Bufs = calloc(Q.Len, sizeof(char *));
+  Q.Lens = calloc(Q.Len, sizeof(size_t));
+  pthread_mutex_init(&Q.Lock, NULL);
+
+  // 各函数相互独立，在多个线程中并行生成代码
+  int Threads = OptCodegenThreads;
+  if (Threads <= 0)
+    Threads = sysconf(_SC_NPROCESSORS_ONLN);
+  Threads = MAX(1, MIN(Threads, Q.Len));
+
+  // 当前线程也作为一个工作线程
+  FILE *Out = OutputFile;
+  pthread_t *Tids = calloc(Threads, sizeof(pthread_t));
+  int Created = 1;
+  for (; Created < Threads; Created++)
+    if (pthread_create(&Tids[Created], NULL, codegenWorker, &Q))
+      break;
+  codegenWorker(&Q);
+  for (int I = 1; I < Created; I++)
+    pthread_join(Tids[I], NULL);
+  OutputFile = Out;
 
-    // 返回
-    printLn("  # 返回a0值给系统调用");
-    printLn("  ret");
+  // 按源代码中的顺序输出各函数的代码
+  for (int I = 0; I < Q.Len; I++) {
+    fwrite(Q.Bufs[I], 1, Q.Lens[I], OutputFile);
+    free(Q.Bufs[I]);
   }
+
+  pthread_mutex_destroy(&Q.Lock);
+  free(Tids);
+  free(Q.Bufs);
+  free(Q.Lens);
+  free(Q.Fns);
 }
 
 void codegen(Obj *Prog, FILE *Out) {
@@ -2479,6 +6946,14 @@ void codegen(Obj *Prog, FILE *Out) {
   for (int I = 0; Files[I]; I++)
     printLn("  .file %d \"%s\"", Files[I]->FileNo, Files[I]->Name);
 
+  // 是否允许汇编器将指令压缩为RVC指令
+  printLn("  .option %s", OptMRVC ? "rvc" : "norvc");
+
+  // 记录本文件中的定义
+  for (Obj *Var = Prog; Var; Var = Var->Next)
+    if (Var->IsDefinition)
+      hashmap_put(&Definitions, Var->Name, Var);
+
   // 计算局部变量的偏移量
   assignLVarOffsets(Prog);
   // 生成数据
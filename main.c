@@ -18,6 +18,32 @@ typedef enum {
 StringArray IncludePaths;
 bool OptFCommon = true;
 bool OptFPIC;
+// 将memcpy等库函数视为内建函数，常量大小时内联展开
+bool OptFBuiltin = true;
+// 开启V扩展时，自动向量化循环
+bool OptFVectorize = true;
+// -O1及以上时，将循环不变量移到循环外，对归纳变量进行强度削减
+bool OptFMoveLoopInvariants = true;
+bool OptFIVOpts = true;
+// -O1及以上时，完全展开迭代次数为较小常量的循环
+bool OptFUnrollLoops;
+// 别名分析时使用基于类型的规则，不同类型的左值不会指向同一对象
+bool OptFStrictAliasing = true;
+// -fvisibility=指定的定义的默认可见性，为NULL时是default
+char *OptFVisibility;
+// -ftls-model=指定的线程局部变量的访问模型
+TLSModel OptFTLSModel = TLS_GLOBAL_DYNAMIC;
+// 小于等于该大小的全局变量放入小数据段，通过gp访问
+int OptMSmallDataLimit = 8;
+// 生成便于汇编器压缩为RVC指令的代码
+bool OptMRVC = true;
+// -march=指定的目标架构，及其中的位操作、预取和向量扩展
+char *OptMArch;
+bool OptZba;
+bool OptZbb;
+bool OptZbs;
+bool OptZicbop;
+bool OptRVV;
 
 // -x选项
 static FileType OptX;
@@ -50,6 +76,10 @@ static char *OptMF;
 static char *OptMT;
 // 目标文件的路径
 static char *OptO;
+// -fcache-stats选项
+static bool OptFCacheStats;
+// cc1写入缓存键的文件
+static char *CacheKeyFile;
 
 static StringArray LdExtraArgs;
 static StringArray StdIncludePaths;
@@ -67,6 +97,7 @@ static StringArray TmpFiles;
 // 输出程序的使用说明
 static void usage(int Status) {
   fprintf(stderr, "rvcc [ -o <path> ] <file>\n");
+  fprintf(stderr, "rvcc --server[=<socket>]\n");
   exit(Status);
 }
 
@@ -107,6 +138,59 @@ static void define(char *Str) {
     defineMacro(Str, "1");
 }
 
+// 解析-march=，如rv64gc_zba_zbb_zbs
+static void parseMArch(char *Arch) {
+  if (strncmp(Arch, "rv64", 4))
+    error("unsupported -march=%s", Arch);
+  OptMArch = Arch;
+  OptMRVC = OptZba = OptZbb = OptZbs = OptZicbop = OptRVV = false;
+
+  for (char *P = Arch + 4; *P;) {
+    if (*P == '_') {
+      P++;
+      continue;
+    }
+
+    // 单字母的扩展，b扩展包含zba、zbb、zbs
+    if (!strchr("zsx", *P)) {
+      if (*P == 'c')
+        OptMRVC = true;
+      if (*P == 'b')
+        OptZba = OptZbb = OptZbs = true;
+      if (*P == 'v')
+        OptRVV = true;
+      P++;
+      continue;
+    }
+
+    // 多字母的扩展，以_分隔
+    int Len = strcspn(P, "_");
+    char *Ext = strndup(P, Len);
+    if (!strcmp(Ext, "zba"))
+      OptZba = true;
+    else if (!strcmp(Ext, "zbb"))
+      OptZbb = true;
+    else if (!strcmp(Ext, "zbs"))
+      OptZbs = true;
+    else if (!strcmp(Ext, "zicbop"))
+      OptZicbop = true;
+    P += Len;
+  }
+
+  if (OptZba)
+    defineMacro("__riscv_zba", "1");
+  if (OptZbb)
+    defineMacro("__riscv_zbb", "1");
+  if (OptZbs)
+    defineMacro("__riscv_zbs", "1");
+  if (OptZicbop)
+    defineMacro("__riscv_zicbop", "1");
+  if (OptRVV) {
+    defineMacro("__riscv_v", "1000000");
+    defineMacro("__riscv_vector", "1");
+  }
+}
+
 static FileType parseOptX(char *S) {
   if (!strcmp(S, "c"))
     return FILE_C;
@@ -117,6 +201,19 @@ static FileType parseOptX(char *S) {
   error("<command line>: unknown argument for -x: %s", S);
 }
 
+// 解析线程局部变量的访问模型，名称无效时返回false
+bool parseTLSModel(char *Name, TLSModel *Model) {
+  static char *Names[] = {"global-dynamic", "local-dynamic", "initial-exec",
+                          "local-exec"};
+  for (int I = 0; I < sizeof(Names) / sizeof(*Names); I++) {
+    if (!strcmp(Name, Names[I])) {
+      *Model = I;
+      return true;
+    }
+  }
+  return false;
+}
+
 static char *quote_makefile(char *s) {
   char *buf = calloc(1, strlen(s) * 2 + 1);
 
@@ -205,6 +302,78 @@ static void parseArgs(int Argc, char **Argv) {
       continue;
     }
 
+    if (!strcmp(Argv[I], "-fbuiltin")) {
+      OptFBuiltin = true;
+      continue;
+    }
+
+    // 独立环境中没有标准库，库函数不能视为内建函数
+    if (!strcmp(Argv[I], "-fno-builtin") ||
+        !strcmp(Argv[I], "-ffreestanding")) {
+      OptFBuiltin = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-ftree-vectorize")) {
+      OptFVectorize = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-tree-vectorize")) {
+      OptFVectorize = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fmove-loop-invariants")) {
+      OptFMoveLoopInvariants = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-move-loop-invariants")) {
+      OptFMoveLoopInvariants = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fivopts")) {
+      OptFIVOpts = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-ivopts")) {
+      OptFIVOpts = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-funroll-loops")) {
+      OptFUnrollLoops = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-unroll-loops")) {
+      OptFUnrollLoops = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fschedule-insns2")) {
+      OptFScheduleInsns2 = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-schedule-insns2")) {
+      OptFScheduleInsns2 = false;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fstrict-aliasing")) {
+      OptFStrictAliasing = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-fno-strict-aliasing")) {
+      OptFStrictAliasing = false;
+      continue;
+    }
+
     // 解析-c
     if (!strcmp(Argv[I], "-c")) {
       OptC = true;
@@ -321,6 +490,92 @@ static void parseArgs(int Argc, char **Argv) {
       continue;
     }
 
+    // 解析-fcache-dir=
+    if (!strncmp(Argv[I], "-fcache-dir=", 12)) {
+      OptFCacheDir = Argv[I] + 12;
+      continue;
+    }
+
+    // 解析-fcache-max-size=，可以使用K、M、G后缀
+    if (!strncmp(Argv[I], "-fcache-max-size=", 17)) {
+      char *End;
+      OptFCacheMaxSize = strtol(Argv[I] + 17, &End, 10);
+      if (*End == 'K' || *End == 'k')
+        OptFCacheMaxSize <<= 10;
+      else if (*End == 'M' || *End == 'm')
+        OptFCacheMaxSize <<= 20;
+      else if (*End == 'G' || *End == 'g')
+        OptFCacheMaxSize <<= 30;
+      continue;
+    }
+
+    // 解析-fcache-stats
+    if (!strcmp(Argv[I], "-fcache-stats")) {
+      OptFCacheStats = true;
+      continue;
+    }
+
+    // 解析-fcodegen-threads=
+    if (!strncmp(Argv[I], "-fcodegen-threads=", 18)) {
+      OptCodegenThreads = atoi(Argv[I] + 18);
+      continue;
+    }
+
+    // 解析-fvisibility=
+    if (!strncmp(Argv[I], "-fvisibility=", 13)) {
+      char *Vis = Argv[I] + 13;
+      if (strcmp(Vis, "default") && strcmp(Vis, "hidden") &&
+          strcmp(Vis, "protected") && strcmp(Vis, "internal"))
+        error("invalid visibility: %s", Vis);
+      OptFVisibility = Vis;
+      continue;
+    }
+
+    // 解析-ftls-model=
+    if (!strncmp(Argv[I], "-ftls-model=", 12)) {
+      if (!parseTLSModel(Argv[I] + 12, &OptFTLSModel))
+        error("invalid tls model: %s", Argv[I] + 12);
+      continue;
+    }
+
+    // 解析-O，-O、-Os、-Og都视为-O1
+    if (!strncmp(Argv[I], "-O", 2)) {
+      char *Level = Argv[I] + 2;
+      OptOLevel = isdigit(*Level) ? atoi(Level) : 1;
+      continue;
+    }
+
+    // 解析-msmall-data-limit=
+    if (!strncmp(Argv[I], "-msmall-data-limit=", 19)) {
+      OptMSmallDataLimit = atoi(Argv[I] + 19);
+      continue;
+    }
+
+    // 解析-march=
+    if (!strncmp(Argv[I], "-march=", 7)) {
+      parseMArch(Argv[I] + 7);
+      continue;
+    }
+
+    // 解析-mtune=
+    if (!strncmp(Argv[I], "-mtune=", 7)) {
+      if (!isTuneModel(Argv[I] + 7))
+        error("unsupported -mtune=%s", Argv[I] + 7);
+      OptMTune = Argv[I] + 7;
+      continue;
+    }
+
+    // 解析-mrvc和-mno-rvc
+    if (!strcmp(Argv[I], "-mrvc")) {
+      OptMRVC = true;
+      continue;
+    }
+
+    if (!strcmp(Argv[I], "-mno-rvc")) {
+      OptMRVC = false;
+      continue;
+    }
+
     if (!strcmp(Argv[I], "-fpic") || !strcmp(Argv[I], "-fPIC")) {
       OptFPIC = true;
       continue;
@@ -338,6 +593,12 @@ static void parseArgs(int Argc, char **Argv) {
       continue;
     }
 
+    // 解析-cc1-cache-key
+    if (!strcmp(Argv[I], "-cc1-cache-key")) {
+      CacheKeyFile = Argv[++I];
+      continue;
+    }
+
     if (!strcmp(Argv[I], "-idirafter")) {
       strArrayPush(&Idirafter, Argv[I++]);
       continue;
@@ -373,13 +634,10 @@ static void parseArgs(int Argc, char **Argv) {
     }
 
     // 忽略多个选项
-    if (!strncmp(Argv[I], "-O", 2) || !strncmp(Argv[I], "-W", 2) ||
+    if (!strncmp(Argv[I], "-W", 2) ||
         !strncmp(Argv[I], "-g", 2) || !strncmp(Argv[I], "-std=", 5) ||
-        !strcmp(Argv[I], "-ffreestanding") ||
-        !strcmp(Argv[I], "-fno-builtin") ||
         !strcmp(Argv[I], "-fno-omit-frame-pointer") ||
-        !strcmp(Argv[I], "-fno-stack-protector") ||
-        !strcmp(Argv[I], "-fno-strict-aliasing") || !strcmp(Argv[I], "-m64") ||
+        !strcmp(Argv[I], "-fno-stack-protector") || !strcmp(Argv[I], "-m64") ||
         !strcmp(Argv[I], "-mno-red-zone") || !strcmp(Argv[I], "-w"))
       continue;
 
@@ -394,6 +652,14 @@ static void parseArgs(int Argc, char **Argv) {
   for (int I = 0; I < Idirafter.Len; I++)
     strArrayPush(&IncludePaths, Idirafter.Data[I]);
 
+  // 输出缓存的统计数据
+  if (OptFCacheStats) {
+    if (!OptFCacheDir)
+      error("-fcache-stats requires -fcache-dir=");
+    cachePrintStats();
+    exit(0);
+  }
+
   // 不存在输入文件时报错
   if (InputPaths.Len == 0)
     error("no input files");
@@ -493,6 +759,8 @@ static void runSubprocess(char **Argv) {
     exit(1);
 }
 
+static void cc1(int Argc, char **Argv);
+
 // 执行调用cc1程序
 // 因为rvcc自身就是cc1程序
 // 所以调用自身，并传入-cc1参数作为子进程
@@ -516,6 +784,38 @@ static void runCC1(int Argc, char **Argv, char *Input, char *Output) {
     Args[Argc++] = Output;
   }
 
+  // 存入写入缓存键的文件
+  if (CacheKeyFile) {
+    Args[Argc++] = "-cc1-cache-key";
+    Args[Argc++] = CacheKeyFile;
+  }
+
+  // 在编译服务器中，直接fork出cc1，以继承服务器中预热过的缓存
+  if (ServerReportFD >= 0) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t Pid = fork();
+    if (Pid == -1)
+      error("fork failed: %s", strerror(errno));
+    if (Pid == 0) {
+      OptCC1 = true;
+      BaseFile = Input;
+      OutputFile = Output;
+      addDefaultIncludePaths(Argv[0]);
+      cc1(Argc, Args);
+      // 临时文件属于驱动，不执行cleanup
+      fflush(NULL);
+      _exit(0);
+    }
+
+    int Status;
+    while (waitpid(Pid, &Status, 0) > 0)
+      ;
+    if (!WIFEXITED(Status) || WEXITSTATUS(Status))
+      exit(1);
+    return;
+  }
+
   // 运行自身作为子进程，同时传入选项
   runSubprocess(Args);
 }
@@ -611,7 +911,7 @@ static Token *appendTokens(Token *Tok1, Token *Tok2) {
 }
 
 // 编译C文件到汇编文件
-static void cc1(void) {
+static void cc1(int Argc, char **Argv) {
   Token *Tok = NULL;
 
   // Process -include option
@@ -638,6 +938,10 @@ static void cc1(void) {
   // 预处理
   Tok = preprocess(Tok);
 
+  // 告知编译服务器用到的头文件，供后续请求使用
+  if (ServerReportFD >= 0)
+    serverReport();
+
   // If -M is given, print file dependencies.
   if (OptM || OptMD) {
     print_dependencies();
@@ -651,6 +955,27 @@ static void cc1(void) {
     return;
   }
 
+  // 查找编译缓存，命中时跳过解析和代码生成
+  char *Key = NULL;
+  if (OptFCacheDir) {
+    Key = cacheKey(Tok, Argc, Argv);
+
+    // -S直接输出缓存的汇编文件
+    if (OptS && OutputFile && strcmp(OutputFile, "-") &&
+        cacheFetch(Key, ".s", OutputFile))
+      return;
+
+    // 可重定位文件由驱动去缓存中获取，这里告知缓存键和是否命中
+    if (!OptS && CacheKeyFile) {
+      bool Hit = cacheHas(Key, ".o");
+      FILE *Out = openFile(CacheKeyFile);
+      fprintf(Out, "%s %d\n", Key, Hit);
+      fclose(Out);
+      if (Hit)
+        return;
+    }
+  }
+
   // 解析终结符流
   Obj *Prog = parse(Tok);
 
@@ -670,6 +995,10 @@ static void cc1(void) {
   FILE *Out = openFile(OutputFile);
   fwrite(Buf, BufLen, 1, Out);
   fclose(Out);
+
+  // 将汇编文件存入缓存
+  if (Key && OptS && OutputFile && strcmp(OutputFile, "-"))
+    cacheStore(Key, ".s", OutputFile);
 }
 
 // 调用汇编器
@@ -677,10 +1006,52 @@ static void assemble(char *Input, char *Output) {
   // 选择对应环境内的汇编器
   char *As = strlen(RVPath) ? "riscv64-unknown-linux-gnu-as" : "as";
   // "-fPIC"：创建与地址无关的程序
-  char *Cmd[] = {As, "-fPIC", "-c", Input, "-o", Output, NULL};
+  // 未指定-march时，MArch为NULL，即使用汇编器默认的架构
+  char *MArch = OptMArch ? format("-march=%s", OptMArch) : NULL;
+  char *Cmd[] = {As, "-fPIC", "-c", Input, "-o", Output, MArch, NULL};
   runSubprocess(Cmd);
 }
 
+// 编译C文件为可重定位文件，开启编译缓存时优先从缓存中获取
+static void compileToObj(int Argc, char **Argv, char *Input, char *Output) {
+  // 临时文件Tmp作为cc1输出的汇编文件
+  char *Tmp = createTmpFile();
+
+  if (!OptFCacheDir) {
+    // cc1，编译C文件为汇编文件
+    runCC1(Argc, Argv, Input, Tmp);
+    // as，编译汇编文件为可重定位文件
+    assemble(Tmp, Output);
+    return;
+  }
+
+  // cc1会将缓存键和是否命中写入CacheKeyFile
+  CacheKeyFile = createTmpFile();
+  runCC1(Argc, Argv, Input, Tmp);
+
+  char Key[64] = "";
+  int Hit = 0;
+  FILE *In = fopen(CacheKeyFile, "r");
+  if (In) {
+    if (fscanf(In, "%63s %d", Key, &Hit) != 2)
+      Key[0] = '\0';
+    fclose(In);
+  }
+  CacheKeyFile = NULL;
+
+  // 命中则直接复制缓存的可重定位文件
+  if (Hit && cacheFetch(Key, ".o", Output))
+    return;
+
+  // 缓存文件在此期间被淘汰了，重新编译
+  if (Hit)
+    runCC1(Argc, Argv, Input, Tmp);
+
+  assemble(Tmp, Output);
+  if (Key[0])
+    cacheStore(Key, ".o", Output);
+}
+
 // 查找文件
 static char *findFile(char *Pattern) {
   char *Path = NULL;
@@ -860,12 +1231,8 @@ static FileType getFileType(char *Filename) {
 //   ↓
 // ld链接为可执行文件
 
-// rvcc的程序入口函数
-int main(int Argc, char **Argv) {
-  // 在程序退出时，执行cleanup函数
-  atexit(cleanup);
-  // 初始化预定义的宏
-  initMacros();
+// 编译器驱动，在编译服务器中每个请求调用一次
+int driver(int Argc, char **Argv) {
   // 解析传入程序的参数
   parseArgs(Argc, Argv);
 
@@ -874,7 +1241,7 @@ int main(int Argc, char **Argv) {
   if (OptCC1) {
     // 增加默认引入路径
     addDefaultIncludePaths(Argv[0]);
-    cc1();
+    cc1(Argc, Argv);
     return 0;
   }
 
@@ -953,26 +1320,16 @@ int main(int Argc, char **Argv) {
 
     // 编译并汇编
     if (OptC) {
-      // 临时文件Tmp作为cc1输出的汇编文件
-      char *Tmp = createTmpFile();
-      // cc1，编译C文件为汇编文件
-      runCC1(Argc, Argv, Input, Tmp);
-      // as，编译汇编文件为可重定位文件
-      assemble(Tmp, Output);
+      compileToObj(Argc, Argv, Input, Output);
       continue;
     }
 
     // 否则运行cc1和as
-    // 临时文件Tmp1作为cc1输出的汇编文件
-    // 临时文件Tmp2作为as输出的可重定位文件
-    char *Tmp1 = createTmpFile();
-    char *Tmp2 = createTmpFile();
-    // cc1，编译C文件为汇编文件
-    runCC1(Argc, Argv, Input, Tmp1);
-    // as，编译汇编文件为可重定位文件
-    assemble(Tmp1, Tmp2);
-    // 将Tmp2存入链接器选项
-    strArrayPush(&LdArgs, Tmp2);
+    // 临时文件Tmp作为as输出的可重定位文件
+    char *Tmp = createTmpFile();
+    compileToObj(Argc, Argv, Input, Tmp);
+    // 将Tmp存入链接器选项
+    strArrayPush(&LdArgs, Tmp);
     continue;
   }
 
@@ -983,3 +1340,37 @@ int main(int Argc, char **Argv) {
 
   return 0;
 }
+
+// 判断是否为驱动的调用，这些调用可以转发给编译服务器
+static bool isClientCall(int Argc, char **Argv) {
+  for (int I = 1; I < Argc; I++)
+    if (!strcmp(Argv[I], "-cc1") || !strncmp(Argv[I], "--server", 8))
+      return false;
+  return true;
+}
+
+// rvcc的程序入口函数
+int main(int Argc, char **Argv) {
+  // 在程序退出时，执行cleanup函数
+  atexit(cleanup);
+
+  // 设置了RVCC_SERVER时，优先交由编译服务器编译
+  if (getenv("RVCC_SERVER") && isClientCall(Argc, Argv)) {
+    int Status = runClient(Argc, Argv);
+    if (Status >= 0)
+      return Status;
+  }
+
+  // 初始化预定义的宏
+  initMacros();
+
+  // 作为编译服务器运行
+  if (Argc > 1 && !strncmp(Argv[1], "--server", 8)) {
+    if (Argv[1][8] == '=')
+      runServer(Argv[1] + 9);
+    if (Argv[1][8] == '\0')
+      runServer(NULL);
+  }
+
+  return driver(Argc, Argv);
+}
@@ -8,24 +8,30 @@ typedef struct {
   int EnumVal;   // 枚举的值
 } VarScope;
 
-// 表示一个块域
-typedef struct Scope Scope;
-struct Scope {
-  Scope *Next; // 指向上一级的域
-
-  // C有两个域：变量（或类型别名）域，结构体（或联合体，枚举）标签域
-  HashMap Vars;    // 指向当前域内的变量
-  HashMap Tags;     // 指向当前域内的结构体标签
+// 符号表中的符号
+// 每个名称对应一个栈，栈顶为最内层的声明，遮蔽了外层同名的声明
+typedef struct Symbol Symbol;
+struct Symbol {
+  Symbol *Shadow; // 被遮蔽的外层同名符号
+  Symbol *Prev;   // 之前声明的符号，离开域时按此顺序弹出
+  HashMap *Table; // 所在的符号表
+  char *Name;     // 名称
+  int NameLen;    // 名称长度
+  int Depth;      // 所在域的深度，0为文件域
+  void *Val;      // 变量域（VarScope）或标签的类型（Type）
 };
 
 // 变量属性
 typedef struct {
-  bool IsTypedef; // 是否为类型别名
-  bool IsStatic;  // 是否为文件域内
-  bool IsExtern;  // 是否为外部变量
-  bool IsInline;  // 是否为内联
-  bool IsTLS;     // thread local storage
-  int Align;      // 对齐量
+  bool IsTypedef;   // 是否为类型别名
+  bool IsStatic;    // 是否为文件域内
+  bool IsExtern;    // 是否为外部变量
+  bool IsInline;    // 是否为内联
+  bool IsTLS;       // thread local storage
+  int Align;        // 对齐量
+  char *Visibility; // 符号的可见性
+  TLSModel TLSModel; // 线程局部变量的访问模型
+  int VectorSize;    // vector_size属性指定的向量大小
 } VarAttr;
 
 // 可变的初始化器。此处为树状结构。
@@ -62,12 +68,33 @@ struct InitDesig {
 Obj *Locals;  // 局部变量
 Obj *Globals; // 全局变量
 
-// 所有的域的链表
-static Scope *Scp = &(Scope){};
+// C有两个域：变量（或类型别名）域，结构体（或联合体，枚举）标签域
+// 各自使用一个全局的符号表，名称映射到该名称的符号栈
+// 查找时无需逐层遍历块域，进出块域也无需分配内存
+static HashMap VarTable;
+static HashMap TagTable;
+// 当前域的深度
+static int ScopeDepth;
+// 最近声明的符号
+static Symbol *LastSym;
 
 // 指向当前正在解析的函数
 static Obj *CurrentFn;
 
+// 当前函数内对线程局部变量的访问
+// 同一变量被访问多次时，用一个局部变量缓存其地址
+typedef struct TLSAccess TLSAccess;
+struct TLSAccess {
+  TLSAccess *Next;
+  Obj *Var;    // 线程局部变量
+  Node *First; // 第一次访问的节点
+  Obj *Slot;   // 缓存地址的局部变量，只访问一次时为NULL
+};
+static TLSAccess *TLSAccesses;
+
+// 文件内的字符串字面量
+static HashMap StrLiterals;
+
 // 当前函数内的goto和标签列表
 static Node *Gotos;
 static Node *Labels;
@@ -92,13 +119,14 @@ static Obj *BuiltinAlloca;
 //             | "signed" | "unsigned"
 //             | structDecl | unionDecl | typedefName
 //             | enumSpecifier | typeof-specifier
+//             | "_Atomic" ("(" typeName ")")?
 //             | "const" | "volatile" | "auto" | "register" | "restrict"
 //             | "__restrict" | "__restrict__" | "_Noreturn")+
 // enumSpecifier = ident? "{" enumList? "}"
 //                 | ident ("{" enumList? "}")?
 // enumList = ident ("=" constExpr)? ("," ident ("=" constExpr)?)* ","?
 // declarator = pointers ("(" ident ")" | "(" declarator ")" | ident) typeSuffix
-// pointers = ("*" ("const" | "volatile" | "restrict")*)*
+// pointers = ("*" ("const" | "volatile" | "restrict" | "_Atomic")*)*
 // typeSuffix = "(" funcParams | "[" arrayDimensions | ε
 // arrayDimensions = ("static" | "restrict")* constExpr? "]" typeSuffix
 // funcParams = ("void" | param ("," param)* ("," "...")?)? ")"
@@ -179,6 +207,10 @@ static Obj *BuiltinAlloca;
 //         | "_Alignof" unary
 //         | "_Generic" genericSelection
 //         | "__builtin_types_compatible_p" "(" typeName, typeName, ")"
+//         | bitBuiltin
+//         | atomicBuiltin
+//         | hintBuiltin
+//         | "__builtin_shuffle" "(" assign ("," assign)? "," assign ")"
 //         | ident
 //         | str
 //         | num
@@ -225,6 +257,7 @@ static Node *shift(Token **Rest, Token *Tok);
 static Node *add(Token **Rest, Token *Tok);
 static Node *newAdd(Node *LHS, Node *RHS, Token *Tok);
 static Node *newSub(Node *LHS, Node *RHS, Token *Tok);
+static Node *newSubscript(Node *Base, Node *Idx, Token *Tok);
 static Node *mul(Token **Rest, Token *Tok);
 static Node *cast(Token **Rest, Token *Tok);
 static Member *getStructMember(Type *Ty, Token *Tok);
@@ -233,11 +266,13 @@ static Type *unionDecl(Token **Rest, Token *Tok);
 static Node *unary(Token **Rest, Token *Tok);
 static Node *postfix(Token **Rest, Token *Tok);
 static Node *funCall(Token **Rest, Token *Tok, Node *Nd);
+static Node *inlineLibCall(Node *Call);
 static Node *primary(Token **Rest, Token *Tok);
-static Token *parseTypedef(Token *Tok, Type *BaseTy);
+static Token *parseTypedef(Token *Tok, Type *BaseTy, VarAttr *Attr);
 static bool isFunction(Token *Tok);
 static Token *function(Token *Tok, Type *BaseTy, VarAttr *Attr);
 static Token *globalVariable(Token *Tok, Type *Basety, VarAttr *Attr);
+static Obj *newLVar(char *Name, Type *Ty);
 
 // 向下对齐值
 // N % Align != 0 , 即 N 未对齐时,  AlignDown(N) = AlignTo(N) - Align
@@ -245,35 +280,52 @@ static Token *globalVariable(Token *Tok, Type *Basety, VarAttr *Attr);
 static int alignDown(int N, int Align) { return alignTo(N - Align + 1, Align); }
 
 // 进入域
-static void enterScope(void) {
-  Scope *S = calloc(1, sizeof(Scope));
-  // 后来的在链表头部
-  // 类似于栈的结构，栈顶对应最近的域
-  S->Next = Scp;
-  Scp = S;
+static void enterScope(void) { ScopeDepth++; }
+
+// 结束当前域，弹出域内声明的所有符号，恢复被遮蔽的符号
+static void leaveScope(void) {
+  while (LastSym && LastSym->Depth == ScopeDepth) {
+    Symbol *Sym = LastSym;
+    hashmap_put2(Sym->Table, Sym->Name, Sym->NameLen, Sym->Shadow);
+    LastSym = Sym->Prev;
+  }
+  ScopeDepth--;
 }
 
-// 结束当前域
-static void leaveScope(void) { Scp = Scp->Next; }
+// 在当前域中声明符号
+static void pushSymbol(HashMap *Table, char *Name, int NameLen, void *Val) {
+  Symbol *Sym = calloc(1, sizeof(Symbol));
+  Sym->Shadow = hashmap_get2(Table, Name, NameLen);
+  Sym->Prev = LastSym;
+  Sym->Table = Table;
+  Sym->Name = Name;
+  Sym->NameLen = NameLen;
+  Sym->Depth = ScopeDepth;
+  Sym->Val = Val;
+  hashmap_put2(Table, Name, NameLen, Sym);
+  LastSym = Sym;
+}
+
+// 查找符号，返回最内层的声明
+static void *findSymbol(HashMap *Table, char *Name, int NameLen) {
+  Symbol *Sym = hashmap_get2(Table, Name, NameLen);
+  return Sym ? Sym->Val : NULL;
+}
 
 // 通过名称，查找一个变量
 static VarScope *findVar(Token *Tok) {
-  for (Scope *Sc = Scp; Sc; Sc = Sc->Next) {
-    VarScope *Sc2 = hashmap_get2(&Sc->Vars, Tok->Loc, Tok->Len);
-    if (Sc2)
-      return Sc2;
-  }
-  return NULL;
+  return findSymbol(&VarTable, Tok->Loc, Tok->Len);
 }
 
 // 通过Token查找标签
 static Type *findTag(Token *Tok) {
-  for (Scope *Sc = Scp; Sc; Sc = Sc->Next) {
-    Type *Ty = hashmap_get2(&Sc->Tags, Tok->Loc, Tok->Len);
-    if (Ty)
-      return Ty;
-  }
-  return NULL;
+  return findSymbol(&TagTable, Tok->Loc, Tok->Len);
+}
+
+// 通过Token查找当前域内的标签
+static Type *findTagInScope(Token *Tok) {
+  Symbol *Sym = hashmap_get2(&TagTable, Tok->Loc, Tok->Len);
+  return Sym && Sym->Depth == ScopeDepth ? Sym->Val : NULL;
 }
 
 // 新建一个节点
@@ -322,10 +374,39 @@ static Node *newULong(long Val, Token *Tok) {
   return node;
 }
 
+// 记录函数内对线程局部变量的访问
+// 第二次访问时创建缓存地址的局部变量，由代码生成根据访问模型决定是否使用
+static void cacheTLSAddr(Node *Nd) {
+  TLSAccess *A = TLSAccesses;
+  while (A && A->Var != Nd->Var)
+    A = A->Next;
+
+  if (!A) {
+    A = calloc(1, sizeof(TLSAccess));
+    A->Var = Nd->Var;
+    A->First = Nd;
+    A->Next = TLSAccesses;
+    TLSAccesses = A;
+    return;
+  }
+
+  if (!A->Slot) {
+    A->Slot = newLVar("", pointerTo(Nd->Var->Ty));
+    A->Slot->TLSVar = Nd->Var;
+    A->First->TLSSlot = A->Slot;
+  }
+  Nd->TLSSlot = A->Slot;
+}
+
 // 新变量
 static Node *newVarNode(Obj *Var, Token *Tok) {
   Node *Nd = newNode(ND_VAR, Tok);
   Nd->Var = Var;
+  if (Var->IsTLS && CurrentFn)
+    cacheTLSAddr(Nd);
+  // 与代码生成中一致，按名称识别alloca
+  if (CurrentFn && !strcmp(Var->Name, "alloca"))
+    CurrentFn->UsesAlloca = true;
   return Nd;
 }
 
@@ -344,13 +425,27 @@ Node *newCast(Node *Expr, Type *Ty) {
   Nd->Tok = Expr->Tok;
   Nd->LHS = Expr;
   Nd->Ty = copyType(Ty);
+
+  // 向量只能与相同大小的向量或整数相互转换，按位重新解释
+  Type *From = Expr->Ty;
+  if ((Ty->Kind == TY_VECTOR || From->Kind == TY_VECTOR) &&
+      Ty->Kind != TY_VOID) {
+    Type *Scalar = Ty->Kind == TY_VECTOR ? From : Ty;
+    if (Ty->Size != From->Size ||
+        (Scalar->Kind != TY_VECTOR && !isInteger(Scalar)))
+      errorTok(Expr->Tok, "cannot convert between vector and non-vector "
+                          "types of different sizes");
+    // 标量转换为向量时，写入临时变量
+    if (From->Kind != TY_VECTOR)
+      Nd->VecTmp = newVecTmp(Ty);
+  }
   return Nd;
 }
 
 // 将变量存入当前的域中
 static VarScope *pushScope(char *Name) {
   VarScope *S = calloc(1, sizeof(VarScope));
-  hashmap_put(&Scp->Vars, Name, S);
+  pushSymbol(&VarTable, Name, strlen(Name), S);
   return S;
 }
 
@@ -360,8 +455,8 @@ static Initializer *newInitializer(Type *Ty, bool IsFlexible) {
   // 存储原始类型
   Init->Ty = Ty;
 
-  // 处理数组类型
-  if (Ty->Kind == TY_ARRAY) {
+  // 处理数组和向量类型
+  if (Ty->Kind == TY_ARRAY || Ty->Kind == TY_VECTOR) {
     // 判断是否需要调整数组元素数并且数组不完整
     if (IsFlexible && Ty->Size < 0) {
       // 设置初始化器为可调整的，之后进行完数组元素数的计算后，再构造初始化器
@@ -427,6 +522,9 @@ static Obj *newLVar(char *Name, Type *Ty) {
   return Var;
 }
 
+// 新建存放向量运算结果的临时变量
+Obj *newVecTmp(Type *Ty) { return newLVar("", Ty); }
+
 // 在链表中新增一个全局变量
 static Obj *newGVar(char *Name, Type *Ty) {
   Obj *Var = newVar(Name, Ty);
@@ -449,9 +547,25 @@ static char *newUniqueName(void) {
 static Obj *newAnonGVar(Type *Ty) { return newGVar(newUniqueName(), Ty); }
 
 // 新增字符串字面量
+// 内容和类型都相同的字面量共用同一个变量
 static Obj *newStringLiteral(char *Str, Type *Ty) {
-  Obj *Var = newAnonGVar(Ty);
+  // 键为元素的类型和字面量的内容
+  int KeyLen = Ty->Size + 2;
+  char *Key = malloc(KeyLen);
+  Key[0] = Ty->Base->Size;
+  Key[1] = Ty->Base->IsUnsigned;
+  memcpy(Key + 2, Str, Ty->Size);
+
+  Obj *Var = hashmap_get2(&StrLiterals, Key, KeyLen);
+  if (Var) {
+    free(Key);
+    return Var;
+  }
+
+  Var = newAnonGVar(Ty);
   Var->InitData = Str;
+  Var->IsLiteral = true;
+  hashmap_put2(&StrLiterals, Key, KeyLen, Var);
   return Var;
 }
 
@@ -475,7 +589,163 @@ static Type *findTypedef(Token *Tok) {
 }
 
 static void pushTagScope(Token *Tok, Type *Ty) {
-  hashmap_put2(&Scp->Tags, Tok->Loc, Tok->Len, Ty);
+  pushSymbol(&TagTable, Tok->Loc, Tok->Len, Ty);
+}
+
+// 跳过括号及其中的内容
+static Token *skipParen(Token *Tok) {
+  int Level = 0;
+  do {
+    if (Tok->Kind == TK_EOF)
+      errorTok(Tok, "unterminated parenthesis");
+    if (equal(Tok, "("))
+      Level++;
+    else if (equal(Tok, ")"))
+      Level--;
+    Tok = Tok->Next;
+  } while (Level > 0);
+  return Tok;
+}
+
+// 判断是否为可以直接忽略的属性，这些属性只用于诊断或优化提示
+static bool isIgnorableAttribute(Token *Tok) {
+  static char *Names[] = {
+      "unused", "used", "maybe_unused", "noinline", "noclone",
+      "always_inline", "gnu_inline", "noreturn", "nothrow", "leaf", "pure",
+      "const", "malloc", "format", "format_arg", "nonnull", "returns_nonnull",
+      "warn_unused_result", "nodiscard", "deprecated", "unavailable", "cold",
+      "hot", "sentinel", "artificial", "access", "fallthrough", "alloc_size",
+      "alloc_align"};
+
+  // __name__与name等价
+  char *Name = Tok->Loc;
+  int Len = Tok->Len;
+  if (Len > 4 && !strncmp(Name, "__", 2) &&
+      !strncmp(Name + Len - 2, "__", 2)) {
+    Name += 2;
+    Len -= 4;
+  }
+
+  for (int I = 0; I < sizeof(Names) / sizeof(*Names); I++)
+    if (strlen(Names[I]) == Len && !strncmp(Name, Names[I], Len))
+      return true;
+  return false;
+}
+
+// attributeList = ("__attribute__" "(" "(" (attribute ("," attribute)*)? ")"
+//                  ")")*
+// attribute = ident ("(" ... ")")?
+// 识别变量和函数的属性，忽略其他的属性
+static Token *attributeList(Token *Tok, VarAttr *Attr) {
+  while (consume(&Tok, Tok, "__attribute__")) {
+    Tok = skip(Tok, "(");
+    Tok = skip(Tok, "(");
+
+    bool First = true;
+    while (!consume(&Tok, Tok, ")")) {
+      if (!First)
+        Tok = skip(Tok, ",");
+      First = false;
+
+      // visibility "(" ("default" | "hidden" | "protected" | "internal") ")"
+      if (Attr && (equal(Tok, "visibility") || equal(Tok, "__visibility__"))) {
+        Tok = skip(Tok->Next, "(");
+        if (Tok->Kind != TK_STR)
+          errorTok(Tok, "expected a string");
+        char *Vis = Tok->Str;
+        if (strcmp(Vis, "default") && strcmp(Vis, "hidden") &&
+            strcmp(Vis, "protected") && strcmp(Vis, "internal"))
+          errorTok(Tok, "invalid visibility: %s", Vis);
+        Attr->Visibility = Vis;
+        Tok = skip(Tok->Next, ")");
+        continue;
+      }
+
+      // tls_model "(" ("global-dynamic" | "local-dynamic" | "initial-exec"
+      //                | "local-exec") ")"
+      if (Attr && (equal(Tok, "tls_model") || equal(Tok, "__tls_model__"))) {
+        Tok = skip(Tok->Next, "(");
+        if (Tok->Kind != TK_STR)
+          errorTok(Tok, "expected a string");
+        if (!parseTLSModel(Tok->Str, &Attr->TLSModel))
+          errorTok(Tok, "invalid tls model: %s", Tok->Str);
+        Tok = skip(Tok->Next, ")");
+        continue;
+      }
+
+      // vector_size "(" constExpr ")"
+      if (Attr &&
+          (equal(Tok, "vector_size") || equal(Tok, "__vector_size__"))) {
+        Tok = skip(Tok->Next, "(");
+        Token *Start = Tok;
+        int64_t Size = constExpr(&Tok, Tok);
+        if (Size <= 0 || (Size & (Size - 1)))
+          errorTok(Start, "vector size must be a power of two");
+        Attr->VectorSize = Size;
+        Tok = skip(Tok, ")");
+        continue;
+      }
+
+      // aligned ("(" constExpr ")")?
+      // 只能增大对齐值，未指定时使用最大的对齐值
+      if (Attr && (equal(Tok, "aligned") || equal(Tok, "__aligned__"))) {
+        int64_t Align = 16;
+        Tok = Tok->Next;
+        if (consume(&Tok, Tok, "(")) {
+          Token *Start = Tok;
+          Align = constExpr(&Tok, Tok);
+          if (Align <= 0 || (Align & (Align - 1)))
+            errorTok(Start, "requested alignment is not a power of 2");
+          Tok = skip(Tok, ")");
+        }
+        Attr->Align = MAX(Attr->Align, Align);
+        continue;
+      }
+
+      // 忽略其他属性及其参数，不影响代码正确性的属性之外给出警告
+      if (!isIgnorableAttribute(Tok))
+        warnTok(Tok, "'%.*s' attribute ignored", Tok->Len, Tok->Loc);
+      Tok = Tok->Next;
+      if (equal(Tok, "("))
+        Tok = skipParen(Tok);
+    }
+    Tok = skip(Tok, ")");
+  }
+  return Tok;
+}
+
+// 设置全局变量或函数的可见性
+// 未指定时沿用之前声明的可见性，定义时默认使用-fvisibility=指定的可见性
+static void setVisibility(Obj *Var, VarAttr *Attr) {
+  Var->Visibility = Attr->Visibility;
+
+  // 之前的声明被当前声明遮蔽
+  Symbol *Sym = hashmap_get(&VarTable, Var->Name);
+  VarScope *Prev = Sym && Sym->Shadow ? Sym->Shadow->Val : NULL;
+  if (!Var->Visibility && Prev && Prev->Var)
+    Var->Visibility = Prev->Var->Visibility;
+
+  if (!Var->Visibility && Var->IsDefinition)
+    Var->Visibility = OptFVisibility;
+}
+
+// 由vector_size属性构造向量类型，元素需为整数或浮点数
+static Type *vectorType(Token *Tok, Type *Ty, int Size) {
+  if ((!isInteger(Ty) || Ty->Kind == TY_BOOL) && !isFloatOrDouble(Ty))
+    errorTok(Tok, "invalid vector element type");
+  if (Size < Ty->Size)
+    errorTok(Tok, "vector size is smaller than the element size");
+  return vectorOf(Ty, Size);
+}
+
+// 声明符之后的vector_size属性，作用于声明的变量或类型别名
+static Type *declVectorType(Type *Ty, VarAttr *Attr) {
+  if (!Attr->VectorSize)
+    return Ty;
+  Type *Vec = vectorType(Ty->Name, Ty, Attr->VectorSize);
+  Vec->Name = Ty->Name;
+  Vec->NamePos = Ty->NamePos;
+  return Vec;
 }
 
 // declspec = ("void" | "_Bool" | char" | "short" | "int" | "long"
@@ -485,6 +755,7 @@ static void pushTagScope(Token *Tok, Type *Ty) {
 //             | "signed" | "unsigned"
 //             | structDecl | unionDecl | typedefName
 //             | enumSpecifier | typeof-specifier
+//             | "_Atomic" ("(" typeName ")")?
 //             | "const" | "volatile" | "auto" | "register" | "restrict"
 //             | "__restrict" | "__restrict__" | "_Noreturn")+
 // declarator specifier
@@ -508,6 +779,13 @@ static Type *declspec(Token **Rest, Token *Tok, VarAttr *Attr) {
 
   Type *Ty = TyInt;
   int Counter = 0; // 记录类型相加的数值
+  bool IsConst = false;
+  bool IsAtomic = false;
+  bool IsVolatile = false;
+  bool IsRestrict = false;
+  // 不存在变量属性时，仍需识别类型的属性
+  VarAttr TyAttr = {};
+  VarAttr *AttrList = Attr ? Attr : &TyAttr;
 
   // 遍历所有类型名的Tok
   while (isTypename(Tok)) {
@@ -538,13 +816,53 @@ static Type *declspec(Token **Rest, Token *Tok, VarAttr *Attr) {
       continue;
     }
 
+    // const限定的对象可以放入只读段
+    if (consume(&Tok, Tok, "const")) {
+      IsConst = true;
+      continue;
+    }
+
+    // "_Atomic" "(" typeName ")"
+    if (equal(Tok, "_Atomic") && equal(Tok->Next, "(")) {
+      if (Counter)
+        break;
+      Ty = typename(&Tok, Tok->Next->Next);
+      Tok = skip(Tok, ")");
+      IsAtomic = true;
+      Counter += OTHER;
+      continue;
+    }
+
+    // _Atomic限定的对象，读写和复合赋值需为原子操作
+    if (consume(&Tok, Tok, "_Atomic")) {
+      IsAtomic = true;
+      continue;
+    }
+
+    // volatile限定的对象，每次读写都需要访问内存
+    if (consume(&Tok, Tok, "volatile")) {
+      IsVolatile = true;
+      continue;
+    }
+
+    // restrict限定的指针，是访问其指向的对象的唯一途径
+    if (consume(&Tok, Tok, "restrict") || consume(&Tok, Tok, "__restrict") ||
+        consume(&Tok, Tok, "__restrict__")) {
+      IsRestrict = true;
+      continue;
+    }
+
     // 识别这些关键字并忽略
-    if (consume(&Tok, Tok, "const") || consume(&Tok, Tok, "volatile") ||
-        consume(&Tok, Tok, "auto") || consume(&Tok, Tok, "register") ||
-        consume(&Tok, Tok, "restrict") || consume(&Tok, Tok, "__restrict") ||
-        consume(&Tok, Tok, "__restrict__") || consume(&Tok, Tok, "_Noreturn"))
+    if (consume(&Tok, Tok, "auto") || consume(&Tok, Tok, "register") ||
+        consume(&Tok, Tok, "_Noreturn"))
       continue;
 
+    // __attribute__
+    if (equal(Tok, "__attribute__")) {
+      Tok = attributeList(Tok, AttrList);
+      continue;
+    }
+
     // _Alignas "(" typeName | constExpr ")"
     if (equal(Tok, "_Alignas")) {
       // 不存在变量属性时，无法设置对齐值
@@ -678,6 +996,21 @@ static Type *declspec(Token **Rest, Token *Tok, VarAttr *Attr) {
     Tok = Tok->Next;
   } // while (isTypename(Tok))
 
+  // vector_size属性作用于声明的基础类型
+  if (AttrList->VectorSize) {
+    Ty = vectorType(Tok, Ty, AttrList->VectorSize);
+    AttrList->VectorSize = 0;
+  }
+
+  // 不完整的结构体在补全时会被原地修改，复制后无法得到补全的成员
+  if ((IsConst || IsAtomic || IsVolatile || IsRestrict) && Ty->Size >= 0) {
+    Ty = copyType(Ty);
+    Ty->IsConst |= IsConst;
+    Ty->IsAtomic |= IsAtomic;
+    Ty->IsVolatile |= IsVolatile;
+    Ty->IsRestrict |= IsRestrict;
+  }
+
   *Rest = Tok;
   return Ty;
 }
@@ -717,8 +1050,10 @@ static Type *funcParams(Token **Rest, Token *Tok, Type *Ty) {
 
     // T类型的数组或函数被转换为T*
     if (Ty2->Kind == TY_ARRAY) {
+      bool IsRestrict = Ty2->IsRestrict;
       Ty2 = pointerTo(Ty2->Base);
       Ty2->Name = Name;
+      Ty2->IsRestrict = IsRestrict;
     } else if (Ty2->Kind == TY_FUNC) {
       Ty2 = pointerTo(Ty2);
       Ty2->Name = Name;
@@ -747,13 +1082,19 @@ static Type *funcParams(Token **Rest, Token *Tok, Type *Ty) {
 // arrayDimensions = ("static" | "restrict")* constExpr? "]" typeSuffix
 static Type *arrayDimensions(Token **Rest, Token *Tok, Type *Ty) {
   // ("static" | "restrict")*
-  while (equal(Tok, "static") || equal(Tok, "restrict"))
+  // 形参的 T [restrict] 转换为 T *restrict
+  bool IsRestrict = false;
+  while (equal(Tok, "static") || equal(Tok, "restrict")) {
+    IsRestrict |= equal(Tok, "restrict");
     Tok = Tok->Next;
+  }
 
   // "]" 无数组维数的 "[]"
   if (equal(Tok, "]")) {
     Ty = typeSuffix(Rest, Tok->Next, Ty);
-    return arrayOf(Ty, -1);
+    Ty = arrayOf(Ty, -1);
+    Ty->IsRestrict = IsRestrict;
+    return Ty;
   }
 
   // 有数组维数的情况
@@ -762,8 +1103,11 @@ static Type *arrayDimensions(Token **Rest, Token *Tok, Type *Ty) {
   Ty = typeSuffix(Rest, Tok, Ty);
 
   if (Ty->Kind == TY_VLA || !isConstExpr(Expr))
-    return VLAOf(Ty, Expr);
-  return arrayOf(Ty, eval(Expr));
+    Ty = VLAOf(Ty, Expr);
+  else
+    Ty = arrayOf(Ty, eval(Expr));
+  Ty->IsRestrict = IsRestrict;
+  return Ty;
 }
 
 // typeSuffix = "(" funcParams | "[" arrayDimensions | ε
@@ -780,17 +1124,27 @@ static Type *typeSuffix(Token **Rest, Token *Tok, Type *Ty) {
   return Ty;
 }
 
-// pointers = ("*" ("const" | "volatile" | "restrict")*)*
+// pointers = ("*" ("const" | "volatile" | "restrict" | "_Atomic")*)*
 static Type *pointers(Token **Rest, Token *Tok, Type *Ty) {
   // "*"*
   // 构建所有的（多重）指针
   while (consume(&Tok, Tok, "*")) {
     Ty = pointerTo(Ty);
-    // 识别这些关键字并忽略
+    // 识别这些关键字
     while (equal(Tok, "const") || equal(Tok, "volatile") ||
            equal(Tok, "restrict") || equal(Tok, "__restrict") ||
-           equal(Tok, "__restrict__"))
+           equal(Tok, "__restrict__") || equal(Tok, "_Atomic")) {
+      if (equal(Tok, "const"))
+        Ty->IsConst = true;
+      if (equal(Tok, "volatile"))
+        Ty->IsVolatile = true;
+      if (equal(Tok, "restrict") || equal(Tok, "__restrict") ||
+          equal(Tok, "__restrict__"))
+        Ty->IsRestrict = true;
+      if (equal(Tok, "_Atomic"))
+        Ty->IsAtomic = true;
       Tok = Tok->Next;
+    }
   }
   *Rest = Tok;
   return Ty;
@@ -1014,10 +1368,16 @@ static Node *declaration(Token **Rest, Token *Tok, Type *BaseTy,
       errorTok(Tok, "variable declared void");
     if (!Ty->Name)
       errorTok(Ty->NamePos, "variable name omitted");
+    VarAttr VarAttr2 = Attr ? *Attr : (VarAttr){};
+    Tok = attributeList(Tok, &VarAttr2);
+    Ty = declVectorType(Ty, &VarAttr2);
 
     if (Attr && Attr->IsStatic) {
       // 静态局部变量
       Obj *Var = newAnonGVar(Ty);
+      Var->IsTLS = Attr->IsTLS;
+      Var->TLSModel = VarAttr2.TLSModel;
+      Var->Align = MAX(Var->Align, VarAttr2.Align);
       pushScope(getIdent(Ty->Name))->Var = Var;
       if (equal(Tok, "="))
         GVarInitializer(&Tok, Tok->Next, Var);
@@ -1047,8 +1407,7 @@ static Node *declaration(Token **Rest, Token *Tok, Type *BaseTy,
 
     Obj *Var = newLVar(getIdent(Ty->Name), Ty);
     // 读取是否存在变量的对齐值
-    if (Attr && Attr->Align)
-      Var->Align = Attr->Align;
+    Var->Align = MAX(Var->Align, VarAttr2.Align);
 
     // 如果不存在"="则为变量声明，不需要生成节点，已经存储在Locals中了
     if (equal(Tok, "=")) {
@@ -1462,6 +1821,15 @@ static void initializer2(Token **Rest, Token *Tok, Initializer *Init) {
     return;
   }
 
+  // 向量的初始化，与数组相同，或者使用其他向量来赋值
+  if (Init->Ty->Kind == TY_VECTOR) {
+    if (equal(Tok, "{"))
+      arrayInitializer1(Rest, Tok, Init);
+    else
+      Init->Expr = assign(Rest, Tok);
+    return;
+  }
+
   // 处理标量外的大括号，例如：int x = {3};
   if (equal(Tok, "{")) {
     initializer2(&Tok, Tok->Next, Init);
@@ -1545,13 +1913,13 @@ static Node *initDesigExpr(InitDesig *Desig, Token *Tok) {
   // 偏移量
   Node *RHS = newNum(Desig->Idx, Tok);
   // 返回偏移后的变量地址
-  return newUnary(ND_DEREF, newAdd(LHS, RHS, Tok), Tok);
+  return newSubscript(LHS, RHS, Tok);
 }
 
 // 创建局部变量的初始化
 static Node *createLVarInit(Initializer *Init, Type *Ty, InitDesig *Desig,
                             Token *Tok) {
-  if (Ty->Kind == TY_ARRAY) {
+  if (Ty->Kind == TY_ARRAY || (Ty->Kind == TY_VECTOR && !Init->Expr)) {
     // 预备空表达式的情况
     Node *Nd = newNode(ND_NULL_EXPR, Tok);
     for (int I = 0; I < Ty->ArrayLen; I++) {
@@ -1643,8 +2011,8 @@ static void writeBuf(char *Buf, uint64_t Val, int Sz) {
 // 对全局变量的初始化器写入数据
 static Relocation *writeGVarData(Relocation *Cur, Initializer *Init, Type *Ty,
                                  char *Buf, int Offset) {
-  // 处理数组
-  if (Ty->Kind == TY_ARRAY) {
+  // 处理数组和向量
+  if (Ty->Kind == TY_ARRAY || (Ty->Kind == TY_VECTOR && !Init->Expr)) {
     int Sz = Ty->Base->Size;
     for (int I = 0; I < Ty->ArrayLen; I++)
       Cur =
@@ -1758,6 +2126,7 @@ static bool isTypename(Token *Tok) {
         "const",      "volatile",     "auto",          "register", "restrict",
         "__restrict", "__restrict__", "_Noreturn",     "float",    "double",
         "typeof",     "inline",       "_Thread_local", "__thread",
+        "__attribute__", "_Atomic",
     };
 
     for (int I = 0; I < sizeof(Kw) / sizeof(*Kw); I++)
@@ -2103,7 +2472,7 @@ static Node *compoundStmt(Token **Rest, Token *Tok) {
 
       // 解析typedef的语句
       if (Attr.IsTypedef) {
-        Tok = parseTypedef(Tok, BaseTy);
+        Tok = parseTypedef(Tok, BaseTy, &Attr);
         continue;
       }
 
@@ -2386,6 +2755,112 @@ static double evalDouble(Node *Nd) {
   }
 }
 
+// 去掉类型的_Atomic限定，用于存放原子对象值的临时变量
+static Type *unatomic(Type *Ty) {
+  if (!Ty->IsAtomic)
+    return Ty;
+  Ty = copyType(Ty);
+  Ty->IsAtomic = false;
+  return Ty;
+}
+
+// 获取原子操作的对象类型，需为指向1、2、4、8字节的整数或指针，
+// 或float、double的指针
+static Type *atomicType(Node *Ptr) {
+  addType(Ptr);
+  if (Ptr->Ty->Kind != TY_PTR && Ptr->Ty->Kind != TY_ARRAY)
+    errorTok(Ptr->Tok, "pointer expected");
+  Type *Ty = Ptr->Ty->Base;
+  if ((!isNumeric(Ty) && Ty->Kind != TY_PTR) || Ty->Kind == TY_LDOUBLE ||
+      (Ty->Size != 1 && Ty->Size != 2 && Ty->Size != 4 && Ty->Size != 8))
+    errorTok(Ptr->Tok, "invalid operand for atomic operation");
+  return Ty;
+}
+
+// 原子读改写：*Ptr = *Ptr op Val
+// Fetch为真时返回原值，否则返回新值
+static Node *newAtomicRW(NodeKind Op, Node *Ptr, Node *Val, bool Fetch,
+                         MemoryOrder Order, Token *Tok) {
+  // 浮点数只支持读取、写入和比较并交换
+  if (isFloNum(atomicType(Ptr)))
+    errorTok(Ptr->Tok, "invalid operand for atomic operation");
+  Type *Ty = unatomic(atomicType(Ptr));
+  Node *Nd = newBinary(ND_ATOMIC_RW, Ptr, newCast(Val, Ty), Tok);
+  Nd->AtomicOp = Op;
+  Nd->AtomicFetch = Fetch;
+  Nd->Order = Order;
+  return Nd;
+}
+
+// 原子比较并交换：*Ptr与*Old相等时写入New，否则将*Ptr的值写入*Old
+static Node *newCas(Node *Ptr, Node *Old, Node *New, MemoryOrder Order,
+                    Token *Tok) {
+  Node *Nd = newNode(ND_CAS, Tok);
+  Nd->CasAddr = Ptr;
+  Nd->CasOld = Old;
+  Nd->CasNew = newCast(New, unatomic(atomicType(Ptr)));
+  Nd->Order = Order;
+  return Nd;
+}
+
+// 转换原子对象的 A op= B
+// 整数的加减和位运算，转换为原子读改写
+// 其他运算，转换为比较并交换的循环：
+//   ({ TMP = &A; VAL = B; OLD = *TMP;
+//      do { NEW = OLD op VAL; } while (!CAS(TMP, &OLD, NEW)); NEW; })
+static Node *atomicAssign(Node *Binary) {
+  Node *LHS = Binary->LHS;
+  Node *RHS = Binary->RHS;
+  Token *Tok = Binary->Tok;
+  NodeKind Op = Binary->Kind;
+
+  if (isInteger(LHS->Ty) && LHS->Ty->Kind != TY_BOOL && isInteger(RHS->Ty) &&
+      (Op == ND_ADD || Op == ND_SUB || Op == ND_BITAND || Op == ND_BITOR ||
+       Op == ND_BITXOR))
+    return newAtomicRW(Op, newUnary(ND_ADDR, LHS, Tok), RHS, false,
+                       MO_SEQ_CST, Tok);
+
+  Type *Ty = unatomic(LHS->Ty);
+  Obj *Addr = newLVar("", pointerTo(LHS->Ty));
+  Obj *Val = newLVar("", unatomic(RHS->Ty));
+  Obj *Old = newLVar("", Ty);
+  Obj *New = newLVar("", Ty);
+
+  Node Head = {};
+  Node *Cur = &Head;
+
+  // TMP = &A; VAL = B; OLD = *TMP;
+  Node *Init[] = {
+      newBinary(ND_ASSIGN, newVarNode(Addr, Tok), newUnary(ND_ADDR, LHS, Tok),
+                Tok),
+      newBinary(ND_ASSIGN, newVarNode(Val, Tok), RHS, Tok),
+      newBinary(ND_ASSIGN, newVarNode(Old, Tok),
+                newUnary(ND_DEREF, newVarNode(Addr, Tok), Tok), Tok),
+  };
+  for (int I = 0; I < sizeof(Init) / sizeof(*Init); I++)
+    Cur = Cur->Next = newUnary(ND_EXPR_STMT, Init[I], Tok);
+
+  // do { NEW = OLD op VAL; } while (!CAS(TMP, &OLD, NEW));
+  Node *Loop = newNode(ND_DO, Tok);
+  Loop->BrkLabel = newUniqueName();
+  Loop->ContLabel = newUniqueName();
+  Node *Calc = newBinary(Op, newVarNode(Old, Tok), newVarNode(Val, Tok), Tok);
+  Loop->Then = newUnary(
+      ND_EXPR_STMT, newBinary(ND_ASSIGN, newVarNode(New, Tok), Calc, Tok), Tok);
+  Node *Cas = newCas(newVarNode(Addr, Tok),
+                     newUnary(ND_ADDR, newVarNode(Old, Tok), Tok),
+                     newVarNode(New, Tok), MO_SEQ_CST, Tok);
+  Loop->Cond = newUnary(ND_NOT, Cas, Tok);
+  Cur = Cur->Next = Loop;
+
+  // NEW
+  Cur = Cur->Next = newUnary(ND_EXPR_STMT, newVarNode(New, Tok), Tok);
+
+  Node *Nd = newNode(ND_STMT_EXPR, Tok);
+  Nd->Body = Head.Next;
+  return Nd;
+}
+
 // 转换 A op= B为 TMP = &A, *TMP = *TMP op B
 // 结构体需要特殊处理
 static Node *toAssign(Node *Binary) {
@@ -2395,6 +2870,10 @@ static Node *toAssign(Node *Binary) {
   addType(Binary->RHS);
   Token *Tok = Binary->Tok;
 
+  // 原子对象需要整体为原子操作
+  if (Binary->LHS->Ty->IsAtomic)
+    return atomicAssign(Binary);
+
   // 转换 A.X op= B 为 TMP = &A, (*TMP).X = (*TMP).X op B
   if (Binary->LHS->Kind == ND_MEMBER) {
     // TMP
@@ -2699,6 +3178,10 @@ static Node *newAdd(Node *LHS, Node *RHS, Token *Tok) {
   if (isNumeric(LHS->Ty) && isNumeric(RHS->Ty))
     return newBinary(ND_ADD, LHS, RHS, Tok);
 
+  // 向量的逐元素加法
+  if (LHS->Ty->Kind == TY_VECTOR || RHS->Ty->Kind == TY_VECTOR)
+    return newBinary(ND_ADD, LHS, RHS, Tok);
+
   // 不能解析 ptr + ptr
   if (LHS->Ty->Base && RHS->Ty->Base)
     errorTok(Tok, "invalid operands");
@@ -2733,6 +3216,10 @@ static Node *newSub(Node *LHS, Node *RHS, Token *Tok) {
   if (isNumeric(LHS->Ty) && isNumeric(RHS->Ty))
     return newBinary(ND_SUB, LHS, RHS, Tok);
 
+  // 向量的逐元素减法
+  if (LHS->Ty->Kind == TY_VECTOR || RHS->Ty->Kind == TY_VECTOR)
+    return newBinary(ND_SUB, LHS, RHS, Tok);
+
   // ptr - num
   if (LHS->Ty->Base && isInteger(RHS->Ty)) {
     // 指针用long类型存储
@@ -2755,6 +3242,15 @@ static Node *newSub(Node *LHS, Node *RHS, Token *Tok) {
   return NULL;
 }
 
+// 下标，x[y]等价于*(x+y)
+// 向量的下标访问其中的元素，即((T *)&x)[y]
+static Node *newSubscript(Node *Base, Node *Idx, Token *Tok) {
+  addType(Base);
+  if (Base->Ty->Kind == TY_VECTOR)
+    Base = newCast(newUnary(ND_ADDR, Base, Tok), pointerTo(Base->Ty->Base));
+  return newUnary(ND_DEREF, newAdd(Base, Idx, Tok), Tok);
+}
+
 // 解析加减
 // add = mul ("+" mul | "-" mul)*
 static Node *add(Token **Rest, Token *Tok) {
@@ -2923,7 +3419,7 @@ static void structMembers(Token **Rest, Token *Tok, Type *Ty) {
       Member *Mem = calloc(1, sizeof(Member));
       Mem->Ty = BaseTy;
       Mem->Idx = Idx++;
-      Mem->Align = Attr.Align ? Attr.Align : Mem->Ty->Align;
+      Mem->Align = MAX(Attr.Align, Mem->Ty->Align);
       Cur = Cur->Next = Mem;
       continue;
     }
@@ -2940,8 +3436,11 @@ static void structMembers(Token **Rest, Token *Tok, Type *Ty) {
       Mem->Name = Mem->Ty->Name;
       // 成员变量对应的索引值
       Mem->Idx = Idx++;
+      // 声明符之后的属性，只作用于当前成员
+      VarAttr MemAttr = Attr;
+      Tok = attributeList(Tok, &MemAttr);
       // 设置对齐值
-      Mem->Align = Attr.Align ? Attr.Align : Mem->Ty->Align;
+      Mem->Align = MAX(MemAttr.Align, Mem->Ty->Align);
 
       // 位域成员赋值
       if (consume(&Tok, Tok, ":")) {
@@ -2997,7 +3496,7 @@ static Type *structUnionDecl(Token **Rest, Token *Tok) {
 
   // 如果是重复定义，就覆盖之前的定义。否则有名称就注册结构体类型
   if (Tag) {
-    Type *Ty2 = hashmap_get2(&Scp->Tags, Tag->Loc, Tag->Len);
+    Type *Ty2 = findTagInScope(Tag);
     if (Ty2) {
       *Ty2 = *Ty;
       return Ty2;
@@ -3151,7 +3650,7 @@ static Node *postfix(Token **Rest, Token *Tok) {
     Type *Ty = typename(&Tok, Tok->Next);
     Tok = skip(Tok, ")");
 
-    if (Scp->Next == NULL) {
+    if (ScopeDepth == 0) {
       Obj *Var = newAnonGVar(Ty);
       GVarInitializer(Rest, Tok, Var);
       return newVarNode(Var, Start);
@@ -3171,7 +3670,7 @@ static Node *postfix(Token **Rest, Token *Tok) {
     // ident "(" funcArgs ")"
     // 匹配到函数调用
     if (equal(Tok, "(")) {
-      Nd = funCall(&Tok, Tok->Next, Nd);
+      Nd = inlineLibCall(funCall(&Tok, Tok->Next, Nd));
       continue;
     }
 
@@ -3180,7 +3679,7 @@ static Node *postfix(Token **Rest, Token *Tok) {
       Token *Start = Tok;
       Node *Idx = expr(&Tok, Tok->Next);
       Tok = skip(Tok, "]");
-      Nd = newUnary(ND_DEREF, newAdd(Nd, Idx, Start), Start);
+      Nd = newSubscript(Nd, Idx, Start);
       continue;
     }
 
@@ -3269,13 +3768,253 @@ static Node *funCall(Token **Rest, Token *Tok, Node *Fn) {
   Nd->Ty = Ty->ReturnTy;
   Nd->Args = Head.Next;
 
-  // 如果函数返回值是结构体，那么调用者需为返回值开辟一块空间
-  if (Nd->Ty->Kind == TY_STRUCT || Nd->Ty->Kind == TY_UNION)
+  // 如果函数返回值是结构体或向量，那么调用者需为返回值开辟一块空间
+  if (Nd->Ty->Kind == TY_STRUCT || Nd->Ty->Kind == TY_UNION ||
+      Nd->Ty->Kind == TY_VECTOR)
     Nd->RetBuffer = newLVar("", Nd->Ty);
 
   return Nd;
 }
 
+// 获取__builtin_前缀的函数对应的库函数，未声明时隐式声明
+// 不是这类函数时返回NULL
+static Obj *builtinLibFunc(Token *Tok) {
+  static char *Names[] = {"memcpy", "memset", "memcmp", "strlen"};
+  if (Tok->Len <= 10 || strncmp(Tok->Loc, "__builtin_", 10))
+    return NULL;
+
+  char *Name = strndup(Tok->Loc + 10, Tok->Len - 10);
+  int I = 0;
+  while (I < sizeof(Names) / sizeof(*Names) && strcmp(Name, Names[I]))
+    I++;
+  if (I == sizeof(Names) / sizeof(*Names))
+    return NULL;
+
+  VarScope *S = findSymbol(&VarTable, Name, strlen(Name));
+  if (S && S->Var && S->Var->IsFunction)
+    return S->Var;
+
+  // void *memcpy(void *, const void *, size_t)
+  // void *memset(void *, int, size_t)
+  // int memcmp(const void *, const void *, size_t)
+  // size_t strlen(const char *)
+  Type *VoidPtr = pointerTo(TyVoid);
+  Type *Params[][3] = {
+      {VoidPtr, VoidPtr, TyULong},
+      {VoidPtr, TyInt, TyULong},
+      {VoidPtr, VoidPtr, TyULong},
+      {pointerTo(TyChar)},
+  };
+  Type *Ret[] = {VoidPtr, VoidPtr, TyInt, TyULong};
+
+  Type *Ty = funcType(Ret[I]);
+  Type Head = {};
+  Type *Cur = &Head;
+  for (int J = 0; J < 3 && Params[I][J]; J++)
+    Cur = Cur->Next = copyType(Params[I][J]);
+  Ty->Params = Head.Next;
+
+  // 声明只加入全局变量的链表，不影响当前的作用域
+  Obj *Fn = calloc(1, sizeof(Obj));
+  Fn->Name = Name;
+  Fn->Ty = Ty;
+  Fn->Align = Ty->Align;
+  Fn->IsFunction = true;
+  Fn->Next = Globals;
+  Globals = Fn;
+  return Fn;
+}
+
+// 指针指向的地址已知的对齐值
+// 包括指向类型的对齐值，取地址的变量和__builtin_assume_aligned的对齐值
+static int ptrAlign(Node *Nd) {
+  int Align = 1;
+  for (;; Nd = Nd->LHS) {
+    addType(Nd);
+    if (Nd->Ty->Kind == TY_PTR)
+      Align = MAX(Align, Nd->Ty->Base->Align);
+    if (Nd->Kind == ND_ALIGNED)
+      return MAX(Align, Nd->Val);
+    if (Nd->Kind == ND_ADDR && Nd->LHS->Kind == ND_VAR)
+      return MAX(Align, Nd->LHS->Var->Align);
+    // 数组转换为指向首元素的指针
+    if (Nd->Kind == ND_VAR && Nd->Ty->Kind == TY_ARRAY)
+      return MAX(Align, Nd->Var->Align);
+    if (Nd->Kind != ND_CAST)
+      return Align;
+  }
+}
+
+// 按对齐值每次读写不超过8字节时，需要的次数
+static int chunkCount(int Size, int Align) {
+  int N = 0;
+  for (int I = 0; I < Size; N++) {
+    int Sz = MIN(Align, 8);
+    while (Sz > Size - I)
+      Sz /= 2;
+    I += Sz;
+  }
+  return N;
+}
+
+// 内联展开时，最多使用的读写次数，超过时仍调用库函数
+#define INLINE_CHUNKS 8
+
+// 对应大小的整数类型
+static Type *intOfSize(int Size) {
+  return Size == 8 ? TyLong : Size == 4 ? TyInt : Size == 2 ? TyShort : TyChar;
+}
+
+// *(Ty *)(Ptr + Offset)
+static Node *newDerefAt(Obj *Ptr, int Offset, Type *Ty, Token *Tok) {
+  Node *Addr = newVarNode(Ptr, Tok);
+  if (Offset)
+    Addr = newAdd(Addr, newNum(Offset, Tok), Tok);
+  return newUnary(ND_DEREF, newCast(Addr, pointerTo(Ty)), Tok);
+}
+
+// 内联展开参数为常量大小的memcpy、memset、memcmp，和参数为字符串字面量的strlen
+// 不满足条件时，返回原来的函数调用
+static Node *inlineLibCall(Node *Call) {
+  Node *Fn = Call->LHS;
+  if (Fn->Kind != ND_VAR || !Fn->Var->IsFunction || Fn->Var->IsStatic)
+    return Call;
+
+  // -fno-builtin时，只展开__builtin_前缀的函数
+  bool IsBuiltin =
+      Fn->Tok->Len > 10 && !strncmp(Fn->Tok->Loc, "__builtin_", 10);
+  if (!OptFBuiltin && !IsBuiltin)
+    return Call;
+
+  char *Name = Fn->Var->Name;
+  Token *Tok = Call->Tok;
+  Node *A[3] = {};
+  int NArgs = 0;
+  for (Node *Arg = Call->Args; Arg; Arg = Arg->Next) {
+    if (NArgs == 3)
+      return Call;
+    A[NArgs++] = Arg;
+  }
+
+  // strlen("...")
+  if (!strcmp(Name, "strlen") && NArgs == 1) {
+    Node *Str = A[0];
+    while (Str->Kind == ND_CAST)
+      Str = Str->LHS;
+    if (Str->Kind != ND_VAR || !Str->Var->IsLiteral ||
+        Str->Var->Ty->Base->Size != 1)
+      return Call;
+    return newULong(strlen(Str->Var->InitData), Tok);
+  }
+
+  if (NArgs != 3 || !isConstExpr(A[2]))
+    return Call;
+  int64_t Size = eval(A[2]);
+  if (Size < 0 || Size > INLINE_CHUNKS * 8)
+    return Call;
+
+  // memcpy(D, S, N) =>
+  //   (TMP1 = D, TMP2 = S, *(BLOCK *)TMP1 = *(BLOCK *)TMP2, TMP1)
+  // BLOCK为大小为N，对齐值为两侧共同对齐值的结构体，按结构体进行复制
+  if (!strcmp(Name, "memcpy")) {
+    int Align = MIN(ptrAlign(A[0]), ptrAlign(A[1]));
+    if (chunkCount(Size, Align) > INLINE_CHUNKS)
+      return Call;
+
+    Type *Block = structType();
+    Block->Size = Size;
+    Block->Align = Align;
+
+    Obj *Dst = newLVar("", pointerTo(TyChar));
+    Obj *Src = newLVar("", pointerTo(TyChar));
+    Node *Nd = newBinary(ND_ASSIGN, newVarNode(Dst, Tok), A[0], Tok);
+    Nd = newBinary(ND_COMMA, Nd,
+                   newBinary(ND_ASSIGN, newVarNode(Src, Tok), A[1], Tok), Tok);
+    if (Size > 0) {
+      Node *Copy = newBinary(ND_ASSIGN, newDerefAt(Dst, 0, Block, Tok),
+                             newDerefAt(Src, 0, Block, Tok), Tok);
+      Nd = newBinary(ND_COMMA, Nd, Copy, Tok);
+    }
+    return newCast(newBinary(ND_COMMA, Nd, newVarNode(Dst, Tok), Tok),
+                   Call->Ty);
+  }
+
+  // memset(D, C, N) =>
+  //   (TMP = D, V = C * 0x0101..., *(T *)(TMP + I) = V ..., TMP)
+  // 按对齐值，每次写入不超过8字节
+  if (!strcmp(Name, "memset")) {
+    int Align = ptrAlign(A[0]);
+    if (chunkCount(Size, Align) > INLINE_CHUNKS)
+      return Call;
+
+    Obj *Dst = newLVar("", pointerTo(TyChar));
+    Node *Nd = newBinary(ND_ASSIGN, newVarNode(Dst, Tok), A[0], Tok);
+
+    // 将字节重复8次，常量时直接计算
+    Node *Byte = newCast(A[1], TyUChar);
+    Node *Val = NULL;
+    bool IsConst = isConstExpr(Byte);
+    uint64_t Pattern = IsConst ? eval(Byte) * 0x0101010101010101 : 0;
+    if (!IsConst) {
+      Obj *Var = newLVar("", TyULong);
+      Node *Rep = newBinary(ND_MUL, newCast(Byte, TyULong),
+                            newULong(0x0101010101010101, Tok), Tok);
+      Nd = newBinary(ND_COMMA, Nd,
+                     newBinary(ND_ASSIGN, newVarNode(Var, Tok), Rep, Tok), Tok);
+      Val = newVarNode(Var, Tok);
+    }
+
+    for (int I = 0; I < Size;) {
+      int Sz = MIN(Align, 8);
+      while (Sz > Size - I)
+        Sz /= 2;
+      Type *Ty = intOfSize(Sz);
+      Node *V;
+      if (IsConst) {
+        V = newLong(Pattern, Tok);
+        V->Ty = Ty;
+      } else {
+        V = newCast(Val, Ty);
+      }
+      Node *Set = newBinary(ND_ASSIGN, newDerefAt(Dst, I, Ty, Tok), V, Tok);
+      Nd = newBinary(ND_COMMA, Nd, Set, Tok);
+      I += Sz;
+    }
+    return newCast(newBinary(ND_COMMA, Nd, newVarNode(Dst, Tok), Tok),
+                   Call->Ty);
+  }
+
+  // memcmp(P, Q, N) =>
+  //   (TMP1 = P, TMP2 = Q,
+  //    (R = TMP1[0] - TMP2[0]) ? R : (R = TMP1[1] - TMP2[1]) ? R : ... : 0)
+  // 逐字节比较，只展开不超过8字节的
+  if (!strcmp(Name, "memcmp")) {
+    if (Size > 8)
+      return Call;
+
+    Obj *P = newLVar("", pointerTo(TyUChar));
+    Obj *Q = newLVar("", pointerTo(TyUChar));
+    Obj *R = newLVar("", TyInt);
+    Node *Cmp = newNum(0, Tok);
+    for (int I = Size - 1; I >= 0; I--) {
+      Node *Diff = newBinary(ND_SUB, newDerefAt(P, I, TyUChar, Tok),
+                             newDerefAt(Q, I, TyUChar, Tok), Tok);
+      Node *Cond = newNode(ND_COND, Tok);
+      Cond->Cond = newBinary(ND_ASSIGN, newVarNode(R, Tok), Diff, Tok);
+      Cond->Then = newVarNode(R, Tok);
+      Cond->Els = Cmp;
+      Cmp = Cond;
+    }
+
+    Node *Nd = newBinary(ND_ASSIGN, newVarNode(P, Tok), A[0], Tok);
+    Nd = newBinary(ND_COMMA, Nd,
+                   newBinary(ND_ASSIGN, newVarNode(Q, Tok), A[1], Tok), Tok);
+    return newCast(newBinary(ND_COMMA, Nd, Cmp, Tok), Call->Ty);
+  }
+
+  return Call;
+}
+
 // genericSelection = "(" assign "," generic-assoc ("," generic-assoc)* ")"
 //
 // generic-assoc = type-name ":" assign
@@ -3320,6 +4059,336 @@ static Node *genericSelection(Token **rest, Token *tok) {
 }
 
 // 解析括号、数字、变量
+// 计算常量的前导零、末尾零或为1的位数
+static int bitCount(NodeKind Kind, uint64_t Val, int Bits) {
+  int N = 0;
+  switch (Kind) {
+  case ND_CLZ:
+    while (N < Bits && !(Val >> (Bits - 1 - N) & 1))
+      N++;
+    return N;
+  case ND_CTZ:
+    while (N < Bits && !(Val >> N & 1))
+      N++;
+    return N;
+  default:
+    for (; Val; Val &= Val - 1)
+      N++;
+    return N;
+  }
+}
+
+// 解析位操作的内建函数，不是则返回NULL
+// bitBuiltin = ("__builtin_clz" | "__builtin_ctz" | "__builtin_popcount")
+//              ("l" | "ll")? "(" assign ")"
+// l和ll后缀的版本以unsigned long为参数，否则以unsigned int为参数
+static Node *bitBuiltin(Token **Rest, Token *Tok) {
+  static char *Names[] = {"__builtin_clz", "__builtin_ctz",
+                          "__builtin_popcount"};
+  static NodeKind Kinds[] = {ND_CLZ, ND_CTZ, ND_POPCOUNT};
+
+  for (int I = 0; I < sizeof(Names) / sizeof(*Names); I++) {
+    int Len = strlen(Names[I]);
+    if (Tok->Len < Len || strncmp(Tok->Loc, Names[I], Len))
+      continue;
+    char *Suffix = strndup(Tok->Loc + Len, Tok->Len - Len);
+    if (*Suffix && strcmp(Suffix, "l") && strcmp(Suffix, "ll"))
+      continue;
+
+    Type *Ty = *Suffix ? TyULong : TyUInt;
+    Token *Start = Tok;
+    Tok = skip(Tok->Next, "(");
+    Node *Arg = newCast(assign(&Tok, Tok), Ty);
+    *Rest = skip(Tok, ")");
+
+    // 参数为常量时，直接计算出结果
+    if (isConstExpr(Arg))
+      return newNum(bitCount(Kinds[I], eval(Arg), Ty->Size * 8), Start);
+    return newUnary(Kinds[I], Arg, Start);
+  }
+  return NULL;
+}
+
+// 解析内建函数的N个参数
+static Node **builtinArgs(Token **Rest, Token *Tok, int N) {
+  Node **Args = calloc(N, sizeof(Node *));
+  Tok = skip(Tok, "(");
+  for (int I = 0; I < N; I++) {
+    if (I > 0)
+      Tok = skip(Tok, ",");
+    Args[I] = assign(&Tok, Tok);
+    addType(Args[I]);
+  }
+  *Rest = skip(Tok, ")");
+  return Args;
+}
+
+// 获取内存顺序，不是常量时按顺序一致处理
+static MemoryOrder memOrder(Node *Nd) {
+  if (!isConstExpr(Nd))
+    return MO_SEQ_CST;
+  int64_t Val = eval(Nd);
+  return (Val >= MO_RELAXED && Val <= MO_SEQ_CST) ? Val : MO_SEQ_CST;
+}
+
+// 原子读取：*Ptr
+static Node *newAtomicLoad(Node *Ptr, MemoryOrder Order, Token *Tok) {
+  atomicType(Ptr);
+  Node *Nd = newUnary(ND_ATOMIC_LD, Ptr, Tok);
+  Nd->Order = Order;
+  return Nd;
+}
+
+// 原子写入：*Ptr = Val
+static Node *newAtomicStore(Node *Ptr, Node *Val, MemoryOrder Order,
+                            Token *Tok) {
+  Type *Ty = unatomic(atomicType(Ptr));
+  Node *Nd = newBinary(ND_ATOMIC_ST, Ptr, newCast(Val, Ty), Tok);
+  Nd->Order = Order;
+  return Nd;
+}
+
+static Node *newFence(MemoryOrder Order, Token *Tok) {
+  Node *Nd = newNode(ND_FENCE, Tok);
+  Nd->Order = Order;
+  return Nd;
+}
+
+// 原子读改写的运算
+static struct {
+  char *Name;
+  NodeKind Kind;
+} AtomicOps[] = {
+    {"add", ND_ADD},   {"sub", ND_SUB}, {"and", ND_BITAND},
+    {"or", ND_BITOR},  {"xor", ND_BITXOR}, {"nand", ND_BITNOT},
+};
+
+// 解析原子操作的内建函数，不是则返回NULL
+// 支持GCC的__atomic_*和__sync_*系列内建函数
+static Node *atomicBuiltin(Token **Rest, Token *Tok) {
+  char *Name = strndup(Tok->Loc, Tok->Len);
+  bool IsSync = !strncmp(Name, "__sync_", 7);
+  if (!IsSync && strncmp(Name, "__atomic_", 9))
+    return NULL;
+
+  Token *Start = Tok;
+  Tok = Tok->Next;
+  Node **A;
+
+  // __atomic_fetch_OP、__atomic_OP_fetch
+  // __sync_fetch_and_OP、__sync_OP_and_fetch
+  for (int I = 0; I < sizeof(AtomicOps) / sizeof(*AtomicOps); I++) {
+    char *Op = AtomicOps[I].Name;
+    bool Fetch;
+    char *FetchOp = IsSync ? "__sync_fetch_and_%s" : "__atomic_fetch_%s";
+    char *OpFetch = IsSync ? "__sync_%s_and_fetch" : "__atomic_%s_fetch";
+    if (!strcmp(Name, format(FetchOp, Op)))
+      Fetch = true;
+    else if (!strcmp(Name, format(OpFetch, Op)))
+      Fetch = false;
+    else
+      continue;
+
+    A = builtinArgs(Rest, Tok, IsSync ? 2 : 3);
+    return newAtomicRW(AtomicOps[I].Kind, A[0], A[1], Fetch,
+                       IsSync ? MO_SEQ_CST : memOrder(A[2]), Start);
+  }
+
+  // __atomic_load_n(Ptr, Order)
+  if (!strcmp(Name, "__atomic_load_n")) {
+    A = builtinArgs(Rest, Tok, 2);
+    return newAtomicLoad(A[0], memOrder(A[1]), Start);
+  }
+
+  // __atomic_load(Ptr, Ret, Order)：*Ret = *Ptr
+  if (!strcmp(Name, "__atomic_load")) {
+    A = builtinArgs(Rest, Tok, 3);
+    Node *Ld = newAtomicLoad(A[0], memOrder(A[2]), Start);
+    return newCast(newBinary(ND_ASSIGN, newUnary(ND_DEREF, A[1], Start), Ld,
+                             Start),
+                   TyVoid);
+  }
+
+  // __atomic_store_n(Ptr, Val, Order)
+  if (!strcmp(Name, "__atomic_store_n")) {
+    A = builtinArgs(Rest, Tok, 3);
+    return newAtomicStore(A[0], A[1], memOrder(A[2]), Start);
+  }
+
+  // __atomic_store(Ptr, ValPtr, Order)
+  if (!strcmp(Name, "__atomic_store")) {
+    A = builtinArgs(Rest, Tok, 3);
+    return newAtomicStore(A[0], newUnary(ND_DEREF, A[1], Start),
+                          memOrder(A[2]), Start);
+  }
+
+  // __atomic_exchange_n(Ptr, Val, Order)
+  if (!strcmp(Name, "__atomic_exchange_n")) {
+    A = builtinArgs(Rest, Tok, 3);
+    return newAtomicRW(ND_ASSIGN, A[0], A[1], true, memOrder(A[2]), Start);
+  }
+
+  // __atomic_exchange(Ptr, ValPtr, Ret, Order)
+  if (!strcmp(Name, "__atomic_exchange")) {
+    A = builtinArgs(Rest, Tok, 4);
+    Node *Xchg = newAtomicRW(ND_ASSIGN, A[0], newUnary(ND_DEREF, A[1], Start),
+                             true, memOrder(A[3]), Start);
+    return newCast(newBinary(ND_ASSIGN, newUnary(ND_DEREF, A[2], Start), Xchg,
+                             Start),
+                   TyVoid);
+  }
+
+  // __atomic_compare_exchange_n(Ptr, Expected, Desired, Weak, Succ, Fail)
+  // __atomic_compare_exchange(Ptr, Expected, DesiredPtr, Weak, Succ, Fail)
+  // 使用的lr/sc循环不会虚假失败，Weak被忽略；失败时的内存顺序不强于成功时，
+  // 统一使用成功时的内存顺序
+  if (!strcmp(Name, "__atomic_compare_exchange_n") ||
+      !strcmp(Name, "__atomic_compare_exchange")) {
+    A = builtinArgs(Rest, Tok, 6);
+    Node *New = A[2];
+    if (!strcmp(Name, "__atomic_compare_exchange"))
+      New = newUnary(ND_DEREF, New, Start);
+    return newCas(A[0], A[1], New, memOrder(A[4]), Start);
+  }
+
+  // __atomic_test_and_set(Ptr, Order)：将字节置为1，返回原来是否已置位
+  if (!strcmp(Name, "__atomic_test_and_set")) {
+    A = builtinArgs(Rest, Tok, 2);
+    Node *Ptr = newCast(A[0], pointerTo(TyUChar));
+    return newCast(newAtomicRW(ND_ASSIGN, Ptr, newNum(1, Start), true,
+                               memOrder(A[1]), Start),
+                   TyBool);
+  }
+
+  // __atomic_clear(Ptr, Order)
+  if (!strcmp(Name, "__atomic_clear")) {
+    A = builtinArgs(Rest, Tok, 2);
+    Node *Ptr = newCast(A[0], pointerTo(TyUChar));
+    return newAtomicStore(Ptr, newNum(0, Start), memOrder(A[1]), Start);
+  }
+
+  // __atomic_thread_fence(Order)
+  if (!strcmp(Name, "__atomic_thread_fence")) {
+    A = builtinArgs(Rest, Tok, 1);
+    return newFence(memOrder(A[0]), Start);
+  }
+
+  // __atomic_signal_fence(Order)
+  // 仅需阻止编译器重排，不生成指令
+  if (!strcmp(Name, "__atomic_signal_fence")) {
+    builtinArgs(Rest, Tok, 1);
+    return newFence(MO_RELAXED, Start);
+  }
+
+  // __atomic_always_lock_free(Size, Ptr)、__atomic_is_lock_free(Size, Ptr)
+  // 1、2、4、8字节的对象都可以无锁地访问
+  if (!strcmp(Name, "__atomic_always_lock_free") ||
+      !strcmp(Name, "__atomic_is_lock_free")) {
+    A = builtinArgs(Rest, Tok, 2);
+    int64_t Size = eval(A[0]);
+    return newNum(Size == 1 || Size == 2 || Size == 4 || Size == 8, Start);
+  }
+
+  // __sync_bool_compare_and_swap(Ptr, Old, New)
+  //   => (TMP = Old, CAS(Ptr, &TMP, New))
+  // __sync_val_compare_and_swap(Ptr, Old, New)
+  //   => (TMP = Old, CAS(Ptr, &TMP, New), TMP)
+  if (!strcmp(Name, "__sync_bool_compare_and_swap") ||
+      !strcmp(Name, "__sync_val_compare_and_swap")) {
+    A = builtinArgs(Rest, Tok, 3);
+    Obj *Var = newLVar("", unatomic(atomicType(A[0])));
+    Node *Set = newBinary(ND_ASSIGN, newVarNode(Var, Start), A[1], Start);
+    Node *Cas = newCas(A[0], newUnary(ND_ADDR, newVarNode(Var, Start), Start),
+                       A[2], MO_SEQ_CST, Start);
+    Node *Nd = newBinary(ND_COMMA, Set, Cas, Start);
+    if (!strcmp(Name, "__sync_val_compare_and_swap"))
+      Nd = newBinary(ND_COMMA, Nd, newVarNode(Var, Start), Start);
+    return Nd;
+  }
+
+  // __sync_lock_test_and_set(Ptr, Val)：获取语义的交换
+  if (!strcmp(Name, "__sync_lock_test_and_set")) {
+    A = builtinArgs(Rest, Tok, 2);
+    return newAtomicRW(ND_ASSIGN, A[0], A[1], true, MO_ACQUIRE, Start);
+  }
+
+  // __sync_lock_release(Ptr)：释放语义的写入0
+  if (!strcmp(Name, "__sync_lock_release")) {
+    A = builtinArgs(Rest, Tok, 1);
+    return newAtomicStore(A[0], newNum(0, Start), MO_RELEASE, Start);
+  }
+
+  // __sync_synchronize()
+  if (!strcmp(Name, "__sync_synchronize")) {
+    builtinArgs(Rest, Tok, 0);
+    return newFence(MO_SEQ_CST, Start);
+  }
+
+  return NULL;
+}
+
+// 解析优化提示的内建函数，不是则返回NULL
+// hintBuiltin = "__builtin_expect" "(" assign "," assign ")"
+//             | "__builtin_prefetch" "(" assign ("," constExpr)* ")"
+//             | "__builtin_unreachable" "(" ")"
+//             | "__builtin_assume_aligned" "(" assign "," constExpr
+//               ("," assign)? ")"
+static Node *hintBuiltin(Token **Rest, Token *Tok) {
+  Token *Start = Tok;
+
+  // 值为Exp，预计Exp等于C
+  if (equal(Tok, "__builtin_expect")) {
+    Node **A = builtinArgs(Rest, Tok->Next, 2);
+    Node *Exp = newCast(A[0], TyLong);
+    // C不是常量时，不作为提示
+    if (!isConstExpr(A[1]))
+      return Exp;
+    Node *Nd = newUnary(ND_EXPECT, Exp, Start);
+    Nd->Val = eval(A[1]);
+    return Nd;
+  }
+
+  // 预取Addr处的数据，RW为1时预取用于写入，局部性的提示被忽略
+  if (equal(Tok, "__builtin_prefetch")) {
+    Tok = skip(Tok->Next, "(");
+    Node *Nd = newUnary(ND_PREFETCH, assign(&Tok, Tok), Start);
+    if (consume(&Tok, Tok, ","))
+      Nd->Val = constExpr(&Tok, Tok);
+    if (consume(&Tok, Tok, ","))
+      constExpr(&Tok, Tok);
+    *Rest = skip(Tok, ")");
+    return Nd;
+  }
+
+  if (equal(Tok, "__builtin_unreachable")) {
+    builtinArgs(Rest, Tok->Next, 0);
+    return newNode(ND_UNREACH, Start);
+  }
+
+  // 假定Ptr减去Offset后按Align对齐，值为Ptr
+  if (equal(Tok, "__builtin_assume_aligned")) {
+    Tok = skip(Tok->Next, "(");
+    Node *Nd = newUnary(ND_ALIGNED, assign(&Tok, Tok), Start);
+    Tok = skip(Tok, ",");
+    int64_t Align = constExpr(&Tok, Tok);
+    if (Align <= 0 || (Align & (Align - 1)))
+      errorTok(Start, "requested alignment is not a positive power of 2");
+
+    // 有偏移量时，Ptr只按偏移量的最低位对齐
+    if (consume(&Tok, Tok, ",")) {
+      Node *Offset = assign(&Tok, Tok);
+      int64_t Val = isConstExpr(Offset) ? eval(Offset) % Align : 1;
+      if (Val)
+        Align = Val & -Val;
+    }
+    *Rest = skip(Tok, ")");
+    Nd->Val = Align;
+    return Nd;
+  }
+
+  return NULL;
+}
+
 // primary = "(" "{" stmt+ "}" ")"
 //         | "(" expr ")"
 //         | "sizeof" "(" typeName ")"
@@ -3328,6 +4397,10 @@ static Node *genericSelection(Token **rest, Token *tok) {
 //         | "_Alignof" unary
 //         | "_Generic" genericSelection
 //         | "__builtin_types_compatible_p" "(" typeName, typeName, ")"
+//         | bitBuiltin
+//         | atomicBuiltin
+//         | hintBuiltin
+//         | "__builtin_shuffle" "(" assign ("," assign)? "," assign ")"
 //         | ident
 //         | str
 //         | num
@@ -3405,6 +4478,53 @@ static Node *primary(Token **Rest, Token *Tok) {
     return newNum(isCompatible(T1, T2), Start);
   }
 
+  // bitBuiltin
+  if (Tok->Kind == TK_IDENT) {
+    Node *Nd = bitBuiltin(Rest, Tok);
+    if (Nd)
+      return Nd;
+  }
+
+  // atomicBuiltin
+  if (Tok->Kind == TK_IDENT) {
+    Node *Nd = atomicBuiltin(Rest, Tok);
+    if (Nd)
+      return Nd;
+  }
+
+  // hintBuiltin
+  if (Tok->Kind == TK_IDENT) {
+    Node *Nd = hintBuiltin(Rest, Tok);
+    if (Nd)
+      return Nd;
+  }
+
+  // 按最后一个参数中的下标，从一或两个向量中选取元素
+  if (equal(Tok, "__builtin_shuffle")) {
+    Tok = skip(Tok->Next, "(");
+    Node *Nd = newNode(ND_SHUFFLE, Start);
+    Nd->LHS = assign(&Tok, Tok);
+    Tok = skip(Tok, ",");
+    Node *Mask = assign(&Tok, Tok);
+    if (consume(&Tok, Tok, ",")) {
+      Nd->RHS = Mask;
+      Mask = assign(&Tok, Tok);
+    }
+    Nd->Mask = Mask;
+    *Rest = skip(Tok, ")");
+    addType(Nd);
+    return Nd;
+  }
+
+  // __builtin_memcpy等，调用对应的库函数
+  if (Tok->Kind == TK_IDENT && equal(Tok->Next, "(")) {
+    Obj *Fn = builtinLibFunc(Tok);
+    if (Fn) {
+      *Rest = Tok->Next;
+      return newVarNode(Fn, Tok);
+    }
+  }
+
   // ident
   if (Tok->Kind == TK_IDENT) {
     // 查找变量（或枚举常量）
@@ -3463,7 +4583,7 @@ static Node *primary(Token **Rest, Token *Tok) {
 }
 
 // 解析类型别名
-static Token *parseTypedef(Token *Tok, Type *BaseTy) {
+static Token *parseTypedef(Token *Tok, Type *BaseTy, VarAttr *Attr) {
   bool First = true;
 
   while (!consume(&Tok, Tok, ";")) {
@@ -3474,6 +4594,14 @@ static Token *parseTypedef(Token *Tok, Type *BaseTy) {
     Type *Ty = declarator(&Tok, Tok, BaseTy);
     if (!Ty->Name)
       errorTok(Ty->NamePos, "typedef name omitted");
+    VarAttr Attr2 = {.Align = Attr->Align};
+    Tok = attributeList(Tok, &Attr2);
+    Ty = declVectorType(Ty, &Attr2);
+    // 类型别名可以指定不同的对齐值
+    if (Attr2.Align && Attr2.Align != Ty->Align && Ty->Size >= 0) {
+      Ty = copyType(Ty);
+      Ty->Align = Attr2.Align;
+    }
     // 类型别名的变量名存入变量域中，并设置类型
     pushScope(getIdent(Ty->Name))->Typedef = Ty;
   }
@@ -3514,11 +4642,14 @@ static void resolveGotoLabels(void) {
 }
 
 static Obj *findFunc(char *name) {
-  Scope *Sc = Scp;
-  while (Sc->Next)
-    Sc = Sc->Next;
-
-  VarScope *sc2 = hashmap_get(&Sc->Vars, name);
+  // 取最近一次的文件域声明，函数定义可能位于原型之后
+  Symbol *Sym = hashmap_get(&VarTable, name);
+  while (Sym && Sym->Depth != 0)
+    Sym = Sym->Shadow;
+  if (!Sym)
+    return NULL;
+
+  VarScope *sc2 = Sym->Val;
   if (sc2 && sc2->Var && sc2->Var->IsFunction)
     return sc2->Var;
   return NULL;
@@ -3542,10 +4673,15 @@ static Token *function(Token *Tok, Type *BaseTy, VarAttr *Attr) {
   if (!Ty->Name)
     errorTok(Ty->NamePos, "function name omitted");
 
+  // 声明符之后的属性
+  VarAttr FnAttr = *Attr;
+  Tok = attributeList(Tok, &FnAttr);
+
   Obj *Fn = newGVar(getIdent(Ty->Name), Ty);
   Fn->IsFunction = true;
   Fn->IsDefinition = !consume(&Tok, Tok, ";");
   Fn->IsStatic = Attr->IsStatic || (Attr->IsInline && !Attr->IsExtern);
+  setVisibility(Fn, &FnAttr);
   Fn->IsInline = Attr->IsInline;
   Fn->IsRoot = !(Fn->IsStatic && Fn->IsInline);
 
@@ -3563,7 +4699,9 @@ static Token *function(Token *Tok, Type *BaseTy, VarAttr *Attr) {
 
   // 有大于16字节的结构体返回值的函数
   Type *RTy = Ty->ReturnTy;
-  if ((RTy->Kind == TY_STRUCT || RTy->Kind == TY_UNION) && RTy->Size > 16)
+  if ((RTy->Kind == TY_STRUCT || RTy->Kind == TY_UNION ||
+       RTy->Kind == TY_VECTOR) &&
+      RTy->Size > 16)
     // 第一个形参是隐式的，包含了结构体的地址
     newLVar("", pointerTo(RTy));
 
@@ -3586,8 +4724,10 @@ static Token *function(Token *Tok, Type *BaseTy, VarAttr *Attr) {
       newStringLiteral(Fn->Name, arrayOf(TyChar, strlen(Fn->Name) + 1));
 
   // 函数体存储语句的AST，Locals存储变量
+  TLSAccesses = NULL;
   Fn->Body = compoundStmt(&Tok, Tok);
   Fn->Locals = Locals;
+  CurrentFn = NULL;
   // 结束当前域
   leaveScope();
   // 处理goto和标签
@@ -3607,6 +4747,11 @@ static Token *globalVariable(Token *Tok, Type *Basety, VarAttr *Attr) {
     Type *Ty = declarator(&Tok, Tok, Basety);
     if (!Ty->Name)
       errorTok(Ty->NamePos, "variable name omitted");
+    // 声明符之后的属性，只作用于当前变量
+    VarAttr VarAttr2 = *Attr;
+    Tok = attributeList(Tok, &VarAttr2);
+    Ty = declVectorType(Ty, &VarAttr2);
+
     // 全局变量初始化
     Obj *Var = newGVar(getIdent(Ty->Name), Ty);
     // 是否具有定义
@@ -3614,9 +4759,10 @@ static Token *globalVariable(Token *Tok, Type *Basety, VarAttr *Attr) {
     // 传递是否为static
     Var->IsStatic = Attr->IsStatic;
     Var->IsTLS = Attr->IsTLS;
-    // 若有设置，则覆盖全局变量的对齐值
-    if (Attr->Align)
-      Var->Align = Attr->Align;
+    Var->TLSModel = VarAttr2.TLSModel;
+    setVisibility(Var, &VarAttr2);
+    // 若有设置，则增大全局变量的对齐值
+    Var->Align = MAX(Var->Align, VarAttr2.Align);
 
     if (equal(Tok, "="))
       GVarInitializer(&Tok, Tok->Next, Var);
@@ -3683,7 +4829,7 @@ Obj *parse(Token *Tok) {
 
     // typedef
     if (Attr.IsTypedef) {
-      Tok = parseTypedef(Tok, BaseTy);
+      Tok = parseTypedef(Tok, BaseTy, &Attr);
       continue;
     }
 
@@ -0,0 +1,1680 @@
+// 窥孔优化
+//
+// 在-O1及以上时，将每个函数生成的汇编代码解析为指令的记录，
+// 在记录上进行局部的优化，再重新输出：
+//   将li折叠进立即数形式的指令，将addi折叠进访存的偏移量，
+//   用寄存器代替压栈弹栈，复制传播，将存储转发给之后的加载，
+//   合并比较与分支，跳转线程化，删除不可达和结果无用的指令。
+// 最后在基本块内进行指令调度，隐藏加载和乘除法的延迟。
+// 无法识别的指令（如内联汇编）和指示视为读写所有寄存器的屏障。
+
+#include "rvcc.h"
+
+// 优化级别，-O1及以上时进行窥孔优化
+int OptOLevel;
+
+// 记录的种类
+typedef enum {
+  IK_INSN,    // 可识别的指令
+  IK_LABEL,   // 标签
+  IK_LOC,     // .loc指示
+  IK_BARRIER, // 其他指示和无法识别的指令
+} InsnKind;
+
+// 指令的类别
+typedef enum {
+  IC_ALU,    // 第一个操作数为目的寄存器，其余的寄存器为源寄存器
+  IC_LI,     // 第一个操作数为目的寄存器，其余为立即数或符号
+  IC_LOAD,   // 加载
+  IC_STORE,  // 存储
+  IC_BRANCH, // 条件分支，最后一个操作数为标签
+  IC_JUMP,   // 无条件跳转
+  IC_CALL,   // 函数调用
+  IC_RET,    // 返回
+} InsnClass;
+
+#define MAX_ARGS 4
+
+// 指令的记录
+typedef struct {
+  InsnKind Kind;
+  InsnClass Class;
+  char *Op;             // 操作码，或标签名
+  char *Args[MAX_ARGS]; // 操作数
+  int NArgs;            // 操作数的数量
+  char *Line;           // 原始的行，用于输出屏障和.loc
+  bool Dead;            // 已被删除
+  uint64_t Use, Def;    // 读、写的寄存器
+  uint64_t LiveOut;     // 指令之后活跃的寄存器
+  int Target;           // 跳转目标标签的下标，-1为未知
+} Insn;
+
+// 一个函数的所有记录
+typedef struct {
+  Insn *Insns;
+  int Len;
+  HashMap Labels; // 标签名到下标+1
+} Func;
+
+//
+// 寄存器
+//
+
+// 寄存器的集合，0~31为整型寄存器，32~63为浮点寄存器
+#define REG(N) (1ULL << (N))
+#define ALL_REGS (~0ULL)
+
+static char *RegNames[64] = {
+    "zero", "ra", "sp",  "gp",   "tp",   "t0",  "t1",  "t2",
+    "fp",   "s1", "a0",  "a1",   "a2",   "a3",  "a4",  "a5",
+    "a6",   "a7", "s2",  "s3",   "s4",   "s5",  "s6",  "s7",
+    "s8",   "s9", "s10", "s11",  "t3",   "t4",  "t5",  "t6",
+    "ft0",  "ft1", "ft2", "ft3", "ft4",  "ft5", "ft6", "ft7",
+    "fs0",  "fs1", "fa0", "fa1", "fa2",  "fa3", "fa4", "fa5",
+    "fa6",  "fa7", "fs2", "fs3", "fs4",  "fs5", "fs6", "fs7",
+    "fs8",  "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11",
+};
+
+#define REG_ZERO 0
+#define REG_SP 2
+#define REG_FP 8
+#define REG_A0 10
+#define REG_A1 11
+#define REG_FA0 42
+#define REG_FA1 43
+
+// 传递参数的寄存器：a0~a7，fa0~fa7
+#define ARG_REGS ((0xffULL << REG_A0) | (0xffULL << REG_FA0))
+// 返回值的寄存器：a0、a1、fa0、fa1
+#define RET_REGS (REG(REG_A0) | REG(REG_A1) | REG(REG_FA0) | REG(REG_FA1))
+// 始终视为活跃的寄存器：zero、ra、sp、gp、tp、fp、s1~s11、fs0~fs11
+#define FIXED_REGS                                                             \
+  (0x1fULL | REG(REG_FP) | REG(9) | (0x3ffULL << 18) | (0x3ULL << 40) |        \
+   (0x3ffULL << 50))
+// 循环中保存不变量和数组元素地址的寄存器：s1~s11
+#define SAVED_REGS (REG(9) | (0x3ffULL << 18))
+
+// 用寄存器代替压栈弹栈时，可用的临时寄存器
+// 优先使用x8~x15中的a2~a5，以便压缩为RVC指令
+static int IntTemps[] = {15, 14, 13, 12, 28, 29, 30, 31, 16, 17};
+static int FloatTemps[] = {44, 45, 46, 47, 48, 49};
+
+// 获取寄存器的编号，不是寄存器时返回-1
+static int regNum(char *Name) {
+  if (!Name)
+    return -1;
+  if (!strcmp(Name, "s0"))
+    return REG_FP;
+  for (int I = 0; I < 64; I++)
+    if (!strcmp(Name, RegNames[I]))
+      return I;
+  return -1;
+}
+
+static bool isFloatReg(int R) { return R >= 32; }
+
+//
+// 操作数
+//
+
+// 解析整数，整个字符串都需要是数字
+static bool isNum(char *S, int64_t *Val) {
+  if (!S || !*S)
+    return false;
+  char *End;
+  errno = 0;
+  *Val = strtoll(S, &End, 0);
+  return *End == '\0' && errno == 0;
+}
+
+// 判断是否为12位有符号立即数
+static bool fitsImm12(int64_t Val) { return -2048 <= Val && Val <= 2047; }
+
+// 获取访存操作数off(base)的基址寄存器，不是访存操作数时返回-1
+static int memBase(char *Arg) {
+  int Len = strlen(Arg);
+  if (Len < 3 || Arg[Len - 1] != ')')
+    return -1;
+  char *LParen = strrchr(Arg, '(');
+  if (!LParen)
+    return -1;
+  char *Base = strndup(LParen + 1, Arg + Len - 1 - LParen - 1);
+  int R = regNum(Base);
+  free(Base);
+  return R;
+}
+
+// 获取访存操作数的偏移量，偏移量不是数字时返回假
+static bool memOff(char *Arg, int64_t *Off) {
+  char *LParen = strrchr(Arg, '(');
+  if (LParen == Arg) {
+    *Off = 0;
+    return true;
+  }
+  char *S = strndup(Arg, LParen - Arg);
+  bool Ok = isNum(S, Off);
+  free(S);
+  return Ok;
+}
+
+// 判断两个访存操作数是否为同一个地址
+static bool sameMem(char *A, char *B) {
+  int64_t X, Y;
+  return memBase(A) == memBase(B) && memOff(A, &X) && memOff(B, &Y) && X == Y;
+}
+
+//
+// 指令的分类
+//
+
+static char *AluOps[] = {
+    "mv",    "not",   "neg",   "negw",  "sext.w", "seqz",  "snez",
+    "sltz",  "sgtz",  "add",   "addw",  "addi",   "addiw", "sub",
+    "subw",  "and",   "andi",  "or",    "ori",    "xor",   "xori",
+    "sll",   "slli",  "sllw",  "slliw", "srl",    "srli",  "srlw",
+    "srliw", "sra",   "srai",  "sraw",  "sraiw",  "slt",   "slti",
+    "sltu",  "sltiu", "mul",   "mulw",  "mulh",   "mulhu", "mulhsu",
+    "div",   "divu",  "divw",  "divuw", "rem",    "remu",  "remw",
+    "remuw",
+    // Zba、Zbb、Zbs扩展
+    "sh1add", "sh2add", "sh3add", "add.uw", "sh1add.uw", "sh2add.uw",
+    "sh3add.uw", "zext.w", "andn", "orn", "xnor", "min", "max", "minu",
+    "maxu", "rol", "rolw", "ror", "rorw", "rori", "roriw", "clz", "clzw",
+    "ctz", "ctzw", "cpop", "cpopw", "sext.b", "sext.h", "zext.h", "bset",
+    "bseti", "bclr", "bclri", "binv", "binvi", "bext", "bexti", NULL,
+};
+
+// 浮点运算指令的前缀，这些指令的第一个操作数都为目的寄存器
+static char *FloatAluPrefixes[] = {
+    "fadd.",  "fsub.",   "fmul.",   "fdiv.",   "fsqrt.", "fsgnj",
+    "fmin.",  "fmax.",   "fcvt.",   "fmv.",    "feq.",   "flt.",
+    "fle.",   "fneg.",   "fabs.",   "fclass.", "fmadd.", "fmsub.",
+    "fnmadd.", "fnmsub.", NULL,
+};
+
+static char *LiOps[] = {"li", "lui", "auipc", "la", "lla", NULL};
+static char *LoadOps[] = {"lb", "lbu", "lh",  "lhu", "lw",
+                          "lwu", "ld", "flw", "fld", NULL};
+static char *StoreOps[] = {"sb", "sh", "sw", "sd", "fsw", "fsd", NULL};
+static char *Branch1Ops[] = {"beqz", "bnez", "blez", "bgez",
+                             "bltz", "bgtz", NULL};
+static char *Branch2Ops[] = {"beq", "bne", "blt",  "bge",  "bltu",
+                             "bgeu", "bgt", "ble", "bgtu", "bleu", NULL};
+
+static bool inList(char **List, char *Op) {
+  for (int I = 0; List[I]; I++)
+    if (!strcmp(List[I], Op))
+      return true;
+  return false;
+}
+
+static bool hasPrefix(char **List, char *Op) {
+  for (int I = 0; List[I]; I++)
+    if (!strncmp(List[I], Op, strlen(List[I])))
+      return true;
+  return false;
+}
+
+// 将寄存器操作数加入到集合中
+static void addReg(uint64_t *Set, char *Arg) {
+  int R = regNum(Arg);
+  if (R >= 0)
+    *Set |= REG(R);
+}
+
+// 根据操作码对指令分类，并计算读写的寄存器，无法识别时返回假
+static bool classify(Insn *I) {
+  I->Use = I->Def = 0;
+  char *Op = I->Op;
+  int N = I->NArgs;
+
+  if (inList(AluOps, Op) || hasPrefix(FloatAluPrefixes, Op)) {
+    if (N < 1 || regNum(I->Args[0]) < 0)
+      return false;
+    I->Class = IC_ALU;
+    addReg(&I->Def, I->Args[0]);
+    for (int J = 1; J < N; J++)
+      addReg(&I->Use, I->Args[J]);
+    return true;
+  }
+
+  if (inList(LiOps, Op)) {
+    if (N != 2 || regNum(I->Args[0]) < 0)
+      return false;
+    I->Class = IC_LI;
+    addReg(&I->Def, I->Args[0]);
+    return true;
+  }
+
+  if (inList(LoadOps, Op)) {
+    if (N != 2 || regNum(I->Args[0]) < 0)
+      return false;
+    I->Class = IC_LOAD;
+    addReg(&I->Def, I->Args[0]);
+    int Base = memBase(I->Args[1]);
+    if (Base >= 0)
+      I->Use |= REG(Base);
+    return true;
+  }
+
+  if (inList(StoreOps, Op)) {
+    if (N < 2 || regNum(I->Args[0]) < 0)
+      return false;
+    I->Class = IC_STORE;
+    addReg(&I->Use, I->Args[0]);
+    int Base = memBase(I->Args[1]);
+    if (Base >= 0 && N == 2)
+      I->Use |= REG(Base);
+    else if (Base < 0 && N == 3)
+      // 存储到符号的伪指令，第三个操作数为临时寄存器
+      addReg(&I->Def, I->Args[2]);
+    else
+      return false;
+    return true;
+  }
+
+  if (inList(Branch1Ops, Op) || inList(Branch2Ops, Op)) {
+    int NRegs = inList(Branch1Ops, Op) ? 1 : 2;
+    if (N != NRegs + 1)
+      return false;
+    I->Class = IC_BRANCH;
+    for (int J = 0; J < NRegs; J++)
+      addReg(&I->Use, I->Args[J]);
+    return true;
+  }
+
+  if (!strcmp(Op, "j") && N == 1) {
+    I->Class = IC_JUMP;
+    return true;
+  }
+
+  if (!strcmp(Op, "call") && N == 1) {
+    // 只将返回值的寄存器视为被写入，从而保守地估计活跃的寄存器
+    I->Class = IC_CALL;
+    I->Use = ARG_REGS;
+    I->Def = RET_REGS;
+    return true;
+  }
+
+  if (!strcmp(Op, "ret") && N == 0) {
+    I->Class = IC_RET;
+    I->Use = RET_REGS | FIXED_REGS;
+    return true;
+  }
+
+  return false;
+}
+
+// 输出一个记录
+static void printInsn(FILE *Out, Insn *I) {
+  fprintf(Out, "  %s", I->Op);
+  for (int J = 0; J < I->NArgs; J++)
+    fprintf(Out, "%s%s", J ? ", " : " ", I->Args[J]);
+  fprintf(Out, "\n");
+}
+
+// 改写指令
+static void setInsn(Insn *I, char *Op, int NArgs, char *Arg0, char *Arg1,
+                    char *Arg2) {
+  I->Kind = IK_INSN;
+  I->Op = Op;
+  I->NArgs = NArgs;
+  I->Args[0] = Arg0;
+  I->Args[1] = Arg1;
+  I->Args[2] = Arg2;
+  I->Target = -1;
+  if (!classify(I))
+    unreachable();
+}
+
+//
+// 解析
+//
+
+static char *skipSpace(char *S) {
+  while (*S == ' ' || *S == '\t')
+    S++;
+  return S;
+}
+
+// 去掉字符串末尾的空白
+static char *trimEnd(char *S) {
+  int Len = strlen(S);
+  while (Len > 0 && (S[Len - 1] == ' ' || S[Len - 1] == '\t'))
+    S[--Len] = '\0';
+  return S;
+}
+
+// 解析一行代码，空行和注释返回假
+static bool parseLine(char *Line, Insn *I) {
+  *I = (Insn){};
+  I->Target = -1;
+  char *S = trimEnd(skipSpace(Line));
+  if (!*S || *S == '#')
+    return false;
+  I->Line = S;
+
+  if (!strncmp(S, ".loc ", 5)) {
+    I->Kind = IK_LOC;
+    return true;
+  }
+
+  // 标签
+  int Len = strlen(S);
+  if (S[Len - 1] == ':' && !strpbrk(S, " \t\"")) {
+    I->Kind = IK_LABEL;
+    I->Op = strndup(S, Len - 1);
+    return true;
+  }
+
+  I->Kind = IK_BARRIER;
+  if (*S == '.' || strpbrk(S, ";\"#"))
+    return true;
+
+  // 操作码
+  char *P = S;
+  while (*P && *P != ' ' && *P != '\t')
+    P++;
+  I->Op = strndup(S, P - S);
+
+  // 以逗号分隔的操作数
+  P = skipSpace(P);
+  while (*P) {
+    if (I->NArgs == MAX_ARGS)
+      return true;
+    char *Comma = strchr(P, ',');
+    char *End = Comma ? Comma : P + strlen(P);
+    I->Args[I->NArgs++] = trimEnd(strndup(P, End - P));
+    P = Comma ? skipSpace(Comma + 1) : End;
+  }
+
+  if (classify(I))
+    I->Kind = IK_INSN;
+  return true;
+}
+
+// 获取跳转指令的目标标签
+static char *targetName(Insn *I) { return I->Args[I->NArgs - 1]; }
+
+// 查找跳转指令的目标
+static void resolveTarget(Func *F, Insn *I) {
+  I->Target = (intptr_t)hashmap_get(&F->Labels, targetName(I)) - 1;
+}
+
+static void parseFunc(Func *F, char *Buf) {
+  int Cap = 0;
+  for (char *Line = Buf; *Line;) {
+    char *End = strchr(Line, '\n');
+    char *Next = End ? End + 1 : Line + strlen(Line);
+    if (End)
+      *End = '\0';
+    if (F->Len == Cap) {
+      Cap = Cap ? Cap * 2 : 256;
+      F->Insns = realloc(F->Insns, sizeof(Insn) * Cap);
+    }
+    bool Ok = parseLine(Line, &F->Insns[F->Len]);
+    Line = Next;
+    if (!Ok)
+      continue;
+    Insn *I = &F->Insns[F->Len];
+    if (I->Kind == IK_LABEL)
+      hashmap_put(&F->Labels, I->Op, (void *)(intptr_t)(F->Len + 1));
+    F->Len++;
+  }
+
+  for (int I = 0; I < F->Len; I++) {
+    Insn *In = &F->Insns[I];
+    if (In->Kind == IK_INSN &&
+        (In->Class == IC_BRANCH || In->Class == IC_JUMP))
+      resolveTarget(F, In);
+  }
+}
+
+//
+// 遍历
+//
+
+// 判断记录是否为需要执行的指令
+static bool isInsn(Insn *I) {
+  return !I->Dead && (I->Kind == IK_INSN || I->Kind == IK_BARRIER);
+}
+
+// 判断标签是否为%pcrel_lo引用的标签，这类标签不是基本块的边界
+static bool isPCRelLabel(Insn *I) { return !strncmp(I->Op, ".Lpcrel_hi", 10); }
+
+// 获取基本块内的下一条指令，到达基本块的末尾时返回-1
+static int nextInBlock(Func *F, int I) {
+  Insn *Cur = &F->Insns[I];
+  if (Cur->Kind != IK_INSN || Cur->Class == IC_JUMP || Cur->Class == IC_RET)
+    return -1;
+  for (int J = I + 1; J < F->Len; J++) {
+    Insn *In = &F->Insns[J];
+    if (In->Dead || In->Kind == IK_LOC)
+      continue;
+    if (In->Kind == IK_LABEL && isPCRelLabel(In))
+      continue;
+    if (In->Kind != IK_INSN)
+      return -1;
+    return J;
+  }
+  return -1;
+}
+
+// 获取基本块内的上一条指令
+static int prevInBlock(Func *F, int I) {
+  for (int J = I - 1; J >= 0; J--) {
+    Insn *In = &F->Insns[J];
+    if (In->Dead || In->Kind == IK_LOC)
+      continue;
+    if (In->Kind == IK_LABEL && isPCRelLabel(In))
+      continue;
+    if (In->Kind != IK_INSN || In->Class == IC_JUMP || In->Class == IC_RET)
+      return -1;
+    return J;
+  }
+  return -1;
+}
+
+// 获取下标I之后（含I）的第一条指令，跳过标签
+static int firstInsnFrom(Func *F, int I) {
+  for (; I < F->Len; I++)
+    if (isInsn(&F->Insns[I]))
+      return I;
+  return -1;
+}
+
+//
+// 活跃变量分析
+//
+
+// 记录之前活跃的寄存器
+static uint64_t liveIn(Func *F, int I, uint64_t *In) {
+  return I < F->Len ? In[I] : ALL_REGS;
+}
+
+// 反向迭代直至不动点，计算每条指令之后活跃的寄存器
+static void computeLiveness(Func *F) {
+  uint64_t *In = calloc(F->Len + 1, sizeof(uint64_t));
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (int I = F->Len - 1; I >= 0; I--) {
+      Insn *Cur = &F->Insns[I];
+      uint64_t Out, Live;
+      if (Cur->Dead || Cur->Kind == IK_LABEL || Cur->Kind == IK_LOC) {
+        Out = Live = liveIn(F, I + 1, In);
+      } else if (Cur->Kind == IK_BARRIER) {
+        Out = Live = ALL_REGS;
+      } else {
+        switch (Cur->Class) {
+        case IC_JUMP:
+          Out = Cur->Target >= 0 ? In[Cur->Target] : ALL_REGS;
+          break;
+        case IC_BRANCH:
+          Out = liveIn(F, I + 1, In) |
+                (Cur->Target >= 0 ? In[Cur->Target] : ALL_REGS);
+          break;
+        case IC_RET:
+          Out = 0;
+          break;
+        default:
+          Out = liveIn(F, I + 1, In);
+          break;
+        }
+        Live = Cur->Use | (Out & ~Cur->Def);
+      }
+      Cur->LiveOut = Out;
+      if (In[I] != Live) {
+        In[I] = Live;
+        Changed = true;
+      }
+    }
+  }
+  free(In);
+}
+
+//
+// 优化
+//
+
+// 立即数形式的指令
+typedef struct {
+  char *Op;         // 寄存器形式
+  char *ImmOp;      // 立即数形式
+  bool Commutative; // 是否可交换操作数
+  int Shift;        // 移位指令的位数，0表示不是移位指令
+} ImmForm;
+
+static ImmForm ImmForms[] = {
+    {"add", "addi", true, 0},    {"addw", "addiw", true, 0},
+    {"and", "andi", true, 0},    {"or", "ori", true, 0},
+    {"xor", "xori", true, 0},    {"sub", "addi", false, 0},
+    {"subw", "addiw", false, 0}, {"slt", "slti", false, 0},
+    {"sltu", "sltiu", false, 0}, {"sll", "slli", false, 64},
+    {"srl", "srli", false, 64},  {"sra", "srai", false, 64},
+    {"sllw", "slliw", false, 32}, {"srlw", "srliw", false, 32},
+    {"sraw", "sraiw", false, 32}, {NULL},
+};
+
+static ImmForm *findImmForm(char *Op) {
+  for (ImmForm *Form = ImmForms; Form->Op; Form++)
+    if (!strcmp(Form->Op, Op))
+      return Form;
+  return NULL;
+}
+
+// 替换指令中读取的寄存器，返回是否有改动
+static bool replaceUse(Insn *In, int From, int To) {
+  bool Changed = false;
+  switch (In->Class) {
+  case IC_ALU:
+    for (int J = 1; J < In->NArgs; J++)
+      if (regNum(In->Args[J]) == From) {
+        In->Args[J] = RegNames[To];
+        Changed = true;
+      }
+    break;
+  case IC_BRANCH:
+    for (int J = 0; J < In->NArgs - 1; J++)
+      if (regNum(In->Args[J]) == From) {
+        In->Args[J] = RegNames[To];
+        Changed = true;
+      }
+    break;
+  case IC_STORE:
+    if (regNum(In->Args[0]) == From) {
+      In->Args[0] = RegNames[To];
+      Changed = true;
+    }
+    // fallthrough
+  case IC_LOAD: {
+    int64_t Off;
+    // 基址不能为zero
+    if (To != REG_ZERO && memBase(In->Args[1]) == From &&
+        memOff(In->Args[1], &Off)) {
+      In->Args[1] = format("%ld(%s)", Off, RegNames[To]);
+      Changed = true;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  if (Changed)
+    classify(In);
+  return Changed;
+}
+
+// 已知寄存器R的值为常量Val，改写读取R的指令In
+static bool foldConst(Insn *In, int R, int64_t Val) {
+  // mv rd, R -> li rd, Val
+  if (In->Class == IC_ALU && !strcmp(In->Op, "mv")) {
+    setInsn(In, "li", 2, In->Args[0], format("%ld", Val), NULL);
+    return true;
+  }
+
+  // 根据常量判断分支是否跳转
+  if (In->Class == IC_BRANCH &&
+      (!strcmp(In->Op, "beqz") || !strcmp(In->Op, "bnez"))) {
+    bool Taken = (Val == 0) == !strcmp(In->Op, "beqz");
+    if (Taken) {
+      int Target = In->Target;
+      setInsn(In, "j", 1, In->Args[1], NULL, NULL);
+      In->Target = Target;
+    } else {
+      In->Dead = true;
+    }
+    return true;
+  }
+
+  // op rd, rs, R -> opi rd, rs, Val
+  ImmForm *Form = In->Class == IC_ALU && In->NArgs == 3 &&
+                          regNum(In->Args[1]) >= 0 && regNum(In->Args[2]) >= 0
+                      ? findImmForm(In->Op)
+                      : NULL;
+  if (Form) {
+    bool IsSub = !strcmp(Form->Op, "sub") || !strcmp(Form->Op, "subw");
+    int64_t V = IsSub ? -Val : Val;
+    bool Fits = Form->Shift ? 0 <= V && V < Form->Shift : fitsImm12(V);
+    char *Other = NULL;
+    if (regNum(In->Args[2]) == R && regNum(In->Args[1]) != R)
+      Other = In->Args[1];
+    else if (Form->Commutative && regNum(In->Args[1]) == R &&
+             regNum(In->Args[2]) != R)
+      Other = In->Args[2];
+    if (Fits && Other) {
+      setInsn(In, Form->ImmOp, 3, In->Args[0], Other, format("%ld", V));
+      return true;
+    }
+  }
+
+  // 值为0的寄存器可以用zero代替
+  if (Val == 0)
+    return replaceUse(In, R, REG_ZERO);
+  return false;
+}
+
+// 将li的常量传播到之后的指令中
+static bool foldImm(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Li = &F->Insns[I];
+    int64_t Val;
+    if (Li->Dead || Li->Kind != IK_INSN || strcmp(Li->Op, "li") ||
+        !isNum(Li->Args[1], &Val))
+      continue;
+    int R = regNum(Li->Args[0]);
+    if (isFloatReg(R) || (REG(R) & FIXED_REGS))
+      continue;
+
+    for (int J = nextInBlock(F, I); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (In->Class == IC_CALL)
+        break;
+      if (In->Use & REG(R)) {
+        Changed |= foldConst(In, R, Val);
+        if (In->Dead)
+          continue;
+      }
+      if (In->Def & REG(R))
+        break;
+    }
+  }
+  return Changed;
+}
+
+// 将addi的偏移量折叠进之后的访存指令
+static bool foldAddr(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Add = &F->Insns[I];
+    int64_t Val;
+    if (Add->Dead || Add->Kind != IK_INSN || strcmp(Add->Op, "addi") ||
+        !isNum(Add->Args[2], &Val))
+      continue;
+    int A = regNum(Add->Args[0]);
+    int B = regNum(Add->Args[1]);
+    if (A == B || (REG(A) & FIXED_REGS))
+      continue;
+
+    for (int J = nextInBlock(F, I); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (In->Class == IC_CALL)
+        break;
+      if (In->Use & REG(A)) {
+        int64_t Off;
+        bool IsMem = In->Class == IC_LOAD || In->Class == IC_STORE;
+        if (IsMem && memBase(In->Args[1]) == A &&
+            (In->Class == IC_LOAD || regNum(In->Args[0]) != A) &&
+            memOff(In->Args[1], &Off) && fitsImm12(Off + Val)) {
+          In->Args[1] = format("%ld(%s)", Off + Val, RegNames[B]);
+          classify(In);
+          Changed = true;
+        } else if (In->Class == IC_ALU && !strcmp(In->Op, "addi") &&
+                   regNum(In->Args[1]) == A && isNum(In->Args[2], &Off) &&
+                   fitsImm12(Off + Val)) {
+          setInsn(In, "addi", 3, In->Args[0], RegNames[B],
+                  format("%ld", Off + Val));
+          Changed = true;
+        } else {
+          break;
+        }
+      }
+      if (In->Def & (REG(A) | REG(B)))
+        break;
+    }
+  }
+  return Changed;
+}
+
+// 判断是否为寄存器间的复制
+static bool isCopy(Insn *I) {
+  return !I->Dead && I->Kind == IK_INSN && I->NArgs == 2 &&
+         (!strcmp(I->Op, "mv") || !strcmp(I->Op, "fmv.d") ||
+          !strcmp(I->Op, "fmv.s")) &&
+         regNum(I->Args[1]) >= 0;
+}
+
+// 复制传播：mv A, B之后读取A的指令改为读取B
+static bool propagateCopies(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Mv = &F->Insns[I];
+    if (!isCopy(Mv))
+      continue;
+    int A = regNum(Mv->Args[0]);
+    int B = regNum(Mv->Args[1]);
+    // B可以为s1~s11，它们只在循环前被写入
+    if (A == B || (REG(A) & FIXED_REGS) ||
+        (REG(B) & FIXED_REGS & ~SAVED_REGS))
+      continue;
+
+    for (int J = nextInBlock(F, I); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (In->Class == IC_CALL)
+        break;
+      if (In->Use & REG(A))
+        Changed |= replaceUse(In, A, B);
+      if (In->Def & (REG(A) | REG(B)))
+        break;
+    }
+  }
+  return Changed;
+}
+
+// 存储到加载的转发：从刚存入的地址加载时，直接使用存入的寄存器
+static bool forwardStores(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *St = &F->Insns[I];
+    if (St->Dead || St->Kind != IK_INSN || St->Class != IC_STORE ||
+        St->NArgs != 2)
+      continue;
+    int R = regNum(St->Args[0]);
+    int Base = memBase(St->Args[1]);
+    int64_t Off;
+    if (R == REG_ZERO || !memOff(St->Args[1], &Off))
+      continue;
+    // 只处理栈上的变量，其他地址可能为volatile的变量
+    if (Base != REG_FP && Base != REG_SP)
+      continue;
+
+    for (int J = nextInBlock(F, I); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (In->Class == IC_STORE || In->Class == IC_CALL)
+        break;
+      if (In->Class == IC_LOAD && sameMem(In->Args[1], St->Args[1])) {
+        char *Rd = In->Args[0];
+        char *Rs = St->Args[0];
+        char *Ld = In->Op;
+        char *Sd = St->Op;
+        if (!strcmp(Sd, "sd") && !strcmp(Ld, "ld"))
+          setInsn(In, "mv", 2, Rd, Rs, NULL);
+        else if (!strcmp(Sd, "sw") && !strcmp(Ld, "lw"))
+          setInsn(In, "sext.w", 2, Rd, Rs, NULL);
+        else if (!strcmp(Sd, "sb") && !strcmp(Ld, "lbu"))
+          setInsn(In, "andi", 3, Rd, Rs, "255");
+        else if (!strcmp(Sd, "fsd") && !strcmp(Ld, "fld"))
+          setInsn(In, "fmv.d", 2, Rd, Rs, NULL);
+        else if (!strcmp(Sd, "fsw") && !strcmp(Ld, "flw"))
+          setInsn(In, "fmv.s", 2, Rd, Rs, NULL);
+        else
+          break;
+        Changed = true;
+      }
+      if (In->Def & (REG(R) | REG(Base)))
+        break;
+    }
+  }
+  return Changed;
+}
+
+// 获取访存指令读写的字节数
+static int memSize(char *Op) {
+  // 跳过浮点访存指令的f，第二个字符为宽度
+  if (*Op == 'f')
+    Op++;
+  switch (Op[1]) {
+  case 'b':
+    return 1;
+  case 'h':
+    return 2;
+  case 'w':
+    return 4;
+  default:
+    return 8;
+  }
+}
+
+// 删除被覆盖的存储：之后的存储完全覆盖了写入的字节，且中间没有读取内存
+static bool removeDeadStores(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *St = &F->Insns[I];
+    int64_t Off, Off2;
+    if (St->Dead || St->Kind != IK_INSN || St->Class != IC_STORE ||
+        St->NArgs != 2 || !memOff(St->Args[1], &Off))
+      continue;
+    // 只处理栈上的变量，其他地址可能为volatile的变量
+    int Base = memBase(St->Args[1]);
+    if (Base != REG_FP && Base != REG_SP)
+      continue;
+    int Size = memSize(St->Op);
+
+    for (int J = nextInBlock(F, I); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (In->Class == IC_LOAD || In->Class == IC_CALL ||
+          In->Class == IC_BRANCH)
+        break;
+      if (In->Class == IC_STORE && In->NArgs == 2 &&
+          memBase(In->Args[1]) == Base && memOff(In->Args[1], &Off2) &&
+          Off2 <= Off && Off + Size <= Off2 + memSize(In->Op)) {
+        St->Dead = true;
+        Changed = true;
+        break;
+      }
+      if (In->Def & REG(Base))
+        break;
+    }
+  }
+  return Changed;
+}
+
+// 判断是否为调整sp的指令：addi sp, sp, Val
+static bool isSPAdjust(Insn *I, int64_t Val) {
+  int64_t V;
+  return I->Kind == IK_INSN && !strcmp(I->Op, "addi") &&
+         regNum(I->Args[0]) == REG_SP && regNum(I->Args[1]) == REG_SP &&
+         isNum(I->Args[2], &V) && V == Val;
+}
+
+// 判断是否为sp处的访存：Op R, 0(sp)
+static bool isStackSlot(Insn *I, char *Op) {
+  int64_t Off;
+  return I->Kind == IK_INSN && !strcmp(I->Op, Op) && I->NArgs == 2 &&
+         memBase(I->Args[1]) == REG_SP && memOff(I->Args[1], &Off) && Off == 0;
+}
+
+// 判断是否为相对sp访问压栈的值之上的栈内变量
+static bool isAboveSlot(Insn *I) {
+  int64_t Off;
+  if ((I->Class == IC_LOAD || I->Class == IC_STORE) && I->NArgs == 2)
+    return memBase(I->Args[1]) == REG_SP && regNum(I->Args[0]) != REG_SP &&
+           memOff(I->Args[1], &Off) && Off >= 8;
+  return I->Class == IC_ALU && !strcmp(I->Op, "addi") &&
+         regNum(I->Args[0]) != REG_SP && regNum(I->Args[1]) == REG_SP &&
+         isNum(I->Args[2], &Off) && Off >= 8;
+}
+
+// 删除压栈后，相对sp的偏移量减少8
+static void adjustSPOffset(Insn *I) {
+  int64_t Off;
+  if (I->Class == IC_ALU) {
+    isNum(I->Args[2], &Off);
+    I->Args[2] = format("%ld", Off - 8);
+  } else {
+    memOff(I->Args[1], &Off);
+    I->Args[1] = format("%ld(sp)", Off - 8);
+  }
+}
+
+// 删除压栈和弹栈后，调整其间相对sp的访存
+static void adjustRegion(Func *F, int St, int Pop) {
+  for (int J = St + 1; J < Pop; J++) {
+    Insn *In = &F->Insns[J];
+    if (!In->Dead && In->Kind == IK_INSN && (In->Use & REG(REG_SP)))
+      adjustSPOffset(In);
+  }
+}
+
+// 用寄存器代替压栈和弹栈
+//   addi sp, sp, -8; sd R, 0(sp); ...; ld R2, 0(sp); addi sp, sp, 8
+// 中间的指令不能修改sp，不能有调用和跳转，相对sp的访存需调整偏移量，
+// 此时将压栈改为复制到一个中间未使用的寄存器T，弹栈改为从T复制。
+// 压入的值未被弹出就丢弃时，直接删除压栈和弹栈
+static bool removePushPop(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Push = &F->Insns[I];
+    if (Push->Dead || !isSPAdjust(Push, -8))
+      continue;
+    int St = nextInBlock(F, I);
+    if (St < 0)
+      continue;
+    bool IsFloat = isStackSlot(&F->Insns[St], "fsd");
+    if (!IsFloat && !isStackSlot(&F->Insns[St], "sd"))
+      continue;
+
+    // 查找对应的弹栈
+    uint64_t Refs = 0;
+    int Ld = -1, Pop = -1;
+    for (int J = nextInBlock(F, St); J >= 0; J = nextInBlock(F, J)) {
+      Insn *In = &F->Insns[J];
+      if (isSPAdjust(In, 8)) {
+        Pop = J;
+        break;
+      }
+      if (isStackSlot(In, IsFloat ? "fld" : "ld")) {
+        int K = nextInBlock(F, J);
+        if (K >= 0 && isSPAdjust(&F->Insns[K], 8)) {
+          Ld = J;
+          Pop = K;
+        }
+        break;
+      }
+      if (In->Class != IC_ALU && In->Class != IC_LI &&
+          In->Class != IC_LOAD && In->Class != IC_STORE)
+        break;
+      if (((In->Use | In->Def) & REG(REG_SP)) && !isAboveSlot(In))
+        break;
+      Refs |= In->Use | In->Def;
+    }
+    if (Pop < 0)
+      continue;
+
+    if (Ld < 0) {
+      Push->Dead = true;
+      F->Insns[St].Dead = true;
+      F->Insns[Pop].Dead = true;
+      adjustRegion(F, St, Pop);
+      Changed = true;
+      continue;
+    }
+
+    char *Mv = IsFloat ? "fmv.d" : "mv";
+    char *Src = F->Insns[St].Args[0];
+    char *Dst = F->Insns[Ld].Args[0];
+    int RDst = regNum(Dst);
+    if (!(Refs & REG(RDst)) && !(REG(RDst) & FIXED_REGS)) {
+      // 弹栈的寄存器在中间未被使用，直接复制到该寄存器
+      setInsn(&F->Insns[St], Mv, 2, Dst, Src, NULL);
+      F->Insns[Ld].Dead = true;
+    } else {
+      int *Temps = IsFloat ? FloatTemps : IntTemps;
+      int NTemps = IsFloat ? sizeof(FloatTemps) / sizeof(int)
+                           : sizeof(IntTemps) / sizeof(int);
+      int T = -1;
+      for (int K = 0; K < NTemps; K++) {
+        uint64_t Busy = Refs | F->Insns[Pop].LiveOut | F->Insns[St].Use;
+        if (!(Busy & REG(Temps[K]))) {
+          T = Temps[K];
+          break;
+        }
+      }
+      if (T < 0)
+        continue;
+      setInsn(&F->Insns[St], Mv, 2, RegNames[T], Src, NULL);
+      setInsn(&F->Insns[Ld], Mv, 2, Dst, RegNames[T], NULL);
+    }
+    Push->Dead = true;
+    F->Insns[Pop].Dead = true;
+    adjustRegion(F, St, Pop);
+    Changed = true;
+  }
+  return Changed;
+}
+
+// 合并复制：X B, ...; mv A, B -> X A, ...，要求B之后不再活跃
+static bool coalesceCopies(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Mv = &F->Insns[I];
+    if (!isCopy(Mv))
+      continue;
+    int A = regNum(Mv->Args[0]);
+    int B = regNum(Mv->Args[1]);
+    if (A == B) {
+      Mv->Dead = true;
+      Changed = true;
+      continue;
+    }
+    if ((REG(A) | REG(B)) & FIXED_REGS || (Mv->LiveOut & REG(B)))
+      continue;
+    int P = prevInBlock(F, I);
+    if (P < 0)
+      continue;
+    Insn *Def = &F->Insns[P];
+    if (Def->Class != IC_ALU && Def->Class != IC_LI && Def->Class != IC_LOAD)
+      continue;
+    if (Def->Def != REG(B) || regNum(Def->Args[0]) != B ||
+        isFloatReg(A) != isFloatReg(B))
+      continue;
+    Def->Args[0] = RegNames[A];
+    classify(Def);
+    Mv->Dead = true;
+    Changed = true;
+  }
+  return Changed;
+}
+
+// 反转分支的条件
+static char *invertBranch(char *Op) {
+  static char *Pairs[][2] = {
+      {"beqz", "bnez"}, {"blez", "bgtz"}, {"bltz", "bgez"}, {"beq", "bne"},
+      {"blt", "bge"},   {"bltu", "bgeu"}, {"bgt", "ble"},   {"bgtu", "bleu"},
+  };
+  for (int I = 0; I < sizeof(Pairs) / sizeof(*Pairs); I++) {
+    if (!strcmp(Op, Pairs[I][0]))
+      return Pairs[I][1];
+    if (!strcmp(Op, Pairs[I][1]))
+      return Pairs[I][0];
+  }
+  return NULL;
+}
+
+// 改写分支指令，保留跳转目标
+static void setBranch(Insn *I, char *Op, char *Arg0, char *Arg1) {
+  char *Label = targetName(I);
+  int Target = I->Target;
+  if (Arg1)
+    setInsn(I, Op, 3, Arg0, Arg1, Label);
+  else
+    setInsn(I, Op, 2, Arg0, Label, NULL);
+  I->Target = Target;
+}
+
+// 合并比较与分支：snez/seqz/slt/sltu/xor X, ...; beqz/bnez X, L
+// 要求X在分支之后不再活跃，从而删除比较
+static bool mergeCompares(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Br = &F->Insns[I];
+    if (Br->Dead || Br->Kind != IK_INSN || Br->Class != IC_BRANCH ||
+        Br->NArgs != 2)
+      continue;
+    bool IsBeqz = !strcmp(Br->Op, "beqz");
+    if (!IsBeqz && strcmp(Br->Op, "bnez"))
+      continue;
+    int X = regNum(Br->Args[0]);
+    int P = prevInBlock(F, I);
+    if (P < 0 || (Br->LiveOut & REG(X)) || (REG(X) & FIXED_REGS))
+      continue;
+    Insn *Cmp = &F->Insns[P];
+    if (Cmp->Class != IC_ALU || regNum(Cmp->Args[0]) != X)
+      continue;
+
+    char *Op = Cmp->Op;
+    if (!strcmp(Op, "snez") && Cmp->NArgs == 2)
+      setBranch(Br, Br->Op, Cmp->Args[1], NULL);
+    else if (!strcmp(Op, "seqz") && Cmp->NArgs == 2)
+      setBranch(Br, invertBranch(Br->Op), Cmp->Args[1], NULL);
+    else if (!strcmp(Op, "slt") && Cmp->NArgs == 3)
+      setBranch(Br, IsBeqz ? "bge" : "blt", Cmp->Args[1], Cmp->Args[2]);
+    else if (!strcmp(Op, "sltu") && Cmp->NArgs == 3)
+      setBranch(Br, IsBeqz ? "bgeu" : "bltu", Cmp->Args[1], Cmp->Args[2]);
+    else if (!strcmp(Op, "xor") && Cmp->NArgs == 3)
+      setBranch(Br, IsBeqz ? "beq" : "bne", Cmp->Args[1], Cmp->Args[2]);
+    else
+      continue;
+    Cmp->Dead = true;
+    Changed = true;
+  }
+  return Changed;
+}
+
+// 判断从I到Target之间只有标签，即跳转到下一条指令
+static bool isNextLabel(Func *F, int I, int Target) {
+  if (Target <= I)
+    return false;
+  for (int J = I + 1; J < Target; J++) {
+    Insn *In = &F->Insns[J];
+    if (!In->Dead && In->Kind != IK_LABEL && In->Kind != IK_LOC)
+      return false;
+  }
+  return true;
+}
+
+// 判断I和J之间是否有标签
+static bool hasLabel(Func *F, int I, int J) {
+  for (int K = I + 1; K < J; K++)
+    if (!F->Insns[K].Dead && F->Insns[K].Kind == IK_LABEL)
+      return true;
+  return false;
+}
+
+// 修改跳转的目标
+static void retarget(Func *F, Insn *I, char *Label) {
+  I->Args[I->NArgs - 1] = Label;
+  resolveTarget(F, I);
+}
+
+// 优化跳转：删除跳转到下一条指令的跳转，跳转线程化，
+// 将跳过无条件跳转的分支反转，删除不可达的指令和未使用的标签
+static bool optimizeJumps(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead || Cur->Kind != IK_INSN ||
+        (Cur->Class != IC_JUMP && Cur->Class != IC_BRANCH) ||
+        Cur->Target < 0)
+      continue;
+
+    // 跳转到下一条指令
+    if (isNextLabel(F, I, Cur->Target)) {
+      Cur->Dead = true;
+      Changed = true;
+      continue;
+    }
+
+    // 目标为无条件跳转时，直接跳转到最终的目标
+    for (int N = 0; N < 8; N++) {
+      int J = firstInsnFrom(F, Cur->Target);
+      if (J < 0 || J == I)
+        break;
+      Insn *Next = &F->Insns[J];
+      if (Next->Kind != IK_INSN || Next->Class != IC_JUMP ||
+          Next->Target < 0 || Next->Target == Cur->Target)
+        break;
+      retarget(F, Cur, targetName(Next));
+      Changed = true;
+    }
+
+    // bxx L1; j L2; L1: -> bxx' L2; L1:
+    if (Cur->Class == IC_BRANCH && invertBranch(Cur->Op)) {
+      int J = firstInsnFrom(F, I + 1);
+      if (J < 0)
+        continue;
+      Insn *Jmp = &F->Insns[J];
+      if (Jmp->Kind == IK_INSN && Jmp->Class == IC_JUMP &&
+          Jmp->Target >= 0 && isNextLabel(F, J, Cur->Target) &&
+          !hasLabel(F, I, J)) {
+        char *Label = targetName(Jmp);
+        setBranch(Cur, invertBranch(Cur->Op), Cur->Args[0],
+                  Cur->NArgs == 3 ? Cur->Args[1] : NULL);
+        retarget(F, Cur, Label);
+        Jmp->Dead = true;
+        Changed = true;
+      }
+    }
+  }
+
+  // 删除无条件跳转和返回之后，直到下一个标签之前的指令
+  bool Reachable = true;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead)
+      continue;
+    if (Cur->Kind == IK_LABEL || Cur->Kind == IK_BARRIER) {
+      Reachable = true;
+      continue;
+    }
+    if (!Reachable && Cur->Kind == IK_INSN) {
+      Cur->Dead = true;
+      Changed = true;
+      continue;
+    }
+    if (Cur->Kind == IK_INSN &&
+        (Cur->Class == IC_JUMP || Cur->Class == IC_RET))
+      Reachable = false;
+  }
+
+  // 删除未被引用的编译器生成的标签，用户定义的标签可能被&&取地址
+  int *Refs = calloc(F->Len, sizeof(int));
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (!Cur->Dead && Cur->Kind == IK_INSN && Cur->Target >= 0)
+      Refs[Cur->Target]++;
+  }
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (!Cur->Dead && Cur->Kind == IK_LABEL && !Refs[I] &&
+        !strncmp(Cur->Op, ".L.", 3) && strncmp(Cur->Op, ".L..", 4)) {
+      Cur->Dead = true;
+      Changed = true;
+    }
+  }
+  free(Refs);
+  return Changed;
+}
+
+// 跳转到li R, C; beqz/bnez R, L时，若分支必然跳转，且R在L处不再活跃，
+// 则直接跳转到L
+static bool threadConstBranches(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead || Cur->Kind != IK_INSN ||
+        (Cur->Class != IC_JUMP && Cur->Class != IC_BRANCH) ||
+        Cur->Target < 0)
+      continue;
+
+    int J = firstInsnFrom(F, Cur->Target);
+    int64_t Val;
+    if (J < 0 || J == I)
+      continue;
+    Insn *Li = &F->Insns[J];
+    if (Li->Kind != IK_INSN || strcmp(Li->Op, "li") ||
+        !isNum(Li->Args[1], &Val))
+      continue;
+    int K = firstInsnFrom(F, J + 1);
+    if (K < 0 || K == I)
+      continue;
+    Insn *Br = &F->Insns[K];
+    int R = regNum(Li->Args[0]);
+    if (Br->Kind != IK_INSN || Br->Class != IC_BRANCH || Br->NArgs != 2 ||
+        regNum(Br->Args[0]) != R || Br->Target < 0 ||
+        (Br->LiveOut & REG(R)))
+      continue;
+    bool Taken = (Val == 0) == !strcmp(Br->Op, "beqz");
+    if (!Taken || (strcmp(Br->Op, "beqz") && strcmp(Br->Op, "bnez")))
+      continue;
+    retarget(F, Cur, targetName(Br));
+    Changed = true;
+  }
+  return Changed;
+}
+
+// 函数内没有写入fs0~fs11时，删除序言中的保存和尾声中的恢复
+static bool removeFSSaves(Func *F) {
+  uint64_t Defs = 0;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead)
+      continue;
+    // 指示不会写入寄存器
+    if (Cur->Kind == IK_BARRIER && *Cur->Line != '.')
+      return false;
+    if (Cur->Kind == IK_INSN && strcmp(Cur->Op, "fsgnj.d"))
+      Defs |= Cur->Def;
+  }
+
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead || Cur->Kind != IK_INSN || strcmp(Cur->Op, "fsgnj.d") ||
+        strcmp(Cur->Args[1], Cur->Args[2]))
+      continue;
+    // fsgnj.d ftN, fsN, fsN 或 fsgnj.d fsN, ftN, ftN
+    char *Dst = Cur->Args[0], *Src = Cur->Args[1];
+    char *FS = !strncmp(Dst, "fs", 2) ? Dst : Src;
+    char *FT = FS == Dst ? Src : Dst;
+    if (strncmp(FS, "fs", 2) || strncmp(FT, "ft", 2) ||
+        strcmp(FS + 2, FT + 2) || (Defs & REG(regNum(FS))))
+      continue;
+    Cur->Dead = true;
+    Changed = true;
+  }
+  return Changed;
+}
+
+// 删除结果不再活跃、且没有副作用的指令
+static bool removeDeadCode(Func *F) {
+  bool Changed = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead || Cur->Kind != IK_INSN)
+      continue;
+    if (Cur->Class != IC_ALU && Cur->Class != IC_LI &&
+        Cur->Class != IC_LOAD)
+      continue;
+    // 只删除栈上的加载，其他地址可能为volatile的变量
+    if (Cur->Class == IC_LOAD) {
+      int Base = memBase(Cur->Args[1]);
+      if (Base != REG_FP && Base != REG_SP)
+        continue;
+    }
+    if (!Cur->Def || (Cur->Def & (FIXED_REGS | Cur->LiveOut)))
+      continue;
+    Cur->Dead = true;
+    Changed = true;
+  }
+  return Changed;
+}
+
+//
+// 指令调度
+//
+// 在每个基本块内进行表调度：按指令间的依赖建立有向无环图，每个周期从
+// 操作数已就绪的指令中，选择到基本块末尾的路径最长的指令，从而在加载、
+// 乘除法的结果可用前先执行其他无关的指令，减少顺序执行的流水线的停顿。
+// 双发射的流水线也按每个周期发射一条指令调度，配对的情况取决于之前的
+// 指令，按单发射调度时穿插的无关指令更多。
+//
+
+// 流水线模型，各类指令的结果在几个周期后可用
+typedef struct {
+  char *Name;
+  int Load;  // 整型加载
+  int FLoad; // 浮点加载
+  int Mul;   // 整型乘法
+  int Div;   // 整型除法和取余
+  int FAlu;  // 浮点运算和类型转换
+  int FDiv;  // 浮点除法和平方根
+} TuneInfo;
+
+static TuneInfo Tunes[] = {
+    // 通用的顺序执行的流水线
+    {"generic", 3, 3, 3, 20, 4, 20},
+    {"rocket", 3, 3, 4, 33, 4, 20},
+    // U74等双发射的顺序执行的流水线
+    {"sifive-7-series", 3, 2, 3, 66, 5, 27},
+    {"thead-c906", 3, 3, 4, 20, 4, 20},
+    // 通用的乱序执行的流水线，加载的延迟更长，较短的延迟由硬件隐藏
+    {"generic-ooo", 4, 4, 3, 16, 3, 16},
+};
+
+// -mtune=指定的流水线模型
+char *OptMTune = "generic";
+// 进行指令调度
+bool OptFScheduleInsns2 = true;
+
+// 查找流水线模型
+static TuneInfo *findTune(char *Name) {
+  for (int I = 0; I < sizeof(Tunes) / sizeof(*Tunes); I++)
+    if (!strcmp(Tunes[I].Name, Name))
+      return &Tunes[I];
+  return NULL;
+}
+
+// 判断是否为支持的流水线模型
+bool isTuneModel(char *Name) { return findTune(Name); }
+
+// 获取指令结果的延迟
+static int insnLatency(TuneInfo *T, Insn *I) {
+  char *Op = I->Op;
+  if (I->Class == IC_LOAD)
+    return *Op == 'f' ? T->FLoad : T->Load;
+  if (I->Class != IC_ALU)
+    return 1;
+  if (!strncmp(Op, "mul", 3))
+    return T->Mul;
+  if (!strncmp(Op, "div", 3) || !strncmp(Op, "rem", 3))
+    return T->Div;
+  if (!strncmp(Op, "fdiv.", 5) || !strncmp(Op, "fsqrt.", 6))
+    return T->FDiv;
+  // 浮点寄存器间的复制和符号注入只需一个周期
+  if (*Op == 'f' && strncmp(Op, "fsgnj", 5) && strncmp(Op, "fmv.", 4) &&
+      strncmp(Op, "fneg.", 5) && strncmp(Op, "fabs.", 5))
+    return T->FAlu;
+  return 1;
+}
+
+// 判断是否为结束基本块的指令
+static bool isBlockEnd(Insn *I) {
+  return I->Class == IC_BRANCH || I->Class == IC_JUMP ||
+         I->Class == IC_CALL || I->Class == IC_RET;
+}
+
+// 判断是否为访问栈的指令
+static bool isStackAccess(Insn *I) {
+  if (I->Class != IC_LOAD && I->Class != IC_STORE)
+    return false;
+  int Base = memBase(I->Args[1]);
+  return Base == REG_SP || Base == REG_FP;
+}
+
+// 判断两条访存指令是否需要保持顺序
+// 栈上的加载之间可以交换，其他地址可能为volatile的变量；
+// 有存储时，只有基址相同且范围不重叠的访存可以交换
+static bool memDepends(Insn *A, Insn *B) {
+  if (A->Class == IC_LOAD && B->Class == IC_LOAD)
+    return !isStackAccess(A) || !isStackAccess(B);
+  int Base = memBase(A->Args[1]);
+  int64_t OffA, OffB;
+  if (Base < 0 || A->NArgs != 2 || B->NArgs != 2 ||
+      Base != memBase(B->Args[1]) || !memOff(A->Args[1], &OffA) ||
+      !memOff(B->Args[1], &OffB))
+    return true;
+  return OffA < OffB + memSize(B->Op) && OffB < OffA + memSize(A->Op);
+}
+
+// 每次调度的最多指令数，更长的基本块分段调度
+#define SCHED_MAX 64
+
+// 调度中的一条指令
+typedef struct {
+  Insn *I;
+  char *Loc;    // 指令所在的.loc
+  Insn *Label;  // 指令之前的%pcrel_lo引用的标签
+  int Prio;     // 到基本块末尾的最长路径的延迟
+  int NPreds;   // 尚未调度的前驱数
+  int Ready;    // 操作数就绪的周期
+  bool Done;    // 已调度
+} SchedNode;
+
+// 调度后的记录
+typedef struct {
+  Insn *Insns;
+  int Len, Cap;
+} InsnBuf;
+
+// 将记录加入到调度后的记录中
+static void emitRecord(InsnBuf *Buf, Insn *I) {
+  if (Buf->Len == Buf->Cap) {
+    Buf->Cap = Buf->Cap ? Buf->Cap * 2 : 256;
+    Buf->Insns = realloc(Buf->Insns, sizeof(Insn) * Buf->Cap);
+  }
+  Buf->Insns[Buf->Len++] = *I;
+}
+
+// 加入指令所在的.loc
+static void emitLoc(InsnBuf *Buf, char *Loc) {
+  if (Loc)
+    emitRecord(Buf, &(Insn){.Kind = IK_LOC, .Line = Loc, .Target = -1});
+}
+
+// 对一个基本块中的指令进行表调度，并输出
+static void scheduleBlock(TuneInfo *T, SchedNode *N, int Len, InsnBuf *Buf) {
+  // 依赖边的延迟，-1为没有依赖
+  signed char Lat[SCHED_MAX][SCHED_MAX];
+  for (int I = 0; I < Len; I++) {
+    N[I].NPreds = N[I].Ready = 0;
+    N[I].Done = false;
+  }
+
+  for (int J = 0; J < Len; J++) {
+    Insn *B = N[J].I;
+    bool MemB = B->Class == IC_LOAD || B->Class == IC_STORE;
+    for (int I = 0; I < J; I++) {
+      Insn *A = N[I].I;
+      bool MemA = A->Class == IC_LOAD || A->Class == IC_STORE;
+      int L = -1;
+      // 写后读
+      if (A->Def & B->Use)
+        L = insnLatency(T, A);
+      // 写后写，读后写
+      else if (A->Def & B->Def)
+        L = 1;
+      else if ((A->Use & B->Def) || isBlockEnd(B))
+        L = 0;
+      // 访存之间的依赖
+      else if (MemA && MemB && memDepends(A, B))
+        L = 0;
+      // 相对fp访问的栈不能越过sp的调整，否则可能访问sp之下的空间
+      else if (((A->Def & REG(REG_SP)) && MemB) ||
+               ((B->Def & REG(REG_SP)) && MemA))
+        L = 0;
+      Lat[I][J] = L;
+      if (L >= 0)
+        N[J].NPreds++;
+    }
+  }
+
+  // 从后向前计算到基本块末尾的最长路径
+  for (int I = Len - 1; I >= 0; I--) {
+    N[I].Prio = insnLatency(T, N[I].I);
+    for (int J = I + 1; J < Len; J++)
+      if (Lat[I][J] >= 0)
+        N[I].Prio = MAX(N[I].Prio, Lat[I][J] + N[J].Prio);
+  }
+
+  // 每个周期选择已就绪、优先级最高的指令，相同时保持原有的顺序
+  for (int Cycle = 0, Cnt = 0; Cnt < Len;) {
+    int Best = -1, Next = 0;
+    for (int I = 0; I < Len; I++) {
+      if (N[I].Done || N[I].NPreds)
+        continue;
+      if (N[I].Ready > Cycle) {
+        if (!Next || N[I].Ready < Next)
+          Next = N[I].Ready;
+      } else if (Best < 0 || N[I].Prio > N[Best].Prio)
+        Best = I;
+    }
+    // 没有就绪的指令时，停顿到最早就绪的周期
+    if (Best < 0) {
+      Cycle = Next;
+      continue;
+    }
+
+    SchedNode *S = &N[Best];
+    S->Done = true;
+    Cnt++;
+    for (int J = Best + 1; J < Len; J++) {
+      if (Lat[Best][J] < 0)
+        continue;
+      N[J].NPreds--;
+      N[J].Ready = MAX(N[J].Ready, Cycle + Lat[Best][J]);
+    }
+    emitLoc(Buf, S->Loc);
+    if (S->Label)
+      emitRecord(Buf, S->Label);
+    emitRecord(Buf, S->I);
+    Cycle++;
+  }
+}
+
+// 记录操作数和指示中出现的所有标识符，其中的标签可能被引用
+static void collectNames(HashMap *Names, char *S) {
+  while (*S) {
+    char *P = S;
+    while (isalnum(*P) || *P == '_' || *P == '.' || *P == '$')
+      P++;
+    if (P != S)
+      hashmap_put2(Names, S, P - S, (void *)1);
+    S = *P ? P + 1 : P;
+  }
+}
+
+// 对每个基本块进行指令调度
+// 没有被引用的标签不是基本块的边界，移到基本块的开头；
+// 有间接跳转时，标签的地址可能存放在函数外的数据中，都视为边界
+static void scheduleInsns(Func *F) {
+  TuneInfo *T = findTune(OptMTune);
+  HashMap Names = {};
+  bool IndirectJump = false;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead || Cur->Kind == IK_LOC || Cur->Kind == IK_LABEL)
+      continue;
+    if (Cur->Kind == IK_BARRIER) {
+      collectNames(&Names, Cur->Line);
+      IndirectJump |= Cur->Op && !strcmp(Cur->Op, "jr");
+    } else
+      for (int J = 0; J < Cur->NArgs; J++)
+        collectNames(&Names, Cur->Args[J]);
+  }
+
+  InsnBuf Buf = {};
+  SchedNode N[SCHED_MAX];
+  int Len = 0;
+  char *Loc = NULL;
+  Insn *Label = NULL;
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead)
+      continue;
+
+    switch (Cur->Kind) {
+    case IK_LOC:
+      Loc = Cur->Line;
+      continue;
+    case IK_LABEL:
+      // %pcrel_lo引用的标签随其后的指令一起调度
+      if (isPCRelLabel(Cur)) {
+        Label = Cur;
+        continue;
+      }
+      if (IndirectJump || strncmp(Cur->Op, ".L", 2) ||
+          hashmap_get(&Names, Cur->Op)) {
+        scheduleBlock(T, N, Len, &Buf);
+        Len = 0;
+      }
+      emitRecord(&Buf, Cur);
+      continue;
+    case IK_BARRIER:
+      scheduleBlock(T, N, Len, &Buf);
+      Len = 0;
+      emitLoc(&Buf, Loc);
+      if (Label)
+        emitRecord(&Buf, Label);
+      Label = NULL;
+      emitRecord(&Buf, Cur);
+      continue;
+    case IK_INSN:
+      N[Len++] = (SchedNode){.I = Cur, .Loc = Loc, .Label = Label};
+      Label = NULL;
+      if (isBlockEnd(Cur) || Len == SCHED_MAX) {
+        scheduleBlock(T, N, Len, &Buf);
+        Len = 0;
+      }
+      continue;
+    }
+  }
+  scheduleBlock(T, N, Len, &Buf);
+
+  free(F->Insns);
+  F->Insns = Buf.Insns;
+  F->Len = Buf.Len;
+}
+
+//
+// 输出
+//
+
+static void printFunc(Func *F, FILE *Out) {
+  // .loc只在其后有指令时输出，且与上一条相同时省略
+  char *PendingLoc = NULL;
+  char *LastLoc = "";
+  for (int I = 0; I < F->Len; I++) {
+    Insn *Cur = &F->Insns[I];
+    if (Cur->Dead)
+      continue;
+    switch (Cur->Kind) {
+    case IK_LOC:
+      PendingLoc = Cur->Line;
+      break;
+    case IK_LABEL:
+      fprintf(Out, "%s:\n", Cur->Op);
+      break;
+    case IK_INSN:
+    case IK_BARRIER:
+      if (PendingLoc && strcmp(PendingLoc, LastLoc)) {
+        fprintf(Out, "  %s\n", PendingLoc);
+        LastLoc = PendingLoc;
+      }
+      PendingLoc = NULL;
+      if (Cur->Kind == IK_INSN)
+        printInsn(Out, Cur);
+      else
+        fprintf(Out, "  %s\n", Cur->Line);
+      break;
+    }
+  }
+}
+
+// 对一个函数生成的汇编代码进行窥孔优化，替换原有的缓冲区
+void peephole(char **Buf, size_t *Len) {
+  Func F = {};
+  parseFunc(&F, *Buf);
+  removeFSSaves(&F);
+
+  for (int Round = 0; Round < 16; Round++) {
+    bool Changed = false;
+    Changed |= foldImm(&F);
+    Changed |= foldAddr(&F);
+    Changed |= propagateCopies(&F);
+    Changed |= forwardStores(&F);
+    Changed |= removeDeadStores(&F);
+    Changed |= optimizeJumps(&F);
+
+    // 以下的优化依赖于活跃变量分析
+    computeLiveness(&F);
+    Changed |= removePushPop(&F);
+    computeLiveness(&F);
+    Changed |= coalesceCopies(&F);
+    computeLiveness(&F);
+    Changed |= mergeCompares(&F);
+    computeLiveness(&F);
+    Changed |= threadConstBranches(&F);
+    computeLiveness(&F);
+    Changed |= removeDeadCode(&F);
+    if (!Changed)
+      break;
+  }
+
+  // 最后在不再改变的指令上进行调度
+  if (OptFScheduleInsns2)
+    scheduleInsns(&F);
+
+  char *NewBuf;
+  size_t NewLen;
+  FILE *Out = open_memstream(&NewBuf, &NewLen);
+  printFunc(&F, Out);
+  fclose(Out);
+
+  free(*Buf);
+  free(F.Insns);
+  *Buf = NewBuf;
+  *Len = NewLen;
+}
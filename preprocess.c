@@ -781,23 +781,102 @@ static bool expandMacro(Token **Rest, Token *Tok) {
   return true;
 }
 
+// 编译服务器中跨请求保存的引入路径查找结果
+typedef struct {
+  StringArray Dirs;        // 引入路径区
+  struct timespec *MTimes; // 各引入路径的修改时间
+  HashMap Paths;           // 文件名到查找结果的映射
+} IncludeLookups;
+
+// 引入路径区的键到IncludeLookups的映射
+static HashMap WarmLookups;
+
+// 本次编译的查找结果
+static HashMap LookupCache;
+
+// 引入路径区对应的键，即以换行符连接的各路径
+char *includePathsKey(void) {
+  char *Buf;
+  size_t BufLen;
+  FILE *Out = open_memstream(&Buf, &BufLen);
+  for (int I = 0; I < IncludePaths.Len; I++)
+    fprintf(Out, "%s\n", IncludePaths.Data[I]);
+  fclose(Out);
+  return Buf;
+}
+
+// 获取本次编译的查找结果
+HashMap *getIncludeLookups(void) { return &LookupCache; }
+
+// 判断引入路径区的各目录是否未被修改
+// 目录中增删文件会修改目录的修改时间
+static bool dirsUnchanged(IncludeLookups *L) {
+  for (int I = 0; I < L->Dirs.Len; I++) {
+    struct stat St = {};
+    stat(L->Dirs.Data[I], &St);
+    if (St.st_mtim.tv_sec != L->MTimes[I].tv_sec ||
+        St.st_mtim.tv_nsec != L->MTimes[I].tv_nsec)
+      return false;
+  }
+  return true;
+}
+
+// 保存查找结果，供编译服务器之后的请求使用
+void cacheIncludeLookup(char *Key, char *Filename, char *Path) {
+  IncludeLookups *L = hashmap_get(&WarmLookups, Key);
+
+  // 目录被修改过时，之前的查找结果全部作废
+  if (L && !dirsUnchanged(L))
+    L = NULL;
+
+  if (!L) {
+    L = calloc(1, sizeof(IncludeLookups));
+    for (char *P = Key, *Q; (Q = strchr(P, '\n')); P = Q + 1)
+      strArrayPush(&L->Dirs, strndup(P, Q - P));
+    L->MTimes = calloc(L->Dirs.Len + 1, sizeof(struct timespec));
+    for (int I = 0; I < L->Dirs.Len; I++) {
+      struct stat St = {};
+      stat(L->Dirs.Data[I], &St);
+      L->MTimes[I] = St.st_mtim;
+    }
+    hashmap_put(&WarmLookups, strdup(Key), L);
+  }
+
+  hashmap_put(&L->Paths, strdup(Filename), strdup(Path));
+}
+
 // 搜索引入路径区
 char *searchIncludePaths(char *Filename) {
   // 以"/"开头的视为绝对路径
   if (Filename[0] == '/')
     return Filename;
 
-  static HashMap cache;
-  char *cached = hashmap_get(&cache, Filename);
+  char *cached = hashmap_get(&LookupCache, Filename);
   if (cached)
     return cached;
 
+  // 使用编译服务器保存的查找结果，只需在本次编译中检查一次各目录
+  // 含有"/"的文件名位于子目录中，子目录的变化无法通过引入路径区察觉，不使用
+  static IncludeLookups *Warm;
+  static bool WarmChecked;
+  if (WarmLookups.used && !WarmChecked) {
+    WarmChecked = true;
+    Warm = hashmap_get(&WarmLookups, includePathsKey());
+    if (Warm && !dirsUnchanged(Warm))
+      Warm = NULL;
+  }
+
+  char *WarmPath = NULL;
+  if (Warm && !strchr(Filename, '/'))
+    WarmPath = hashmap_get(&Warm->Paths, Filename);
+
   // 从引入路径区查找文件
   for (int I = 0; I < IncludePaths.Len; I++) {
     char *Path = format("%s/%s", IncludePaths.Data[I], Filename);
-    if (!fileExists(Path))
+    // 存在之前的查找结果时，无需检查文件是否存在
+    if (WarmPath ? strcmp(WarmPath, Path) : !fileExists(Path))
       continue;
-    hashmap_put(&cache, Filename, Path);
+    hashmap_put(&LookupCache, Filename, Path);
     include_next_idx = I + 1;
     return Path;
   }
@@ -1234,7 +1313,6 @@ void initMacros(void) {
   defineMacro("__SIZEOF_SIZE_T__", "8");
   defineMacro("__SIZE_TYPE__", "unsigned long");
   defineMacro("__STDC_HOSTED__", "1");
-  defineMacro("__STDC_NO_ATOMICS__", "1");
   defineMacro("__STDC_NO_COMPLEX__", "1");
   defineMacro("__STDC_UTF_16__", "1");
   defineMacro("__STDC_UTF_32__", "1");
@@ -1264,6 +1342,23 @@ void initMacros(void) {
   defineMacro("__riscv_div", "1");
   defineMacro("__riscv_float_abi_double", "1");
   defineMacro("__riscv_flen", "64");
+  defineMacro("__riscv_atomic", "1");
+
+  // 原子操作内建函数的内存顺序
+  defineMacro("__ATOMIC_RELAXED", "0");
+  defineMacro("__ATOMIC_CONSUME", "1");
+  defineMacro("__ATOMIC_ACQUIRE", "2");
+  defineMacro("__ATOMIC_RELEASE", "3");
+  defineMacro("__ATOMIC_ACQ_REL", "4");
+  defineMacro("__ATOMIC_SEQ_CST", "5");
+  // 各类型的原子操作都是无锁的
+  defineMacro("__GCC_ATOMIC_BOOL_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_CHAR_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_SHORT_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_INT_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_LONG_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_LLONG_LOCK_FREE", "2");
+  defineMacro("__GCC_ATOMIC_POINTER_LOCK_FREE", "2");
 
   addBuiltin("__FILE__", fileMacro);
   addBuiltin("__LINE__", lineMacro);
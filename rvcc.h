@@ -129,6 +129,8 @@ Token *tokenizeStringLiteral(Token *Tok, Type *BaseTy);
 Token *tokenize(File *FP);
 // 词法分析
 Token *tokenizeFile(char *Path);
+// 为编译服务器预先词法分析文件
+void cacheTokenizedFile(char *Path, struct stat *St);
 
 // 指rvcc源文件的某个文件的某一行出了问题，打印出文件名和行号
 #define unreachable() error("internal error at %s:%d", __FILE__, __LINE__)
@@ -138,6 +140,10 @@ Token *tokenizeFile(char *Path);
 //
 
 char *searchIncludePaths(char *Filename);
+// 引入路径区对应的键
+char *includePathsKey(void);
+// 为编译服务器保存引入路径的查找结果
+void cacheIncludeLookup(char *Key, char *Filename, char *Path);
 void initMacros(void);
 void defineMacro(char *Name, char *Buf);
 void undefMacro(char *Name);
@@ -147,6 +153,14 @@ Token *preprocess(Token *Tok);
 // 生成AST（抽象语法树），语法解析
 //
 
+// 线程局部存储的访问模型，从通用到高效排列
+typedef enum {
+  TLS_GLOBAL_DYNAMIC, // 通用动态，每次访问调用__tls_get_addr
+  TLS_LOCAL_DYNAMIC,  // 局部动态，函数内缓存__tls_get_addr的结果
+  TLS_INITIAL_EXEC,   // 初始执行，从GOT中读取相对tp的偏移量
+  TLS_LOCAL_EXEC,     // 局部执行，直接使用相对tp的偏移量
+} TLSModel;
+
 // 变量 或 函数
 typedef struct Obj Obj;
 struct Obj {
@@ -157,19 +171,28 @@ struct Obj {
   bool IsLocal; // 是 局部或全局 变量
   int Align;    // 对齐量
   // 局部变量
-  int Offset; // fp的偏移量
+  int Offset;       // fp的偏移量
+  bool IsAddrTaken; // 地址被获取过，可能被间接地读写
+  int Reg;          // -O1时存放变量的s寄存器，为0时在栈中
+  int64_t RegUses;  // 按循环嵌套加权的使用次数，用于选择放入寄存器的变量
 
   // 结构体类型
   bool IsHalfByStack; // 一半用寄存器，一半用栈
 
+  // 缓存线程局部变量地址的局部变量，对应的线程局部变量
+  Obj *TLSVar;
+
   // 函数 或 全局变量
   bool IsFunction;
   bool IsDefinition; // 是否为函数定义
   bool IsStatic;     // 是否为文件域内的
+  char *Visibility;  // 符号的可见性，为NULL时使用默认可见性
 
   // 全局变量
   bool IsTentative; // 不定的
   bool IsTLS;       // thread local storage
+  bool IsLiteral;   // 是否为字符串字面量
+  TLSModel TLSModel; // tls_model属性指定的访问模型
   char *InitData;   // 用于初始化的数据
   Relocation *Rel;  // 指向其他全局变量的指针
 
@@ -181,6 +204,7 @@ struct Obj {
   Obj *VaArea;       // 可变参数区域
   Obj *AllocaBottom; // Alloca区域底部
   int StackSize;     // 栈大小
+  bool UsesAlloca;   // 调用了alloca，sp会在函数内动态变化
 
   // 静态内联函数
   bool IsLive;
@@ -198,6 +222,16 @@ struct Relocation {
   long Addend;      // 加数
 };
 
+// 原子操作的内存顺序，与__ATOMIC_*宏的值相同
+typedef enum {
+  MO_RELAXED,
+  MO_CONSUME,
+  MO_ACQUIRE,
+  MO_RELEASE,
+  MO_ACQ_REL,
+  MO_SEQ_CST,
+} MemoryOrder;
+
 // AST的节点种类
 typedef enum {
   ND_NULL_EXPR, // 空表达式
@@ -246,6 +280,19 @@ typedef enum {
   ND_CAST,      // 类型转换
   ND_MEMZERO,   // 栈中变量清零
   ND_ASM,       // "asm"汇编
+  ND_CLZ,       // __builtin_clz，前导零的个数
+  ND_CTZ,       // __builtin_ctz，末尾零的个数
+  ND_POPCOUNT,  // __builtin_popcount，为1的位数
+  ND_CAS,       // 原子比较并交换
+  ND_ATOMIC_RW, // 原子读改写
+  ND_ATOMIC_LD, // 原子读取
+  ND_ATOMIC_ST, // 原子写入
+  ND_FENCE,     // 内存屏障
+  ND_EXPECT,    // __builtin_expect，分支预测的提示
+  ND_PREFETCH,  // __builtin_prefetch，预取
+  ND_UNREACH,   // __builtin_unreachable，不可到达
+  ND_ALIGNED,   // __builtin_assume_aligned，假定指针的对齐值
+  ND_SHUFFLE,   // __builtin_shuffle，按下标重排向量的元素
 } NodeKind;
 
 // AST中二叉树节点
@@ -280,6 +327,7 @@ struct Node {
   Type *FuncType;   // 函数类型
   Node *Args;       // 函数参数
   bool PassByStack; // 通过栈传递
+  bool IsDirect;    // 不经过栈，直接计算到传参的寄存器中
   Obj *RetBuffer;   // 返回值缓冲区
 
   // goto和标签语句
@@ -298,13 +346,28 @@ struct Node {
   // "asm" 字符串字面量
   char *AsmStr;
 
+  // 原子操作
+  Node *CasAddr;      // 比较并交换的地址
+  Node *CasOld;       // 指向期望值的指针，失败时写入内存中的值
+  Node *CasNew;       // 相等时写入的新值
+  NodeKind AtomicOp;  // 读改写的运算，ND_ASSIGN为交换，ND_BITNOT为与非
+  bool AtomicFetch;   // 返回运算前的值，否则返回运算后的值
+  MemoryOrder Order;  // 内存顺序
+
+  // 向量运算
+  Node *Mask;  // __builtin_shuffle的下标向量
+  Obj *VecTmp; // 存放向量运算结果的临时变量
+
   Obj *Var;         // 存储ND_VAR种类的变量
+  Obj *TLSSlot;     // 缓存线程局部变量地址的局部变量
   int64_t Val;      // 存储ND_NUM种类的值
   long double FVal; // 存储ND_NUM种类的浮点值
 };
 
 // 类型转换，将表达式的值转换为另一种类型
 Node *newCast(Node *Expr, Type *Ty);
+// 新建存放向量运算结果的临时变量
+Obj *newVecTmp(Type *Ty);
 // 解析常量表达式
 int64_t constExpr(Token **Rest, Token *Tok);
 // 语法解析入口函数
@@ -332,6 +395,7 @@ typedef enum {
   TY_VLA,     // 可变长度数组，variable-length array
   TY_STRUCT,  // 结构体
   TY_UNION,   // 联合体
+  TY_VECTOR,  // 向量，vector_size属性声明的类型
 } TypeKind;
 
 struct Type {
@@ -339,6 +403,10 @@ struct Type {
   int Size;        // 大小, sizeof返回的值
   int Align;       // 对齐
   bool IsUnsigned; // 是否为无符号的
+  bool IsConst;    // 是否为const限定的
+  bool IsAtomic;   // 是否为_Atomic限定的
+  bool IsVolatile; // 是否为volatile限定的
+  bool IsRestrict; // 是否为restrict限定的
   Type *Origin;    // 类型兼容性检查
 
   // 指针
@@ -348,7 +416,7 @@ struct Type {
   Token *Name;
   Token *NamePos; // 名称位置
 
-  // 数组
+  // 数组 或 向量
   int ArrayLen; // 数组长度, 元素总个数
 
   // 可变长数组
@@ -421,6 +489,8 @@ void addType(Node *Nd);
 Type *arrayOf(Type *Base, int Size);
 // 可变长数组类型
 Type *VLAOf(Type *Base, Node *Expr);
+// 向量类型
+Type *vectorOf(Type *Base, int Size);
 // 枚举类型
 Type *enumType(void);
 // 结构体类型
@@ -432,12 +502,30 @@ Type *funcType(Type *ReturnTy);
 // 语义分析与代码生成
 //
 
+// 代码生成的线程数
+extern int OptCodegenThreads;
+
 // 代码生成入口函数
 void codegen(Obj *Prog, FILE *Out);
 int alignTo(int N, int Align);
 bool isIdent1_1(uint32_t C);
 bool isIdent2_1(uint32_t C);
 
+//
+// 窥孔优化
+//
+
+// 优化级别
+extern int OptOLevel;
+
+// 指令调度，及-mtune=指定的流水线模型
+extern bool OptFScheduleInsns2;
+extern char *OptMTune;
+bool isTuneModel(char *Name);
+
+// 对一个函数生成的汇编代码进行窥孔优化
+void peephole(char **Buf, size_t *Len);
+
 //
 // unicode 统一码
 //
@@ -470,15 +558,68 @@ void hashmap_delete(HashMap *map, char *key);
 void hashmap_delete2(HashMap *map, char *key, int keylen);
 void hashmap_test(void);
 
+//
+// 编译缓存
+//
+
+extern char *OptFCacheDir;
+extern long OptFCacheMaxSize;
+
+// 计算预处理结果和编译选项对应的缓存键
+char *cacheKey(Token *Tok, int Argc, char **Argv);
+// 缓存中是否存在键对应的文件
+bool cacheHas(char *Key, char *Extn);
+// 从缓存中取出文件
+bool cacheFetch(char *Key, char *Extn, char *Dst);
+// 将文件存入缓存
+void cacheStore(char *Key, char *Extn, char *Src);
+// 输出缓存的统计数据
+void cachePrintStats(void);
+
+//
+// 编译服务器
+//
+
+extern int ServerReportFD;
+
+// 作为客户端，将请求转发给编译服务器
+int runClient(int Argc, char **Argv);
+// 作为编译服务器运行
+noreturn void runServer(char *Path);
+// 报告本次编译用到的头文件和查找结果
+void serverReport(void);
+// 获取本次编译的引入路径查找结果
+HashMap *getIncludeLookups(void);
+
 //
 // 主程序，驱动文件
 //
 
 // 判断文件存在
 bool fileExists(char *Path);
+// 编译器驱动
+int driver(int Argc, char **Argv);
 
 // 引入路径区
 extern StringArray IncludePaths;
 extern bool OptFPIC;
+extern char *OptFVisibility;
+extern TLSModel OptFTLSModel;
+extern int OptMSmallDataLimit;
+extern bool OptMRVC;
+extern char *OptMArch;
+extern bool OptZba;
+extern bool OptZbb;
+extern bool OptZbs;
+extern bool OptZicbop;
+extern bool OptRVV;
+
+bool parseTLSModel(char *Name, TLSModel *Model);
 extern bool OptFCommon;
+extern bool OptFBuiltin;
+extern bool OptFVectorize;
+extern bool OptFMoveLoopInvariants;
+extern bool OptFIVOpts;
+extern bool OptFUnrollLoops;
+extern bool OptFStrictAliasing;
 extern char *BaseFile;
@@ -0,0 +1,389 @@
+// 编译服务器
+//
+// rvcc --server[=套接字路径] 在本地Unix套接字上监听编译请求。
+// 设置了环境变量RVCC_SERVER时，rvcc作为客户端，将参数、当前目录
+// 以及标准输入输出错误的文件描述符转发给服务器，并等待返回的退出码。
+//
+// 服务器为每个请求fork出子进程，请求间可以并发执行，
+// 子进程中的cc1不再重新exec，从而继承服务器中预热过的缓存：
+//   已词法分析过的头文件（tokenizeFile）
+//   引入路径区的查找结果（searchIncludePaths）
+// 子进程对缓存的修改不会影响服务器，缓存对请求而言是只读的。
+// 请求结束后，cc1通过管道报告用到的头文件和查找结果，由服务器进行预热。
+
+#include "rvcc.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+extern char **environ;
+
+// 处理请求时用于报告缓存信息的管道，不在处理请求时为-1
+int ServerReportFD = -1;
+
+// 正在处理的请求
+typedef struct {
+  pid_t Pid;  // 处理请求的子进程
+  int Conn;   // 与客户端的连接
+  int Report; // 读取子进程报告的管道
+  char *Buf;  // 报告的内容
+  size_t Len; // 报告的长度
+  size_t Cap; // 报告缓冲区的容量
+} Request;
+
+// 默认的套接字路径
+static char *defaultSocketPath(void) {
+  char *Path = getenv("RVCC_SERVER");
+  if (Path && *Path)
+    return Path;
+  return format("/tmp/rvcc-server-%d.sock", (int)getuid());
+}
+
+// 读取指定长度的数据，返回是否成功
+static bool readFull(int FD, void *Buf, size_t Len) {
+  char *P = Buf;
+  while (Len > 0) {
+    ssize_t N = read(FD, P, Len);
+    if (N <= 0)
+      return false;
+    P += N;
+    Len -= N;
+  }
+  return true;
+}
+
+// 写入指定长度的数据，返回是否成功
+static bool writeFull(int FD, void *Buf, size_t Len) {
+  char *P = Buf;
+  while (Len > 0) {
+    ssize_t N = write(FD, P, Len);
+    if (N <= 0)
+      return false;
+    P += N;
+    Len -= N;
+  }
+  return true;
+}
+
+// 请求的格式：
+//   头部：参数个数，环境变量个数，数据长度，
+//         同时附带标准输入输出错误的文件描述符
+//   数据：当前目录、各个参数和环境变量，以'\0'分隔
+
+// 作为客户端，将请求转发给编译服务器，返回退出码
+// 无法连接到服务器时返回-1，由调用者在本地编译
+int runClient(int Argc, char **Argv) {
+  int FD = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0)
+    return -1;
+
+  struct sockaddr_un Addr = {};
+  Addr.sun_family = AF_UNIX;
+  strncpy(Addr.sun_path, defaultSocketPath(), sizeof(Addr.sun_path) - 1);
+  if (connect(FD, (struct sockaddr *)&Addr, sizeof(Addr))) {
+    close(FD);
+    return -1;
+  }
+
+  // 构造数据
+  char *Buf;
+  size_t BufLen;
+  FILE *Out = open_memstream(&Buf, &BufLen);
+  char *Cwd = getcwd(NULL, 0);
+  fwrite(Cwd, strlen(Cwd) + 1, 1, Out);
+  for (int I = 0; I < Argc; I++)
+    fwrite(Argv[I], strlen(Argv[I]) + 1, 1, Out);
+  // 汇编器和链接器需要使用客户端的PATH等环境变量
+  int Envc = 0;
+  for (; environ[Envc]; Envc++)
+    fwrite(environ[Envc], strlen(environ[Envc]) + 1, 1, Out);
+  fclose(Out);
+
+  // 发送头部，以及标准输入输出错误
+  uint32_t Header[3] = {Argc, Envc, BufLen};
+  struct iovec IOV = {Header, sizeof(Header)};
+  union {
+    char Buf[CMSG_SPACE(sizeof(int) * 3)];
+    struct cmsghdr Align;
+  } Ctrl = {};
+  struct msghdr Msg = {};
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Ctrl.Buf;
+  Msg.msg_controllen = sizeof(Ctrl.Buf);
+
+  struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg);
+  CMsg->cmsg_level = SOL_SOCKET;
+  CMsg->cmsg_type = SCM_RIGHTS;
+  CMsg->cmsg_len = CMSG_LEN(sizeof(int) * 3);
+  int FDs[3] = {0, 1, 2};
+  memcpy(CMSG_DATA(CMsg), FDs, sizeof(FDs));
+
+  if (sendmsg(FD, &Msg, 0) != sizeof(Header) || !writeFull(FD, Buf, BufLen)) {
+    close(FD);
+    return -1;
+  }
+
+  // 等待退出码
+  int32_t Status;
+  bool Ok = readFull(FD, &Status, sizeof(Status));
+  close(FD);
+  // 服务器在处理中途退出时，在本地重新编译
+  return Ok ? Status : -1;
+}
+
+// 在子进程中处理请求
+static noreturn void serveRequest(int Conn, int ReportFD) {
+  // 接收头部和文件描述符
+  uint32_t Header[3];
+  struct iovec IOV = {Header, sizeof(Header)};
+  union {
+    char Buf[CMSG_SPACE(sizeof(int) * 3)];
+    struct cmsghdr Align;
+  } Ctrl = {};
+  struct msghdr Msg = {};
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Ctrl.Buf;
+  Msg.msg_controllen = sizeof(Ctrl.Buf);
+
+  if (recvmsg(Conn, &Msg, 0) != sizeof(Header))
+    _exit(1);
+  struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg);
+  if (!CMsg || CMsg->cmsg_type != SCM_RIGHTS ||
+      CMsg->cmsg_len != CMSG_LEN(sizeof(int) * 3))
+    _exit(1);
+  int FDs[3];
+  memcpy(FDs, CMSG_DATA(CMsg), sizeof(FDs));
+
+  // 接收当前目录、参数和环境变量
+  int Argc = Header[0];
+  int Envc = Header[1];
+  char *Buf = malloc(Header[2] + 1);
+  if (!readFull(Conn, Buf, Header[2]))
+    _exit(1);
+  Buf[Header[2]] = '\0';
+  close(Conn);
+
+  char *End = Buf + Header[2];
+  char *Cwd = Buf;
+  char *P = Cwd + strlen(Cwd) + 1;
+  char **Argv = calloc(Argc + 1, sizeof(char *));
+  for (int I = 0; I < Argc && P < End; I++) {
+    Argv[I] = P;
+    P += strlen(P) + 1;
+  }
+  char **Envp = calloc(Envc + 1, sizeof(char *));
+  for (int I = 0; I < Envc && P < End; I++) {
+    Envp[I] = P;
+    P += strlen(P) + 1;
+  }
+  environ = Envp;
+
+  // 使用客户端的标准输入输出错误和当前目录
+  for (int I = 0; I < 3; I++) {
+    dup2(FDs[I], I);
+    close(FDs[I]);
+  }
+  if (chdir(Cwd))
+    error("cannot change directory: %s: %s", Cwd, strerror(errno));
+
+  // 汇编器、链接器等子进程不需要报告管道
+  fcntl(ReportFD, F_SETFD, FD_CLOEXEC);
+  ServerReportFD = ReportFD;
+  signal(SIGPIPE, SIG_DFL);
+  exit(driver(Argc, Argv));
+}
+
+// 报告的格式，每条记录以类型开头：
+//   'F' 路径'\0' struct stat          已词法分析的头文件
+//   'I' 引入路径区'\0' 文件名'\0' 路径'\0' 引入路径区的查找结果
+
+// 在cc1中报告本次编译用到的头文件和查找结果
+void serverReport(void) {
+  char *Buf;
+  size_t BufLen;
+  FILE *Out = open_memstream(&Buf, &BufLen);
+
+  File **Files = getInputFiles();
+  for (int I = 0; Files[I]; I++) {
+    struct stat St;
+    // 只缓存头文件，不缓存被编译的文件本身
+    // 相对路径依赖于请求的当前目录，也不缓存
+    if (Files[I]->Name[0] != '/' || stat(Files[I]->Name, &St))
+      continue;
+    fputc('F', Out);
+    fwrite(Files[I]->Name, strlen(Files[I]->Name) + 1, 1, Out);
+    fwrite(&St, sizeof(St), 1, Out);
+  }
+
+  // 引入路径区都为绝对路径时，查找结果才与当前目录无关
+  char *Key = includePathsKey();
+  bool Absolute = Key[0] == '/' && !strstr(Key, "\n\n");
+  for (char *P = strchr(Key, '\n'); P; P = strchr(P + 1, '\n'))
+    if (P[1] && P[1] != '/')
+      Absolute = false;
+
+  HashMap *Lookups = getIncludeLookups();
+  for (int I = 0; Absolute && I < Lookups->capacity; I++) {
+    HashEntry *Ent = &Lookups->buckets[I];
+    if (!Ent->key || Ent->key == (void *)-1)
+      continue;
+    fputc('I', Out);
+    fwrite(Key, strlen(Key) + 1, 1, Out);
+    fwrite(Ent->key, Ent->keylen, 1, Out);
+    fputc('\0', Out);
+    fwrite(Ent->val, strlen(Ent->val) + 1, 1, Out);
+  }
+  fclose(Out);
+
+  writeFull(ServerReportFD, Buf, BufLen);
+  free(Buf);
+}
+
+// 根据请求的报告预热缓存
+static void warmCaches(char *Buf, size_t Len) {
+  char *End = Buf + Len;
+  char *P = Buf;
+
+  while (P < End) {
+    char Kind = *P++;
+
+    if (Kind == 'F') {
+      char *Path = P;
+      P += strlen(P) + 1;
+      if (P + sizeof(struct stat) > End)
+        return;
+      struct stat St;
+      memcpy(&St, P, sizeof(St));
+      P += sizeof(St);
+      cacheTokenizedFile(Path, &St);
+      continue;
+    }
+
+    if (Kind == 'I') {
+      char *Key = P;
+      P += strlen(P) + 1;
+      char *Filename = P;
+      P += strlen(P) + 1;
+      char *Path = P;
+      P += strlen(P) + 1;
+      if (P > End)
+        return;
+      cacheIncludeLookup(Key, Filename, Path);
+      continue;
+    }
+
+    return;
+  }
+}
+
+// 作为编译服务器运行
+noreturn void runServer(char *Path) {
+  if (!Path)
+    Path = defaultSocketPath();
+
+  int Listen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Listen < 0)
+    error("socket: %s", strerror(errno));
+
+  struct sockaddr_un Addr = {};
+  Addr.sun_family = AF_UNIX;
+  if (strlen(Path) >= sizeof(Addr.sun_path))
+    error("socket path is too long: %s", Path);
+  strcpy(Addr.sun_path, Path);
+  unlink(Path);
+  if (bind(Listen, (struct sockaddr *)&Addr, sizeof(Addr)))
+    error("cannot bind %s: %s", Path, strerror(errno));
+  if (listen(Listen, 128))
+    error("listen: %s", strerror(errno));
+
+  // 客户端中途退出时，不终止服务器
+  signal(SIGPIPE, SIG_IGN);
+  fprintf(stderr, "rvcc: listening on %s\n", Path);
+
+  Request *Reqs = NULL;
+  int NumReqs = 0, CapReqs = 0;
+  struct pollfd *PFDs = NULL;
+
+  while (true) {
+    // 监听新的连接，以及各请求的报告
+    PFDs = realloc(PFDs, sizeof(struct pollfd) * (NumReqs + 1));
+    PFDs[0] = (struct pollfd){Listen, POLLIN, 0};
+    for (int I = 0; I < NumReqs; I++)
+      PFDs[I + 1] = (struct pollfd){Reqs[I].Report, POLLIN, 0};
+
+    if (poll(PFDs, NumReqs + 1, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      error("poll: %s", strerror(errno));
+    }
+
+    // 读取报告，全部读完时请求结束
+    for (int I = NumReqs - 1; I >= 0; I--) {
+      if (!PFDs[I + 1].revents)
+        continue;
+
+      Request *R = &Reqs[I];
+      if (R->Cap - R->Len < 4096) {
+        R->Cap = R->Cap * 2 + 4096;
+        R->Buf = realloc(R->Buf, R->Cap);
+      }
+      ssize_t N = read(R->Report, R->Buf + R->Len, R->Cap - R->Len);
+      if (N > 0) {
+        R->Len += N;
+        continue;
+      }
+      if (N < 0 && errno == EINTR)
+        continue;
+
+      // 返回退出码
+      int Status;
+      waitpid(R->Pid, &Status, 0);
+      int32_t Code = WIFEXITED(Status) ? WEXITSTATUS(Status) : 1;
+      writeFull(R->Conn, &Code, sizeof(Code));
+      close(R->Conn);
+      close(R->Report);
+
+      // 预热缓存，供之后的请求使用
+      warmCaches(R->Buf, R->Len);
+      free(R->Buf);
+      Reqs[I] = Reqs[--NumReqs];
+    }
+
+    // 接受新的连接
+    if (PFDs[0].revents) {
+      int Conn = accept(Listen, NULL, NULL);
+      if (Conn < 0)
+        continue;
+
+      int Pipe[2];
+      if (pipe(Pipe)) {
+        close(Conn);
+        continue;
+      }
+
+      fflush(NULL);
+      pid_t Pid = fork();
+      if (Pid == 0) {
+        close(Listen);
+        close(Pipe[0]);
+        serveRequest(Conn, Pipe[1]);
+      }
+      close(Pipe[1]);
+      if (Pid < 0) {
+        close(Conn);
+        close(Pipe[0]);
+        continue;
+      }
+
+      if (NumReqs == CapReqs) {
+        CapReqs = CapReqs ? CapReqs * 2 : 16;
+        Reqs = realloc(Reqs, sizeof(Request) * CapReqs);
+      }
+      Reqs[NumReqs++] = (Request){Pid, Conn, Pipe[0], NULL, 0, 0};
+    }
+  }
+}
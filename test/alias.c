@@ -0,0 +1,123 @@
+#include "test.h"
+
+// 别名分析允许在-O1时外提这些循环中的读取，结果须与-O0相同
+
+static void copy0(int *restrict a, int *restrict b, int n) {
+  for (int i = 0; i < n; i++)
+    a[i] = b[0] + i;
+}
+
+// 没有restrict时a和b可能重叠
+static void copy1(int *a, int *b, int n) {
+  for (int i = 0; i < n; i++)
+    a[i] = b[1] + i;
+}
+
+// 写入float不会改变int
+static void fill(float *y, int *x, int n) {
+  for (int i = 0; i < n; i++)
+    y[i] = *x;
+}
+
+// 通过char写入可以改变任意类型的对象
+static int bytes(char *p, int *x, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    s += *x;
+    p[i] = 1;
+  }
+  return s;
+}
+
+typedef union {
+  int I;
+  float F;
+} IntFloat;
+
+static int pun(IntFloat *u, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    s += u->I;
+    u->F = 1.0f;
+  }
+  return s;
+}
+
+typedef struct {
+  int n;
+  float *v;
+} Vec;
+
+static void scale(Vec *s, float k) {
+  for (int i = 0; i < s->n; i++)
+    s->v[i] *= k;
+}
+
+typedef struct {
+  int n;
+  int a[3];
+} Cnt;
+
+// 指向int的指针可能指向结构体中的int成员
+static int members(Cnt *s, int *a, int n) {
+  int t = 0;
+  for (int i = 0; i < n; i++) {
+    t += s->n;
+    a[i] = i;
+  }
+  return t;
+}
+
+static int G, H;
+
+static void globals(int n) {
+  for (int i = 0; i < n; i++)
+    G += H;
+}
+
+// 循环体可能不执行、提前退出或只在部分迭代中读取，不能提前读取空指针
+static int guard(int *a, int *p, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    if (a[i] < 0)
+      break;
+    s += *p;
+  }
+  return s;
+}
+
+static int cond(int *p, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    if (p)
+      s += *p;
+  return s;
+}
+
+// 条件中有副作用，第一次判断条件只能计算一次
+static int once(int *k, int *x, int n) {
+  int s = 0;
+  for (int i = 0; (*k)++ < n; i++)
+    s += *x;
+  return s;
+}
+
+int main() {
+  ASSERT(1, ({ int a[4], b[1] = {5}; copy0(a, b, 4); a[0] == 5 && a[3] == 8; }));
+  ASSERT(1, ({ int a[1] = {9}; copy0(a, 0, 0); a[0] == 9; }));
+  ASSERT(1, ({ int a[5] = {0, 10, 0, 0, 0}; copy1(a, a, 5); a[0] == 10 && a[1] == 11 && a[2] == 13 && a[4] == 15; }));
+  ASSERT(1, ({ float y[3]; int x = 7; fill(y, &x, 3); y[0] == 7.0f && y[2] == 7.0f; }));
+  ASSERT(258, ({ int x = 0; bytes((char *)&x, &x, 3); }));
+  ASSERT(1, ({ IntFloat u = {5}; pun(&u, 3) == 5 + 2 * 0x3f800000; }));
+  ASSERT(1, ({ float v[3] = {1, 2, 3}; Vec s = {3, v}; scale(&s, 2); v[0] == 2 && v[2] == 6; }));
+  ASSERT(1, ({ Cnt s = {9}; members(&s, &s.n, 3) == 9 && s.a[1] == 2; }));
+  ASSERT(6, ({ G = 0; H = 2; globals(3); G; }));
+  ASSERT(0, ({ int a[2] = {-1, 0}; guard(a, 0, 2); }));
+  ASSERT(0, cond(0, 3));
+  ASSERT(9, ({ int x = 3; cond(&x, 3); }));
+  ASSERT(1, ({ int k = 0, x = 4; once(&k, &x, 3) == 12 && k == 4; }));
+  ASSERT(1, ({ int k = 5, x = 4; once(&k, 0, 3) == 0 && k == 6; }));
+
+  printf("OK\n");
+  return 0;
+}
@@ -163,6 +163,56 @@ int main() {
   ASSERT(45, (long double)1 + 2 + (char)3 + 4 + 5 + (int)6 + (float)7 + 8 + 9);
   ASSERT(2, (long double)8 / 4 + 2 * 4 - 8);
 
+  printf("乘除以常量\n");
+  ASSERT(-123, ({ int i=-41; i*3; }));
+  ASSERT(119, ({ int i=17; i*7; }));
+  ASSERT(-68, ({ int i=17; i*-4; }));
+  ASSERT(1, ({ long i=1L<<40; i*10 == 10L<<40; }));
+  ASSERT(1, ({ unsigned i=5; i*0xffffffffu == -5u; }));
+  ASSERT(5, ({ unsigned i=5; i*0x80000001u % 16; }));
+  ASSERT(8, ({ unsigned i=5; i*0x80000001u >> 28; }));
+  ASSERT(8, ({ unsigned i=3; i*0x80000000u >> 28; }));
+  ASSERT(-7, ({ int i=7; i*(int)0xffffffffu; }));
+  ASSERT(-14, ({ int i=-100; i/7; }));
+  ASSERT(-2, ({ int i=-100; i%7; }));
+  ASSERT(14, ({ int i=-100; i/-7; }));
+  ASSERT(-12, ({ int i=-100; i/8; }));
+  ASSERT(-4, ({ int i=-100; i%8; }));
+  ASSERT(1, ({ unsigned i=-1; i/3 == 1431655765; }));
+  ASSERT(0, ({ unsigned i=-1; i%3; }));
+  ASSERT(1, ({ unsigned i=-1; i/0x80000001u; }));
+  ASSERT(1, ({ long i=-1000000000000L; i/1000 == -1000000000; }));
+  ASSERT(1, ({ unsigned long i=-1; i/7 == 2635249153387078802UL; }));
+  ASSERT(1, ({ unsigned long i=-1; i%10 == 5; }));
+  ASSERT(1, ({ long i=-9223372036854775807L-1; i/3 == -3074457345618258602L; }));
+
+  ASSERT(12, ({ int a[8]={0,2,4,6,8,10,12,14}; int i=6; a[i]; }));
+  ASSERT(12, ({ int a[8]={0,2,4,6,8,10,12,14}; unsigned i=6; a[i]; }));
+  ASSERT(3, ({ long a[4]={0,1,2,3}; unsigned i=3; a[i]; }));
+  ASSERT(5, ({ char a[8]={0,1,2,3,4,5}; unsigned i=5; a[i]; }));
+  ASSERT(1, ({ unsigned i=-1; long x=i; x == 4294967295L; }));
+  ASSERT(-1, ({ int i=255; (signed char)i; }));
+  ASSERT(65535, ({ int i=-1; (unsigned short)i; }));
+  ASSERT(1, ({ unsigned x=0x80000001; ((x<<1)|(x>>31)) == 3; }));
+  ASSERT(1, ({ unsigned x=0x80000001; int n=4; ((x<<n)|(x>>(32-n))) == 0x18; }));
+  ASSERT(1, ({ unsigned long x=1; int n=1; ((x>>n)|(x<<(64-n))) == 1UL<<63; }));
+  ASSERT(1, ({ unsigned long x=3; ((x>>1)|(x<<63)) == 0x8000000000000001UL; }));
+  ASSERT(8, ({ int x=12, y=5; x & ~y; }));
+  ASSERT(-3, ({ int x=1, y=2; x | ~y; }));
+  ASSERT(-7, ({ int x=12, y=10; x ^ ~y; }));
+  ASSERT(3, ({ int a=3, b=7; a<b?a:b; }));
+  ASSERT(7, ({ int a=3, b=7; a<b?b:a; }));
+  ASSERT(-5, ({ long a=-5, b=7; a<=b?a:b; }));
+  ASSERT(3, ({ unsigned a=-1, b=3; a<b?a:b; }));
+  ASSERT(1, ({ long x=0; int n=40; (x|(1L<<n)) == 1L<<40; }));
+  ASSERT(1, ({ long x=-1; int n=40; (x&~(1L<<n)) == ~(1L<<40); }));
+  ASSERT(1, ({ long x=0; int n=63; (x^(1L<<n)) == 1L<<63; }));
+  ASSERT(1, ({ long x=1L<<33; int n=33; (x>>n)&1; }));
+  ASSERT(1, ({ int x=-1; (x>>31)&1; }));
+  ASSERT(1, ({ long x=0; (x|0x100000) == 1048576; }));
+  ASSERT(1, ({ int x=-1; (x&~0x40000000) == -1073741825; }));
+  ASSERT(1, ({ long x=0; (x^(1L<<62)) == 4611686018427387904L; }));
+
   printf("OK\n");
   return 0;
 }
@@ -0,0 +1,107 @@
+#include "test.h"
+#include <stdatomic.h>
+
+_Atomic int G1 = 5;
+_Atomic(long) G2;
+_Atomic char G3 = 250;
+
+static int addFetch(_Atomic int *P, int N) { return *P += N; }
+
+int main() {
+  // _Atomic限定的对象和复合赋值
+  ASSERT(4, sizeof(_Atomic int));
+  ASSERT(8, sizeof(_Atomic(long)));
+  ASSERT(1, __builtin_types_compatible_p(_Atomic int, int));
+
+  ASSERT(5, G1);
+  ASSERT(7, G1 += 2);
+  ASSERT(4, G1 -= 3);
+  ASSERT(4, G1++);
+  ASSERT(4, --G1);
+  ASSERT(12, G1 *= 3);
+  ASSERT(4, G1 /= 3);
+  ASSERT(8, G1 <<= 1);
+  ASSERT(3, G1 %= 5);
+  ASSERT(10, addFetch(&G1, 7));
+  ASSERT(252, G3 += 2);
+  ASSERT(4, G3 += 8);
+  ASSERT(3, ({ _Atomic long x = 1; x |= 2; x; }));
+  ASSERT(2, ({ _Atomic short x = 3; x &= 6; x; }));
+  ASSERT(-1, ({ _Atomic short x = 1; x -= 2; x; }));
+  ASSERT(5, ({ _Atomic unsigned char x = 1; x ^= 4; x; }));
+  ASSERT(3, ({ _Atomic double x = 1.5; x *= 2; (int)x; }));
+  ASSERT(8, ({ int a[3]; int *_Atomic p = a; p += 2; (char *)p - (char *)a; }));
+  ASSERT(1, ({ _Atomic _Bool b = 0; b += 2; b; }));
+
+  ASSERT(3, ({ int x = 3; __atomic_load_n(&x, __ATOMIC_ACQUIRE); }));
+  ASSERT(9, ({ long x = 3; __atomic_store_n(&x, 9, __ATOMIC_RELEASE); x; }));
+  ASSERT(7, ({ short x = 3, y; __atomic_store_n(&x, 7, 0); __atomic_load(&x, &y, 5); y; }));
+  ASSERT(3, ({ int x = 3; __atomic_exchange_n(&x, 4, __ATOMIC_SEQ_CST); }));
+  ASSERT(4, ({ int x = 3; __atomic_exchange_n(&x, 4, __ATOMIC_SEQ_CST); x; }));
+  ASSERT(200, ({ unsigned char x = 200; __atomic_exchange_n(&x, 1, 5); }));
+  ASSERT(1, ({ unsigned char x = 200; __atomic_exchange_n(&x, 1, 5); x; }));
+
+  ASSERT(10, ({ int x = 10; __atomic_fetch_add(&x, 5, 5); }));
+  ASSERT(15, ({ int x = 10; __atomic_add_fetch(&x, 5, 5); }));
+  ASSERT(5, ({ long x = 10; __atomic_sub_fetch(&x, 5, 0); }));
+  ASSERT(8, ({ int x = 12; __atomic_and_fetch(&x, 10, 2); }));
+  ASSERT(14, ({ int x = 12; __atomic_or_fetch(&x, 10, 3); }));
+  ASSERT(6, ({ int x = 12; __atomic_xor_fetch(&x, 10, 4); }));
+  ASSERT(-9, ({ int x = 12; __atomic_nand_fetch(&x, 10, 5); }));
+  ASSERT(12, ({ long x = 12; __atomic_fetch_nand(&x, 10, 5); }));
+  ASSERT(-9, ({ long x = 12; __atomic_fetch_nand(&x, 10, 5); x; }));
+  ASSERT(-1, ({ int x = 0; __atomic_sub_fetch(&x, 1, 5); }));
+  ASSERT(1, ({ unsigned x = 0; __atomic_sub_fetch(&x, 1, 5) == 0xffffffff; }));
+  ASSERT(1, ({ unsigned x = 0; __atomic_fetch_sub(&x, 1, 5); x == 0xffffffff; }));
+
+  ASSERT(255, ({ unsigned char x = 0; __atomic_sub_fetch(&x, 1, 5); }));
+  ASSERT(-1, ({ signed char x = 0; __atomic_sub_fetch(&x, 1, 5); }));
+  ASSERT(0x1234, ({ short a[4] = {1, 2, 3, 4}; __atomic_store_n(&a[1], 0x1234, 5); a[1]; }));
+  ASSERT(0x0401, ({ char a[4] = {1, 2, 3, 4}; __atomic_fetch_or(&a[1], 0x80, 5); a[3] << 8 | a[0]; }));
+  ASSERT(0x82, ({ char a[4] = {1, 2, 3, 4}; __atomic_fetch_or(&a[1], 0x80, 5); a[1]; }));
+  ASSERT(0x300, ({ short a[4] = {1, 0x300, 3, 4}; __atomic_fetch_add(&a[1], 1, 5); }));
+  ASSERT(0x302, ({ short a[4] = {1, 0x301, 3, 4}; __atomic_add_fetch(&a[1], 1, 5); }));
+  ASSERT(4, ({ short a[4] = {1, 2, 3, 4}; __atomic_add_fetch(&a[3], 0, 5); }));
+  ASSERT(-4, ({ char a[4] = {1, 2, 3, 4}; __atomic_nand_fetch(&a[2], 3, 5); (signed char)a[2]; }));
+
+  ASSERT(1, ({ int x = 3, y = 3; __atomic_compare_exchange_n(&x, &y, 5, 0, 5, 5); }));
+  ASSERT(5, ({ int x = 3, y = 3; __atomic_compare_exchange_n(&x, &y, 5, 0, 5, 5); x; }));
+  ASSERT(0, ({ int x = 3, y = 4; __atomic_compare_exchange_n(&x, &y, 5, 0, 5, 5); }));
+  ASSERT(3, ({ int x = 3, y = 4; __atomic_compare_exchange_n(&x, &y, 5, 0, 5, 5); y; }));
+  ASSERT(1, ({ unsigned x = -1, y = -1; __atomic_compare_exchange_n(&x, &y, 5, 0, 5, 5); }));
+  ASSERT(1, ({ long x = -1, y = -1, z = 6; __atomic_compare_exchange(&x, &y, &z, 1, 5, 5); }));
+  ASSERT(6, ({ long x = -1, y = -1, z = 6; __atomic_compare_exchange(&x, &y, &z, 1, 5, 5); x; }));
+  ASSERT(1, ({ char a[4] = {1, 200, 3, 4}; char e = 200; __atomic_compare_exchange_n(&a[1], &e, 9, 0, 5, 5); }));
+  ASSERT(0x04030901, ({ char a[4] = {1, 200, 3, 4}; char e = 200; __atomic_compare_exchange_n(&a[1], &e, 9, 0, 5, 5); *(int *)a; }));
+  ASSERT(0, ({ short a[2] = {1, 2}; short e = 1; __atomic_compare_exchange_n(&a[1], &e, 9, 0, 5, 5); }));
+  ASSERT(2, ({ short a[2] = {1, 2}; short e = 1; __atomic_compare_exchange_n(&a[1], &e, 9, 0, 5, 5); e; }));
+
+  ASSERT(0, ({ char f = 0; __atomic_test_and_set(&f, 5); }));
+  ASSERT(1, ({ char f = 0; __atomic_test_and_set(&f, 5); __atomic_test_and_set(&f, 5); }));
+  ASSERT(0, ({ char f = 1; __atomic_clear(&f, 5); f; }));
+  ASSERT(1, __atomic_always_lock_free(sizeof(long), 0));
+  ASSERT(0, __atomic_is_lock_free(16, 0));
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+  ASSERT(3, ({ int x = 3; __sync_fetch_and_add(&x, 2); }));
+  ASSERT(5, ({ int x = 3; __sync_add_and_fetch(&x, 2); }));
+  ASSERT(1, ({ long x = 3; __sync_bool_compare_and_swap(&x, 3, 8); }));
+  ASSERT(0, ({ long x = 3; __sync_bool_compare_and_swap(&x, 4, 8); }));
+  ASSERT(3, ({ long x = 3; __sync_val_compare_and_swap(&x, 4, 8); }));
+  ASSERT(8, ({ long x = 3; __sync_val_compare_and_swap(&x, 3, 8); x; }));
+  ASSERT(0, ({ int l = 0; __sync_lock_test_and_set(&l, 1); }));
+  ASSERT(0, ({ int l = 1; __sync_lock_release(&l); l; }));
+  __sync_synchronize();
+
+  ASSERT(3, ({ atomic_int x; atomic_init(&x, 3); atomic_load(&x); }));
+  ASSERT(3, ({ atomic_int x = 1; atomic_fetch_add(&x, 2); x; }));
+  ASSERT(1, ({ atomic_long x = 1; atomic_fetch_sub_explicit(&x, 2, memory_order_relaxed); }));
+  ASSERT(9, ({ atomic_uint x = 1; atomic_store(&x, 9); atomic_exchange(&x, 2); }));
+  ASSERT(1, ({ atomic_int x = 1; int e = 1; atomic_compare_exchange_strong(&x, &e, 2); }));
+  ASSERT(0, ({ atomic_flag f = ATOMIC_FLAG_INIT; atomic_flag_test_and_set(&f); }));
+  ASSERT(1, ({ atomic_flag f = ATOMIC_FLAG_INIT; atomic_flag_test_and_set(&f); atomic_flag_test_and_set(&f); }));
+
+  printf("OK\n");
+  return 0;
+}
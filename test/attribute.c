@@ -0,0 +1,50 @@
+#include "test.h"
+#include <stddef.h>
+
+// 支持__attribute__((visibility))
+__attribute__((visibility("hidden"))) int g1 = 3;
+int g2 __attribute__((visibility("hidden"))) = 5;
+int g3 __attribute__((visibility("default"), unused));
+static int g4 __attribute__((unused)) = 7;
+
+int hiddenFn(int X) __attribute__((__visibility__("hidden")));
+int hiddenFn(int X) { return X + g1; }
+
+__attribute__((noinline, visibility("internal"))) static int internalFn(void) {
+  return g2;
+}
+
+typedef int MyInt __attribute__((aligned(4)));
+
+// 支持__attribute__((aligned))
+int a2 __attribute__((aligned(32)));
+int a3 __attribute__((aligned(1)));
+typedef int AlignedInt __attribute__((aligned(8)));
+struct AlignedMem { char a; int b __attribute__((__aligned__(16))); };
+
+int main() {
+  // 支持__attribute__((visibility))
+  ASSERT(3, g1);
+  ASSERT(5, g2);
+  ASSERT(0, g3);
+  ASSERT(7, g4);
+  ASSERT(13, hiddenFn(10));
+  ASSERT(5, internalFn());
+  ASSERT(4, ({ MyInt X __attribute__((unused)) = 4; X; }));
+  ASSERT(4, sizeof(MyInt));
+
+  // 支持__attribute__((aligned))
+  ASSERT(0, (long)&a2 % 32);
+  ASSERT(0, (long)&a3 % 4);
+  ASSERT(8, _Alignof(AlignedInt));
+  ASSERT(4, sizeof(AlignedInt));
+  ASSERT(16, _Alignof(struct AlignedMem));
+  ASSERT(32, sizeof(struct AlignedMem));
+  ASSERT(16, offsetof(struct AlignedMem, b));
+  ASSERT(32, ({ char x __attribute__((aligned(32))), y __attribute__((aligned(32))); &y-&x; }));
+  ASSERT(0, ({ static char c; static int x __attribute__((aligned(64))); (long)&x % 64; }));
+  ASSERT(16, ({ __attribute__((aligned)) char x, y; &y-&x; }));
+
+  printf("OK\n");
+  return 0;
+}
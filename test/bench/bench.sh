@@ -0,0 +1,141 @@
+#!/bin/bash
+# 性能基准测试
+# 第一部分：编译期基准，记录编译耗时、峰值内存、.s文件大小
+# 第二部分：生成代码的微基准，记录周期数和指令数
+#
+# 环境变量：
+#   CC        链接微基准所用的编译器
+#   RUN       运行微基准所用的命令前缀，如 "$RISCV/bin/qemu-riscv64 -L $RISCV/sysroot"
+#   CFLAGS    传给rvcc的额外参数，如系统头文件路径
+#   SQLITE    sqlite3.c合并文件的路径，不存在时尝试下载
+rvcc=`realpath $1`
+measure=`realpath test/bench/measure`
+micro=`realpath test/bench/micro`
+CC=${CC:-gcc}
+
+out=tmp-bench
+mkdir -p $out/gen $out/s $out/micro
+result=$out/result.txt
+# 保留上一次的结果，用于对比
+[ -f $result ] && mv $result $out/last.txt
+: > $result
+
+# 生成合成的压力测试文件
+
+# 深度嵌套的宏
+gen_macro() {
+  {
+    echo '#define M0(x) (x)'
+    for i in $(seq 1 40); do
+      echo "#define M$i(x) M$((i-1))((x) + $i)"
+    done
+    echo 'int f(int x) { return'
+    for i in $(seq 1 10); do echo "  M40(x) +"; done
+    echo '  0; }'
+  } > $out/gen/macro.c
+}
+
+# 巨大的初始化器
+gen_init() {
+  {
+    echo 'struct S { int a; char b[4]; double c; };'
+    echo 'int Arr[20000] = {'
+    seq 1 20000 | awk '{ printf "%d,", $1 * 31 % 1000; if (NR % 20 == 0) print "" }'
+    echo '};'
+    echo 'struct S Str[5000] = {'
+    seq 1 5000 | awk '{ printf "{%d, \"ab\", %d.5},\n", $1, $1 }'
+    echo '};'
+    echo 'int f(void) { int L[2000] = {'
+    seq 1 2000 | awk '{ printf "%d,", $1 }'
+    echo '}; return L[7]; }'
+  } > $out/gen/init.c
+}
+
+# 10000个case的switch
+gen_switch() {
+  {
+    echo 'int f(int x) {'
+    echo '  switch (x) {'
+    seq 0 9999 | awk '{ printf "  case %d: return %d;\n", $1, $1 * 3 + 1 }'
+    echo '  }'
+    echo '  return -1;'
+    echo '}'
+  } > $out/gen/switch.c
+}
+
+# 巨大的函数
+gen_func() {
+  {
+    echo 'int f(int a, int b) {'
+    for i in $(seq 0 499); do echo "  int v$i = a * $i + b;"; done
+    seq 0 4999 | awk '{ v = $1 % 500; printf "  if (v%d > b) v%d = v%d - %d; else v%d += a;\n", v, v, v, $1, v }'
+    echo '  return v0 + v499;'
+    echo '}'
+  } > $out/gen/func.c
+}
+
+gen_macro
+gen_init
+gen_switch
+gen_func
+
+# 获取sqlite合并文件
+if [ -z "$SQLITE" ]; then
+  SQLITE=$out/sqlite/sqlite3.c
+  if [ ! -f $SQLITE ]; then
+    mkdir -p $out/sqlite
+    url=https://www.sqlite.org/2022/sqlite-amalgamation-3380500.zip
+    (curl -sfL -o $out/sqlite/sqlite.zip $url &&
+       unzip -qjo $out/sqlite/sqlite.zip -d $out/sqlite) || rm -f $SQLITE
+  fi
+fi
+
+# 编译一个文件，记录 名称 耗时 峰值内存 .s大小
+compile() {
+  name=$1
+  shift
+  s=$out/s/$name.s
+  if stat=$($measure $rvcc $CFLAGS -S -o $s "$@" 2>&1 >/dev/null | tail -1) &&
+     [ -f $s ]; then
+    echo "compile.$name $stat $(wc -c < $s)" >> $result
+  else
+    echo "compile.$name failed" >> $result
+  fi
+}
+
+for f in $out/gen/*.c; do
+  compile $(basename $f .c) $f
+done
+
+# rvcc自身的源文件，与stage2所编译的相同
+for f in *.c; do
+  compile rvcc.$(basename $f .c) $f
+done
+
+if [ -f $SQLITE ]; then
+  compile sqlite $SQLITE
+else
+  echo "compile.sqlite skipped" >> $result
+fi
+
+# 运行微基准
+for f in $micro/*.c; do
+  name=$(basename $f .c)
+  exe=$out/micro/$name.exe
+  if $rvcc $CFLAGS -c -o $out/micro/$name.o $f &&
+     $CC -static -o $exe $out/micro/$name.o -xc $micro/common; then
+    $RUN $exe | grep "^$name\." >> $result
+  else
+    echo "micro.$name failed" >> $result
+  fi
+done
+
+# 输出结果，存在上一次的结果时一并列出
+echo "compile: name sec rss(KB) .s(bytes); micro: name cycles instret"
+if [ -f $out/last.txt ]; then
+  awk 'NR == FNR { last[$1] = $0; next }
+       { print $0; if ($1 in last) print "  last: " last[$1] }' \
+    $out/last.txt $result
+else
+  cat $result
+fi
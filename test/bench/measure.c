@@ -0,0 +1,49 @@
+// 运行一条命令，测量其耗时和峰值内存
+// 用法：measure 命令 参数...
+// 输出：秒数 峰值内存（KB）
+// 使用了wait4函数
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int Argc, char **Argv) {
+  if (Argc < 2) {
+    fprintf(stderr, "usage: %s command [args...]\n", Argv[0]);
+    return 1;
+  }
+
+  struct timespec Begin, End;
+  clock_gettime(CLOCK_MONOTONIC, &Begin);
+
+  // 子进程执行命令
+  pid_t Pid = fork();
+  if (Pid == 0) {
+    execvp(Argv[1], Argv + 1);
+    perror(Argv[1]);
+    _exit(127);
+  }
+
+  // 等待子进程结束，同时获取其资源使用情况
+  int Status;
+  struct rusage Usage;
+  if (wait4(Pid, &Status, 0, &Usage) < 0) {
+    perror("wait4");
+    return 1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &End);
+
+  double Sec =
+      (End.tv_sec - Begin.tv_sec) + (End.tv_nsec - Begin.tv_nsec) / 1e9;
+  // ru_maxrss在Linux上以KB为单位
+  fprintf(stderr, "%.3f %ld\n", Sec, Usage.ru_maxrss);
+
+  if (WIFEXITED(Status))
+    return WEXITSTATUS(Status);
+  return 1;
+}
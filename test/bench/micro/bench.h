@@ -0,0 +1,8 @@
+// 微基准测试公共声明，计数函数由common提供
+int printf(char *fmt, ...);
+void *memset(void *s, int c, long n);
+
+// 开始计数
+void benchBegin(void);
+// 结束计数，并输出：名称 周期数 指令数
+void benchEnd(char *Name);
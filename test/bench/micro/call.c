@@ -0,0 +1,35 @@
+#include "bench.h"
+
+// 函数调用：递归、多参数调用、函数指针调用
+
+static int fib(int N) { return N < 2 ? N : fib(N - 1) + fib(N - 2); }
+
+static long add8(long A, long B, long C, long D, long E, long F, long G,
+                 long H) {
+  return A + B + C + D + E + F + G + H;
+}
+
+static int inc(int X) { return X + 1; }
+static int dec(int X) { return X - 1; }
+
+int main() {
+  benchBegin();
+  int F = fib(22);
+  benchEnd("call.fib");
+
+  benchBegin();
+  long S = 0;
+  for (int I = 0; I < 50000; I++)
+    S += add8(I, 1, 2, 3, 4, 5, 6, 7);
+  benchEnd("call.args");
+
+  benchBegin();
+  int (*Fns[2])(int) = {inc, dec};
+  int X = 0;
+  for (int I = 0; I < 100000; I++)
+    X = Fns[I & 1](X) + 1;
+  benchEnd("call.indirect");
+
+  printf("%d %ld %d\n", F, S, X);
+  return 0;
+}
@@ -0,0 +1,41 @@
+#include "bench.h"
+
+// 浮点运算：累加、乘加、整数与浮点转换
+
+int main() {
+  benchBegin();
+  double Sum = 0;
+  for (int I = 1; I < 100000; I++)
+    Sum += 1.0 / I;
+  benchEnd("float.harmonic");
+
+  benchBegin();
+  int Inside = 0;
+  for (int Y = 0; Y < 40; Y++) {
+    for (int X = 0; X < 60; X++) {
+      double CR = X / 30.0 - 1.5, CI = Y / 20.0 - 1.0;
+      double ZR = 0, ZI = 0;
+      int K = 0;
+      while (K < 50 && ZR * ZR + ZI * ZI < 4.0) {
+        double T = ZR * ZR - ZI * ZI + CR;
+        ZI = 2 * ZR * ZI + CI;
+        ZR = T;
+        K++;
+      }
+      Inside += K == 50;
+    }
+  }
+  benchEnd("float.mandel");
+
+  benchBegin();
+  float FS = 0;
+  long L = 0;
+  for (int I = 0; I < 100000; I++) {
+    FS += (float)I * 0.5f;
+    L += (long)FS;
+  }
+  benchEnd("float.convert");
+
+  printf("%f %d %f %ld\n", Sum, Inside, FS, L);
+  return 0;
+}
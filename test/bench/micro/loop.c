@@ -0,0 +1,35 @@
+#include "bench.h"
+
+// 整数循环：数组求和、嵌套循环、while计数
+
+int Arr[4096];
+
+int main() {
+  benchBegin();
+  for (int I = 0; I < 4096; I++)
+    Arr[I] = I * 7 + 3;
+  long Sum = 0;
+  for (int K = 0; K < 100; K++)
+    for (int I = 0; I < 4096; I++)
+      Sum += Arr[I];
+  benchEnd("loop.sum");
+
+  benchBegin();
+  long Acc = 0;
+  for (int I = 0; I < 300; I++)
+    for (int J = 0; J < 300; J++)
+      Acc += (I ^ J) & 15;
+  benchEnd("loop.nested");
+
+  benchBegin();
+  unsigned X = 1;
+  int N = 0;
+  while (N < 200000) {
+    X = X * 1103515245 + 12345;
+    N++;
+  }
+  benchEnd("loop.while");
+
+  printf("%ld %ld %u\n", Sum, Acc, X);
+  return 0;
+}
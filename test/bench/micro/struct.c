@@ -0,0 +1,61 @@
+#include "bench.h"
+
+// 结构体复制：赋值、按值传参、按值返回
+
+typedef struct {
+  int A, B;
+} Small;
+
+typedef struct {
+  double X, Y;
+} Pair;
+
+typedef struct {
+  long V[16];
+} Big;
+
+static Small makeSmall(int I) {
+  Small S = {I, I + 1};
+  return S;
+}
+
+static double sumPair(Pair P) { return P.X + P.Y; }
+
+static Big passBig(Big B) {
+  B.V[0]++;
+  return B;
+}
+
+int main() {
+  benchBegin();
+  Small S;
+  long T = 0;
+  for (int I = 0; I < 50000; I++) {
+    S = makeSmall(I);
+    T += S.A + S.B;
+  }
+  benchEnd("struct.small");
+
+  benchBegin();
+  Pair P = {1.5, 2.5};
+  double D = 0;
+  for (int I = 0; I < 50000; I++)
+    D += sumPair(P);
+  benchEnd("struct.float");
+
+  benchBegin();
+  Big B;
+  memset(&B, 0, sizeof(B));
+  for (int I = 0; I < 20000; I++)
+    B = passBig(B);
+  benchEnd("struct.big");
+
+  benchBegin();
+  Big Arr[8];
+  for (int I = 0; I < 20000; I++)
+    Arr[I & 7] = B;
+  benchEnd("struct.copy");
+
+  printf("%ld %f %ld %ld\n", T, D, B.V[0], Arr[3].V[0]);
+  return 0;
+}
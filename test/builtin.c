@@ -1,5 +1,20 @@
 #include "test.h"
 
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+static int hint(int x) {
+  if (unlikely(x < 0))
+    return 2;
+  if (likely(x > 0) && !unlikely(x > 5))
+    x += 2;
+  else if (unlikely(x == 0))
+    x = 3;
+  else
+    x++;
+  return x;
+}
+
 int main() {
   printf("[255] [GNU] 支持__builtin_types_compatible_p\n");
   ASSERT(1, __builtin_types_compatible_p(int, int));
@@ -29,6 +44,65 @@ int main() {
 
   ASSERT(1, ({ struct {int a; int b;} x; __builtin_types_compatible_p(typeof(x.a), typeof(x.b)); }));
 
+  ASSERT(31, __builtin_clz(1));
+  ASSERT(0, __builtin_clz(0x80000000));
+  ASSERT(63, __builtin_clzl(1));
+  ASSERT(20, __builtin_clzll(0xfffffffffffL));
+  ASSERT(0, __builtin_ctz(1));
+  ASSERT(31, __builtin_ctz(0x80000000));
+  ASSERT(40, __builtin_ctzl(1L << 40));
+  ASSERT(32, __builtin_popcount(-1));
+  ASSERT(64, __builtin_popcountl(-1));
+  ASSERT(3, __builtin_popcountll(0x10000000101L));
+  ASSERT(4, ({ char x[__builtin_popcount(15)]; sizeof(x); }));
+  ASSERT(31, ({ unsigned x=1; __builtin_clz(x); }));
+  ASSERT(27, ({ int x=16; __builtin_clz(x); }));
+  ASSERT(0, ({ int x=-1; __builtin_clz(x); }));
+  ASSERT(23, ({ long x=1L<<40; __builtin_clzl(x); }));
+  ASSERT(0, ({ long x=-1; __builtin_clzl(x); }));
+  ASSERT(4, ({ int x=16; __builtin_ctz(x); }));
+  ASSERT(31, ({ int x=0x80000000; __builtin_ctz(x); }));
+  ASSERT(63, ({ unsigned long x=1UL<<63; __builtin_ctzl(x); }));
+  ASSERT(32, ({ int x=-1; __builtin_popcount(x); }));
+  ASSERT(5, ({ int x=0x1f; __builtin_popcount(x); }));
+  ASSERT(64, ({ long x=-1; __builtin_popcountl(x); }));
+  ASSERT(2, ({ long x=(1L<<50)|1; __builtin_popcountll(x); }));
+
+  ASSERT(3, __builtin_expect(3, 0));
+  ASSERT(1, ({ int x = 5; __builtin_expect(x > 3, 1); }));
+  ASSERT(8, sizeof(__builtin_expect(1, 1)));
+  ASSERT(2, hint(-1));
+  ASSERT(3, hint(0));
+  ASSERT(5, hint(3));
+  ASSERT(11, hint(10));
+  ASSERT(7, ({ int x = 7; __builtin_prefetch(&x); __builtin_prefetch(&x, 1, 0); x; }));
+  ASSERT(4, ({ int x = 4; if (x != 4) __builtin_unreachable(); x; }));
+  ASSERT(6, ({ int x = 3; if (x == 3) x = 6; else __builtin_unreachable(); x; }));
+  ASSERT(9, ({ int x = 9; switch (x) { case 9: break; default: __builtin_unreachable(); x = 1; } x; }));
+  ASSERT(1, ({ long a[4] = {1, 2, 3, 4}; long *p = __builtin_assume_aligned(a, 16); *p; }));
+  ASSERT(3, ({ long a[4] = {1, 2, 3, 4}; long *p = __builtin_assume_aligned(a + 1, 16, 8); p[1]; }));
+  ASSERT(7, ({ struct { char c[7]; } a = {{1, 2, 3, 4, 5, 6, 7}}, b; b = *(typeof(a) *)__builtin_assume_aligned(&a, 8); b.c[6]; }));
+  ASSERT(0, ({ struct { long a; int b; } x = {1, 2}, y; y = x; memcmp(&x, &y, sizeof(x)); }));
+
+  ASSERT(5, strlen("hello"));
+  ASSERT(2, __builtin_strlen("ab\0cd"));
+  ASSERT(3, ({ char *p = "xyz"; strlen(p); }));
+  ASSERT(0x0807060504030201, ({ long x = 0; char a[8] = {1, 2, 3, 4, 5, 6, 7, 8}; memcpy(&x, a, 8); x; }));
+  ASSERT(6, ({ struct { int a; short b; char c[6]; } x = {5, 6, "abc"}, y; __builtin_memcpy(&y, &x, sizeof(y)); y.b; }));
+  ASSERT(98, ({ struct { int a; short b; char c[6]; } x = {5, 6, "abc"}, y; __builtin_memcpy(&y, &x, sizeof(y)); y.c[1]; }));
+  ASSERT(1, ({ long a[3] = {1, 2, 3}, b[3]; char *p = memcpy(b, a, 24); p == (char *)b && b[2] == 3; }));
+  ASSERT(3, ({ char a[5] = "abcd"; memcpy(a + 1, a, 0); memcpy(a, a + 1, 3); a[2] - 'a'; }));
+  ASSERT(0x0101010101010101, ({ long x; memset(&x, 1, 8); x; }));
+  ASSERT(0, ({ int a[5] = {1, 2, 3, 4, 5}; __builtin_memset(a, 0, sizeof(a)); a[0] | a[4]; }));
+  ASSERT(0x7f7f, ({ short a[3] = {0}; int c = 0x37f; memset(a + 1, c, 4); a[2]; }));
+  ASSERT(1, ({ char a[7] = "abcdef"; memset(a + 1, 'x', 5) == a + 1 && a[0] == 'a' && a[5] == 'x'; }));
+  ASSERT(0, memcmp("abc", "abc", 3));
+  ASSERT(1, memcmp("abd", "abc", 3) > 0);
+  ASSERT(1, memcmp("abc", "abd", 3) < 0);
+  ASSERT(1, __builtin_memcmp("\xff", "\x01", 1) > 0);
+  ASSERT(0, ({ char *p = "abcdef"; memcmp(p + 2, "cd", 2); }));
+  ASSERT(0, memcmp("ab", "cd", 0));
+
   printf("OK\n");
   return 0;
 }
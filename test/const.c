@@ -1,5 +1,13 @@
 #include "test.h"
 
+// const限定的全局变量放入只读段
+const int g1 = 3;
+const char g2[] = "abc";
+const struct { int a; const char *b; } g3 = {5, "xyz"};
+char *const g4 = "abc";
+
+const char *lit(void) { return "abc"; }
+
 int main() {
   // [136] 忽略const volatile auto register restrict _Noreturn
   { const x; }
@@ -10,6 +18,16 @@ int main() {
   ASSERT(8, ({ const x = 8; int *const y=&x; *y; }));
   ASSERT(6, ({ const x = 6; *(const * const)&x; }));
 
+  ASSERT(3, g1);
+  ASSERT('b', g2[1]);
+  ASSERT(5, g3.a);
+  ASSERT('z', g3.b[2]);
+  ASSERT(7, ({ static const int x = 7; x; }));
+  // 相同的字符串字面量共用同一个变量
+  ASSERT(1, g4 == lit());
+  ASSERT(0, g2 == lit());
+  ASSERT(1, sizeof(L"ab") == sizeof(int) * 3 && L"ab" != (void *)U"ab");
+
   printf("OK\n");
   return 0;
 }
@@ -169,6 +169,9 @@ check inline
 echo 'static inline void f1() {} static inline void f2() { f1(); } void foo() { f2(); }' | $rvcc -o- -S -xc - | grep -q f1:
 check inline
 
+echo 'static inline int f1(int); int foo() { return f1(1); } static inline int f1(int x) { return x; }' | $rvcc -o- -S -xc - | grep -q f1:
+check 'inline prototype'
+
 echo 'static inline void f1() {} static inline void f2() { f1(); } void foo() { f2(); }' | $rvcc -o- -S -xc - | grep -q f2:
 check inline
 
@@ -380,4 +383,314 @@ else
 fi
 check -Xlinker
 
+# -fcache-dir
+# 编译缓存
+echo 'int foo(int x) { return x + 1; }' > $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -S -o $tmp/cache1.s $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -S -o $tmp/cache2.s $tmp/cache.c
+cmp -s $tmp/cache1.s $tmp/cache2.s
+check -fcache-dir
+$rvcc -fcache-dir=$tmp/cache -fcache-stats | grep -q 'hits *1$'
+check -fcache-stats
+
+$rvcc -fcache-dir=$tmp/cache -c -o $tmp/cache1.o $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -c -o $tmp/cache2.o $tmp/cache.c
+cmp -s $tmp/cache1.o $tmp/cache2.o
+check -fcache-dir
+$rvcc -fcache-dir=$tmp/cache -fcache-stats | grep -q 'hits *2$'
+check -fcache-stats
+
+# 行号变化时不能命中
+(echo; cat $tmp/cache.c) > $tmp/cache2.c
+mv $tmp/cache2.c $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -S -o $tmp/cache1.s $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -fcache-stats | grep -q 'misses *3$'
+check -fcache-dir
+
+# -fcache-max-size=
+echo 'int bar(void) { return 1; }' >> $tmp/cache.c
+$rvcc -fcache-dir=$tmp/cache -fcache-max-size=1K -S -o $tmp/cache1.s $tmp/cache.c
+[ $(ls $tmp/cache | wc -l) = 1 ]
+check -fcache-max-size
+
+# -fvisibility=
+# 位置无关代码中，可能被抢占的符号通过GOT访问，其他的符号使用PC相对寻址
+echo 'int x; static int y; int get(void) { return x + y; }' > $tmp/vis.c
+$rvcc -fPIC -S -o- $tmp/vis.c | grep -q '  la a0, x'
+check -fPIC
+$rvcc -fPIC -S -o- $tmp/vis.c | grep -q 'lla a0, y'
+check -fPIC
+$rvcc -fPIC -fvisibility=hidden -S -o- $tmp/vis.c | grep -q '.hidden x'
+check -fvisibility=hidden
+$rvcc -fPIC -fvisibility=hidden -S -o- $tmp/vis.c | grep -q 'lla a0, x'
+check -fvisibility=hidden
+echo 'int x __attribute__((visibility("default"))); int get(void) { return x; }' > $tmp/vis.c
+$rvcc -fPIC -fvisibility=hidden -S -o- $tmp/vis.c | grep -q '  la a0, x'
+check -fvisibility=hidden
+
+# -ftls-model=
+# 可执行文件中，定义的变量使用local-exec，外部的变量使用initial-exec
+echo '_Thread_local int x; extern _Thread_local int y; int get(void) { return x + y; }' > $tmp/tls.c
+$rvcc -S -o- $tmp/tls.c | grep -q 'tprel_hi(x)'
+check -ftls-model
+$rvcc -S -o- $tmp/tls.c | grep -q 'tls_ie_pcrel_hi(y)'
+check -ftls-model
+$rvcc -fPIC -S -o- $tmp/tls.c | grep -q 'tls_gd_pcrel_hi(y)'
+check -ftls-model
+$rvcc -fPIC -ftls-model=initial-exec -S -o- $tmp/tls.c | grep -q 'tls_ie_pcrel_hi(y)'
+check -ftls-model=initial-exec
+! $rvcc -ftls-model=foo -S -o- $tmp/tls.c 2> /dev/null
+check -ftls-model=foo
+# 多次访问同一个局部的变量时，缓存第一次调用__tls_get_addr的结果
+echo 'static _Thread_local int x; int get(void) { return x + x + x; }' > $tmp/tls.c
+[ "$($rvcc -fPIC -S -o- $tmp/tls.c | grep -c 'bnez a0, .L.tls')" = 3 ]
+check -ftls-model=local-dynamic
+# 只在sizeof中出现的变量不调用__tls_get_addr
+echo 'static _Thread_local int x; int get(void) { return sizeof(x) + sizeof(x); }' > $tmp/tls.c
+! $rvcc -fPIC -S -o- $tmp/tls.c | grep -q __tls_get_addr
+check -ftls-model=local-dynamic
+echo '_Thread_local int x __attribute__((tls_model("local-exec"))); int get(void) { return x; }' > $tmp/tls.c
+$rvcc -fPIC -S -o- $tmp/tls.c | grep -q 'tprel_hi(x)'
+check 'tls_model("local-exec")'
+
+# -msmall-data-limit=
+# 小的全局变量放入小数据段，通过符号直接读写
+echo 'int x = 1; long y; char z[16]; int get(void) { y = x; return z[0]; }' > $tmp/sdata.c
+$rvcc -fno-common -S -o- $tmp/sdata.c | grep -q '.section .sdata'
+check -msmall-data-limit
+$rvcc -fno-common -S -o- $tmp/sdata.c | grep -q '.section .sbss'
+check -msmall-data-limit
+$rvcc -S -o- $tmp/sdata.c | grep -q 'lw a0, x'
+check -msmall-data-limit
+$rvcc -S -o- $tmp/sdata.c | grep -q 'sd a0, y, t0'
+check -msmall-data-limit
+! $rvcc -msmall-data-limit=0 -S -o- $tmp/sdata.c | grep -q 'lw a0, x'
+check -msmall-data-limit=0
+! $rvcc -fPIC -S -o- $tmp/sdata.c | grep -q 'section .sdata'
+check -fPIC
+
+# .rodata
+# const限定的变量和字符串字面量放入只读段，相同的字符串字面量只输出一次
+echo 'const int x[4] = {1}; char *f(void) { return "abc"; } char *g(void) { return "abc"; }' > $tmp/rodata.c
+$rvcc -S -o- $tmp/rodata.c | grep -q 'section .rodata$'
+check .rodata
+$rvcc -S -o- $tmp/rodata.c | grep -q 'section .rodata.str1.1'
+check .rodata.str1.1
+[ "$($rvcc -S -o- $tmp/rodata.c | grep -c 'size .L..[0-9]*, 4')" = 1 ]
+check .rodata.str1.1
+
+# 数据指示
+# 初始值使用.zero/.string/.quad等紧凑的指示输出
+echo 'char x[100000] = {1}; char y[] = "hello world"; long z[2] = {3, 4};' > $tmp/data.c
+$rvcc -S -o- $tmp/data.c | grep -q '.zero 99992'
+check .zero
+$rvcc -S -o- $tmp/data.c | grep -q '.string "hello world"'
+check .string
+$rvcc -S -o- $tmp/data.c | grep -q '.quad 3, 4'
+check .quad
+
+# -O1
+# 窥孔优化：常量折叠进立即数和偏移量，用寄存器代替压栈弹栈，删除多余的跳转
+echo 'int sum(int *a, int n) { int s = 0; for (int i = 0; i < n; i++) s += a[i]; return s; }' > $tmp/peephole.c
+$rvcc -O0 -mno-rvc -S -o- $tmp/peephole.c | grep -q 'sd a0, 0(sp)'
+check -O0
+! $rvcc -O1 -mno-rvc -S -o- $tmp/peephole.c | grep -q 'sd a0, 0(sp)'
+check -O1
+echo 'void foo(int *p); void bar(void) { int x = 0; foo(&x); }' > $tmp/zero.c
+$rvcc -O1 -mno-rvc -S -o- $tmp/zero.c | grep -q 'sw zero, -[0-9]*(fp)'
+check -O1
+! $rvcc -O1 -S -o- $tmp/peephole.c | grep -q 'fsgnj.d'
+check -O1
+[ $($rvcc -O1 -S -o- $tmp/peephole.c | grep -c '^  [a-z]') -lt \
+  $($rvcc -O0 -S -o- $tmp/peephole.c | grep -c '^  [a-z]') ]
+check -O1
+
+# 局部变量
+# -O1时地址未被获取的整型和指针局部变量放入s寄存器
+$rvcc -O1 -S -o- $tmp/peephole.c | grep -q 'addiw s[0-9]*, s[0-9]*, 1'
+check 'register locals'
+! $rvcc -O0 -S -o- $tmp/peephole.c | grep -q 'addiw s[0-9]*, s[0-9]*, 1'
+check 'register locals'
+$rvcc -O1 -S -o- $tmp/zero.c | grep -q 'sw zero'
+check 'register locals'
+echo 'int setjmp(void *); int foo(void *b) { int i = 0; if (setjmp(b)) return i; i++; i++; i++; return i; }' > $tmp/setjmp.c
+! $rvcc -O1 -S -o- $tmp/setjmp.c | grep -q 's1'
+check 'register locals'
+echo 'void foo(void (*f)(int)) { f(1); f(2); f(3); }' > $tmp/fnptr.c
+$rvcc -O1 -S -o- $tmp/fnptr.c | grep -q 'jalr s1'
+check 'register locals'
+
+# -fmove-loop-invariants
+# 循环优化：不变量放入s寄存器，数组元素的地址每次迭代递增，展开小循环
+echo 'long K; void foo(int *a, int *b, int n) { for (int i = 0; i < n; i++) a[i] = b[i] * K; }' > $tmp/loop.c
+$rvcc -O1 -S -o- $tmp/loop.c | sed -n '1,/^.L.begin/p' | grep -q 'ld a0, K'
+check -fmove-loop-invariants
+! $rvcc -O0 -S -o- $tmp/loop.c | sed -n '1,/^.L.begin/p' | grep -q 'ld a0, K'
+check -fmove-loop-invariants
+! $rvcc -O1 -fno-move-loop-invariants -fno-ivopts -S -o- $tmp/loop.c | sed -n '1,/^.L.begin/p' | grep -q 'ld a0, K'
+check -fno-move-loop-invariants
+$rvcc -O1 -S -o- $tmp/loop.c | grep -q 'addi s[0-9]*, s[0-9]*, 4'
+check -fivopts
+! $rvcc -O1 -fno-ivopts -S -o- $tmp/loop.c | grep -q 'addi s[0-9]*, s[0-9]*, 4'
+check -fno-ivopts
+echo 'int foo(int *a) { int s = 0; for (int i = 0; i < 4; i++) s += a[i]; return s; }' > $tmp/unroll.c
+$rvcc -O1 -S -o- $tmp/unroll.c | grep -q '^.L.begin'
+check -funroll-loops
+! $rvcc -O1 -funroll-loops -S -o- $tmp/unroll.c | grep -q '^.L.begin'
+check -funroll-loops
+
+# -fstrict-aliasing
+# 别名分析：写入float不影响int，restrict指针不与其他指针重叠
+echo 'void foo(float *y, int *x, int n) { for (int i = 0; i < n; i++) y[i] = *x; }' > $tmp/alias.c
+$rvcc -O1 -S -o- $tmp/alias.c | grep -q '^.L.body'
+check -fstrict-aliasing
+! $rvcc -O1 -fno-strict-aliasing -S -o- $tmp/alias.c | grep -q '^.L.body'
+check -fno-strict-aliasing
+echo 'void foo(int *restrict a, int *restrict b, int n) { for (int i = 0; i < n; i++) a[i] = b[i] + 1; }' > $tmp/alias.c
+! $rvcc -march=rv64gcv -S -o- $tmp/alias.c | grep -q 'noalias'
+check restrict
+sed -i 's/restrict//g' $tmp/alias.c
+$rvcc -march=rv64gcv -S -o- $tmp/alias.c | grep -q 'noalias'
+check restrict
+
+# -fschedule-insns2
+# 指令调度：在加载和乘除法的结果可用前执行其他无关的指令
+echo 'long foo(long *a, long *b, long n) { return a[0] * n + b[1]; }' > $tmp/sched.c
+! $rvcc -O1 -S -o- $tmp/sched.c | grep -A1 'ld a0, 0(a0)' | grep -q 'mul'
+check -fschedule-insns2
+$rvcc -O1 -fno-schedule-insns2 -S -o- $tmp/sched.c | grep -A1 'ld a0, 0(a0)' | grep -q 'mul'
+check -fno-schedule-insns2
+$rvcc -O1 -mtune=sifive-7-series -S -o- $tmp/sched.c > /dev/null &&
+  $rvcc -O1 -mtune=generic-ooo -S -o- $tmp/sched.c > /dev/null
+check -mtune
+! $rvcc -O1 -mtune=foo -S -o- $tmp/sched.c > /dev/null 2>&1
+check -mtune
+
+# -mrvc
+# 默认生成便于压缩的代码：相对sp访问栈内变量
+echo 'int foo(int x) { int y = x + 1; return y * 2; }' > $tmp/rvc.c
+$rvcc -S -o- $tmp/rvc.c | grep -q '.option rvc'
+check -mrvc
+$rvcc -S -o- $tmp/rvc.c | grep -q 'sw a0, [0-9]*(sp)'
+check -mrvc
+$rvcc -mno-rvc -S -o- $tmp/rvc.c | grep -q '.option norvc'
+check -mno-rvc
+! $rvcc -mno-rvc -S -o- $tmp/rvc.c | grep -q 'sw a0, [0-9]*(sp)'
+check -mno-rvc
+# 调用alloca的函数中sp会变化，仍相对fp访问
+echo 'void *alloca(unsigned long); int foo(int x) { char *p = alloca(x); p[0] = 1; return x; }' > $tmp/rvc.c
+! $rvcc -S -o- $tmp/rvc.c | grep -q 'sw a0, [0-9]*(sp)'
+check -mrvc
+
+# -march
+# 位操作扩展
+echo 'int foo(int *a, long i) { return a[i] + __builtin_popcount(i); }' > $tmp/march.c
+$rvcc -march=rv64gc_zba -S -o- $tmp/march.c | grep -q 'sh2add'
+check -march
+! $rvcc -S -o- $tmp/march.c | grep -q 'sh2add'
+check -march
+$rvcc -march=rv64gc_zbb -S -o- $tmp/march.c | grep -q 'cpopw'
+check -march
+! $rvcc -march=rv64gc_zba -S -o- $tmp/march.c | grep -q 'cpopw'
+check -march
+echo __riscv_zbb | $rvcc -march=rv64gcb -E - | grep -q '^1$'
+check -march
+$rvcc -march=rv64g -S -o- $tmp/march.c | grep -q '.option norvc'
+check -march
+! $rvcc -march=x86-64 -S -o- $tmp/march.c 2> /dev/null
+check -march
+# 向量扩展：自动向量化循环
+echo 'void foo(int n, int *a, int *b) { for (int i = 0; i < n; i++) a[i] += b[i] * 3; }' > $tmp/vec.c
+$rvcc -march=rv64gcv -S -o- $tmp/vec.c | grep -q 'vsetvli'
+check -march
+! $rvcc -S -o- $tmp/vec.c | grep -q 'vsetvli'
+check -march
+! $rvcc -march=rv64gcv -fno-tree-vectorize -S -o- $tmp/vec.c | grep -q 'vsetvli'
+check -march
+echo __riscv_vector | $rvcc -march=rv64gcv -E - | grep -q '^1$'
+check -march
+# 向量类型：开启V扩展时使用RVV指令，否则使用SWAR或逐个元素计算
+echo 'typedef int v4si __attribute__((vector_size(16))); v4si foo(v4si a, v4si b) { return a * b + 1; }' > $tmp/vecty.c
+$rvcc -march=rv64gcv -S -o- $tmp/vecty.c | grep -q 'vmul.vv'
+check -march
+! $rvcc -S -o- $tmp/vecty.c | grep -q 'vsetivli'
+check -march
+echo 'typedef char v16qi __attribute__((vector_size(16))); v16qi foo(v16qi a, v16qi b) { return a + b; }' > $tmp/vecty.c
+$rvcc -S -o- $tmp/vecty.c | grep -q '0x8080808080808080'
+check -march
+echo 'typedef int v4si __attribute__((vector_size(16))); int foo(v4si a) { return !a; }' > $tmp/vecty.c
+! $rvcc -S -o /dev/null $tmp/vecty.c 2> /dev/null
+check -march
+
+# _Atomic
+# 原子操作使用amo指令和内存屏障
+echo '_Atomic int x; int f(int *p) { x += 2; return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED); }' > $tmp/atomic.c
+$rvcc -S -o- $tmp/atomic.c | grep -q 'amoadd.w.aqrl'
+check _Atomic
+$rvcc -S -o- $tmp/atomic.c | grep -q 'amoadd.w a0'
+check _Atomic
+echo 'int g(_Atomic long *p) { return *p; }' > $tmp/atomic.c
+$rvcc -S -o- $tmp/atomic.c | grep -q 'fence r, rw'
+check _Atomic
+echo __STDC_NO_ATOMICS__ | $rvcc -E - | grep -q '^__STDC_NO_ATOMICS__$'
+check _Atomic
+
+# __builtin_expect
+# 不太可能执行的分支放在函数末尾
+echo 'int g(void); int f(int x) { if (__builtin_expect(x, 0)) return g(); return 1; }' > $tmp/expect.c
+$rvcc -S -o- $tmp/expect.c | sed -n '/ret$/,$p' | grep -q 'call g'
+check __builtin_expect
+
+# __builtin_prefetch
+# 支持Zicbop扩展时生成prefetch指令
+echo 'void f(int *p) { __builtin_prefetch(p); __builtin_prefetch(p + 1, 1); }' > $tmp/prefetch.c
+$rvcc -march=rv64gc_zicbop -S -o- $tmp/prefetch.c | grep -q '^  prefetch.r'
+check __builtin_prefetch
+$rvcc -march=rv64gc_zicbop -S -o- $tmp/prefetch.c | grep -q '^  prefetch.w'
+check __builtin_prefetch
+! $rvcc -S -o- $tmp/prefetch.c | grep -q '^  prefetch'
+check __builtin_prefetch
+
+# -fno-builtin
+# 常量大小的memcpy等内联展开
+echo 'void *memcpy(void *, const void *, unsigned long);' > $tmp/builtin.c
+echo 'void f(long *d, long *s) { memcpy(d, s, 16); }' >> $tmp/builtin.c
+echo 'void g(long *d, long *s) { memcpy(d, s, 1024); }' >> $tmp/builtin.c
+echo 'void h(long *d, long *s) { __builtin_memcpy(d, s, 16); }' >> $tmp/builtin.c
+! $rvcc -S -o- $tmp/builtin.c | sed -n '/^f:/,/ret$/p' | grep -q 'call memcpy'
+check -fbuiltin
+$rvcc -S -o- $tmp/builtin.c | sed -n '/^g:/,/ret$/p' | grep -q 'call memcpy'
+check -fbuiltin
+$rvcc -fno-builtin -S -o- $tmp/builtin.c | sed -n '/^f:/,/ret$/p' | grep -q 'call memcpy'
+check -fno-builtin
+! $rvcc -fno-builtin -S -o- $tmp/builtin.c | sed -n '/^h:/,/ret$/p' | grep -q 'call memcpy'
+check -fno-builtin
+
+# -fcodegen-threads
+# 多线程生成的代码与单线程相同
+for i in $(seq 100); do
+  echo "int f$i(int x) { return x ? f$i(x - 1) + $i : 0; }"
+done > $tmp/threads.c
+$rvcc -fcodegen-threads=1 -S -o $tmp/threads1.s $tmp/threads.c
+$rvcc -fcodegen-threads=4 -S -o $tmp/threads4.s $tmp/threads.c
+cmp -s $tmp/threads1.s $tmp/threads4.s
+check -fcodegen-threads
+
+# --server
+# 编译服务器
+$rvcc --server=$tmp/server.sock 2> /dev/null &
+server=$!
+trap 'kill $server; rm -rf $tmp' INT TERM HUP EXIT
+for i in $(seq 50); do [ -S $tmp/server.sock ] && break; sleep 0.1; done
+echo '#include <stddef.h>
+int foo(void) { return sizeof(size_t); }' > $tmp/server.c
+$rvcc -S -o $tmp/server1.s $tmp/server.c
+RVCC_SERVER=$tmp/server.sock $rvcc -S -o $tmp/server2.s $tmp/server.c
+RVCC_SERVER=$tmp/server.sock $rvcc -S -o $tmp/server3.s $tmp/server.c
+cmp -s $tmp/server1.s $tmp/server2.s && cmp -s $tmp/server1.s $tmp/server3.s
+check --server
+echo 'int x = ;' > $tmp/server.c
+! RVCC_SERVER=$tmp/server.sock $rvcc -S -o $tmp/server1.s $tmp/server.c 2> /dev/null
+check --server
+
 echo OK
@@ -464,6 +464,11 @@ inline int inline_fn(void) {
   return 3;
 }
 
+// 先声明原型，使用之后再定义的静态内联函数
+static inline int inline_proto(int x);
+int inline_proto_use(int x) { return inline_proto(x) + 1; }
+static inline int inline_proto(int x) { return x * 2; }
+
 // [280] 支持long double
 int add_long_double(int a, long double b, float c);
 double to_double(long double x) { return x; }
@@ -486,6 +491,15 @@ long double ld_num2(long double A, long double B) {
   return Y / X[19] + 1 + A + B;
 }
 
+int mix_args(int a, double b, int *c, float d, long e, char f) {
+  return a * 100000 + (int)b * 10000 + *c * 1000 + (int)d * 100 + e * 10 + f;
+}
+int mix_g = 4;
+int mix_bump(void) { mix_g++; return 9; }
+double mix_half(double x) { return x / 2; }
+typedef struct {long a, b, c;} MixBig;
+long mix_big(int x, MixBig s, int y) { return x + s.a + s.b + s.c + y; }
+
 int main() {
   // [25] 支持零参函数定义
   ASSERT(3, ret3());
@@ -1237,6 +1251,7 @@ int main() {
 
   printf("[260] 将inline函数作为static函数\n");
   ASSERT(3, inline_fn());
+  ASSERT(7, inline_proto_use(3));
 
   printf("[280] 支持long double\n");
   ASSERT(10, ({add_long_double(2,3.8,5.2);}));
@@ -1275,5 +1290,13 @@ int main() {
 
   ASSERT(10, ({ ld_num2(3, 1); }));
 
+  ASSERT(123456, ({ int c=3; mix_args(1, 2.5, &c, 4.5f, 5, 6); }));
+  ASSERT(923456, ({ int c=3; mix_args(mix_bump(), 2, &c, 4, 5, 6); }));
+  ASSERT(5, ({ mix_g; }));
+  ASSERT(253456, ({ int c[2]={0,3}; mix_args(2, mix_half(10), &c[1], 4, 5, 6); }));
+  ASSERT(123456, ({ int (*fp)(int,double,int*,float,long,char)=mix_args; int c=3; fp(1, 2, &c, 4, 5, 6); }));
+  ASSERT(69, ({ MixBig s={10,20,30}; mix_big(4, s, 5); }));
+  ASSERT(67, ({ MixBig s={10,20,30}; int x=1; mix_big(x+1, s, x*5); }));
+
   printf("OK\n");
 }
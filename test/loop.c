@@ -0,0 +1,141 @@
+#include "test.h"
+
+// 这些循环在-O1时会外提不变量、递增数组元素的地址，结果须与-O0相同
+
+static void scale(int *a, int *b, int n, int k) {
+  for (int i = 0; i < n; i++)
+    a[i] = b[i] * k;
+}
+
+static void stencil(long *d, long *s, int n) {
+  for (int i = 1; i < n - 1; i++)
+    d[i] = s[i - 1] + s[i] * 2 + s[i + 1];
+}
+
+static int skip(int *a, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    if (a[i] < 0)
+      continue;
+    s += a[i];
+  }
+  return s;
+}
+
+static long down(short *a, long n) {
+  long s = 0;
+  for (long i = n - 1; i >= 0; i -= 2)
+    s = s * 3 + a[i];
+  return s;
+}
+
+static unsigned wrap(int *a, unsigned lo, unsigned hi) {
+  unsigned s = 0;
+  for (unsigned i = lo; i != hi; i++)
+    s += a[i - lo];
+  return s;
+}
+
+static int matmul(int m[4][4], int x[4][4], int y[4][4]) {
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++) {
+      int s = 0;
+      for (int k = 0; k < 4; k++)
+        s += x[i][k] * y[k][j];
+      m[i][j] = s;
+    }
+  return m[3][3];
+}
+
+static int count(char *s) {
+  int n = 0;
+  do
+    n++;
+  while (*s++);
+  return n;
+}
+
+// 循环中写入了可能为不变量的内存，不能外提读取
+static int alias(int *a, int *n) {
+  int s = 0;
+  for (int i = 0; i < *n; i++) {
+    s += a[i];
+    a[i + 1] = 0;
+    if (i == 2)
+      *n = 5;
+  }
+  return s;
+}
+
+static int GN;
+static void bump(void) { GN--; }
+
+static int call(int *a) {
+  int s = 0;
+  for (int i = 0; i < GN; i++) {
+    s += a[i];
+    bump();
+  }
+  return s;
+}
+
+static int Flag;
+static volatile int Spins;
+
+static int spin(volatile int *p) {
+  int n = 0;
+  while (*p) {
+    if (++n == 100)
+      *p = 0;
+  }
+  return n;
+}
+
+// 使用超过s1~s11个寄存器的值
+static long many(long *a, long *b, long *c, long *d, long *e, long *f, long *g,
+                 long *h, long k1, long k2, long k3, long k4, int n) {
+  long s = 0;
+  for (int i = 0; i < n; i++)
+    s += a[i] * k1 + b[i] * k2 + c[i] * k3 + d[i] * k4 + e[i] + f[i] + g[i] +
+         h[i] + k1 * k2 + k3 * k4;
+  return s;
+}
+
+static int small(void) {
+  int a[6] = {1, 2, 3, 4, 5, 6};
+  int s = 0;
+  for (int i = 0; i < 6; i++)
+    s = s * 10 + a[i];
+  return s;
+}
+
+static int small2(void) {
+  int s = 0, i;
+  for (i = 10; i > 3; i -= 3)
+    s += i;
+  return s * 100 + i;
+}
+
+int main() {
+  ASSERT(1, ({ int a[20], b[20]; for (int i = 0; i < 20; i++) b[i] = i - 7; scale(a, b, 20, -3); a[0] == 21 && a[19] == -36; }));
+  ASSERT(1, ({ int a[2] = {5, 5}, b[2] = {1, 1}; scale(a, b, 0, 2); a[0] == 5; }));
+  ASSERT(1, ({ long d[10] = {}, s[10]; for (int i = 0; i < 10; i++) s[i] = i * i; stencil(d, s, 10); d[0] == 0 && d[1] == 6 && d[8] == 258 && d[9] == 0; }));
+  ASSERT(12, ({ int a[6] = {1, -2, 3, -4, 8, -16}; skip(a, 6); }));
+  ASSERT(55, ({ short a[6] = {0, 1, 2, 3, 4, 5}; down(a, 6); }));
+  ASSERT(0, ({ short a[1]; down(a, 0); }));
+  ASSERT(10, ({ int a[4] = {1, 2, 3, 4}; wrap(a, 0xfffffffe, 2); }));
+  ASSERT(0, ({ int a[1]; wrap(a, 7, 7); }));
+  ASSERT(1, ({ int m[4][4], x[4][4], y[4][4]; for (int i = 0; i < 4; i++) for (int j = 0; j < 4; j++) { x[i][j] = i + j; y[i][j] = i - j; } matmul(m, x, y); m[0][0] == 14 && m[3][3] == -22 && m[1][2] == 0 && m[2][1] == 12; }));
+  ASSERT(6, count("hello"));
+  ASSERT(1, count(""));
+  ASSERT(1, ({ int a[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, n = 9; alias(a, &n) == 1 && n == 5 && a[5] == 0; }));
+  ASSERT(15, ({ int a[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}; GN = 10; call(a); }));
+  ASSERT(100, ({ Spins = 1; spin(&Spins); }));
+  ASSERT(0, ({ Flag = 0; spin((volatile int *)&Flag); }));
+  ASSERT(1, ({ long a[5], b[5], c[5], d[5], e[5], f[5], g[5], h[5]; for (int i = 0; i < 5; i++) a[i] = b[i] = c[i] = d[i] = e[i] = f[i] = g[i] = h[i] = i + 1; many(a, b, c, d, e, f, g, h, 1, 2, 3, 4, 5) == 15 * 14 + 5 * 14; }));
+  ASSERT(123456, small());
+  ASSERT(2101, small2());
+
+  printf("OK\n");
+  return 0;
+}
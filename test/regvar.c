@@ -0,0 +1,116 @@
+#include "test.h"
+
+// -O1时这些局部变量放入s寄存器，结果须与-O0相同
+
+static int wrap(void) {
+  unsigned u = 0xfffffff0;
+  unsigned char c = 250;
+  short s = 32767;
+  _Bool b = 0;
+  for (int i = 0; i < 20; i++) {
+    u += 1;
+    c++;
+    s += 1;
+    b = i & 2;
+  }
+  return u == 4 && c == 14 && s == -32749 && b == 1;
+}
+
+static long compound(long x) {
+  int i = 7;
+  unsigned char c = 3;
+  char *p = "abcdef";
+  i *= x;
+  i <<= 2;
+  i -= 5;
+  i %= 1000;
+  c -= 4;
+  p += 2;
+  x = i++;
+  x += ++i + c + *p++;
+  x += *p;
+  return x * 1000 + i;
+}
+
+// 超过8个整型参数时，之后的参数通过栈传递
+static long params(int a, int b, int c, int d, int e, int f, int g, int h,
+                   int i, unsigned j) {
+  long s = 0;
+  for (int k = 0; k < 3; k++) {
+    s += a + b + c + d + e + f + g + h + i;
+    j += 0x7fffffff;
+  }
+  return s * 10 + (j > 0xffff);
+}
+
+static int fib(int n) {
+  int a = n - 1, b = n - 2;
+  if (n < 2)
+    return n;
+  return fib(a) + fib(b);
+}
+
+// 超过s1~s11个寄存器的变量
+static long many(int n) {
+  long v0 = 1, v1 = 2, v2 = 3, v3 = 4, v4 = 5, v5 = 6, v6 = 7, v7 = 8;
+  long v8 = 9, v9 = 10, v10 = 11, v11 = 12, v12 = 13, v13 = 14;
+  for (int i = 0; i < n; i++) {
+    v0 += v1;
+    v1 += v2;
+    v2 += v3;
+    v3 += v4;
+    v4 += v5;
+    v5 += v6;
+    v6 += v7;
+    v7 += v8;
+    v8 += v9;
+    v9 += v10;
+    v10 += v11;
+    v11 += v12;
+    v12 += v13;
+    v13 += i;
+  }
+  return v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8 + v9 + v10 + v11 + v12 +
+         v13;
+}
+
+static int addr(int n) {
+  int x = n, y = n;
+  int *p = &x;
+  *p += 1;
+  y += *p;
+  return x * 100 + y;
+}
+
+static int loop(int *a, int n) {
+  int s = 0, i = 0;
+again:
+  if (i < n) {
+    switch (a[i] & 3) {
+    case 0:
+      s += 1;
+      break;
+    case 1:
+      s += 10;
+      break;
+    default:
+      s += 100;
+    }
+    i++;
+    goto again;
+  }
+  return s;
+}
+
+int main() {
+  ASSERT(1, wrap());
+  ASSERT(1, ({ long x = compound(3); x == (79 + 81 + 255 + 'c' + 'd') * 1000 + 81; }));
+  ASSERT(1351, params(1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+  ASSERT(55, fib(10));
+  ASSERT(1, many(0) == 105 && many(5) == 3226);
+  ASSERT(407, addr(3));
+  ASSERT(1, ({ int a[6] = {0, 1, 2, 3, 4, 5}; loop(a, 6) == 2 * 1 + 2 * 10 + 2 * 100; }));
+
+  printf("OK\n");
+  return 0;
+}
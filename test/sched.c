@@ -0,0 +1,90 @@
+#include "test.h"
+
+// -O1时基本块内的指令会重新排序，结果须与-O0相同
+
+// 两个指针指向同一数组，存储和加载不能交换
+static long overlap(long *a, long *b) {
+  a[1] = 5;
+  long x = b[0] * 3;
+  b[0] = 7;
+  return x + a[1] * 100 + a[0] * 10000;
+}
+
+// 同一基址、偏移量不同的访存可以交换，部分重叠的不能交换
+static int offsets(char *p) {
+  *(int *)p = 0x01020304;
+  p[8] = 9;
+  int x = p[1] + p[8] * 10;
+  *(short *)(p + 2) = 0x0506;
+  return x * 1000000 + *(int *)p % 1000000;
+}
+
+static int divmul(int a, int b, int c) {
+  int q = a / b;
+  int r = a % b;
+  int m = b * c;
+  return q * 10000 + r * 100 + m;
+}
+
+static double fp(double *x, int n) {
+  double s = 0, t = 1;
+  for (int i = 0; i < n; i++) {
+    s += x[i] / 2;
+    t *= x[i] + 1;
+  }
+  return s * 1000 + t;
+}
+
+// 地址被获取的局部变量，通过指针写入后直接读取
+static int local(void) {
+  int a[4] = {1, 2, 3, 4};
+  int *p = a + 1;
+  *p = 20;
+  int x = a[1];
+  p[1] = x + a[0];
+  return a[2] * 100 + a[3];
+}
+
+static long add3(long a, long b, long c) { return a * 100 + b * 10 + c; }
+
+static long calls(long *p) {
+  long a = p[0] + 1;
+  long b = add3(a, p[1], p[2]);
+  p[1] = b;
+  return add3(p[0], p[1] / 100, b % 10);
+}
+
+// alloca改变sp后的访存
+static int stack(int n) {
+  int *p = alloca(n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    p[i] = i * i;
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += p[i];
+  return s;
+}
+
+typedef struct {
+  long a, b, c;
+} Triple;
+
+static Triple swap(Triple t) {
+  Triple u = {t.c, t.a, t.b};
+  return u;
+}
+
+int main() {
+  ASSERT(1, ({ long a[2] = {4, 0}; overlap(a, a) == 12 + 500 + 70000 && a[0] == 7; }));
+  ASSERT(1, ({ long a[2] = {4, 0}, b[1] = {6}; overlap(a, b) == 18 + 500 + 40000 && b[0] == 7; }));
+  ASSERT(1, ({ char p[12] = {}; offsets(p) == 93 * 1000000 + 0x05060304 % 1000000; }));
+  ASSERT(1, divmul(100, 7, -3) == 14 * 10000 + 2 * 100 - 21);
+  ASSERT(1, ({ double x[3] = {1, 2, 3}; fp(x, 3) == 3000 + 24; }));
+  ASSERT(2104, local());
+  ASSERT(1, ({ long p[3] = {1, 2, 3}; calls(p) == 1 * 100 + 2 * 10 + 3 && p[1] == 223; }));
+  ASSERT(30, stack(5));
+  ASSERT(1, ({ Triple t = {1, 2, 3}; Triple u = swap(t); u.a == 3 && u.b == 1 && u.c == 2; }));
+
+  printf("OK\n");
+  return 0;
+}
@@ -6,6 +6,17 @@
 _Thread_local int v1;
 _Thread_local int v2 = 5;
 int v3 = 7;
+__thread int v4 __attribute__((tls_model("initial-exec"))) = 9;
+extern _Thread_local int v5;
+_Thread_local int v5 = 11;
+
+// 多次访问同一个线程局部变量
+int tls_sum(void) {
+  static _Thread_local int cnt;
+  cnt++;
+  v4 += v5;
+  return v4 + v5 + cnt;
+}
 
 int thread_main(void *unused) {
   ASSERT(0, v1);
@@ -20,6 +31,9 @@ int thread_main(void *unused) {
   ASSERT(2, v2);
   ASSERT(3, v3);
 
+  ASSERT(32, tls_sum());
+  ASSERT(44, tls_sum());
+
   return 0;
 }
 
@@ -38,6 +52,9 @@ int main() {
   ASSERT(5, v2);
   ASSERT(3, v3);
 
+  ASSERT(32, tls_sum());
+  ASSERT(9, v4 - v5);
+
   printf("OK\n");
   return 0;
 }
@@ -0,0 +1,124 @@
+#include "test.h"
+
+// 支持GCC的vector_size向量类型
+
+typedef int v4si __attribute__((vector_size(16)));
+typedef unsigned int v4su __attribute__((vector_size(16)));
+typedef signed char v16qi __attribute__((vector_size(16)));
+typedef unsigned char v16qu __attribute__((vector_size(16)));
+typedef short v8hi __attribute__((vector_size(16)));
+typedef long v2di __attribute__((vector_size(16)));
+typedef float v4sf __attribute__((vector_size(16)));
+typedef double v2df __attribute__((vector_size(16)));
+typedef short v4hi __attribute__((vector_size(8)));
+typedef int v8si __attribute__((vector_size(32)));
+typedef double v4df __attribute__((vector_size(32)));
+typedef signed char v64qi __attribute__((vector_size(64)));
+typedef int v32si __attribute__((vector_size(128)));
+typedef __attribute__((__vector_size__(8))) unsigned char v8qu;
+
+v4si G1 = {1, 2, 3, 4};
+v2df G2 = {1.5};
+int __attribute__((vector_size(16))) G3 = {5, 6};
+
+static v4si add4(v4si A, v4si B) { return A + B; }
+static v8si scale8(v8si A, int K) { return A * K; }
+static v4df addd(v4df A, v4df B) { return A + B; }
+static v4hi dup(v4hi A) { return A + A; }
+static v4sf sub4(v4sf A, v4sf B) { return A - B; }
+
+static int sum(int *P, int N) {
+  int S = 0;
+  for (int I = 0; I < N; I++)
+    S += P[I];
+  return S;
+}
+
+int main() {
+  ASSERT(16, sizeof(v4si));
+  ASSERT(16, _Alignof(v4si));
+  ASSERT(8, sizeof(v4hi));
+  ASSERT(8, _Alignof(v4hi));
+  ASSERT(32, sizeof(v8si));
+  ASSERT(16, _Alignof(v8si));
+  ASSERT(128, sizeof(v32si));
+  ASSERT(8, sizeof(v8qu));
+  ASSERT(4, sizeof(((v4si){})[0]));
+  ASSERT(2, sizeof(((v8hi){})[0]));
+
+  ASSERT(3, G1[2]);
+  ASSERT(1, G2[0] == 1.5 && G2[1] == 0);
+  ASSERT(11, G3[0] + G3[1] + G3[2] + G3[3]);
+
+  ASSERT(3, ({ v4si A = {1, 2, 3}; A[2]; }));
+  ASSERT(0, ({ v4si A = {1, 2, 3}; A[3]; }));
+  ASSERT(9, ({ v4si A = {}; A[1] = 9; A[1]; }));
+  ASSERT(10, ({ v4si A = {1, 2, 3, 4}; sum((int *)&A, 4); }));
+  ASSERT(7, ({ v4si A = {1, 2, 3, 4}, B; B = A; B[0] = 7; A[0] + B[0] - 1; }));
+
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}, B = {10, 20, 30, 40}; v4si C = A + B; C[0] == 11 && C[3] == 44; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}, B = {10, 20, 30, 40}; v4si C = B - A * 2; C[0] == 8 && C[3] == 32; }));
+  ASSERT(1, ({ v4si A = {-7, 7, 100, -100}; v4si C = A / 2; C[0] == -3 && C[1] == 3 && C[3] == -50; }));
+  ASSERT(1, ({ v4si A = {-7, 7, 100, -100}; v4si C = A % 3; C[0] == -1 && C[1] == 1 && C[2] == 1; }));
+  ASSERT(1, ({ v4su A = {-7, 7, 100, 1}; v4su C = A / 2; C[0] == 2147483644 && C[3] == 0; }));
+  ASSERT(1, ({ v4si A = {12, 10, 6, 5}, B = {10, 3, 5, 6}; v4si C = (A & B) | (A ^ ~B); C[0] == -7 && C[1] == -10 && C[2] == -4; }));
+  ASSERT(1, ({ v4si A = {1, -8, 3, 4}; v4si C = A << 2; v4si D = A >> 1; C[0] == 4 && C[1] == -32 && D[1] == -4 && D[3] == 2; }));
+  ASSERT(1, ({ v4su A = {1, -8, 3, 4}; v4su D = A >> 1; D[1] == 2147483644; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}, B = {4, 3, 2, 1}; v4si C = A << B; C[0] == 16 && C[3] == 8; }));
+  ASSERT(1, ({ v4si A = {1, -2, 3, 0}; v4si C = -A; v4si D = ~A; C[0] == -1 && C[1] == 2 && D[3] == -1 && D[2] == -4; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}; v4si C = 10 - A; C[0] == 9 && C[3] == 6; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}; A += 5; A *= A; A[0] == 36 && A[3] == 81; }));
+
+  ASSERT(1, ({ v4si A = {1, 5, 3, 4}, B = {1, 2, 3, 9}; v4si C = A == B; C[0] == -1 && C[1] == 0 && C[2] == -1 && C[3] == 0; }));
+  ASSERT(1, ({ v4si A = {1, 5, 3, 4}, B = {1, 2, 3, 9}; v4si C = A != B; C[0] == 0 && C[1] == -1; }));
+  ASSERT(1, ({ v4si A = {1, 5, -3, 4}, B = {1, 2, 3, 9}; v4si C = A < B, D = A >= B; C[0] == 0 && C[2] == -1 && C[3] == -1 && D[0] == -1 && D[3] == 0; }));
+  ASSERT(1, ({ v4su A = {1, 5, -3, 4}, B = {1, 2, 3, 9}; v4si C = A > B; C[2] == -1 && C[1] == -1 && C[0] == 0; }));
+  ASSERT(1, ({ v4si A = {1, 5, -3, 4}; v4si C = A <= 3; C[0] == -1 && C[1] == 0 && C[2] == -1; }));
+
+  ASSERT(1, ({ v16qi A = {1, 2, 127, -128}, B = {1, 1, 1, 1}; v16qi C = A + B; C[2] == -128 && C[3] == -127 && C[15] == 0; }));
+  ASSERT(1, ({ v16qi A = {1, 2, 0, -128}, B = {2, 1, 1, 1}; v16qi C = A - B; C[0] == -1 && C[2] == -1 && C[3] == 127 && C[4] == 0; }));
+  ASSERT(1, ({ v16qu A = {200, 2, 255}, B = {100, 1, 1}; v16qu C = A + B; C[0] == 44 && C[2] == 0 && C[1] == 3; }));
+  ASSERT(1, ({ v16qu A = {200, 2, 255}; v16qu C = -A; C[0] == 56 && C[2] == 1 && C[3] == 0; }));
+  ASSERT(1, ({ v16qi A = {-100, 50}; v16qi C = A * 3; C[0] == -44 && C[1] == -106; }));
+  ASSERT(1, ({ v16qu A = {200, 7}; v16qu C = A >> 2; v16qi D = (v16qi)A >> 2; C[0] == 50 && D[0] == -14 && D[1] == 1; }));
+  ASSERT(1, ({ v16qu A = {200, 7, 9}; v16qu C = A > 8; C[0] == 255 && C[1] == 0 && C[2] == 255; }));
+  ASSERT(1, ({ v8hi A = {30000, -2, 7}, B = {30000, 3, -9}; v8hi C = A + B, D = A - B; C[0] == -5536 && C[1] == 1 && D[2] == 16 && D[1] == -5; }));
+  ASSERT(1, ({ v8hi A = {30000, -2, 7}; v8hi C = -A; C[0] == -30000 && C[1] == 2 && C[7] == 0; }));
+  ASSERT(1, ({ v2di A = {1L << 40, -3}, B = {3, 4}; v2di C = A * B + 1; C[0] == (3L << 40) + 1 && C[1] == -11; }));
+  ASSERT(1, ({ v2di A = {1L << 40, -3}; v2di C = A < 0; C[0] == 0 && C[1] == -1; }));
+  ASSERT(1, ({ v8qu A = {1, 2, 3, 4, 5, 6, 7, 8}; v8qu C = A ^ 0xff; C[0] == 254 && C[7] == 247; }));
+
+  ASSERT(1, ({ v4sf A = {1.5, 2, 3, 4}, B = {0.5, 4, 8, 16}; v4sf C = A * B + A / B; C[0] == 3.75 && C[1] == 8.5 && C[3] == 64.25; }));
+  ASSERT(1, ({ v4sf A = {1.5, 2, 3, 4}; v4sf C = -A + 1.0f; C[0] == -0.5 && C[3] == -3; }));
+  ASSERT(1, ({ v4sf A = {1.5, 2, 3, 4}; v4si C = A < 2.5f; v4si D = A == 2; C[0] == -1 && C[2] == 0 && D[1] == -1 && D[0] == 0; }));
+  ASSERT(1, ({ v2df A = {1.5, -2}, B = {2, 2}; v2df C = A * B - 1; C[0] == 2 && C[1] == -5; }));
+  ASSERT(1, ({ v2df A = {1.5, -2}; v2di C = A != 1.5; C[0] == 0 && C[1] == -1; }));
+
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}, B = {5, 6, 7, 8}; v4si C = add4(A, B); C[0] == 6 && C[3] == 12; }));
+  ASSERT(1, ({ v8si A = {1, 2, 3, 4, 5, 6, 7, 8}; v8si C = scale8(A, 3); C[0] == 3 && C[7] == 24; }));
+  ASSERT(1, ({ v4df A = {1, 2, 3, 4}; v4df C = addd(A, A); C[0] == 2 && C[3] == 8; }));
+  ASSERT(1, ({ v4hi A = {1, -2, 3, 4}; v4hi C = dup(A); C[1] == -4 && C[3] == 8; }));
+  ASSERT(1, ({ v4sf A = {1, 2, 3, 4}; v4sf C = sub4(A, A * A); C[1] == -2 && C[3] == -12; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}; v4si C = add4(A, G1) + add4(G1, A); C[0] == 4 && C[3] == 16; }));
+
+  ASSERT(1, ({ v8si A, B; for (int I = 0; I < 8; I++) { A[I] = I; B[I] = I * I; } v8si C = A * B - A; C[2] == 6 && C[7] == 336; }));
+  ASSERT(1, ({ v64qi A; for (int I = 0; I < 64; I++) A[I] = I; v64qi C = A + A, D = A & 15; C[63] == 126 && D[63] == 15 && D[17] == 1; }));
+  ASSERT(1, ({ v64qi A; for (int I = 0; I < 64; I++) A[I] = I; v64qi C = A * 3 > 60; C[20] == 0 && C[21] == -1; }));
+  ASSERT(1, ({ v32si A; for (int I = 0; I < 32; I++) A[I] = I; v32si C = A * A + 1, D = A | 64, E = A >= 16; C[31] == 962 && D[5] == 69 && E[15] == 0 && E[16] == -1; }));
+
+  ASSERT(1, ({ v4si A = {10, 20, 30, 40}; v4si M = {3, 2, 1, 4}; v4si C = __builtin_shuffle(A, M); C[0] == 40 && C[1] == 30 && C[2] == 20 && C[3] == 10; }));
+  ASSERT(1, ({ v4si A = {10, 20, 30, 40}, B = {50, 60, 70, 80}; v4si M = {0, 4, 7, 10}; v4si C = __builtin_shuffle(A, B, M); C[0] == 10 && C[1] == 50 && C[2] == 80 && C[3] == 30; }));
+  ASSERT(1, ({ v4sf A = {1, 2, 3, 4}; v4si M = {1, 1, 0, 0}; v4sf C = __builtin_shuffle(A, M); C[0] == 2 && C[3] == 1; }));
+  ASSERT(1, ({ v16qu A, B, M; for (int I = 0; I < 16; I++) { A[I] = I; B[I] = I + 100; M[I] = I * 3; } v16qu C = __builtin_shuffle(A, B, M); C[1] == 3 && C[6] == 102 && C[11] == 1 && C[15] == 13; }));
+  ASSERT(1, ({ v32si A, M; for (int I = 0; I < 32; I++) { A[I] = I * 10; M[I] = 31 - I; } v32si C = __builtin_shuffle(A, M); C[0] == 310 && C[31] == 0; }));
+
+  ASSERT(1, ({ v4si A = {1, 0, 0, 0}; v16qi B = (v16qi)A; B[0] == 1 && B[1] == 0; }));
+  ASSERT(1, ({ v2df A = {1.0, 2.0}; v2di B = (v2di)A; B[0] == 0x3ff0000000000000L; }));
+  ASSERT(1, ({ long X = 0x0102030405060708; v4hi A = (v4hi)X; A[0] == 0x0708 && A[3] == 0x0102; }));
+  ASSERT(1, ({ v4hi A = {1, 2, 3, 4}; long X = (long)A; X == 0x0004000300020001; }));
+  ASSERT(1, ({ unsigned char C = 0xab; v8qu A = (v8qu)(long)C; A[0] == 0xab && A[1] == 0; }));
+  ASSERT(1, ({ v4si A = {1, 2, 3, 4}, B = {5, 6, 7, 8}; int K = 0; v4si C = K ? A : B; C[0] == 5; }));
+
+  printf("OK\n");
+  return 0;
+}
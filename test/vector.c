@@ -0,0 +1,112 @@
+#include "test.h"
+
+// 这些循环在-march含v时会被向量化，结果须与标量版本相同
+
+static void saxpy(int n, float a, float *x, float *y) {
+  for (int i = 0; i < n; i++)
+    y[i] = a * x[i] + y[i];
+}
+
+static void daxpy(long n, double a, double *x, double *y) {
+  for (long i = 0; i < n; i++)
+    y[i] += a * x[i];
+}
+
+static void add3(int n, int *d, int *a, int *b) {
+  for (int i = 0; i < n; i++)
+    d[i] = a[i] + b[i] * 3 - (a[i] >> 1);
+}
+
+static void xorb(int n, unsigned char *d, unsigned char *s) {
+  for (int i = 0; i < n; i++)
+    d[i] = s[i] ^ 0x5a;
+}
+
+static void shift(int n, short *d, short *s) {
+  for (int i = 0; i < n; i++)
+    d[i] = (short)(s[i] << 3) + (short)-s[i];
+}
+
+static void inc(int n, int *d, int *s) {
+  for (int i = 0; i < n; i++)
+    d[i] = s[i] + 1;
+}
+
+static void twice(int n, long *d) {
+  for (int i = 1; i <= n; i++)
+    d[i] = d[i] * 2 + 1;
+}
+
+static unsigned sum8(unsigned char *p, int n) {
+  unsigned s = 0;
+  for (int i = 0; i < n; i++)
+    s += p[i];
+  return s;
+}
+
+static long sub(int *p, int n) {
+  long s = 7;
+  for (int i = 0; i < n; i++)
+    s -= p[i];
+  return s;
+}
+
+static int xorr(int *p, unsigned n) {
+  int s = 0;
+  for (unsigned i = 0; i < n; i++)
+    s ^= p[i];
+  return s;
+}
+
+static int find(unsigned char *p, int n, int c) {
+  for (int i = 0; i < n; i++)
+    if (p[i] == c)
+      return i;
+  return -1;
+}
+
+static long mismatch(long *p, long *q, long n) {
+  long i;
+  for (i = 0; i < n; i++)
+    if (p[i] != q[i])
+      break;
+  return i;
+}
+
+int GA[100], GB[100], GC[100];
+
+static void glob(int n) {
+  for (int i = 0; i < n; i++)
+    GA[i] = GB[i] / (GC[i] | 1) % 7;
+}
+
+int main() {
+  ASSERT(1, ({ float x[37], y[37]; for (int i = 0; i < 37; i++) { x[i] = i; y[i] = 100 - i; } saxpy(37, 1.5f, x, y); y[0] == 100 && y[36] == 118 && y[10] == 105; }));
+  ASSERT(1, ({ double x[37], y[37]; for (int i = 0; i < 37; i++) { x[i] = i; y[i] = i * i; } daxpy(37, -0.5, x, y); y[36] == 1278 && y[3] == 7.5; }));
+  ASSERT(1, ({ double x[5] = {1, 2, 3, 4, 5}, y[5] = {}; daxpy(0, 2, x, y); y[0] == 0; }));
+  ASSERT(1, ({ int a[50], b[50], d[50]; for (int i = 0; i < 50; i++) { a[i] = i * 7919 - 1000; b[i] = -i * 31; } add3(50, d, a, b); d[0] == -500 && d[49] == 188959; }));
+  ASSERT(1, ({ unsigned char s[77], d[77]; for (int i = 0; i < 77; i++) s[i] = i * 13; xorb(77, d, s); d[0] == 0x5a && d[76] == ((76 * 13) & 255 ^ 0x5a); }));
+  ASSERT(1, ({ short s[30], d[30]; for (int i = 0; i < 30; i++) s[i] = i * 3001; shift(30, d, s); d[1] == 21007 && d[29] == 19379; }));
+  ASSERT(1, ({ long d[40]; for (int i = 0; i < 40; i++) d[i] = i; twice(38, d); d[0] == 0 && d[1] == 3 && d[38] == 77 && d[39] == 39; }));
+
+  ASSERT(2926, ({ unsigned char p[77]; for (int i = 0; i < 77; i++) p[i] = i; sum8(p, 77); }));
+  ASSERT(0, ({ unsigned char p[1]; sum8(p, 0); }));
+  ASSERT(7 - 1225, ({ int p[50]; for (int i = 0; i < 50; i++) p[i] = i; sub(p, 50); }));
+  ASSERT(32, ({ int p[33]; for (int i = 0; i < 33; i++) p[i] = i; xorr(p, 33); }));
+
+  ASSERT(60, ({ unsigned char p[77]; for (int i = 0; i < 77; i++) p[i] = i + 3; find(p, 77, 63); }));
+  ASSERT(-1, ({ unsigned char p[77]; for (int i = 0; i < 77; i++) p[i] = i + 3; find(p, 77, 1); }));
+  ASSERT(-1, ({ unsigned char p[77]; for (int i = 0; i < 77; i++) p[i] = i + 3; find(p, 5, 63); }));
+  ASSERT(33, ({ long p[40], q[40]; for (int i = 0; i < 40; i++) p[i] = q[i] = i; q[33] = 0; mismatch(p, q, 40); }));
+  ASSERT(30, ({ long p[40], q[40]; for (int i = 0; i < 40; i++) p[i] = q[i] = i; q[33] = 0; mismatch(p, q, 30); }));
+
+  ASSERT(1, ({ for (int i = 0; i < 100; i++) { GB[i] = i * 1000 - 3; GC[i] = i - 50; } glob(100); GA[0] == 0 && GA[60] == 59997 / 11 % 7 && GA[99] == 98997 / 49 % 7; }));
+
+  // 源和目标重叠时，运行时检查后执行标量循环
+  ASSERT(1, ({ int o[60]; for (int i = 0; i < 60; i++) o[i] = i; inc(50, o + 1, o); o[50] == 50 && o[20] == 20 && o[51] == 51; }));
+  ASSERT(1, ({ int o[60]; for (int i = 0; i < 60; i++) o[i] = i; inc(50, o, o + 1); o[49] == 51 && o[20] == 22 && o[50] == 50; }));
+  ASSERT(1, ({ int o[60]; for (int i = 0; i < 60; i++) o[i] = i; inc(50, o, o); o[49] == 50 && o[50] == 50; }));
+
+  printf("OK\n");
+  return 0;
+}
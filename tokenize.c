@@ -226,7 +226,7 @@ static bool isKeyword(Token *Tok) {
         "restrict",  "__restrict", "__restrict__",
         "_Noreturn", "float",      "double",
         "typeof",    "asm",        "_Thread_local",
-        "__thread",
+        "__thread",  "__attribute__", "_Atomic",
     };
 
     for (int i = 0; i < sizeof(kw) / sizeof(*kw); i++)
@@ -906,8 +906,26 @@ static void convertUniversalChars(char *P) {
   *Q = '\0';
 }
 
-// 词法分析文件
-Token *tokenizeFile(char *Path) {
+// 编译服务器中预先词法分析好的文件
+typedef struct {
+  File *File;     // 文件，尚未分配文件编号
+  Token *Tok;     // 终结符链表
+  struct stat St; // 词法分析时文件的状态，用于判断文件是否被修改
+} CachedFile;
+
+// 文件路径到CachedFile的映射
+static HashMap FileCache;
+
+// 判断文件自缓存后是否未被修改
+static bool isSameFile(struct stat *A, struct stat *B) {
+  return A->st_ino == B->st_ino && A->st_dev == B->st_dev &&
+         A->st_size == B->st_size &&
+         A->st_mtim.tv_sec == B->st_mtim.tv_sec &&
+         A->st_mtim.tv_nsec == B->st_mtim.tv_nsec;
+}
+
+// 读取文件，并进行词法分析前的预处理
+static File *readSourceFile(char *Path) {
   // 读取文件内容
   char *P = readFile(Path);
   if (!P)
@@ -924,10 +942,16 @@ Token *tokenizeFile(char *Path) {
   removeBackslashNewline(P);
   convertUniversalChars(P);
 
+  // 文件路径，文件编号稍后分配，文件内容
+  return newFile(Path, 0, P);
+}
+
+// 为文件分配编号，并保存到InputFiles中
+static void registerFile(File *FP) {
   // 文件编号
   static int FileNo;
-  // 文件路径，文件编号从1开始，文件内容
-  File *FP = newFile(Path, FileNo + 1, P);
+  // 文件编号从1开始
+  FP->FileNo = FileNo + 1;
 
   // 为汇编的.file指示保存文件名
   // 最后字符串为空，作为结尾。
@@ -939,6 +963,50 @@ Token *tokenizeFile(char *Path) {
   InputFiles[FileNo + 1] = NULL;
   // 文件编号加1
   FileNo++;
+}
+
+// 预先词法分析文件并缓存，供编译服务器之后的请求使用
+// St为请求中读取该文件时的状态，文件已变化时不缓存
+void cacheTokenizedFile(char *Path, struct stat *St) {
+  struct stat Cur;
+  if (stat(Path, &Cur) || !isSameFile(St, &Cur))
+    return;
+  // Path属于请求的报告，报告处理完后会被释放
+  Path = strdup(Path);
+
+  CachedFile *CF = hashmap_get(&FileCache, Path);
+  if (CF && isSameFile(&CF->St, &Cur))
+    return;
+
+  File *FP = readSourceFile(Path);
+  if (!FP)
+    return;
+
+  CF = calloc(1, sizeof(CachedFile));
+  CF->File = FP;
+  CF->Tok = tokenize(FP);
+  CF->St = Cur;
+  hashmap_put(&FileCache, Path, CF);
+}
+
+// 词法分析文件
+Token *tokenizeFile(char *Path) {
+  // 使用编译服务器缓存的终结符
+  // 缓存只使用一次，同一文件再次被引入时需要新的文件编号和终结符
+  if (FileCache.used) {
+    CachedFile *CF = hashmap_get(&FileCache, Path);
+    struct stat St;
+    if (CF && !stat(Path, &St) && isSameFile(&CF->St, &St)) {
+      hashmap_delete(&FileCache, Path);
+      registerFile(CF->File);
+      return CF->Tok;
+    }
+  }
+
+  File *FP = readSourceFile(Path);
+  if (!FP)
+    return NULL;
+  registerFile(FP);
 
   // 词法分析文件
   return tokenize(FP);
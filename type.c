@@ -89,6 +89,8 @@ bool isCompatible(Type *T1, Type *T2) {
     if (!isCompatible(T1->Base, T2->Base))
       return false;
     return T1->ArrayLen < 0 && T2->ArrayLen < 0 && T1->ArrayLen == T2->ArrayLen;
+  case TY_VECTOR:
+    return T1->Size == T2->Size && isCompatible(T1->Base, T2->Base);
   default:
     return false;
   }
@@ -136,6 +138,15 @@ Type *VLAOf(Type *Base, Node *Len) {
   return Ty;
 }
 
+// 构造向量类型, 传入 元素类型, 向量的字节数
+// 与GCC相同，对齐值为向量大小，但不超过16字节
+Type *vectorOf(Type *Base, int Size) {
+  Type *Ty = newType(TY_VECTOR, Size, MIN(Size, 16));
+  Ty->Base = Base;
+  Ty->ArrayLen = Size / Base->Size;
+  return Ty;
+}
+
 // 构造枚举类型
 Type *enumType(void) { return newType(TY_ENUM, 4, 4); }
 
@@ -188,6 +199,85 @@ static void usualArithConv(Node **LHS, Node **RHS) {
   *RHS = newCast(*RHS, Ty);
 }
 
+// 元素大小相同的有符号整数向量，为向量比较的结果类型
+static Type *intVectorOf(Type *Ty) {
+  Type *Base = Ty->Base->Size == 1   ? TyChar
+               : Ty->Base->Size == 2 ? TyShort
+               : Ty->Base->Size == 4 ? TyInt
+                                     : TyLong;
+  return vectorOf(Base, Ty->Size);
+}
+
+// 向量的逐元素运算，不是向量运算时返回false
+// 两侧都为向量时，元素的个数和大小需相同；
+// 标量先转换为元素的类型，再与每个元素进行运算
+static bool vectorOp(Node *Nd) {
+  Type *LTy = Nd->LHS ? Nd->LHS->Ty : NULL;
+  Type *RTy = Nd->RHS ? Nd->RHS->Ty : NULL;
+  bool LVec = LTy && LTy->Kind == TY_VECTOR;
+  bool RVec = RTy && RTy->Kind == TY_VECTOR;
+
+  switch (Nd->Kind) {
+  case ND_ADD:
+  case ND_SUB:
+  case ND_MUL:
+  case ND_DIV:
+  case ND_MOD:
+  case ND_BITAND:
+  case ND_BITOR:
+  case ND_BITXOR:
+  case ND_SHL:
+  case ND_SHR:
+  case ND_EQ:
+  case ND_NE:
+  case ND_LT:
+  case ND_LE:
+  case ND_NEG:
+  case ND_BITNOT:
+    if (!LVec && !RVec)
+      return false;
+    break;
+  case ND_NOT:
+  case ND_LOGAND:
+  case ND_LOGOR:
+    if (LVec || RVec)
+      errorTok(Nd->Tok, "invalid operands to vector operation");
+    return false;
+  default:
+    return false;
+  }
+
+  Type *Ty = LVec ? LTy : RTy;
+  Node **Other = LVec ? &Nd->RHS : &Nd->LHS;
+  if (LVec && RVec) {
+    if (LTy->ArrayLen != RTy->ArrayLen || LTy->Size != RTy->Size ||
+        isFloNum(LTy->Base) != isFloNum(RTy->Base))
+      errorTok(Nd->Tok, "invalid operands to vector operation");
+  } else if (*Other) {
+    // 整数向量只能与整数运算，浮点数会被截断
+    if (!isInteger((*Other)->Ty) &&
+        !(isFloatOrDouble((*Other)->Ty) && isFloNum(Ty->Base)))
+      errorTok(Nd->Tok, "invalid operands to vector operation");
+    *Other = newCast(*Other, Ty->Base);
+  }
+
+  // 浮点向量不能取余、进行位运算和移位
+  if (isFloNum(Ty->Base) &&
+      (Nd->Kind == ND_MOD || Nd->Kind == ND_BITAND || Nd->Kind == ND_BITOR ||
+       Nd->Kind == ND_BITXOR || Nd->Kind == ND_SHL || Nd->Kind == ND_SHR ||
+       Nd->Kind == ND_BITNOT))
+    errorTok(Nd->Tok, "invalid operands to vector operation");
+
+  // 比较的结果，真为-1，假为0
+  if (Nd->Kind == ND_EQ || Nd->Kind == ND_NE || Nd->Kind == ND_LT ||
+      Nd->Kind == ND_LE)
+    Nd->Ty = intVectorOf(Ty);
+  else
+    Nd->Ty = Ty;
+  Nd->VecTmp = newVecTmp(Nd->Ty);
+  return true;
+}
+
 // 为节点内的所有节点添加类型
 void addType(Node *Nd) {
   // 判断 节点是否为空 或者 节点类型已经有值，那么就直接返回
@@ -202,6 +292,10 @@ void addType(Node *Nd) {
   addType(Nd->Els);
   addType(Nd->Init);
   addType(Nd->Inc);
+  addType(Nd->CasAddr);
+  addType(Nd->CasOld);
+  addType(Nd->CasNew);
+  addType(Nd->Mask);
 
   // 访问链表内的所有节点以增加类型
   for (Node *N = Nd->Body; N; N = N->Next)
@@ -210,6 +304,9 @@ void addType(Node *Nd) {
   for (Node *N = Nd->Args; N; N = N->Next)
     addType(N);
 
+  if (vectorOp(Nd))
+    return;
+
   switch (Nd->Kind) {
   // 将节点类型设为 int
   case ND_NUM:
@@ -240,6 +337,11 @@ void addType(Node *Nd) {
   case ND_ASSIGN:
     if (Nd->LHS->Ty->Kind == TY_ARRAY)
       errorTok(Nd->LHS->Tok, "not an lvalue");
+    // 向量之间按位复制，大小需相同
+    if ((Nd->LHS->Ty->Kind == TY_VECTOR || Nd->RHS->Ty->Kind == TY_VECTOR) &&
+        (Nd->LHS->Ty->Kind != Nd->RHS->Ty->Kind ||
+         Nd->LHS->Ty->Size != Nd->RHS->Ty->Size))
+      errorTok(Nd->Tok, "incompatible types in assignment");
     if (Nd->LHS->Ty->Kind != TY_STRUCT)
       // 对右部转换
       Nd->RHS = newCast(Nd->RHS, Nd->LHS->Ty);
@@ -261,6 +363,9 @@ void addType(Node *Nd) {
   case ND_NOT:
   case ND_LOGOR:
   case ND_LOGAND:
+  case ND_CLZ:
+  case ND_CTZ:
+  case ND_POPCOUNT:
     Nd->Ty = TyInt;
     return;
   // 将节点类型设为 左部的类型
@@ -278,6 +383,12 @@ void addType(Node *Nd) {
   case ND_COND:
     if (Nd->Then->Ty->Kind == TY_VOID || Nd->Els->Ty->Kind == TY_VOID) {
       Nd->Ty = TyVoid;
+    } else if (Nd->Then->Ty->Kind == TY_VECTOR ||
+               Nd->Els->Ty->Kind == TY_VECTOR) {
+      if (Nd->Then->Ty->Kind != Nd->Els->Ty->Kind ||
+          Nd->Then->Ty->Size != Nd->Els->Ty->Size)
+        errorTok(Nd->Tok, "type mismatch in conditional expression");
+      Nd->Ty = Nd->Then->Ty;
     } else {
       usualArithConv(&Nd->Then, &Nd->Els);
       Nd->Ty = Nd->Then->Ty;
@@ -304,7 +415,7 @@ void addType(Node *Nd) {
   // 节点类型：如果解引用指向的是指针，则为指针指向的类型；否则报错
   case ND_DEREF:
     // 如果不存在基类, 则无法解引用
-    if (!Nd->LHS->Ty->Base)
+    if (!Nd->LHS->Ty->Base || Nd->LHS->Ty->Kind == TY_VECTOR)
       errorTok(Nd->Tok, "invalid pointer dereference");
     if (Nd->LHS->Ty->Base->Kind == TY_VOID)
       errorTok(Nd->Tok, "dereferencing a void pointer");
@@ -327,6 +438,43 @@ void addType(Node *Nd) {
   case ND_LABEL_VAL:
     Nd->Ty = pointerTo(TyVoid);
     return;
+  // 比较并交换，返回是否成功
+  case ND_CAS:
+    Nd->Ty = TyBool;
+    return;
+  // 原子读改写和原子读取，为指针指向的类型
+  case ND_ATOMIC_RW:
+  case ND_ATOMIC_LD:
+    Nd->Ty = Nd->LHS->Ty->Base;
+    return;
+  case ND_ATOMIC_ST:
+  case ND_FENCE:
+  case ND_PREFETCH:
+  case ND_UNREACH:
+    Nd->Ty = TyVoid;
+    return;
+  case ND_EXPECT:
+    Nd->Ty = TyLong;
+    return;
+  case ND_ALIGNED:
+    Nd->Ty = pointerTo(TyVoid);
+    return;
+  // 重排后的向量，与第一个向量的类型相同
+  case ND_SHUFFLE: {
+    Type *Ty = Nd->LHS->Ty;
+    Type *MTy = Nd->Mask->Ty;
+    if (Ty->Kind != TY_VECTOR ||
+        (Nd->RHS && (Nd->RHS->Ty->Kind != TY_VECTOR ||
+                     Nd->RHS->Ty->Size != Ty->Size)))
+      errorTok(Nd->Tok, "__builtin_shuffle arguments must be vectors");
+    if (MTy->Kind != TY_VECTOR || !isInteger(MTy->Base) ||
+        MTy->ArrayLen != Ty->ArrayLen || MTy->Size != Ty->Size)
+      errorTok(Nd->Mask->Tok, "__builtin_shuffle mask must be an integer "
+                              "vector with the same number of elements");
+    Nd->Ty = Ty;
+    Nd->VecTmp = newVecTmp(Ty);
+    return;
+  }
   default:
     break;
   }